@@ -0,0 +1,1134 @@
+//------------//
+// ZBench.cpp //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.30                               //
+//-------------------------------------------------------//
+
+// The benchmarks of the hot paths of ZelosBase.
+//
+// usage: ZBench [options]
+//   --list              print the benchmark names and exit
+//   --filter <text>     run only the benchmarks whose names contain the text
+//   --repeat <n>        the number of the timed runs of each benchmark (default: 5)
+//   --warmup <n>        the number of the untimed runs before them (default: 1)
+//   --scale <s>         the problem size multiplier (default: 1)
+//   --threads <n>       the number of the OpenMP threads (default: all)
+//   --json <file>       write the results as JSON ("-": stdout)
+//   --compare <file>    compare the medians with a previous JSON output
+//   --tolerance <t>     the allowed slowdown ratio of --compare (default: 0.1)
+//   --tmp <dir>         the directory for the file I/O benchmarks (default: /tmp)
+//   --profile <file>    write the Chrome trace of ZProfiler and print its call tree
+//
+// All the inputs are synthetic and made from the fixed seeds, so the same build gives the same work on every run.
+// The counters (iterations, residuals, checksums, ...) are reported to catch the changes of the results as well as the speed.
+// (The counters of the solvers depend on the number of threads because of the order of the reductions.)
+// With --compare, the exit code is 1 if any benchmark is slower than the previous one by more than the tolerance.
+// With --profile, each benchmark is a root scope of the call tree,
+// and the scopes inside the library are recorded only when it is compiled with -DZELOS_PROFILE.
+
+#include <ZelosBase.h>
+#include <chrono>
+#include <functional>
+
+using namespace std;
+using namespace Zelos;
+
+/////////////////////////////////
+// the harness
+
+struct ZBenchOptions
+{
+	ZString filter;
+	int     repeat;
+	int     warmup;
+	float   scale;
+	int     threads;
+	ZString jsonPath;
+	ZString comparePath;
+	float   tolerance;
+	ZString tmpDir;
+	ZString profilePath;
+	bool    listOnly;
+
+	ZBenchOptions()
+	: repeat(5), warmup(1), scale(1.f), threads(0), tolerance(0.1f), tmpDir("/tmp"), listOnly(false)
+	{}
+};
+
+struct ZBenchResult
+{
+	ZString                         name;
+	double                          items;		// the number of the processed items per run
+	std::vector<double>             times;		// in milliseconds
+	std::vector<pair<ZString,double> > counters;
+
+	double minTime() const    { return *std::min_element( times.begin(), times.end() ); }
+	double meanTime() const   { double s=0; FOR( i, 0, (int)times.size() ) { s += times[i]; } return ( s / times.size() ); }
+	double medianTime() const { std::vector<double> t( times ); std::sort( t.begin(), t.end() ); const int n=(int)t.size(); return ( (n%2) ? t[n/2] : 0.5*(t[n/2-1]+t[n/2]) ); }
+	double stdDevTime() const { const double m=meanTime(); double s=0; FOR( i, 0, (int)times.size() ) { s += ZPow2(times[i]-m); } return sqrt( s / times.size() ); }
+};
+
+class ZBenchContext
+{
+	private:
+
+		const ZBenchOptions& _options;
+		ZBenchResult&        _result;
+
+	public:
+
+		ZBenchContext( const ZBenchOptions& options, ZBenchResult& result )
+		: _options(options), _result(result)
+		{}
+
+		// the problem size (at least 1)
+		int size( int baseSize ) const { return ZMax( 1, (int)( baseSize * _options.scale + 0.5f ) ); }
+
+		// the grid resolution: the number of the cells scales with 'scale'
+		int resolution( int baseResolution ) const { return ZMax( 4, (int)( baseResolution * cbrt( _options.scale ) + 0.5f ) ); }
+
+		const ZString& tmpDir() const { return _options.tmpDir; }
+
+		// It runs the function (warmup + repeat) times and records the time of each of the last 'repeat' runs.
+		void measure( double items, const std::function<void()>& run )
+		{
+			_result.items = items;
+
+			FOR( i, 0, _options.warmup ) { run(); }
+
+			FOR( i, 0, ZMax( _options.repeat, 1 ) )
+			{
+				const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+				run();
+				const std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+				_result.times.push_back( std::chrono::duration<double,std::milli>( t1 - t0 ).count() );
+			}
+		}
+
+		void counter( const char* name, double value )
+		{
+			_result.counters.push_back( make_pair( ZString(name), value ) );
+		}
+};
+
+struct ZBenchCase
+{
+	const char*                          name;
+	std::function<void(ZBenchContext&)>  run;
+};
+
+static std::vector<ZBenchCase>&
+BenchCases()
+{
+	static std::vector<ZBenchCase> cases;
+	return cases;
+}
+
+static void
+AddBench( const char* name, const std::function<void(ZBenchContext&)>& run )
+{
+	ZBenchCase c;
+	c.name = name;
+	c.run  = run;
+	BenchCases().push_back( c );
+}
+
+/////////////////////////////////
+// the synthetic inputs
+
+static void
+ToTriMesh( ZMesh& mesh, ZTriMesh& triMesh )
+{
+	mesh.triangulate();
+
+	triMesh.reset();
+	triMesh.p = mesh.points();
+
+	FOR( i, 0, mesh.numElements() )
+	{
+		const ZMeshElement& e = mesh.element(i);
+		if( ( e.type != ZMeshElementType::zFace ) || ( e.count() != 3 ) ) { continue; }
+
+		triMesh.v012.push_back( ZInt3( e[0], e[1], e[2] ) );
+	}
+}
+
+static void
+SphereMesh( ZTriMesh& triMesh, int subdivision, float radius=1.f )
+{
+	ZMesh mesh;
+	MakeSphere( mesh, radius, 2*subdivision, subdivision, ZDirection::yPositive, false );
+	ToTriMesh( mesh, triMesh );
+}
+
+static void
+PlaneMesh( ZTriMesh& triMesh, int subdivision, float width=100.f )
+{
+	ZMesh mesh;
+	MakePlane( mesh, width, width, subdivision, subdivision, ZDirection::yPositive, false );
+	ToTriMesh( mesh, triMesh );
+
+	// some relief not to be flat
+	FOR( i, 0, triMesh.p.length() )
+	{
+		ZPoint& p = triMesh.p[i];
+		p.y = 0.03f * width * sinf( 0.05f*p.x ) * cosf( 0.07f*p.z );
+	}
+}
+
+static void
+RandomPoints( ZPointArray& points, int n, const ZBoundingBox& box, int seed )
+{
+	const ZPoint& minPt = box.minPoint();
+	const ZVector size( box.width(0), box.width(1), box.width(2) );
+
+	points.setLength( n );
+
+	FOR( i, 0, n )
+	{
+		const int s = seed + 3*i;
+		points[i].set( minPt.x + size.x * ZRand(s), minPt.y + size.y * ZRand(s+1), minPt.z + size.z * ZRand(s+2) );
+	}
+}
+
+// the 7-point Laplacian with the Dirichlet boundary in the nxnxn box
+static void
+BoxLaplacian( int n, ZSparseMatrix<float>& A, ZFloatArray& b )
+{
+	const int nxy = n*n;
+	const int m   = nxy*n;
+
+	A.setSevenPointLaplacian( n, n, n );
+	b.setLength( m );
+
+	FOR( k, 0, n ) FOR( j, 0, n ) FOR( i, 0, n )
+	{
+		const int idx = i + n*( j + n*k );
+		const int e   = 7*idx;
+
+		const bool inside[7] = { true, i<n-1, i>0, j<n-1, j>0, k<n-1, k>0 };
+
+		A.v[e] = 6.f;
+
+		FOR( q, 1, 7 )
+		{
+			if( inside[q] ) { A.v[e+q] = -1.f;                 }
+			else            { A.v[e+q] =  0.f;   A.c[e+q] = -1; }
+		}
+
+		b[idx] = sinf( 0.1f*idx ) + 0.3f;
+	}
+}
+
+static double
+Residual( const ZSparseMatrix<float>& A, const ZFloatArray& x, const ZFloatArray& b )
+{
+	ZFloatArray Ax;
+	Multiply( A, x, Ax );
+
+	double sum = 0.0;
+	FOR( i, 0, b.length() ) { sum += ZPow2( (double)b[i] - Ax[i] ); }
+
+	return sqrt( sum );
+}
+
+static double
+Checksum( const float* data, int n )
+{
+	double sum = 0.0;
+	FOR( i, 0, n ) { sum += data[i] * ( 1.0 + ( i % 7 ) ); }
+	return sum;
+}
+
+// CG by the separate helper calls of ZSparseMatrixUtils.h (the implementation before the fused kernels)
+static int
+LegacyCG( const ZSparseMatrix<float>& A, ZFloatArray& x, const ZFloatArray& b, int maxIter )
+{
+	ZFloatArray r, p, Ap, t;
+
+	Multiply( A, x, t );
+	Subtract( b, t, r );
+	Equal( r, p );
+
+	float denom = 0.f, rsold = 0.f;
+	Multiply( r, r, rsold );
+
+	if( sqrt(rsold) < 1e-6 ) { return 0; }
+
+	const int numIter = ZMin( maxIter, b.length()*2 );
+
+	int it = 0;
+	for( ; it<numIter; ++it )
+	{
+		Multiply( A, p, Ap );
+
+		Multiply( p, Ap, denom );
+		const float alpha = rsold / denom;
+
+		Multiply( p, alpha, t );
+		Add( x, t, x );
+
+		Multiply( Ap, alpha, t );
+		Subtract( r, t, r );
+
+		float rsnew = 0.f;
+		Multiply( r, r, rsnew );
+
+		if( sqrt(rsnew) < 1e-6 ) { break; }
+
+		Multiply( p, rsnew/rsold, t );
+		Add( r, t, p );
+
+		rsold = rsnew;
+	}
+
+	return it;
+}
+
+/////////////////////////////////
+// the benchmarks
+
+static void
+RegisterTreeBenchmarks()
+{
+	AddBench( "tree/ZTriMeshDistTree.set", []( ZBenchContext& ctx )
+	{
+		ZTriMesh mesh;
+		SphereMesh( mesh, ctx.size(256) );
+
+		ZTriMeshDistTree tree;
+		ctx.measure( mesh.numTriangles(), [&]() { tree.set( mesh ); } );
+		ctx.counter( "triangles", mesh.numTriangles() );
+		ctx.counter( "cells", tree.numCells() );
+	} );
+
+	AddBench( "tree/ZTriMeshDistTree.getClosestPoints", []( ZBenchContext& ctx )
+	{
+		ZTriMesh mesh;
+		SphereMesh( mesh, ctx.size(256) );
+
+		ZTriMeshDistTree tree( mesh );
+
+		// in the band around the surface (The points near the center are equidistant from all the triangles.)
+		ZPointArray queries;
+		RandomPoints( queries, ctx.size(200000), ZBoundingBox( ZPoint(-1.f), ZPoint(1.f) ), 11 );
+		FOR( i, 0, queries.length() ) { queries[i] = ZPoint( queries[i].normalized() * ( 0.8f + 0.4f*ZRand(i+7) ) ); }
+
+		ZFloatArray dists;   ZPointArray closestPts;   ZIntArray tris;   ZFloat3Array bary;
+		ctx.measure( queries.length(), [&]() { tree.getClosestPoints( queries, dists, closestPts, tris, bary ); } );
+		ctx.counter( "checksum", Checksum( dists.pointer(), dists.length() ) );
+	} );
+
+	AddBench( "tree/ZTriMeshDistTree.intersectRays", []( ZBenchContext& ctx )
+	{
+		ZTriMesh mesh;
+		SphereMesh( mesh, ctx.size(256) );
+
+		ZTriMeshDistTree tree( mesh );
+
+		ZPointArray origins, targets;
+		RandomPoints( origins, ctx.size(200000), ZBoundingBox( ZPoint(-3.f), ZPoint(3.f) ), 13 );
+		RandomPoints( targets, origins.length(), ZBoundingBox( ZPoint(-0.5f), ZPoint(0.5f) ), 17 );
+
+		ZVectorArray directions( origins.length() );
+		FOR( i, 0, origins.length() ) { directions[i] = ( targets[i] - origins[i] ).normalized(); }
+
+		ZFloatArray hitDists;   ZIntArray hitTris;   ZFloat3Array bary;
+		ctx.measure( origins.length(), [&]() { tree.intersectRays( origins, directions, hitDists, hitTris, bary ); } );
+
+		int numHits = 0;
+		FOR( i, 0, hitTris.length() ) { if( hitTris[i] >= 0 ) { ++numHits; } }
+		ctx.counter( "hits", numHits );
+	} );
+
+	AddBench( "tree/ZPointsDistTree.setPoints", []( ZBenchContext& ctx )
+	{
+		ZPointArray points;
+		RandomPoints( points, ctx.size(500000), ZBoundingBox( ZPoint(-50.f), ZPoint(50.f) ), 19 );
+
+		ZPointsDistTree tree;
+		ctx.measure( points.length(), [&]() { tree.setPoints( points ); } );
+	} );
+
+	AddBench( "tree/ZPointsDistTree.findClosestPoint", []( ZBenchContext& ctx )
+	{
+		ZPointArray points, queries;
+		RandomPoints( points,  ctx.size(500000), ZBoundingBox( ZPoint(-50.f), ZPoint(50.f) ), 19 );
+		RandomPoints( queries, ctx.size(200000), ZBoundingBox( ZPoint(-50.f), ZPoint(50.f) ), 23 );
+
+		ZPointsDistTree tree( points );
+
+		ZIntArray ids( queries.length() );
+		ctx.measure( queries.length(), [&]()
+		{
+			#pragma omp parallel for
+			FOR( i, 0, queries.length() )
+			{
+				float dist2 = 0.f;
+				tree.findClosestPoint( queries[i], ids[i], dist2 );
+			}
+		} );
+
+		double sum = 0.0;
+		FOR( i, 0, ids.length() ) { sum += ids[i]; }
+		ctx.counter( "checksum", sum );
+	} );
+
+	AddBench( "tree/ZPointsDistTree.findNPoints", []( ZBenchContext& ctx )
+	{
+		ZPointArray points, queries;
+		RandomPoints( points,  ctx.size(500000), ZBoundingBox( ZPoint(-50.f), ZPoint(50.f) ), 19 );
+		RandomPoints( queries, ctx.size(50000),  ZBoundingBox( ZPoint(-50.f), ZPoint(50.f) ), 29 );
+
+		ZPointsDistTree tree( points );
+
+		ZFloatArray radii( queries.length() );
+		ctx.measure( queries.length(), [&]()
+		{
+			#pragma omp parallel for
+			FOR( i, 0, queries.length() )
+			{
+				ZIntArray ids;   ZFloatArray dist2;
+				radii[i] = tree.findNPoints( queries[i], 16, Z_LARGE, ids, dist2 );
+			}
+		} );
+		ctx.counter( "checksum", Checksum( radii.pointer(), radii.length() ) );
+	} );
+
+	AddBench( "hash/ZPointsHashGrid.build", []( ZBenchContext& ctx )
+	{
+		ZPointArray points;
+		RandomPoints( points, ctx.size(1000000), ZBoundingBox( ZPoint(-50.f), ZPoint(50.f) ), 31 );
+
+		ctx.measure( points.length(), [&]()
+		{
+			ZPointsHashGrid grid( 1<<20, 1.f );
+			grid.build( points );
+		} );
+	} );
+
+	AddBench( "hash/ZPointsHashGrid.findPoints", []( ZBenchContext& ctx )
+	{
+		ZPointArray points, queries;
+		RandomPoints( points,  ctx.size(1000000), ZBoundingBox( ZPoint(-50.f), ZPoint(50.f) ), 31 );
+		RandomPoints( queries, ctx.size(100000),  ZBoundingBox( ZPoint(-50.f), ZPoint(50.f) ), 37 );
+
+		ZPointsHashGrid grid( 1<<20, 1.f );
+		grid.build( points );
+
+		ZIntArray start, neighbors;
+		int total = 0;
+		ctx.measure( queries.length(), [&]() { total = grid.findPoints( start, neighbors, queries, 1.5f, true ); } );
+		ctx.counter( "neighbors", total );
+	} );
+}
+
+static void
+RegisterSolverBenchmarks()
+{
+	// the same system for all the solvers
+	// (CG.legacy rounds the dot products to float, so its iteration count can differ by a few from the fused ones,
+	//  while the true residuals agree.)
+	struct System
+	{
+		int n;
+		ZSparseMatrix<float> A;
+		ZFloatArray b;
+	};
+
+	static std::shared_ptr<System> system;
+
+	auto getSystem = []( ZBenchContext& ctx ) -> System&
+	{
+		const int n = ctx.resolution( 48 );
+
+		if( !system || ( system->n != n ) )
+		{
+			system = std::make_shared<System>();
+			system->n = n;
+			BoxLaplacian( n, system->A, system->b );
+		}
+
+		return *system;
+	};
+
+	const int maxIter = 200;
+
+	AddBench( "solver/CG.legacy", [=]( ZBenchContext& ctx )
+	{
+		System& s = getSystem( ctx );
+
+		ZFloatArray x;
+		int iterations = 0;
+		ctx.measure( s.b.length(), [&]() { x.setLength( s.b.length() ); iterations = LegacyCG( s.A, x, s.b, maxIter ); } );
+		ctx.counter( "iterations", iterations );
+		ctx.counter( "residual", Residual( s.A, x, s.b ) );
+	} );
+
+	AddBench( "solver/CG.fused", [=]( ZBenchContext& ctx )
+	{
+		System& s = getSystem( ctx );
+
+		ZLinearSystemSolver solver;
+		ZFloatArray x;
+		ctx.measure( s.b.length(), [&]() { x.setLength( s.b.length() ); solver.CG( s.A, x, s.b, maxIter ); } );
+		ctx.counter( "iterations", solver.curIterations );
+		ctx.counter( "residual", Residual( s.A, x, s.b ) );
+	} );
+
+	AddBench( "solver/CG.fused.sell", [=]( ZBenchContext& ctx )
+	{
+		System& s = getSystem( ctx );
+
+		ZSellMatrix A( s.A );
+
+		ZLinearSystemSolver solver;
+		ZFloatArray x;
+		ctx.measure( s.b.length(), [&]() { x.setLength( s.b.length() ); solver.CG( A, x, s.b, maxIter ); } );
+		ctx.counter( "iterations", solver.curIterations );
+		ctx.counter( "residual", Residual( s.A, x, s.b ) );
+	} );
+
+	AddBench( "solver/PCG.jacobi", [=]( ZBenchContext& ctx )
+	{
+		System& s = getSystem( ctx );
+
+		ZLinearSystemSolver solver;
+		ZFloatArray x;
+		ctx.measure( s.b.length(), [&]() { x.setLength( s.b.length() ); solver.PCG( s.A, x, s.b, maxIter ); } );
+		ctx.counter( "iterations", solver.curIterations );
+		ctx.counter( "residual", Residual( s.A, x, s.b ) );
+	} );
+
+	AddBench( "solver/MGPCG", [=]( ZBenchContext& ctx )
+	{
+		System& s = getSystem( ctx );
+
+		ZMultigrid mg;
+		ZLinearSystemSolver solver;
+		ZFloatArray x;
+		ctx.measure( s.b.length(), [&]()
+		{
+			mg.build( s.A, s.n, s.n, s.n );
+			x.setLength( s.b.length() );
+			solver.MGPCG( s.A, x, s.b, mg, maxIter, 1e-6f );
+		} );
+		ctx.counter( "levels", mg.numLevels() );
+		ctx.counter( "iterations", solver.curIterations );
+		ctx.counter( "residual", Residual( s.A, x, s.b ) );
+	} );
+
+	AddBench( "solver/ICPCG", [=]( ZBenchContext& ctx )
+	{
+		System& s = getSystem( ctx );
+
+		ZIncompleteCholesky ic;
+		ZLinearSystemSolver solver;
+		ZFloatArray x;
+		ctx.measure( s.b.length(), [&]()
+		{
+			ic.build( s.A );
+			x.setLength( s.b.length() );
+			solver.ICPCG( s.A, x, s.b, ic, maxIter, 1e-6f );
+		} );
+		ctx.counter( "iterations", solver.curIterations );
+		ctx.counter( "residual", Residual( s.A, x, s.b ) );
+	} );
+}
+
+static void
+RegisterGeometryBenchmarks()
+{
+	AddBench( "voxel/ZVoxelizer.voxelize", []( ZBenchContext& ctx )
+	{
+		ZTriMesh mesh;
+		SphereMesh( mesh, ctx.size(128), 0.8f );
+
+		const int n = ctx.resolution( 128 );
+		ZGrid3D grid( n, n, n, ZBoundingBox( ZPoint(-1.f), ZPoint(1.f) ) );
+
+		ZScalarField3D lvs( grid );
+		ZVoxelizer voxelizer;
+		ctx.measure( lvs.numElements(), [&]() { voxelizer.voxelize( lvs, mesh, 3, 3 ); } );
+		ctx.counter( "checksum", Checksum( lvs.pointer(), lvs.numElements() ) );
+	} );
+
+	AddBench( "scatter/ZTriMeshScatter.randomBarycentric", []( ZBenchContext& ctx )
+	{
+		ZTriMesh mesh;
+		PlaneMesh( mesh, ctx.size(300) );
+
+		ZTriMeshScatter scatter( mesh );
+		scatter.method       = ZSamplingMethod::zRandomBarycentric1;
+		scatter.targetNumber = ctx.size(1000000);
+		scatter.randomSeed   = 7;
+
+		ZIntArray tris;   ZFloat3Array bary;
+		int count = 0;
+		ctx.measure( scatter.targetNumber, [&]() { count = scatter.scatter( tris, bary ); } );
+		ctx.counter( "samples", count );
+	} );
+
+	AddBench( "scatter/ZTriMeshScatter.poissonDiskOnMesh", []( ZBenchContext& ctx )
+	{
+		ZTriMesh mesh;
+		PlaneMesh( mesh, ctx.size(300) );
+
+		ZTriMeshScatter scatter( mesh );
+		scatter.method       = ZSamplingMethod::zPoissonDiskOnMesh;
+		scatter.targetNumber = ctx.size(50000);
+		scatter.randomSeed   = 7;
+
+		ZIntArray tris;   ZFloat3Array bary;
+		int count = 0;
+		ctx.measure( scatter.targetNumber, [&]() { count = scatter.scatter( tris, bary ); } );
+		ctx.counter( "samples", count );
+	} );
+
+	AddBench( "mesh/ZTriMeshConnectionInfo.build", []( ZBenchContext& ctx )
+	{
+		ZTriMesh mesh;
+		SphereMesh( mesh, ctx.size(512) );
+
+		ctx.measure( mesh.numTriangles(), [&]()
+		{
+			ZTriMeshConnectionInfo info( mesh );
+			info.build();
+		} );
+	} );
+
+	AddBench( "mesh/ZDelaunay2D", []( ZBenchContext& ctx )
+	{
+		const int n = ctx.size(200000);
+
+		ZFloat2Array vertices( n );
+		FOR( i, 0, n ) { vertices[i] = ZFloat2( ZRand(2*i+41), ZRand(2*i+42) ); }
+
+		int numTriangles = 0;
+		ctx.measure( n, [&]()
+		{
+			ZIntArray connections, neighbors;
+			ZDelaunay2D delaunay( vertices, numTriangles, connections, neighbors );
+		} );
+		ctx.counter( "triangles", numTriangles );
+	} );
+
+	AddBench( "cluster/ZKmeanClustering.run", []( ZBenchContext& ctx )
+	{
+		ZPointArray points;
+		RandomPoints( points, ctx.size(200000), ZBoundingBox( ZPoint(-50.f), ZPoint(50.f) ), 43 );
+
+		ZKmeanClustering kmeans;
+		kmeans.setRandomSeed( 1 );
+		kmeans.setPointSet( points.pointer(), points.length() );
+
+		ctx.measure( points.length(), [&]() { kmeans.run( 64, 0.01f, 100 ); } );
+		ctx.counter( "iterations", kmeans.numIterations() );
+	} );
+}
+
+static void
+RegisterNoiseBenchmarks()
+{
+	AddBench( "noise/ZSimplexNoise.fBm", []( ZBenchContext& ctx )
+	{
+		ZPointArray points;
+		RandomPoints( points, ctx.size(500000), ZBoundingBox( ZPoint(-10.f), ZPoint(10.f) ), 47 );
+
+		ZSimplexNoise noise( 3 );
+		ZFloatArray values;
+		ctx.measure( points.length(), [&]() { noise.fBm( points, 0.5f, 6, 1.f, 1.f, 0.5f, values ); } );
+		ctx.counter( "checksum", Checksum( values.pointer(), values.length() ) );
+	} );
+
+	AddBench( "noise/ZCurlNoise.velocity", []( ZBenchContext& ctx )
+	{
+		ZPointArray points;
+		RandomPoints( points, ctx.size(200000), ZBoundingBox( ZPoint(-10.f), ZPoint(10.f) ), 53 );
+
+		ZCurlNoise noise;
+		ZVectorArray velocities;
+		ctx.measure( points.length(), [&]() { noise.velocity( points, 0.5f, velocities ); } );
+		ctx.counter( "checksum", Checksum( (const float*)velocities.pointer(), 3*velocities.length() ) );
+	} );
+
+	AddBench( "noise/ZScalarField3D.setFBm", []( ZBenchContext& ctx )
+	{
+		const int n = ctx.resolution( 96 );
+		ZScalarField3D field( n, n, n, 10.f, 10.f, 10.f );
+
+		ZSimplexNoise noise( 5 );
+		ctx.measure( field.numElements(), [&]() { field.setFBm( noise, 0.f, 4, 1.f, 1.f, 0.5f ); } );
+		ctx.counter( "checksum", Checksum( field.pointer(), field.numElements() ) );
+	} );
+}
+
+static void
+RegisterFieldBenchmarks()
+{
+	AddBench( "field/Gradient", []( ZBenchContext& ctx )
+	{
+		const int n = ctx.resolution( 128 );
+		ZScalarField3D s( n, n, n, 1.f, 1.f, 1.f );
+		ZVectorField3D v( n, n, n, 1.f, 1.f, 1.f );
+
+		s.setNoise( ZSimplexNoise( 7 ), 0.f );
+
+		ctx.measure( s.numElements(), [&]() { Gradient( v, s ); } );
+		ctx.counter( "checksum", Checksum( (const float*)v.pointer(), 3*v.numElements() ) );
+	} );
+
+	AddBench( "field/Divergence", []( ZBenchContext& ctx )
+	{
+		const int n = ctx.resolution( 128 );
+		const ZGrid3D grid( n, n, n, ZBoundingBox( ZPoint(0.f), ZPoint(1.f) ) );
+
+		ZScalarField3D s( grid, ZFieldLocation::zCell );
+		ZVectorField3D v( grid, ZFieldLocation::zNode );
+
+		v.setCurlNoise( ZCurlNoise(), 0.f );
+
+		ctx.measure( s.numElements(), [&]() { s.fill( 0.f ); Divergence( s, v ); } );
+		ctx.counter( "checksum", Checksum( s.pointer(), s.numElements() ) );
+	} );
+
+	AddBench( "field/ZAdvector3D.advect", []( ZBenchContext& ctx )
+	{
+		const int n = ctx.resolution( 128 );
+		const ZGrid3D grid( n, n, n, ZBoundingBox( ZPoint(0.f), ZPoint(1.f) ) );
+
+		ZScalarField3D s0( grid, ZFieldLocation::zCell );
+		ZVectorField3D v( grid, ZFieldLocation::zNode );
+
+		s0.setNoise( ZSimplexNoise( 7 ), 0.f );
+		v.setCurlNoise( ZCurlNoise(), 0.f );
+
+		ZScalarField3D s( s0 );
+		ZAdvector3D advector; // (MacCormack, RK2)
+
+		ctx.measure( s.numElements(), [&]() { s = s0; advector.advect( s, v, 2.f/n ); } );
+		ctx.counter( "checksum", Checksum( s.pointer(), s.numElements() ) );
+	} );
+
+	AddBench( "field/ZScalarField3D.lerp", []( ZBenchContext& ctx )
+	{
+		const int n = ctx.resolution( 128 );
+		ZScalarField3D s( n, n, n, 1.f, 1.f, 1.f );
+		s.setNoise( ZSimplexNoise( 7 ), 0.f );
+
+		ZPointArray points;
+		RandomPoints( points, ctx.size(1000000), ZBoundingBox( ZPoint(0.f), ZPoint(1.f) ), 59 );
+
+		ZFloatArray values( points.length() );
+		ctx.measure( points.length(), [&]()
+		{
+			#pragma omp parallel for
+			FOR( i, 0, points.length() )
+			{
+				values[i] = s.lerp( points[i] );
+			}
+		} );
+		ctx.counter( "checksum", Checksum( values.pointer(), values.length() ) );
+	} );
+
+	AddBench( "field/ZScalarField3D.sample", []( ZBenchContext& ctx )
+	{
+		const int n = ctx.resolution( 128 );
+		ZScalarField3D s( n, n, n, 1.f, 1.f, 1.f );
+		s.setNoise( ZSimplexNoise( 7 ), 0.f );
+
+		ZPointArray points;
+		RandomPoints( points, ctx.size(1000000), ZBoundingBox( ZPoint(0.f), ZPoint(1.f) ), 59 );
+
+		ZFloatArray values;
+		ctx.measure( points.length(), [&]() { s.sample( points, values ); } );
+		ctx.counter( "checksum", Checksum( values.pointer(), values.length() ) );
+	} );
+
+	AddBench( "field/ZVectorField3D.sample.catrom", []( ZBenchContext& ctx )
+	{
+		const int n = ctx.resolution( 128 );
+		const ZGrid3D grid( n, n, n, ZBoundingBox( ZPoint(0.f), ZPoint(1.f) ) );
+
+		ZVectorField3D v( grid, ZFieldLocation::zNode );
+		v.setCurlNoise( ZCurlNoise(), 0.f );
+
+		ZPointArray points;
+		RandomPoints( points, ctx.size(1000000), ZBoundingBox( ZPoint(0.f), ZPoint(1.f) ), 61 );
+
+		ZVectorArray values;
+		ctx.measure( points.length(), [&]() { v.sample( points, values, ZInterpolationType::zCatmullRom ); } );
+		ctx.counter( "checksum", Checksum( (const float*)values.pointer(), 3*values.length() ) );
+	} );
+
+	AddBench( "field/ZFFT2D.forwardInverse", []( ZBenchContext& ctx )
+	{
+		int n = 2;
+		while( n*n < ctx.size(1024*1024) ) { n *= 2; }
+
+		ZComplexField2D f( n, n );
+		FOR( i, 0, f.length() ) { f[i].set( ZRand( 2*i, -1.f, 1.f ), ZRand( 2*i+1, -1.f, 1.f ) ); }
+
+		const ZFFT2D fft( n, n );
+		ctx.measure( f.length(), [&]() { fft.forward( f ); fft.inverse( f ); } );
+		ctx.counter( "checksum", Checksum( (const float*)f.pointer(), 2*f.length() ) );
+	} );
+
+	AddBench( "field/ZFFTOcean.update", []( ZBenchContext& ctx )
+	{
+		ZFFTOcean ocean;
+		ocean.resolution  = 2;
+		ocean.numCascades = 2;
+		while( ocean.resolution*ocean.resolution < ctx.size(256*256) ) { ocean.resolution *= 2; }
+
+		ocean.update( 0.f ); // (the spectra are built once)
+
+		float time = 0.f;
+		ctx.measure( 2*ZPow2(ocean.resolution), [&]() { ocean.update( time += 1.f/24.f ); } );
+		ctx.counter( "checksum", Checksum( (const float*)ocean.displacement().pointer(), 3*ocean.displacement().numElements() ) );
+	} );
+}
+
+static void
+RegisterIOBenchmarks()
+{
+	AddBench( "io/ZFloatArray.save", []( ZBenchContext& ctx )
+	{
+		ZFloatArray a( ctx.size(1<<23) );
+		FOR( i, 0, a.length() ) { a[i] = ZRand(i); }
+
+		const ZString path = ctx.tmpDir() + "/ZBench_float.zarr";
+		ctx.measure( a.usedMemorySize(), [&]() { a.save( path.asChar() ); } );
+		remove( path.asChar() );
+	} );
+
+	AddBench( "io/ZFloatArray.load", []( ZBenchContext& ctx )
+	{
+		ZFloatArray a( ctx.size(1<<23) );
+		FOR( i, 0, a.length() ) { a[i] = ZRand(i); }
+
+		const ZString path = ctx.tmpDir() + "/ZBench_float.zarr";
+		a.save( path.asChar() );
+
+		ZFloatArray b;
+		ctx.measure( a.usedMemorySize(), [&]() { b.load( path.asChar() ); } );
+		ctx.counter( "equal", ( a.length() == b.length() ) && ( a == b ) );
+		remove( path.asChar() );
+	} );
+
+	AddBench( "io/ZPointArray.save", []( ZBenchContext& ctx )
+	{
+		ZPointArray a;
+		RandomPoints( a, ctx.size(1<<21), ZBoundingBox( ZPoint(-1.f), ZPoint(1.f) ), 61 );
+
+		const ZString path = ctx.tmpDir() + "/ZBench_point.zarr";
+		ctx.measure( a.usedMemorySize(), [&]() { a.save( path.asChar() ); } );
+		remove( path.asChar() );
+	} );
+
+	AddBench( "io/ZPointArray.load", []( ZBenchContext& ctx )
+	{
+		ZPointArray a;
+		RandomPoints( a, ctx.size(1<<21), ZBoundingBox( ZPoint(-1.f), ZPoint(1.f) ), 61 );
+
+		const ZString path = ctx.tmpDir() + "/ZBench_point.zarr";
+		a.save( path.asChar() );
+
+		ZPointArray b;
+		ctx.measure( a.usedMemorySize(), [&]() { b.load( path.asChar() ); } );
+		ctx.counter( "equal", ( a.length() == b.length() ) && ( a == b ) );
+		remove( path.asChar() );
+	} );
+}
+
+/////////////////////////////////
+// the output
+
+static ZString
+JsonString( const ZString& str )
+{
+	ZString out( "\"" );
+
+	FOR( i, 0, (int)str.length() )
+	{
+		const char c = str[i];
+
+		if( ( c == '"' ) || ( c == '\\' ) ) { out += '\\'; out += c; }
+		else if( (unsigned char)c < 0x20 ) { out += ' '; }
+		else { out += c; }
+	}
+
+	return ( out + "\"" );
+}
+
+static ZString
+JsonNumber( double value )
+{
+	if( !std::isfinite( value ) ) { return ZString( "null" ); }
+
+	char buffer[64];
+	snprintf( buffer, 64, "%.9g", value );
+	return ZString( buffer );
+}
+
+// one benchmark per line (so --compare can read it back without a JSON parser)
+static void
+WriteJson( ostream& os, const ZBenchOptions& options, const std::vector<ZBenchResult>& results )
+{
+	char timeStamp[64] = "";
+	const time_t now = time( NULL );
+	strftime( timeStamp, 64, "%Y-%m-%dT%H:%M:%S", localtime( &now ) );
+
+	char hostName[256] = "";
+	gethostname( hostName, 255 );
+
+	bool sse = false;
+	#ifdef __SSE2__
+	 sse = true;
+	#endif
+
+	os << "{" << endl;
+	os << "  \"suite\": \"ZBench\"," << endl;
+	os << "  \"time\": " << JsonString( timeStamp ) << "," << endl;
+	os << "  \"host\": " << JsonString( hostName ) << "," << endl;
+	os << "  \"compiler\": " << JsonString( __VERSION__ ) << "," << endl;
+	os << "  \"sse2\": " << ( sse ? "true" : "false" ) << "," << endl;
+	os << "  \"threads\": " << omp_get_max_threads() << "," << endl;
+	os << "  \"scale\": " << JsonNumber( options.scale ) << "," << endl;
+	os << "  \"repeat\": " << options.repeat << "," << endl;
+	os << "  \"warmup\": " << options.warmup << "," << endl;
+	os << "  \"benchmarks\": [" << endl;
+
+	FOR( i, 0, (int)results.size() )
+	{
+		const ZBenchResult& r = results[i];
+		const double median = r.medianTime();
+
+		os << "    { \"name\": " << JsonString( r.name );
+		os << ", \"median_ms\": " << JsonNumber( median );
+		os << ", \"min_ms\": " << JsonNumber( r.minTime() );
+		os << ", \"mean_ms\": " << JsonNumber( r.meanTime() );
+		os << ", \"stddev_ms\": " << JsonNumber( r.stdDevTime() );
+		os << ", \"items\": " << JsonNumber( r.items );
+		os << ", \"items_per_sec\": " << JsonNumber( ( median > 0.0 ) ? ( 1000.0 * r.items / median ) : 0.0 );
+		os << ", \"times_ms\": [";
+		FOR( j, 0, (int)r.times.size() ) { os << ( j ? ", " : "" ) << JsonNumber( r.times[j] ); }
+		os << "], \"counters\": {";
+		FOR( j, 0, (int)r.counters.size() ) { os << ( j ? ", " : " " ) << JsonString( r.counters[j].first ) << ": " << JsonNumber( r.counters[j].second ); }
+		os << ( r.counters.empty() ? "" : " " ) << "} }" << ( ( i+1 < (int)results.size() ) ? "," : "" ) << endl;
+	}
+
+	os << "  ]" << endl;
+	os << "}" << endl;
+}
+
+// the value of "key": in the line (NaN if none)
+static double
+JsonValue( const std::string& line, const std::string& key, std::string* str=NULL )
+{
+	const std::string tag = "\"" + key + "\": ";
+
+	const size_t pos = line.find( tag );
+	if( pos == std::string::npos ) { return NAN; }
+
+	const size_t start = pos + tag.length();
+
+	if( str )
+	{
+		const size_t end = line.find( '"', start+1 );
+		if( ( line[start] != '"' ) || ( end == std::string::npos ) ) { return NAN; }
+		*str = line.substr( start+1, end-start-1 );
+		return 0.0;
+	}
+
+	return strtod( line.c_str()+start, NULL );
+}
+
+// It returns the number of the regressions, or -1 when the baseline cannot be read.
+static int
+Compare( ostream& log, const ZString& path, const std::vector<ZBenchResult>& results, float tolerance )
+{
+	ifstream fin( path.asChar() );
+
+	if( !fin.is_open() )
+	{
+		log << "Error@ZBench: Failed to open " << path << endl;
+		return -1;
+	}
+
+	std::map<std::string,double> previous;
+
+	std::string line;
+	while( std::getline( fin, line ) )
+	{
+		std::string name;
+		if( JsonValue( line, "name", &name ) != 0.0 ) { continue; }
+
+		const double median = JsonValue( line, "median_ms" );
+		if( std::isfinite( median ) ) { previous[name] = median; }
+	}
+
+	if( fin.bad() || previous.empty() )
+	{
+		log << "Error@ZBench: Invalid baseline " << path << endl;
+		return -1;
+	}
+
+	int numRegressions = 0;
+
+	log << endl << "comparison with " << path << " (tolerance: " << ( 100.f * tolerance ) << "%)" << endl;
+
+	FOR( i, 0, (int)results.size() )
+	{
+		const ZBenchResult& r = results[i];
+
+		std::map<std::string,double>::const_iterator itr = previous.find( r.name.asChar() );
+		if( itr == previous.end() ) { log << "  " << setw(48) << left << r.name.asChar() << " (new)" << endl; continue; }
+
+		const double ratio = r.medianTime() / ZMax( itr->second, 1e-9 );
+		const bool   slow  = ( ratio > 1.0 + tolerance );
+
+		if( slow ) { ++numRegressions; }
+
+		log << "  " << setw(48) << left << r.name.asChar() << right << setw(10) << fixed << setprecision(3) << ratio << "x" << ( slow ? "  REGRESSION" : "" ) << endl;
+	}
+
+	log.unsetf( ios::floatfield );
+
+	return numRegressions;
+}
+
+/////////////////////////////////
+// main
+
+static void
+PrintUsage()
+{
+	cout << "usage: ZBench [--list] [--filter text] [--repeat n] [--warmup n] [--scale s] [--threads n]" << endl;
+	cout << "              [--json file|-] [--compare file] [--tolerance t] [--tmp dir] [--profile file]" << endl;
+}
+
+int
+main( int argc, char** argv )
+{
+	ZBenchOptions options;
+
+	FOR( i, 1, argc )
+	{
+		const ZString arg( argv[i] );
+		const bool hasValue = ( i+1 < argc );
+
+		if( arg == "--list"                  ) { options.listOnly    = true;                  } else
+		if( arg == "--filter"    && hasValue ) { options.filter      = argv[++i];             } else
+		if( arg == "--repeat"    && hasValue ) { options.repeat      = atoi( argv[++i] );     } else
+		if( arg == "--warmup"    && hasValue ) { options.warmup      = atoi( argv[++i] );     } else
+		if( arg == "--scale"     && hasValue ) { options.scale       = (float)atof( argv[++i] ); } else
+		if( arg == "--threads"   && hasValue ) { options.threads     = atoi( argv[++i] );     } else
+		if( arg == "--json"      && hasValue ) { options.jsonPath    = argv[++i];             } else
+		if( arg == "--compare"   && hasValue ) { options.comparePath = argv[++i];             } else
+		if( arg == "--tolerance" && hasValue ) { options.tolerance   = (float)atof( argv[++i] ); } else
+		if( arg == "--tmp"       && hasValue ) { options.tmpDir      = argv[++i];             } else
+		if( arg == "--profile"   && hasValue ) { options.profilePath = argv[++i];             } else
+		{
+			PrintUsage();
+			return ( ( arg == "--help" ) || ( arg == "-h" ) ) ? 0 : 2;
+		}
+	}
+
+	if( options.threads > 0 ) { omp_set_num_threads( options.threads ); }
+
+	RegisterTreeBenchmarks();
+	RegisterSolverBenchmarks();
+	RegisterGeometryBenchmarks();
+	RegisterNoiseBenchmarks();
+	RegisterFieldBenchmarks();
+	RegisterIOBenchmarks();
+
+	const std::vector<ZBenchCase>& cases = BenchCases();
+
+	if( options.listOnly )
+	{
+		FOR( i, 0, (int)cases.size() ) { cout << cases[i].name << endl; }
+		return 0;
+	}
+
+	// The table goes to stderr when the JSON goes to stdout.
+	ostream& log = ( options.jsonPath == "-" ) ? cerr : cout;
+
+	log << "ZBench: " << omp_get_max_threads() << " threads, scale " << options.scale << ", " << options.repeat << " runs" << endl;
+	log << setw(48) << left << "name" << right << setw(12) << "median(ms)" << setw(12) << "min(ms)" << setw(16) << "items/s" << endl;
+
+	if( options.profilePath.length() ) { ZProfiler::global().enable(); }
+
+	std::vector<ZBenchResult> results;
+
+	FOR( i, 0, (int)cases.size() )
+	{
+		const ZString name( cases[i].name );
+		if( options.filter.length() && ( name.find( options.filter ) == std::string::npos ) ) { continue; }
+
+		ZBenchResult result;
+		result.name  = name;
+		result.items = 0.0;
+
+		ZBenchContext ctx( options, result );
+		{
+			ZProfileScope scope( cases[i].name );
+			cases[i].run( ctx );
+		}
+
+		if( result.times.empty() ) { continue; }
+
+		const double median = result.medianTime();
+
+		log << setw(48) << left << name.asChar() << right << fixed << setprecision(3)
+		    << setw(12) << median << setw(12) << result.minTime()
+		    << setw(16) << setprecision(0) << ( ( median > 0.0 ) ? ( 1000.0 * result.items / median ) : 0.0 );
+
+		FOR( j, 0, (int)result.counters.size() ) { log << "  " << result.counters[j].first.asChar() << "=" << setprecision(6) << defaultfloat << result.counters[j].second; }
+		log << defaultfloat << endl;
+
+		results.push_back( result );
+	}
+
+	if( options.jsonPath == "-" ) {
+
+		WriteJson( cout, options, results );
+
+	} else if( options.jsonPath.length() ) {
+
+		ofstream fout( options.jsonPath.asChar() );
+
+		if( !fout.is_open() ) {
+			log << "Error@ZBench: Failed to open " << options.jsonPath << endl;
+			return 2;
+		}
+
+		WriteJson( fout, options, results );
+
+	}
+
+	if( options.profilePath.length() )
+	{
+		ZProfiler& profiler = ZProfiler::global();
+		profiler.enable( false );
+
+		log << endl;
+		profiler.report( log, 0.1f );
+
+		if( !profiler.exportChromeTrace( options.profilePath.asChar() ) ) { return 2; }
+	}
+
+	if( options.comparePath.length() )
+	{
+		const int numRegressions = Compare( log, options.comparePath, results, options.tolerance );
+
+		if( numRegressions < 0 ) { return 2; }
+		if( numRegressions > 0 ) { return 1; }
+	}
+
+	return 0;
+}
+
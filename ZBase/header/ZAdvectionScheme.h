@@ -0,0 +1,64 @@
+//--------------------//
+// ZAdvectionScheme.h //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.30                               //
+//-------------------------------------------------------//
+
+#ifndef _ZAdvectionScheme_h_
+#define _ZAdvectionScheme_h_
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+// zSemiLagrangian
+// the first order semi-Lagrangian advection: q(x) <- q(x-dt*u) (stable but diffusive)
+
+// zMacCormack
+// the semi-Lagrangian advection corrected by the half of the error of a backward round trip (Selle et al. 2008)
+
+// zBFECC
+// back and forth error compensation and correction: the source is corrected by the round trip error before the advection (Kim et al. 2005)
+
+class ZAdvectionScheme
+{
+	public:
+
+		enum AdvectionScheme
+		{
+			zNone           = 0,
+			zSemiLagrangian = 1,
+			zMacCormack     = 2,
+			zBFECC          = 3
+		};
+
+	public:
+
+		ZAdvectionScheme() {}
+
+		static ZString name( ZAdvectionScheme::AdvectionScheme scheme )
+		{
+			switch( scheme )
+			{
+				default:
+				case ZAdvectionScheme::zNone:           { return ZString("none");           }
+				case ZAdvectionScheme::zSemiLagrangian: { return ZString("semi-Lagrangian"); }
+				case ZAdvectionScheme::zMacCormack:     { return ZString("MacCormack");     }
+				case ZAdvectionScheme::zBFECC:          { return ZString("BFECC");          }
+			}
+		}
+};
+
+inline ostream&
+operator<<( ostream& os, const ZAdvectionScheme& object )
+{
+	os << "<ZAdvectionScheme>" << endl;
+	os << endl;
+	return os;
+}
+
+ZELOS_NAMESPACE_END
+
+#endif
+
@@ -0,0 +1,68 @@
+//---------------//
+// ZAdvector3D.h //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.30                               //
+//-------------------------------------------------------//
+
+#ifndef _ZAdvector3D_h_
+#define _ZAdvector3D_h_
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+/// @brief The semi-Lagrangian advection of the 3D scalar and vector fields by a velocity field.
+/**
+	Each element of the field is traced back through the velocity field by the Runge-Kutta method of the given order
+	(1: Euler, 2: midpoint, 3: Ralston), and the new value is the trilinear interpolation of the old field there.
+	zMacCormack and zBFECC estimate the error of this step by a forward round trip and correct it (second order in space and time).
+	The corrected values are clamped into the range of the eight old values around the back-traced position,
+	which suppresses the overshoots (and keeps a density non-negative, for example).
+	The velocity field may have any location and resolution: it is interpolated in the world space.
+	The elements are processed by the tiles of tileSize^3 in parallel so the threads read the nearby memory.
+	The advector owns the scratch buffers which are swapped with the data of the advected field (ping-pong),
+	so a simulation loop reusing one advector doesn't allocate memory after the first step.
+	The positions out of the field domain are clamped to the boundary of the domain.
+*/
+class ZAdvector3D
+{
+	private:
+
+		ZFloatArray  _scalar[2];	// the scratch buffers of the scalar fields
+		ZVectorArray _vector[2];	// the scratch buffers of the vector fields
+		ZPointArray  _backPos;		// the back-traced positions (zMacCormack, zBFECC)
+
+	public:
+
+		ZAdvectionScheme::AdvectionScheme scheme;
+
+		int  order;		// the order of the Runge-Kutta back-tracing (1~3)
+		bool clamp;		// whether the corrected values are clamped (zMacCormack, zBFECC)
+		int  tileSize;	// the number of the elements per axis of a tile
+
+	public:
+
+		ZAdvector3D();
+
+		void reset();
+
+		// It returns false when the fields are invalid.
+		// (field and velocity can be the same one: the self-advection of a velocity field.)
+		bool advect( ZScalarField3D& field, const ZVectorField3D& velocity, float dt, bool useOpenMP=true );
+		bool advect( ZVectorField3D& field, const ZVectorField3D& velocity, float dt, bool useOpenMP=true );
+
+		double usedMemorySize( ZDataUnit::DataUnit dataUnit=ZDataUnit::zBytes ) const;
+
+	private:
+
+		bool _check( const ZField3DBase& field, const ZField3DBase& velocity ) const;
+};
+
+ostream&
+operator<<( ostream& os, const ZAdvector3D& object );
+
+ZELOS_NAMESPACE_END
+
+#endif
+
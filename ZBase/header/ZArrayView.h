@@ -0,0 +1,115 @@
+//--------------//
+// ZArrayView.h //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.30                               //
+//-------------------------------------------------------//
+
+#ifndef _ZArrayView_h_
+#define _ZArrayView_h_
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+/// @brief A read-only view of a contiguous array owned by someone else.
+/**
+	It has the same read-only interface as ZArray (length(), operator[], pointer(), ...) without any copy.
+	The views by ZCacheReader point into the memory-mapped cache file directly,
+	and they keep the mapping alive by themselves, so they are valid even after the reader is closed or destroyed.
+	copyTo() makes a ZArray when a writable array is required.
+*/
+template <class T>
+class ZArrayView
+{
+	private:
+
+		const T* _data;
+		int      _length;
+
+		std::shared_ptr<const void> _owner; // the owner of the memory (null for the views of the user memory)
+
+	public:
+
+		ZArrayView();
+		ZArrayView( const T* data, int length, const std::shared_ptr<const void>& owner=std::shared_ptr<const void>() );
+		ZArrayView( const ZArray<T>& array );
+
+		void reset();
+
+		const T& operator[]( const int& i ) const { return _data[i]; }
+		const T& operator()( const int& i ) const { return _data[i]; }
+
+		int length() const { return _length; }
+		int size() const { return _length; }
+		bool empty() const { return ( _length == 0 ); }
+
+		const T* pointer( const int& startIndex=0 ) const { return ( _data + startIndex ); }
+
+		const T* begin() const { return _data; }
+		const T* end() const { return ( _data + _length ); }
+
+		const T& first() const { return _data[0]; }
+		const T& last() const { return _data[_length-1]; }
+
+		void copyTo( ZArray<T>& array ) const;
+
+		double usedMemorySize( ZDataUnit::DataUnit dataUnit=ZDataUnit::zBytes ) const;
+};
+
+template <class T>
+inline
+ZArrayView<T>::ZArrayView()
+: _data(0), _length(0)
+{}
+
+template <class T>
+inline
+ZArrayView<T>::ZArrayView( const T* data, int length, const std::shared_ptr<const void>& owner )
+: _data(data), _length(length), _owner(owner)
+{}
+
+template <class T>
+inline
+ZArrayView<T>::ZArrayView( const ZArray<T>& array )
+: _data( array.empty() ? 0 : &array[0] ), _length( array.length() )
+{}
+
+template <class T>
+inline void
+ZArrayView<T>::reset()
+{
+	_data   = 0;
+	_length = 0;
+
+	_owner.reset();
+}
+
+template <class T>
+inline void
+ZArrayView<T>::copyTo( ZArray<T>& array ) const
+{
+	array.setLength( _length, false );
+	if( _length ) { memcpy( (char*)&array[0], (const char*)_data, _length*sizeof(T) ); }
+}
+
+template <class T>
+inline double
+ZArrayView<T>::usedMemorySize( ZDataUnit::DataUnit dataUnit ) const
+{
+	const double bytes = _length * sizeof(T);
+
+	switch( dataUnit )
+	{
+		case ZDataUnit::zBytes:     { return bytes;                 }
+		case ZDataUnit::zKilobytes: { return (bytes/(1024.0));      }
+		case ZDataUnit::zMegabytes: { return (bytes/ZPow2(1024.0)); }
+		case ZDataUnit::zGigabytes: { return (bytes/ZPow3(1024.0)); }
+		default: { cout<<"Error@ZArrayView::usedMemorySize(): Invalid data unit." << endl; return 0; }
+	}
+}
+
+ZELOS_NAMESPACE_END
+
+#endif
+
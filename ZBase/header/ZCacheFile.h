@@ -0,0 +1,223 @@
+//--------------//
+// ZCacheFile.h //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.30                               //
+//-------------------------------------------------------//
+
+#ifndef _ZCacheFile_h_
+#define _ZCacheFile_h_
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+// The chunked cache file format (version 1)
+//
+// [header: 64 bytes]
+// [chunk 0] [chunk 1] ... : the raw data of each chunk starting at a 64-byte aligned offset
+// [chunk table: numChunks x 128 bytes]
+//
+// The values are stored in the host byte order as they are in memory, so that the chunks can be used in place.
+// (A file written on a machine of the other byte order fails the version check of ZCacheReader::open().)
+// The chunks can be memory-mapped, so the processes reading the same file share the page cache.
+
+#define Z_CACHE_MAGIC     "ZCACHE\0\0"
+#define Z_CACHE_VERSION   2
+#define Z_CACHE_ALIGNMENT 64
+
+// The type tag of a chunk: a fixed string per element type (not typeid(), which differs between compilers).
+// Only the types declared here can be stored in a cache file.
+template <class T> struct ZCacheType;
+
+#define Z_CACHE_TYPE( T, tag ) template <> struct ZCacheType<T> { static const char* name() { return tag; } };
+
+Z_CACHE_TYPE( char,         "char"        )
+Z_CACHE_TYPE( int,          "int"         )
+Z_CACHE_TYPE( float,        "float"       )
+Z_CACHE_TYPE( double,       "double"      )
+Z_CACHE_TYPE( ZInt2,        "int2"        )
+Z_CACHE_TYPE( ZInt3,        "int3"        )
+Z_CACHE_TYPE( ZInt4,        "int4"        )
+Z_CACHE_TYPE( ZFloat2,      "float2"      )
+Z_CACHE_TYPE( ZFloat3,      "float3"      )
+Z_CACHE_TYPE( ZFloat4,      "float4"      )
+Z_CACHE_TYPE( ZVector,      "vector"      )
+Z_CACHE_TYPE( ZColor,       "color"       )
+Z_CACHE_TYPE( ZBoundingBox, "boundingBox" )
+
+struct ZCacheHeader
+{
+	char    magic[8];
+	int32_t version;
+	int32_t numChunks;
+	int64_t tableOffset;
+	int64_t fileSize;
+	char    reserved[32];
+};
+
+struct ZCacheChunkInfo
+{
+	char    name[64];		// the attribute name (null terminated)
+	char    type[32];		// ZCacheType<T>::name()
+	int64_t offset;			// the byte offset from the beginning of the file (64-byte aligned)
+	int64_t bytes;			// the byte size of the data
+	int32_t count;			// the number of the elements
+	int32_t elementSize;	// sizeof(T)
+	char    reserved[8];
+};
+
+/// @brief The writer of the chunked cache file.
+/**
+	Each add() appends a chunk, and close() writes the chunk table and completes the header.
+	The chunks are written to a temporary file in the same directory, and close() renames it over the target,
+	so the readers which map the previous file keep their (unchanged) data.
+	The file is not replaced until close() returns true.
+	abort() (or the destructor without close()) discards the temporary file and leaves the target as it was.
+*/
+class ZCacheWriter
+{
+	private:
+
+		ofstream                     _fout;
+		ZString                      _filePathName;
+		ZString                      _tempPathName;	// the file actually written until close()
+		std::vector<ZCacheChunkInfo> _chunks;
+
+	public:
+
+		ZCacheWriter();
+		ZCacheWriter( const char* filePathName );
+
+		~ZCacheWriter();
+
+		bool open( const char* filePathName );
+		bool close();
+
+		// It discards everything written since open().
+		void abort();
+
+		bool isOpened() const;
+
+		// It writes count elements of elementSize bytes from data.
+		bool add( const char* name, const char* type, const void* data, int count, int elementSize );
+
+		template <class T>
+		bool add( const char* name, const ZArray<T>& array );
+
+		template <class T>
+		bool addValue( const char* name, const T& value );
+};
+
+/// @brief The reader of the chunked cache file.
+/**
+	It maps the whole file as read-only shared memory, so nothing is read before being accessed,
+	and only the pages of the accessed attributes are loaded (lazily per attribute).
+	view() returns a zero-copy ZArrayView into the mapping, and read() copies it into a ZArray.
+	The views keep the mapping alive by themselves.
+*/
+class ZCacheReader
+{
+	private:
+
+		ZString                      _filePathName;
+		std::shared_ptr<const void>  _mapping;	// the mapped memory (unmapped when the last owner is gone)
+		const char*                  _base;
+		int64_t                      _fileSize;
+		std::vector<ZCacheChunkInfo> _chunks;
+
+	public:
+
+		ZCacheReader();
+		ZCacheReader( const char* filePathName );
+
+		bool open( const char* filePathName );
+		void close();
+
+		bool isOpened() const;
+
+		int numChunks() const;
+		const ZCacheChunkInfo& chunk( int i ) const;
+
+		// It returns NULL when there is no chunk of the name.
+		const ZCacheChunkInfo* find( const char* name ) const;
+
+		bool has( const char* name ) const;
+
+		// It asks the OS to start reading the pages of the chunk in background.
+		void prefetch( const char* name ) const;
+
+		// zero-copy
+		template <class T>
+		bool view( const char* name, ZArrayView<T>& view ) const;
+
+		// copy
+		template <class T>
+		bool read( const char* name, ZArray<T>& array ) const;
+
+		template <class T>
+		bool readValue( const char* name, T& value ) const;
+
+		double usedMemorySize( ZDataUnit::DataUnit dataUnit=ZDataUnit::zBytes ) const;
+
+	private:
+
+		const ZCacheChunkInfo* _find( const char* name, const char* type, int elementSize, const char* func ) const;
+};
+
+template <class T>
+inline bool
+ZCacheWriter::add( const char* name, const ZArray<T>& array )
+{
+	return ZCacheWriter::add( name, ZCacheType<T>::name(), array.empty() ? 0 : (const void*)&array[0], array.length(), sizeof(T) );
+}
+
+template <class T>
+inline bool
+ZCacheWriter::addValue( const char* name, const T& value )
+{
+	return ZCacheWriter::add( name, ZCacheType<T>::name(), (const void*)&value, 1, sizeof(T) );
+}
+
+template <class T>
+inline bool
+ZCacheReader::view( const char* name, ZArrayView<T>& view ) const
+{
+	const ZCacheChunkInfo* info = _find( name, ZCacheType<T>::name(), sizeof(T), "view" );
+
+	if( !info ) { view.reset(); return false; }
+
+	view = ZArrayView<T>( (const T*)( _base + info->offset ), info->count, _mapping );
+
+	return true;
+}
+
+template <class T>
+inline bool
+ZCacheReader::read( const char* name, ZArray<T>& array ) const
+{
+	ZArrayView<T> v;
+
+	if( !ZCacheReader::view( name, v ) ) { array.clear(); return false; }
+
+	v.copyTo( array );
+
+	return true;
+}
+
+template <class T>
+inline bool
+ZCacheReader::readValue( const char* name, T& value ) const
+{
+	const ZCacheChunkInfo* info = _find( name, ZCacheType<T>::name(), sizeof(T), "readValue" );
+	if( !info || ( info->count != 1 ) ) { return false; }
+
+	memcpy( (char*)&value, _base + info->offset, sizeof(T) );
+
+	return true;
+}
+
+ZELOS_NAMESPACE_END
+
+#endif
+
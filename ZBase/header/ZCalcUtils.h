@@ -609,7 +609,7 @@ ClosestPointOnTriangle( cZP& P, cZP& A, cZP& B, cZP& C, ZFloat3& baryCoords )
 				s = ZClamp( numer/denom, 0.f, 1.f );
 				t = 1-s;
 			} else {
-				s = ZClamp( -e/c, 0.f, 1.f );
+				s = ZClamp( -d/a, 0.f, 1.f );
 				t = 0.f;
 			}
 		} else {
@@ -0,0 +1,54 @@
+//-------------//
+// ZCellType.h //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.30                               //
+//-------------------------------------------------------//
+
+#ifndef _ZCellType_h_
+#define _ZCellType_h_
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+/// @brief The cell types of a ZMarkerField3D for the pressure projection.
+class ZCellType
+{
+	public:
+
+		enum CellType
+		{
+			zAir   = 0, ///< air (Dirichlet)
+			zFluid = 1, ///< fluid (unknown)
+			zSolid = 2  ///< solid (Neumann)
+		};
+
+	public:
+
+		ZCellType() {}
+
+		static ZString name( ZCellType::CellType type )
+		{
+			switch( type )
+			{
+				default:
+				case ZCellType::zAir  : { return ZString("air");   }
+				case ZCellType::zFluid: { return ZString("fluid"); }
+				case ZCellType::zSolid: { return ZString("solid"); }
+			}
+		}
+};
+
+inline ostream&
+operator<<( ostream& os, const ZCellType& object )
+{
+	os << "<ZCellType>" << endl;
+	os << endl;
+	return os;
+}
+
+ZELOS_NAMESPACE_END
+
+#endif
+
@@ -3,7 +3,7 @@
 //-------------------------------------------------------//
 // author: Wanho Choi @ Dexter Studios                   //
 //         Jinhyuk Bae @ Dexter Studios                  //
-// last update: 2015.10.07                               //
+// last update: 2019.03.30                               //
 //-------------------------------------------------------//
 
 #ifndef _ZCurlNoise_h_
@@ -13,18 +13,24 @@
 
 ZELOS_NAMESPACE_BEGIN
 
+/// @brief The divergence-free velocity as the curl of the potential ZSimplexNoise::vector().
+/**
+	The curl is computed from the analytic derivatives of the simplex noise (no finite differences),
+	so it has no step size to tune and it is divergence-free up to the float rounding.
+*/
 class ZCurlNoise : public ZSimplexNoise
 {
-	private:
-
-		float _delta;
-		float _denom;
-
 	public:
 
 		ZCurlNoise();
-	
-		ZVector velocity( float x, float y, float z, float t );
+
+		ZVector velocity( float x, float y, float z, float t ) const;
+
+		// velocities[i] = velocity( p.x, p.y, p.z, t ) (four points at once by SSE if available)
+		void velocity( const ZPointArray& points, float t, ZVectorArray& velocities, bool useOpenMP=true ) const;
+
+		// the kernel of the batch function for the four points (x[i],y[i],z[i]) without any threading
+		void velocity4( const float x[4], const float y[4], const float z[4], float t, float vx[4], float vy[4], float vz[4] ) const;
 };
 
 ostream&
@@ -18,6 +18,10 @@ ZELOS_NAMESPACE_BEGIN
 // t: curve parameter
 //
 // cv(i,j) = position(t=j/(numCVs(i)-1))
+//
+// The arc length table is optional and has to be built by buildArcLengthTable().
+// It is invalidated by the member functions which change the CVs.
+// If the CVs are modified directly through the references (cv(), cvs(), operator[], ...), call invalidateArcLengthTable().
 class ZCurves
 {
 	private:
@@ -27,6 +31,10 @@ class ZCurves
 		ZIntArray    _startIdx;		// start index of each curve (not to be saved)
 		ZPointArray  _cv;			// control vertex positions  (to be saved)
 
+		int          _arcSubSteps;	// # of table samples per segment (0: no table)
+		ZIntArray    _arcStartIdx;	// start index of each curve in _arcLength
+		ZFloatArray  _arcLength;	// cumulative arc lengths at t=k/(numSegments(i)*_arcSubSteps)
+
 	public:
 
 		ZCurves();
@@ -95,6 +103,16 @@ class ZCurves
 		float lineLength( int i ) const;
 		void getLineLengths( ZFloatArray& curveLengths, bool useOpenMP=true ) const;
 
+		void buildArcLengthTable( int subSteps=8, bool useOpenMP=true );
+		void invalidateArcLengthTable();
+		bool hasArcLengthTable() const;
+
+		float arcLength( int i ) const;
+		float paramFromLength( int i, float s ) const;
+		float lengthFromParam( int i, float t ) const;
+
+		void resample( ZCurves& result, int nCVs=-1, bool useOpenMP=true ) const;
+
         ZBoundingBox boundingBox( int i ) const;
 
 		ZBoundingBox boundingBox( bool onlyEndPoints=false, bool useOpenMP=true ) const;
@@ -109,6 +127,11 @@ class ZCurves
 		bool save( const char* filePathName ) const;
 		bool load( const char* filePathName );
 
+		// the chunked cache file of ZCacheFile.h
+		// (loadCache() copies the arrays into the members; ZCacheReader::view() reads them from the file without any copy.)
+		bool saveCache( const char* filePathName ) const;
+		bool loadCache( const char* filePathName );
+
 		double usedMemorySize( ZDataUnit::DataUnit dataUnit=ZDataUnit::zBytes ) const;
 
 		void glPoints( int i, int j ) const;
@@ -132,6 +155,12 @@ class ZCurves
 
 		void _whereIsIt( int i, float& t, int index[4] ) const;
 
+		void _computeArcLengths( int i, int subSteps, float* L ) const;
+		void _resample( int i, int subSteps, const float* L, ZPoint* p, int n ) const;
+
+		static float _paramFromLength( const float* L, int m, float s );
+		static float _lengthFromParam( const float* L, int m, float t );
+
 		ZPoint  _zeroDerivative   ( float t, const ZPoint& P0, const ZPoint& P1, const ZPoint& P2, const ZPoint& P3 ) const;
 		ZVector _firstDerivative  ( float t, const ZPoint& P0, const ZPoint& P1, const ZPoint& P2, const ZPoint& P3 ) const;
 		ZVector _secondDerivative ( float t, const ZPoint& P0, const ZPoint& P1, const ZPoint& P2, const ZPoint& P3 ) const;
@@ -272,6 +301,12 @@ ZCurves::tip( const int& i ) const
 	return _cv[ _startIdx[i] + _numCVs[i] - 1 ];
 }
 
+inline bool
+ZCurves::hasArcLengthTable() const
+{
+	return ( _arcSubSteps > 0 );
+}
+
 inline void
 ZCurves::_whereIsIt( int i, float& t, int idx[4] ) const
 {
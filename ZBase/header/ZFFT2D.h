@@ -0,0 +1,77 @@
+//----------//
+// ZFFT2D.h //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.30                               //
+//-------------------------------------------------------//
+
+#ifndef _ZFFT2D_h_
+#define _ZFFT2D_h_
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+/// @brief The 2D complex FFT (fast Fourier transform) of the power-of-two sizes.
+/**
+	The data are Nx*Nz complex numbers where the element (i,k) is data[i+Nx*k] (the same as the cell-located ZComplexField2D).
+	forward(): X(u,v) = sum_{i,k} x(i,k) exp( -2*pi*I*(u*i/Nx+v*k/Nz) )
+	inverse(): x(i,k) = sum_{u,v} X(u,v) exp( +2*pi*I*(u*i/Nx+v*k/Nz) ) (divided by Nx*Nz only when normalize is true)
+	The frequencies are in the standard order: u=0,1,...,Nx/2-1,-Nx/2,...,-1.
+	It is the iterative radix-2 Cooley-Tukey transform with the twiddle factors and the bit-reversal tables precomputed by set().
+	The rows are transformed in parallel one by one, and the columns in parallel by the blocks of adjacent columns:
+	a block is copied into a small buffer (in the bit-reversed order), transformed there, and copied back,
+	so each butterfly works on contiguous memory which stays in the cache.
+	A plan can be shared by threads since forward()/inverse() don't modify it.
+*/
+class ZFFT2D
+{
+	private:
+
+		int           _nx, _nz;
+		ZComplexArray _wx, _wz;		// exp(-2*pi*I*j/N) (j=0,...,N/2-1)
+		ZIntArray     _rx, _rz;		// the bit-reversal permutations
+
+	public:
+
+		ZFFT2D();
+		ZFFT2D( int Nx, int Nz );
+
+		void reset();
+
+		// It returns false if Nx or Nz is not a power of two.
+		bool set( int Nx, int Nz );
+
+		int nx() const { return _nx; }
+		int nz() const { return _nz; }
+
+		void forward( ZComplex* data, bool useOpenMP=true ) const;
+		void inverse( ZComplex* data, bool normalize=true, bool useOpenMP=true ) const;
+
+		// The field must be cell-located and have the same resolution as this plan.
+		bool forward( ZComplexField2D& field, bool useOpenMP=true ) const;
+		bool inverse( ZComplexField2D& field, bool normalize=true, bool useOpenMP=true ) const;
+
+		double usedMemorySize( ZDataUnit::DataUnit dataUnit=ZDataUnit::zBytes ) const;
+
+		static bool isPowerOfTwo( int n );
+
+	private:
+
+		void _transform( ZComplex* data, bool inverse, float scale, bool useOpenMP ) const;
+		bool _check( const ZComplexField2D& field, const char* funcName ) const;
+};
+
+inline bool
+ZFFT2D::isPowerOfTwo( int n )
+{
+	return ( ( n > 0 ) && !( n & (n-1) ) );
+}
+
+ostream&
+operator<<( ostream& os, const ZFFT2D& object );
+
+ZELOS_NAMESPACE_END
+
+#endif
+
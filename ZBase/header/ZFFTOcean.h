@@ -0,0 +1,144 @@
+//-------------//
+// ZFFTOcean.h //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.30                               //
+//-------------------------------------------------------//
+
+#ifndef _ZFFTOcean_h_
+#define _ZFFTOcean_h_
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+/// @brief The CPU ocean surface by the FFT of a wave spectrum (Tessendorf, "Simulating Ocean Water").
+/**
+	Each cascade is a periodic square patch of resolution*resolution cells, and its size is patchSize/cascadeRatio^c.
+	The cascades share the wave numbers in bands (no wave is counted twice), so they can be summed up by sample().
+	The initial spectrum h0(k) is built from the directional spectrum Psi(k) (the variance per unit area of the wave vectors):
+	h0(k) = amplitude * sqrt(Psi(k)*dk*dk) * (xi_r+I*xi_i) / 2 (xi_r,xi_i: the Gaussian random numbers of each wave vector),
+	where Psi(k) = S(k) * D(theta) * exp(-k^2*l^2), D: the cos^(2s)(theta/2) spreading around the wind direction, l: smallWaveCutoff.
+	The random numbers depend only on the seed, the cascade and the wave vector (not on the resolution).
+	The angular frequencies follow the finite depth dispersion w^2 = g*k*tanh(k*depth) (deep water when depth<=0),
+	and they are rounded down to the multiples of 2*pi/repeatPeriod when repeatPeriod>0 to make the ocean loop.
+	update() rebuilds h0(k) and w(k) only when the spectrum parameters are changed (time-only re-evaluation otherwise),
+	and h(k,t) = h0(k)*exp(I*w*t) + conj(h0(-k))*exp(-I*w*t) and its derivatives are transformed by four inverse FFTs:
+	each complex FFT gives two real fields (the Hermitian spectra A and B are packed into A+I*B).
+	The outputs are cell-located on [0,patchSize]x[0,patchSize] (y=0):
+	- displacement: (choppiness*Dx, h, choppiness*Dz) (D = -I*k/|k|*h: the horizontal displacement toward the crests)
+	- normal: the normal of the displaced surface
+	- jacobian: det(I+choppiness*grad(D)) (<0 where the surface folds over)
+	- foam: clamp(foamThreshold-jacobian,0,1), accumulated with the exponential decay of foamDecay per second (0: no accumulation)
+	Only choppiness, foamThreshold and foamDecay are applied without rebuilding the spectra.
+*/
+class ZFFTOcean
+{
+	private:
+
+		struct Cascade
+		{
+			float           patchSize;
+			float           kMin, kMax;		// the band of the wave numbers
+			ZComplexField2D h0;				// h0(k) (in the FFT order)
+			ZComplexField2D h0c;			// conj(h0(-k))
+			ZFloatArray     omega;			// w(k)
+			ZComplexField2D packed[4];		// (h,Dx), (Dz,dh/dx), (dh/dz,dDx/dx), (dDz/dz,dDx/dz)
+			ZVectorField2D  displacement;
+			ZVectorField2D  normal;
+			ZVectorField2D  slope;			// (dh/dx,0,dh/dz)
+			ZVectorField2D  gradient;		// (dDx/dx,dDx/dz,dDz/dz) * choppiness
+			ZScalarField2D  jacobian;
+			ZScalarField2D  foam;
+		};
+
+		std::vector<Cascade> _cascades;
+		ZFFT2D               _fft;
+
+		std::vector<double>  _builtKey;		// the spectrum parameters of the current cascades
+		float                _time;
+		bool                 _evaluated;
+
+	public:
+
+		ZOceanSpectrumType::OceanSpectrumType spectrumType;
+
+		int   resolution;			// the FFT size of each cascade (a power of two)
+		float patchSize;			// the size of the first (largest) cascade in meters
+		int   numCascades;			// the number of the cascades (1~4)
+		float cascadeRatio;			// the size ratio of the adjacent cascades (a non-integer hides the repetitions)
+		float windSpeed;			// in m/s (at 10 m above the sea)
+		float windDirection;		// in degrees (0: +x, 90: +z)
+		float fetch;				// the distance over which the wind blows in km (JONSWAP)
+		float peakEnhancement;		// gamma (JONSWAP)
+		float directionalSpread;	// s of cos^(2s)(theta/2) (larger: more aligned with the wind)
+		float smallWaveCutoff;		// l of exp(-k^2*l^2) in meters
+		float depth;				// in meters (<=0: deep water)
+		float amplitude;			// the height multiplier
+		float choppiness;			// the horizontal displacement multiplier
+		float repeatPeriod;			// in seconds (<=0: no loop)
+		float foamThreshold;		// the Jacobian below which it foams
+		float foamDecay;			// the decay rate of the accumulated foam per second
+		int   seed;
+
+	public:
+
+		ZFFTOcean();
+
+		void reset();
+
+		// It returns false when the parameters are invalid.
+		bool update( float time, bool useOpenMP=true );
+
+		float cascadePatchSize( int cascade ) const;
+		float time() const;
+
+		const ZComplexField2D& initialSpectrum( int cascade=0 ) const;
+		const ZVectorField2D&  displacement( int cascade=0 ) const;
+		const ZVectorField2D&  normal( int cascade=0 ) const;
+		const ZScalarField2D&  jacobian( int cascade=0 ) const;
+		const ZScalarField2D&  foam( int cascade=0 ) const;
+
+		// the sum of all the cascades at the rest position (x,z) (periodic)
+		void sample( const ZPoint& p, ZVector& displacement, ZVector& normal, float& jacobian ) const;
+		void sample( const ZPointArray& p, ZVectorArray& displacements, ZVectorArray& normals, ZFloatArray& jacobians, bool useOpenMP=true ) const;
+
+		double usedMemorySize( ZDataUnit::DataUnit dataUnit=ZDataUnit::zBytes ) const;
+
+	private:
+
+		std::vector<double> _key() const;
+		const Cascade& _cascade( int c ) const;
+
+		void _build( bool useOpenMP );
+		void _evaluate( Cascade& c, float time, float dt, bool useOpenMP );
+
+		float _spectrum( float k ) const;	// S(k)/k: Psi(k) without the spreading and the cutoff
+		float _omega( float k ) const;
+		float _dOmega( float k ) const;		// dw/dk
+
+		static ZVector _normal( const ZVector& slope, const ZVector& gradient );
+};
+
+inline float
+ZFFTOcean::time() const
+{
+	return _time;
+}
+
+inline ZVector
+ZFFTOcean::_normal( const ZVector& s, const ZVector& g )
+{
+	// Tz x Tx (Tx=(1+Dxx,dh/dx,Dxz), Tz=(Dxz,dh/dz,1+Dzz): the tangents of the displaced surface)
+	ZVector n( s.z*g.y - (1+g.z)*s.x, (1+g.z)*(1+g.x) - g.y*g.y, g.y*s.x - s.z*(1+g.x) );
+	n.normalize();
+	return n;
+}
+
+ostream&
+operator<<( ostream& os, const ZFFTOcean& object );
+
+ZELOS_NAMESPACE_END
+
+#endif
+
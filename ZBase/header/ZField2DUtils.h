@@ -3,7 +3,7 @@
 //-------------------------------------------------------//
 // author: Wanho Choi @ Dexter Studios                   //
 //         Nayoung Kim @ Dexter Studios                  //
-// last update: 2016.09.19                               //
+// last update: 2019.03.30                               //
 //-------------------------------------------------------//
 
 #ifndef _ZField2DUtils_h_
@@ -33,6 +33,9 @@ bool MapToField( const ZImageMap& img, ZVectorField2D& rgb, ZScalarField2D& cusp
 bool MapToVectorField( const ZImageMap& img, ZVectorField2D& field, bool useOpenMP=true );
 bool MapToScalarField( const ZImageMap& img, ZScalarField2D& field, int n, bool useOpenMP=true );
 
+// the image from ZImageCache::global() at the mip level lod (0: the original resolution)
+bool MapToScalarField( const char* imageFilePathName, ZScalarField2D& field, int n, int lod=0, bool useOpenMP=true );
+
 bool ArrayToField( const ZVectorArray& arr, ZVectorField2D& field, bool useOpenMP=true );
 
 void VectorFieldLerp( const ZPoint& p, const ZVectorField2D& field, ZVector& vec, float Lx, float Lz );
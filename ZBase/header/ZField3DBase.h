@@ -107,7 +107,13 @@ class ZField3DBase : public ZGrid3D
 			indices[25] = idx+jj+kk;  // (i  , j+1, k+1 );
 			indices[26] = idx+1+jj+kk;// (i+1, j+1, k+1 );
 		}
-		
+
+	protected:
+
+		// the batch interpolation of numComponents (1 or 3) interleaved floats per element at the points
+		// (the common part of ZScalarField3D::sample() and ZVectorField3D::sample())
+		bool _sample( const float* data, int numComponents, const ZPointArray& points, float* values,
+		              ZInterpolationType::InterpolationType type, bool useOpenMP ) const;
 };
 
 inline void 
@@ -15,6 +15,19 @@ ZELOS_NAMESPACE_BEGIN
 bool Gradient( ZVectorField3D& v, const ZScalarField3D& s, bool useOpenMP=true );
 bool Divergence( ZScalarField3D& s, const ZVectorField3D& v, bool useOpenMP=true );
 
+// the MacCormack advection with the RK2 back-tracing by a temporary ZAdvector3D
+// (Use a ZAdvector3D directly in a simulation loop to reuse its buffers.)
+// v and vel can be the same field.
+bool ZAdvect( ZScalarField3D& s, const ZVectorField3D& vel, float dt, bool useOpenMP=true );
+bool ZAdvect( ZVectorField3D& v, const ZVectorField3D& vel, float dt, bool useOpenMP=true );
+
+// v is set to the grid and the location of s, and only the tiles where the gradient can be non-zero are activated.
+bool Gradient( ZSparseVectorField3D& v, const ZSparseScalarField3D& s, bool useOpenMP=true );
+
+// s (zCell) must be on the grid of v (zNode), and the net flux of v out of each cell is added to s as the dense version does.
+// Only the tiles where the divergence can be non-zero are activated.
+bool Divergence( ZSparseScalarField3D& s, const ZSparseVectorField3D& v, bool useOpenMP=true );
+
 ZELOS_NAMESPACE_END
 
 #endif
@@ -0,0 +1,97 @@
+//-------------------//
+// ZFieldLattice3D.h //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.30                               //
+//-------------------------------------------------------//
+
+#ifndef _ZFieldLattice3D_h_
+#define _ZFieldLattice3D_h_
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+/// @brief The index space of the elements of a 3D field.
+/**
+	It is the common part of the trilinear gathers of ZField3DBase::_sample() and ZAdvector3D,
+	which work on the raw interleaved components (C floats per element) instead of the typed fields.
+	The positions are clamped into the domain, so a stencil is always inside.
+*/
+struct ZFieldLattice3D
+{
+	float ox, oy, oz;			// the world position of the element (0,0,0)
+	float dx, dy, dz;
+	float ddx, ddy, ddz;		// 1/dx, 1/dy, 1/dz
+	int   iMax, jMax, kMax;
+	int   s0, s1;				// the strides of j and k
+
+	ZFieldLattice3D()
+	{}
+
+	// (the cell or node location of f)
+	ZFieldLattice3D( const ZField3DBase& f );
+};
+
+// the lower corner element of the eight elements around a position and the fractions in them
+struct ZFieldStencil3D
+{
+	int   i, j, k;
+	int   base;				// the index of (i,j,k)
+	float fx, fy, fz;
+};
+
+inline void
+ZGetStencil( const ZFieldLattice3D& L, const ZPoint& p, ZFieldStencil3D& st )
+{
+	const float x = ZClamp( (p.x-L.ox)*L.ddx, 0.f, (float)L.iMax );
+	const float y = ZClamp( (p.y-L.oy)*L.ddy, 0.f, (float)L.jMax );
+	const float z = ZClamp( (p.z-L.oz)*L.ddz, 0.f, (float)L.kMax );
+
+	st.i = ZMin( (int)x, L.iMax-1 );
+	st.j = ZMin( (int)y, L.jMax-1 );
+	st.k = ZMin( (int)z, L.kMax-1 );
+
+	st.base = st.i + L.s0*st.j + L.s1*st.k;
+
+	st.fx = x - st.i;
+	st.fy = y - st.j;
+	st.fz = z - st.k;
+}
+
+// the trilinear interpolation of the C interleaved components of q around base
+// (It is branch-free and the same for all the components, so the compiler unrolls it for a constant C.)
+template <int C>
+inline void
+ZTrilerp( const float* q, const ZFieldLattice3D& L, int base, float fx, float fy, float fz, float* out )
+{
+	const float* q00 = q + C*base;
+	const float* q10 = q00 + C*L.s0;
+	const float* q01 = q00 + C*L.s1;
+	const float* q11 = q01 + C*L.s0;
+
+	FOR( c, 0, C )
+	{
+		const float x00 = q00[c] + fx * ( q00[C+c] - q00[c] );
+		const float x10 = q10[c] + fx * ( q10[C+c] - q10[c] );
+		const float x01 = q01[c] + fx * ( q01[C+c] - q01[c] );
+		const float x11 = q11[c] + fx * ( q11[C+c] - q11[c] );
+
+		const float y0 = x00 + fy * ( x10 - x00 );
+		const float y1 = x01 + fy * ( x11 - x01 );
+
+		out[c] = y0 + fz * ( y1 - y0 );
+	}
+}
+
+template <int C>
+inline void
+ZTrilerp( const float* q, const ZFieldLattice3D& L, const ZFieldStencil3D& st, float* out )
+{
+	ZTrilerp<C>( q, L, st.base, st.fx, st.fy, st.fz, out );
+}
+
+ZELOS_NAMESPACE_END
+
+#endif
+
@@ -0,0 +1,83 @@
+//---------------//
+// ZImageCache.h //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.30                               //
+//-------------------------------------------------------//
+
+#ifndef _ZImageCache_h_
+#define _ZImageCache_h_
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+/// @brief The thread-safe cache of the tiled mip-mapped images keyed by the file path.
+/**
+	get() decodes an image file only once as long as the file is not modified (the modification time and the size),
+	and the least recently used images are evicted when the total memory exceeds the budget.
+	The returned images are shared: they stay valid even after being evicted (or the cache is cleared).
+	When several threads ask for the same image at the same time, only one of them decodes it and the others wait for it.
+	global() is the process-wide cache which the density/remove maps of the scattering use.
+*/
+class ZImageCache
+{
+	private:
+
+		typedef std::shared_ptr<const ZTiledImage> Image;
+
+		struct Entry
+		{
+			std::shared_future<Image>      image;
+			int64_t                        id;		// to tell the decoding thread if it was replaced
+			time_t                         mtime;
+			int64_t                        fileSize;
+			double                         bytes;	// 0 while being decoded
+			std::list<ZString>::iterator   lru;		// the position in _lru
+		};
+
+		std::map<ZString,Entry> _entries;
+		std::list<ZString>      _lru;			// the most recently used first
+
+		double                  _budget;		// in bytes
+		double                  _usedBytes;
+
+		int                     _numHits;
+		int                     _numMisses;
+		int64_t                 _nextId;
+
+		mutable std::mutex      _mutex;
+
+	public:
+
+		ZImageCache( double memoryBudgetInMegabytes=4096.0 );
+
+		static ZImageCache& global();
+
+		// It returns NULL when the file cannot be loaded.
+		std::shared_ptr<const ZTiledImage> get( const char* filePathName );
+
+		void setMemoryBudget( double memoryBudgetInMegabytes );
+		double memoryBudget() const; // in megabytes
+
+		void erase( const char* filePathName );
+		void clear();
+
+		int numImages() const;
+		int numHits() const;
+		int numMisses() const;
+
+		double usedMemorySize( ZDataUnit::DataUnit dataUnit=ZDataUnit::zBytes ) const;
+
+	private:
+
+		void _evict(); // (with _mutex locked)
+};
+
+ostream&
+operator<<( ostream& os, const ZImageCache& object );
+
+ZELOS_NAMESPACE_END
+
+#endif
+
@@ -0,0 +1,64 @@
+//-----------------------//
+// ZIncompleteCholesky.h //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.27                               //
+//-------------------------------------------------------//
+
+#ifndef _ZIncompleteCholesky_h_
+#define _ZIncompleteCholesky_h_
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+/// @brief Level-scheduled IC(0)/MIC(0) preconditioner of a symmetric sparse matrix.
+/**
+	M = (E+L) E^{-2} (E+L)^T, where L is the strictly lower part of A and E is the diagonal ("Fluid Simulation for Computer Graphics" p.72).
+	The modified version (MIC) moves the dropped fill-ins to the diagonal by the factor tau.
+	It is the exact IC(0)/MIC(0) when the graph of A has no triangles like the 5-point and 7-point Laplacians.
+	The rows are grouped into the levels (wavefronts) where no row depends on the other ones of the same level,
+	so the factorization and the triangular solves run in parallel per level and give the same result for any number of threads.
+	The entries out of the matrix or with zero values are ignored, and the rows with non-positive diagonals are treated as empty.
+*/
+class ZIncompleteCholesky
+{
+	private:
+
+		int         _m;
+
+		ZIntArray   _lr, _lc;		// the strictly lower part of A (CSR)
+		ZFloatArray _lv;
+		ZIntArray   _ur, _uc;		// the strictly upper part of A (CSR)
+		ZFloatArray _uv;
+
+		ZFloatArray _precon;		// 1/E
+
+		ZIntArray   _levelStart;	// the start index of each level in _levelRows (length: numLevels+1)
+		ZIntArray   _levelRows;		// the rows sorted by the level
+
+		ZFloatArray _q;				// the intermediate result of the forward substitution
+
+		bool _useOpenMP;
+
+	public:
+
+		ZIncompleteCholesky();
+
+		void reset();
+
+		// modified: MIC(0) if true, IC(0) otherwise
+		// tau: the fraction of the dropped fill-ins added to the diagonal for MIC(0)
+		// sigma: the diagonal falls back to the one of A when it gets smaller than sigma times of it
+		bool build( const ZSparseMatrix<float>& A, bool modified=true, float tau=0.97f, float sigma=0.25f, bool useOpenMP=true );
+
+		int numLevels() const;
+
+		// z = M^{-1} r
+		void apply( const ZFloatArray& r, ZFloatArray& z );
+};
+
+ZELOS_NAMESPACE_END
+
+#endif
+
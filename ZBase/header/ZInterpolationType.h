@@ -0,0 +1,64 @@
+//----------------------//
+// ZInterpolationType.h //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.30                               //
+//-------------------------------------------------------//
+
+#ifndef _ZInterpolationType_h_
+#define _ZInterpolationType_h_
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+// zLinear
+// the trilinear interpolation of the 2x2x2 elements (lerp())
+
+// zCatmullRom
+// the tricubic Catmull-Rom spline of the 4x4x4 elements (catrom()): smoother, but it may overshoot
+
+// zMonotonicCubic
+// the tricubic Hermite spline of the 4x4x4 elements whose slopes are zeroed at the extrema (mcerp()): no overshoots
+
+class ZInterpolationType
+{
+	public:
+
+		enum InterpolationType
+		{
+			zNone           = 0,
+			zLinear         = 1,
+			zCatmullRom     = 2,
+			zMonotonicCubic = 3
+		};
+
+	public:
+
+		ZInterpolationType() {}
+
+		static ZString name( ZInterpolationType::InterpolationType interpolationType )
+		{
+			switch( interpolationType )
+			{
+				default:
+				case ZInterpolationType::zNone:           { return ZString("none");           }
+				case ZInterpolationType::zLinear:         { return ZString("linear");         }
+				case ZInterpolationType::zCatmullRom:     { return ZString("Catmull-Rom");    }
+				case ZInterpolationType::zMonotonicCubic: { return ZString("monotonic cubic"); }
+			}
+		}
+};
+
+inline ostream&
+operator<<( ostream& os, const ZInterpolationType& object )
+{
+	os << "<ZInterpolationType>" << endl;
+	os << endl;
+	return os;
+}
+
+ZELOS_NAMESPACE_END
+
+#endif
+
@@ -3,7 +3,7 @@
 //-------------------------------------------------------//
 // author: Wanho Choi @ Dexter Studios                   //
 //         Jinhyuk Bae @ Dexter Studios                  //
-// last update: 2015.10.07                               //
+// last update: 2019.03.30                               //
 //-------------------------------------------------------//
 
 #ifndef _ZKmeanClustering_h_
@@ -13,6 +13,14 @@
 
 ZELOS_NAMESPACE_BEGIN
 
+/// @brief k-means clustering of a point set.
+/**
+	run() is Lloyd's algorithm accelerated by Hamerly's bounds: each point keeps an upper bound of the distance to its center
+	and a lower bound of the distance to the second closest one, so most of the points skip the distance computations after
+	the first few iterations. runMiniBatch() updates the centers from the random batches of points (Sculley 2010) for very large sets.
+	When the initial positions are not given, the centers are seeded by k-means|| (the parallel version of k-means++).
+	The results depend only on the random seed, not on the number of threads.
+*/
 class ZKmeanClustering
 {
 	public:
@@ -21,30 +29,47 @@ class ZKmeanClustering
 		void reset();
 
 		void setPointSet( ZPoint* posArray, int numPtc );
-		void run( int numClustering, float tolerance=0.01, int maxIter=1000, const ZPointArray& initPos=ZPointArray() );
+		void setRandomSeed( unsigned int seed );
 
-		void getClusterNum( ZIntArray& numArray );	// # of points of each cluster 
+		void run( int numClustering, float tolerance=0.01, int maxIter=1000, const ZPointArray& initPos=ZPointArray(), bool useOpenMP=true );
+		void runMiniBatch( int numClustering, int batchSize, int maxIter=100, const ZPointArray& initPos=ZPointArray(), bool useOpenMP=true );
+
+		// k-means|| seeding (used by run() and runMiniBatch() when initPos is not given)
+		void seed( int numClustering, ZPointArray& centers, bool useOpenMP=true ) const;
+
+		int numClusters() const;
+		int numIterations() const;
+
+		void getClusterNum( ZIntArray& numArray );	// # of points of each cluster
 		void getClusterId(  ZIntArray& idArray );	// id of cluster of each points
-		void getPointIndex( int k, ZIntArray& idArray );  // id array of each cluster 
-		void getCenterPos( ZPointArray& centerPosArray ); // center pos of each cluster 
+		void getPointIndex( int k, ZIntArray& idArray );  // id array of each cluster
+		void getCenterPos( ZPointArray& centerPosArray ); // center pos of each cluster
 		void getCenterPos( int k, ZPoint& centerPos ); // center pos of each cluster
 		void getCovMatrix( int k, ZMatrix& covMatrix ); // get covariance matrix
 
 
-	private: 
-	
+	private:
+
 		ZPoint* 			_points;
 
 		ZIntArray			_clusterId;			// id for cluster  			( # of _clusterId == # of points  )
 		ZIntArray			_numPtcEachCluster; // size of each cluster 	( # of _numPtcEachCluster == # of cluster )
 		vector<ZIntArray>	_pointId;			// id array of each cluster ( size of vector == # of cluster )
-		
+		vector<ZMatrix>		_covMatrix;			// covariance matrix of each cluster ( size of vector == # of cluster )
+
 		ZPointArray			_centerPos;			// center position ( # of _centerPos == # of cluster )
-		ZPointArray			_centerPosNew;		// center position ( # of _centerPos == # of cluster )
 
 		float				_tolerance;
 		int					_maxIter;
 		int					_numPtc;
+		int					_numIter;
+		unsigned int		_seed;
+
+	private:
+
+		void _initCenters( int numK, const ZPointArray& initPos, bool useOpenMP );
+		void _assignAll( bool useOpenMP );
+		void _finalize( bool useOpenMP );
 };
 
 ostream&
@@ -3,7 +3,7 @@
 //-------------------------------------------------------//
 // author: Jaegwang Lim @ Dexter Studios                 //
 //         Wanho Choi @ Dexter Studios                   //
-// last update: 2016.06.20                               //
+// last update: 2019.03.29                               //
 //-------------------------------------------------------//
 
 #ifndef _ZLinearSystemSolver_h_
@@ -17,7 +17,8 @@ class ZLinearSystemSolver
 {
     private:  
 
-        ZFloatArray  t, r, z, r0, z0, p, Ap;        
+        ZFloatArray  r, z, p, Ap, invD;
+        std::vector<double> partial;    // the per thread partial sums of SumOverThreads()
         
     public:
     
@@ -25,113 +26,396 @@ class ZLinearSystemSolver
         int maxIterations;
         int curIterations;
 
+        // the convergence statistics of the last MGPCG(), ICPCG(), and MG()
+        float initialResidual;  // |b-Ax| before the iterations
+        float finalResidual;    // |b-Ax| after the iterations
+        float convergenceRate;  // the average reduction ratio of the residual per iteration
+        bool  converged;        // whether it reached the tolerance
+
     public:
-        void CG       ( const ZSparseMatrix<float>& A, ZFloatArray& x, const ZFloatArray& b, const int maxIter=300 );
-        void PCG      ( const ZSparseMatrix<float>& A, ZFloatArray& x, const ZFloatArray& b, const int maxIter=300 );
+        ZLinearSystemSolver();
+
+        // MATRIX: ZSparseMatrix<float>, ZSellMatrix, or ZLaplacianOperator (see the kernels of ZSolverKernels.h)
+        // x and b can be ZScalarField3D's of the grid of ZLaplacianOperator.
+        // Each iteration of CG() and PCG() runs in a single parallel region with the fused kernels of ZSolverKernels.h.
+        // The work arrays are kept between the solves.
+        // They stop when the updated residual |r| drops below 1e-6 (absolute). For a large system this is below the float
+        // round-off of the true residual |b-Ax|, so the stopping iteration depends on the rounding of the dot products.
+        // (The kernels keep the dot products in double, so the count can differ by a few iterations from the loop of
+        //  the helpers of ZSparseMatrixUtils.h, which rounds them to float, while |b-Ax| agrees.)
+        template <class MATRIX>
+        void CG       ( const MATRIX& A, ZFloatArray& x, const ZFloatArray& b, const int maxIter=300 );
+        template <class MATRIX>
+        void PCG      ( const MATRIX& A, ZFloatArray& x, const ZFloatArray& b, const int maxIter=300 );
         void Jacobian ( const ZSparseMatrix<float>& A, ZFloatArray& x, const ZFloatArray& b, const int maxIter=300 ){};
         void Gaussian ( const ZSparseMatrix<float>& A, ZFloatArray& x, const ZFloatArray& b, const int maxIter=300 ){};
+
+        // PCG with the V-cycle of the multigrid or the incomplete Cholesky as the preconditioner
+        // The preconditioner must be built from A in advance, and the tolerance is relative to |b|.
+        template <class MATRIX>
+        void MGPCG    ( const MATRIX& A, ZFloatArray& x, const ZFloatArray& b, ZMultigrid& mg, const int maxIter=300, const float tolerance=1e-6f );
+        template <class MATRIX>
+        void ICPCG    ( const MATRIX& A, ZFloatArray& x, const ZFloatArray& b, ZIncompleteCholesky& ic, const int maxIter=300, const float tolerance=1e-6f );
+
+        // the standalone multigrid solver (repeated V-cycles)
+        template <class MATRIX>
+        void MG       ( const MATRIX& A, ZFloatArray& x, const ZFloatArray& b, ZMultigrid& mg, const int maxIter=100, const float tolerance=1e-6f );
+
+    private:
+        template <class MATRIX, class PRECONDITIONER>
+        void _PCG     ( const MATRIX& A, ZFloatArray& x, const ZFloatArray& b, PRECONDITIONER& M, const int maxIter, const float tolerance );
+
+        // It sizes the work arrays (without clearing) and returns the partial sum buffer.
+        double* _prepare( ZFloatArray& x, int N );
+
+        // r = b - Ax, and it returns |r|.
+        template <class MATRIX>
+        double _residual( const MATRIX& A, const ZFloatArray& x, const ZFloatArray& b );
+
+        void _setStatistics( double r0, double r1, int iterations, int maxIter, double threshold );
 };
 
-inline void 
-ZLinearSystemSolver::CG( const ZSparseMatrix<float>& A, ZFloatArray& x, const ZFloatArray& b, const int maxIter )
+inline
+ZLinearSystemSolver::ZLinearSystemSolver()
+: maxIterations(0), curIterations(0), initialResidual(0), finalResidual(0), convergenceRate(0), converged(false)
+{}
+
+template <class MATRIX>
+inline void
+ZLinearSystemSolver::CG( const MATRIX& A, ZFloatArray& x, const ZFloatArray& b, const int maxIter )
 {    
-    Multiply(A, x, t);
-    Subtract(b, t, r);
-    Equal(r, p);
-    
-    float denom(0.0);
-    float rsold(0.0);
-    Multiply(r, r, rsold);
-    
-    if(sqrt(rsold) < 1e-6) return;
-    
-    const int numIter = std::min(maxIter, (int)b.size()*2);
-    
+    ZPROFILE_SCOPE( "ZLinearSystemSolver::CG" );
+
+    const int N = b.length();
+    if( N < 1 ) { return; }
+
+    double* sums = _prepare( x, N );
+
+    const int numIter = std::min(maxIter, N*2);
+
     int it = 0;
-    for(; it<numIter; it++)
+
+    #pragma omp parallel
     {
-        Multiply(A, p, Ap);
-        
-        float alpha(0.0);
-        Multiply(p, Ap, denom);
-        alpha = rsold / denom;
-        
-        Multiply(p, alpha, t);
-        Add(x, t, x);
-        
-        Multiply(Ap, alpha, t);
-        Subtract(r, t, r);
-        
-        float rsnew(0.0);
-        Multiply(r, r, rsnew);
-        
-        if(sqrt(rsnew) < 1e-6) break;
-        
-        Multiply(p, rsnew/rsold, t);
-        Add(r, t, p);
-        
-        rsold = rsnew;
-    }   
-    
+        int i0, i1;
+        GetThreadRange( N, i0, i1 );
+
+        // r = b - Ax, p = r
+        double rsold = SumOverThreads( ResidualDotKernel( A, &x[0], &b[0], &r[0], i0, i1 ), sums );
+        memcpy( (char*)&p[i0], (char*)&r[i0], (i1-i0)*sizeof(float) );
+
+        int k = 0;
+
+        if( sqrt(rsold) >= 1e-6 )
+        {
+            for(; k<numIter; k++)
+            {
+                #pragma omp barrier // p must be complete before the SpMV.
+
+                // Ap = A*p, pAp = p.Ap
+                const double pAp = SumOverThreads( SpMVDotKernel( A, &p[0], &Ap[0], i0, i1 ), sums );
+
+                const float alpha = (float)( rsold / pAp );
+
+                // x += alpha*p, r -= alpha*Ap, rsnew = r.r
+                const double rsnew = SumOverThreads( AxpyDotKernel( alpha, &p[0], &Ap[0], &x[0], &r[0], i0, i1 ), sums );
+
+                if( sqrt(rsnew) < 1e-6 ) break;
+
+                // p = r + beta*p
+                XpbyKernel( &r[0], (float)( rsnew / rsold ), &p[0], i0, i1 );
+
+                rsold = rsnew;
+            }
+        }
+
+        #pragma omp single
+        it = k;
+    }
+
     maxIterations = numIter;
     curIterations = it;    
 }
 
-inline void 
-ZLinearSystemSolver::PCG( const ZSparseMatrix<float>& A, ZFloatArray& x, const ZFloatArray& b, const int maxIter )
+template <class MATRIX>
+inline void
+ZLinearSystemSolver::PCG( const MATRIX& A, ZFloatArray& x, const ZFloatArray& b, const int maxIter )
 {    
-    Multiply(A, x, t);
-    Subtract(b, t, r);
-    
-    float denom(0.0);
-    
-    InverseDiagonalMultiply(A, r, z);    
-    Equal(z, p);       
-    
-    float rsold(0.0);
-    Multiply(z, z, rsold);
-    
-    if(sqrt(rsold) < 1e-6) return;    
-    
-    const int numIter = std::min(maxIter, (int)b.size()*2);
-    
-    int it =0;
-    for(;it<numIter; it++)
+    ZPROFILE_SCOPE( "ZLinearSystemSolver::PCG" );
+
+    const int N = b.length();
+    if( N < 1 ) { return; }
+
+    double* sums = _prepare( x, N );
+
+    invD.setLength( N, false );
+
+    const int numIter = std::min(maxIter, N*2);
+
+    int it = 0;
+
+    #pragma omp parallel
     {
-        Equal(z, z0);
-        Equal(r, r0);
-        
-        float alpha(0.0);
-        Multiply(r, z, alpha );        
-        Multiply(A, p, Ap    );
-        Multiply(p, Ap, denom);        
-        alpha = alpha / denom;
-        
-        Multiply(p, alpha, t);
-        Add(x, t, x);
-        
-        Multiply(Ap, alpha, t);
-        Subtract(r, t, r);
-        
-        float rs(0.0);
-        Multiply(r, r, rs);
-        if(sqrt(rs) < 1e-06) break;
-        
-        InverseDiagonalMultiply(A, r, z);
-        
-        float beta(0.0);
-        Multiply(z , r , beta );
-        Multiply(z0, r0, denom);
-        beta = beta / denom;
-        
-        Multiply(p, beta, t);
-        Add(z, t, p);
+        int i0, i1;
+        GetThreadRange( N, i0, i1 );
+
+        InverseDiagonalKernel( A, &invD[0], i0, i1 );
+
+        // r = b - Ax, z = D^{-1}r, p = z
+        ResidualDotKernel( A, &x[0], &b[0], &r[0], i0, i1 );
+
+        #pragma omp barrier // r may be written by the other threads (ZSellMatrix).
+
+        double rz=0, zz=0;
+        ScaleDotKernel( &invD[0], &r[0], &z[0], i0, i1, rz, zz );
+        SumOverThreads( rz, zz, sums );
+
+        memcpy( (char*)&p[i0], (char*)&z[i0], (i1-i0)*sizeof(float) );
+
+        int k = 0;
+
+        if( sqrt(zz) >= 1e-6 )
+        {
+            for(; k<numIter; k++)
+            {
+                #pragma omp barrier // p must be complete before the SpMV.
+
+                // Ap = A*p, pAp = p.Ap
+                const double pAp = SumOverThreads( SpMVDotKernel( A, &p[0], &Ap[0], i0, i1 ), sums );
+
+                const float alpha = (float)( rz / pAp );
+
+                // x += alpha*p, r -= alpha*Ap, z = D^{-1}r, rzNew = r.z, rs = r.r
+                double rzNew=0, rs=0;
+                AxpyScaleDotKernel( alpha, &p[0], &Ap[0], &invD[0], &x[0], &r[0], &z[0], i0, i1, rzNew, rs );
+                SumOverThreads( rzNew, rs, sums );
+
+                if( sqrt(rs) < 1e-06 ) break;
+
+                // p = z + beta*p
+                XpbyKernel( &z[0], (float)( rzNew / rz ), &p[0], i0, i1 );
+
+                rz = rzNew;
+            }
+        }
+
+        #pragma omp single
+        it = k;
     }
-    
+
     maxIterations = numIter;
     curIterations = it;
 }
 
+template <class MATRIX>
+inline void
+ZLinearSystemSolver::MGPCG( const MATRIX& A, ZFloatArray& x, const ZFloatArray& b, ZMultigrid& mg, const int maxIter, const float tolerance )
+{
+    ZPROFILE_SCOPE( "ZLinearSystemSolver::MGPCG" );
+
+    _PCG( A, x, b, mg, maxIter, tolerance );
+}
+
+template <class MATRIX>
+inline void
+ZLinearSystemSolver::ICPCG( const MATRIX& A, ZFloatArray& x, const ZFloatArray& b, ZIncompleteCholesky& ic, const int maxIter, const float tolerance )
+{
+    ZPROFILE_SCOPE( "ZLinearSystemSolver::ICPCG" );
+
+    _PCG( A, x, b, ic, maxIter, tolerance );
+}
+
+template <class MATRIX>
+inline void
+ZLinearSystemSolver::MG( const MATRIX& A, ZFloatArray& x, const ZFloatArray& b, ZMultigrid& mg, const int maxIter, const float tolerance )
+{
+    ZPROFILE_SCOPE( "ZLinearSystemSolver::MG" );
+
+    const int N = b.length();
+    if( N < 1 ) { return; }
+
+    double* sums = _prepare( x, N );
+
+    double bNorm = 0.0;
+
+    #pragma omp parallel
+    {
+        int i0, i1;
+        GetThreadRange( N, i0, i1 );
+
+        const double bb = SumOverThreads( DotKernel( &b[0], &b[0], i0, i1 ), sums );
+
+        #pragma omp single
+        bNorm = sqrt( bb );
+    }
+
+    const double threshold = tolerance * ( ( bNorm > 0.0 ) ? bNorm : 1.0 );
+    const double r0        = _residual( A, x, b );
+
+    double rNorm = r0;
+
+    int it = 0;
+    for(; ( it<maxIter ) && ( rNorm > threshold ); it++)
+    {
+        mg.vCycle(x, b);
+
+        const double prev = rNorm;
+        rNorm = _residual( A, x, b );
+
+        // stagnation at the round-off level of the single precision
+        if( rNorm > 0.9*prev ) { it++; break; }
+    }
+
+    _setStatistics( r0, rNorm, it, maxIter, threshold );
+}
+
+// The preconditioner has its own parallel regions,
+// so an iteration has two regions around it: (SpMV, AXPY) and (dot, XPBY).
+template <class MATRIX, class PRECONDITIONER>
+inline void
+ZLinearSystemSolver::_PCG( const MATRIX& A, ZFloatArray& x, const ZFloatArray& b, PRECONDITIONER& M, const int maxIter, const float tolerance )
+{
+    const int N = b.length();
+    if( N < 1 ) { return; }
+
+    double* sums = _prepare( x, N );
+
+    double bNorm = 0.0;
+    double rNorm = 0.0;
+
+    #pragma omp parallel
+    {
+        int i0, i1;
+        GetThreadRange( N, i0, i1 );
+
+        double bb = DotKernel( &b[0], &b[0], i0, i1 );
+        double rr = ResidualDotKernel( A, &x[0], &b[0], &r[0], i0, i1 );
+        SumOverThreads( bb, rr, sums );
+
+        #pragma omp single
+        { bNorm = sqrt( bb );   rNorm = sqrt( rr ); }
+    }
+
+    const double threshold = tolerance * ( ( bNorm > 0.0 ) ? bNorm : 1.0 );
+    const double r0        = rNorm;
+
+    M.apply(r, z);
+
+    double rz = 0.0;
+
+    #pragma omp parallel
+    {
+        int i0, i1;
+        GetThreadRange( N, i0, i1 );
+
+        memcpy( (char*)&p[i0], (char*)&z[i0], (i1-i0)*sizeof(float) );
+
+        const double sum = SumOverThreads( DotKernel( &r[0], &z[0], i0, i1 ), sums );
+
+        #pragma omp single
+        rz = sum;
+    }
+
+    int it = 0;
+    for(; ( it<maxIter ) && ( rNorm > threshold ); it++)
+    {
+        bool breakdown = false;
+
+        #pragma omp parallel
+        {
+            int i0, i1;
+            GetThreadRange( N, i0, i1 );
+
+            const double pAp = SumOverThreads( SpMVDotKernel( A, &p[0], &Ap[0], i0, i1 ), sums );
+
+            if( pAp > 0.0 )
+            {
+                const double rr = SumOverThreads( AxpyDotKernel( (float)( rz / pAp ), &p[0], &Ap[0], &x[0], &r[0], i0, i1 ), sums );
+
+                #pragma omp single
+                rNorm = sqrt( rr );
+            }
+            else
+            {
+                #pragma omp single
+                breakdown = true; // A or M is not positive definite.
+            }
+        }
+
+        if( breakdown ) break;
+        if( rNorm <= threshold ) { it++; break; }
+
+        M.apply(r, z);
+
+        #pragma omp parallel
+        {
+            int i0, i1;
+            GetThreadRange( N, i0, i1 );
+
+            const double rzNew = SumOverThreads( DotKernel( &r[0], &z[0], i0, i1 ), sums );
+
+            XpbyKernel( &z[0], (float)( rzNew / rz ), &p[0], i0, i1 );
+
+            #pragma omp barrier
+
+            #pragma omp single
+            rz = rzNew;
+        }
+    }
+
+    _setStatistics( r0, rNorm, it, maxIter, threshold );
+}
+
+inline double*
+ZLinearSystemSolver::_prepare( ZFloatArray& x, int N )
+{
+    if( x.length() != N ) { x.setLength( N ); }
+
+    r .setLength( N, false );
+    z .setLength( N, false );
+    p .setLength( N, false );
+    Ap.setLength( N, false );
+
+    const size_t numSums = (size_t)( ZSolverKernelsPad * omp_get_max_threads() );
+    if( partial.size() < numSums ) { partial.resize( numSums ); }
+
+    return &partial[0];
+}
+
+template <class MATRIX>
+inline double
+ZLinearSystemSolver::_residual( const MATRIX& A, const ZFloatArray& x, const ZFloatArray& b )
+{
+    const int N = b.length();
+    double* sums = &partial[0];
+
+    double rNorm = 0.0;
+
+    #pragma omp parallel
+    {
+        int i0, i1;
+        GetThreadRange( N, i0, i1 );
+
+        const double rr = SumOverThreads( ResidualDotKernel( A, &x[0], &b[0], &r[0], i0, i1 ), sums );
+
+        #pragma omp single
+        rNorm = sqrt( rr );
+    }
+
+    return rNorm;
+}
+
+inline void
+ZLinearSystemSolver::_setStatistics( double r0, double r1, int iterations, int maxIter, double threshold )
+{
+    maxIterations   = maxIter;
+    curIterations   = iterations;
+    initialResidual = (float)r0;
+    finalResidual   = (float)r1;
+    convergenceRate = ( iterations > 0 && r0 > 0.0 ) ? (float)pow( r1/r0, 1.0/iterations ) : 0.f;
+    converged       = ( r1 <= threshold );
+}
+
 ZELOS_NAMESPACE_END
 
 #endif
@@ -486,6 +486,19 @@ ZCatRom( const T& P0, const T& P1, const T& P2, const T& P3, const float& t )
 //				  + ( -1*P0+3*P1-3*P2+1*P3 ) * ttt );
 //}
 
+// the weights of P0~P3 in ZCatRom()
+inline void
+ZCatRomWeights( const float& t, float w[4] )
+{
+	const float tt  = t*t;
+	const float ttt = tt*t;
+
+	w[0] = 0.5f * (-t+2*tt-ttt);
+	w[1] = 0.5f * (2-5*tt+3*ttt);
+	w[2] = 0.5f * (t+4*tt-3*ttt);
+	w[3] = 0.5f * (-tt+ttt);
+}
+
 template <class T>
 inline T
 ZMCerp( const T& v0, const T& v1, const T& v2, const T& v3, const float& f )
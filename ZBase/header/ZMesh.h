@@ -110,7 +110,8 @@ class ZMesh
 		void getQuadrilateralIndices( ZInt4Array& quadConnections ) const;
 		void getTetrahedronIndices( ZInt4Array& tetConnections ) const;
 
-		void weld( float epsilon=Z_EPS );
+		// It merges the vertices and the UVs closer than epsilon, and deletes the unused ones.
+		void weld( float epsilon=Z_EPS, bool useOpenMP=true );
 
 		void reverse();
 
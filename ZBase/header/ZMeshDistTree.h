@@ -3,7 +3,7 @@
 //-------------------------------------------------------//
 // author: Taeyong Kim @ nVidia                          //
 //         Wanho Choi @ Dexter Studios                   //
-// last update: 2015.10.07                               //
+// last update: 2019.03.20                               //
 //-------------------------------------------------------//
 
 #ifndef _ZMeshDistTree_h_
@@ -14,48 +14,20 @@
 ZELOS_NAMESPACE_BEGIN
 
 /// @brief The bounding box hierarchy class for accelerating point-triangle distance query.
+/**
+	It keeps its own copy of the triangles and queries them through ZTriangleBVH.
+	maxLevel is the maximum depth of the tree, and maxElements is the maximum number of triangles per leaf.
+*/
 class ZMeshDistTree
 {
 	protected:
 
-		/// Distance information used by KDTree structures
-		struct Data
-		{
-			int    id;		///< The triangle id.
-			float  dist;	///< The computed distance.
-			ZPoint pt;		///< The computed point.
-
-			Data()
-			: id(-1), dist(Z_LARGE) {}
-
-			bool valid()   const { return (id>=0); }
-			bool invalid() const { return (id< 0); }
-		};
-
-		/// Each cell of spatial partitioning scheme
-		struct Cell
-		{
-			int          level;		///< suvdivision level of the cell
-			int          parent;	///< index of the parent
-			int          left;		///< index of the left child
-			int          right;		///< index of the right child
-			ZIntArray    ids;		///< element ID list
-			ZBoundingBox bBox;		///< bounding box of the cell
-
-			Cell( int subdLevel= -1 )
-			: level(subdLevel), parent(-1), left(-1), right(-1) {}
-
-			bool isLeaf() const { return ( (left<0) || (right<0) ); }
-		};
-
-	protected:
-
-		int                              _maxLevel;		///< The maximum level of subdivision.
-		int                              _maxElements;	///< The maximum number of elements per each leaf node.
-		ZPointArray                      _points;		///< The triangle vertex positions.
-		ZInt3Array                       _triangles;	///< The triangle vertices.
-		std::vector<ZMeshDistTree::Cell> _cells;		///< The cells.
-		ZBoundingBoxArray                _bBoxes;		///< The bounding boxes of triangles.
+		int               _maxLevel;		///< The maximum level of subdivision.
+		int               _maxElements;		///< The maximum number of elements per each leaf node.
+		ZPointArray       _points;			///< The triangle vertex positions.
+		ZInt3Array        _triangles;		///< The triangle vertices.
+		ZBoundingBoxArray _bBoxes;			///< The bounding boxes of triangles.
+		ZTriangleBVH      _bvh;				///< The bounding volume hierarchy.
 
 	public:
 
@@ -66,7 +38,7 @@ class ZMeshDistTree
 			@param[in] maxElements The maximum number of elements in leaf cell.
 			@note This structure should be initialized using initialize() function.
 		*/
-		ZMeshDistTree( int maxLevel=10, int maxElements=10 );
+		ZMeshDistTree( int maxLevel=32, int maxElements=4 );
 
 		/**
 			Class constructor.
@@ -75,7 +47,7 @@ class ZMeshDistTree
 			@param[in] maxLevel The maximum subdivision level.
 			@param[in] maxElements The maximum number of elements in leaf cell.
 		*/
-		ZMeshDistTree( const ZMesh& mesh, int maxLevel=10, int maxElements=10 );
+		ZMeshDistTree( const ZMesh& mesh, int maxLevel=32, int maxElements=4 );
 
 		/**
 			Reset the current distance tree.
@@ -86,8 +58,9 @@ class ZMeshDistTree
 			Reinitialize the tree from the given mesh.
 			Set points and triangles from the given shape.
 			@param[in] mesh The input shape to extract points and triangles.
+			@param[in] useOpenMP Whether the tree is built in parallel or not.
 		*/
-		bool set( const ZMesh& mesh );
+		bool set( const ZMesh& mesh, bool useOpenMP=true );
 
 		/**
 			Return the maximum subdivision level.
@@ -149,50 +122,11 @@ class ZMeshDistTree
 		*/
 		void getTriangles( const ZBoundingBox& bBox, ZIntArray& triangles, bool accurate=true ) const;
 
-	protected:
-
-		/// @brief The variables initializer.
-		/** 
-			This function initializes all the internal data, including suvdivision.
-			@return True if success and false otherwise.
-		*/
-		bool _initialize();
-
-		/**
-			Check if we can subdivide the cell of the given index.
-			@param cellId The cell index.
-			@return True if the cell can be further subdivided and false otherwise.
-		*/
-		bool _subdividable( int cellId ) const;
-
-		/** 
-			Split the cell of the given index by k-D subdivision.
-			@param cellId The cell id being splited into two children cells.
-		*/
-		void _splitCell( int cellId );
-
-		/**
-			Add a new cell with a given level.
-			@param[in] level The level of the cell being added.
-			@return The index of the cell being added.
-		*/
-		int _addCell( int level );
-
-		/**
-			Recursively find the closest triangle in the cell of the given index.
-			@param[in] cellId The cell index being queried.
-			@param[in] point The point to compute distance from it.
-			@param[out] distData The distance data coming in and gets updated in this function.
-		*/
-		void _compute( int cellId, const ZPoint& point, ZMeshDistTree::Data& distData ) const;
-
 		/**
-			Recursively find the cell index which is the deepest cell including the given bounding box.
-			@param[in] cellId The cell index being queried.
-			@param[in] bBox The bounding box being queried.
-			@return The deepest cell index including the given bounding box.
+			Return the reference to the bounding volume hierarchy.
+			@return The reference to the bounding volume hierarchy.
 		*/
-		int _findDeepestCellIncludingBox( int cellId, const ZBoundingBox& bBox ) const;
+		const ZTriangleBVH& bvh() const;
 };
 
 ZELOS_NAMESPACE_END
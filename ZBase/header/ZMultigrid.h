@@ -0,0 +1,84 @@
+//--------------//
+// ZMultigrid.h //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.29                               //
+//-------------------------------------------------------//
+
+#ifndef _ZMultigrid_h_
+#define _ZMultigrid_h_
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+/// @brief Geometric multigrid for the 7-point (or 5-point) Laplacian-like sparse matrices.
+/**
+	The matrix must be a symmetric 7-point stencil matrix on an nx x ny x nz grid with the row index i+nx*(j+ny*k),
+	like the ones by ZSparseMatrix::setSevenPointLaplacian() (the coefficients can vary per cell).
+	The entries out of the grid or with zero values are ignored, and the rows with zero diagonals are treated as empty cells.
+	Each coarse level aggregates 2x2x2 fine cells, and its matrix is the Galerkin product P^T*A*P of the piecewise constant
+	prolongation P scaled by 1/2, which is again a 7-point stencil matrix (and the same as the rediscretized one for the constant coefficients),
+	except for the Dirichlet part of the diagonal (the excess of the diagonal over the sum of the couplings), which is scaled by 0.6 instead of 1/2.
+	This is an empirical correction: the exact product moves the Dirichlet boundaries at the ghost cell centers (like the air cells of the fluid solvers)
+	outward level by level, and the V-cycle then diverges at the fine resolutions. So the coarse operator is not exactly the Galerkin one near such boundaries.
+	The smoother is the red-black Gauss-Seidel (red->black before the restriction and black->red after the prolongation),
+	so that one V-cycle from zero is a symmetric positive definite operator and can be used as the preconditioner of CG.
+*/
+class ZMultigrid
+{
+	private:
+
+		struct Level
+		{
+			int nx, ny, nz;
+			ZFloatArray d;				// diagonal
+			ZFloatArray ax, ay, az;		// couplings between (i,j,k) and (i+1,j,k), (i,j+1,k), (i,j,k+1)
+			ZFloatArray x, b, r;		// unknowns, right hand side, residual (x and b are not used at the finest level)
+		};
+
+		std::vector<Level> _levels;
+
+		bool _useOpenMP;
+
+	public:
+
+		int numSmoothings;		// the number of pre(post) red-black sweeps per level (default: 2)
+		int numCoarseSweeps;	// the number of red-black sweeps at the coarsest level (default: 32)
+		int minCoarseSize;		// coarsening stops when all of the dimensions are not larger than it (default: 4)
+
+	public:
+
+		ZMultigrid();
+
+		void reset();
+
+		bool build( const ZSparseMatrix<float>& A, int nx, int ny, int nz, bool useOpenMP=true );
+
+		// the same as the above with the matrix of the operator (without any CSR matrix)
+		bool build( const ZLaplacianOperator& A, bool useOpenMP=true );
+
+		int numLevels() const;
+
+		// z = M^{-1} r: one V-cycle from zero (the preconditioner)
+		void apply( const ZFloatArray& r, ZFloatArray& z );
+
+		// one V-cycle improving the current x of Ax=b
+		void vCycle( ZFloatArray& x, const ZFloatArray& b );
+
+	private:
+
+		void _vCycle( int l, float* x, const float* b, bool fromZero );
+
+		void _smooth( int l, float* x, const float* b, int color );
+		void _residual( int l, const float* x, const float* b, float* r );
+		void _restrict( int l, const float* r );
+		void _prolongate( int l, float* x );
+		void _coarsen( int l );
+		void _coarsenAll();
+};
+
+ZELOS_NAMESPACE_END
+
+#endif
+
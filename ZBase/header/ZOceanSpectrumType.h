@@ -0,0 +1,62 @@
+//----------------------//
+// ZOceanSpectrumType.h //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.30                               //
+//-------------------------------------------------------//
+
+#ifndef _ZOceanSpectrumType_h_
+#define _ZOceanSpectrumType_h_
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+// zPhillips
+// Tessendorf's Phillips spectrum: (alpha/2) * exp(-1/(k*L)^2) / k^4 (L = U^2/g: the largest wave of the wind speed U).
+// It has no peak frequency, so the waves get larger with the patch size up to L.
+
+// zJONSWAP
+// the JONSWAP (Joint North Sea Wave Project) frequency spectrum of the fetch-limited sea
+// (alpha*g^2/w^5) * exp(-5/4*(wp/w)^4) * gamma^r (alpha and wp from the wind speed and the fetch, r: the peak enhancement).
+// It becomes the Pierson-Moskowitz spectrum of the fully developed sea when gamma=1.
+
+class ZOceanSpectrumType
+{
+	public:
+
+		enum OceanSpectrumType
+		{
+			zNone     = 0,
+			zPhillips = 1,
+			zJONSWAP  = 2
+		};
+
+	public:
+
+		ZOceanSpectrumType() {}
+
+		static ZString name( ZOceanSpectrumType::OceanSpectrumType spectrumType )
+		{
+			switch( spectrumType )
+			{
+				default:
+				case ZOceanSpectrumType::zNone:     { return ZString("none");     }
+				case ZOceanSpectrumType::zPhillips: { return ZString("Phillips"); }
+				case ZOceanSpectrumType::zJONSWAP:  { return ZString("JONSWAP");  }
+			}
+		}
+};
+
+inline ostream&
+operator<<( ostream& os, const ZOceanSpectrumType& object )
+{
+	os << "<ZOceanSpectrumType>" << endl;
+	os << endl;
+	return os;
+}
+
+ZELOS_NAMESPACE_END
+
+#endif
+
@@ -0,0 +1,25 @@
+//--------------------//
+// ZPointArrayUtils.h //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.30                               //
+//-------------------------------------------------------//
+
+#ifndef _ZPointArrayUtils_h_
+#define _ZPointArrayUtils_h_
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+// the positions in the unit cube by the bounding box of the input
+void GetNormalizedPositions( const ZPointArray& input, ZPointArray& output, bool useOpenMP=true );
+
+// k-means clustering by ZKmeanClustering::run() in the normalized space of the points (kInitCentroids.length() clusters)
+// It returns the number of the iterations, and clusterIndices[k] is the point indices of the k-th cluster.
+int DoKMeansClustering( const ZPointArray& nPoints, const ZPointArray& kInitCentroids, int maxIterations, float tolerance, bool useOpenMP, vector<ZIntArray>& clusterIndices );
+
+ZELOS_NAMESPACE_END
+
+#endif
+
@@ -2,7 +2,7 @@
 // ZPointsHashGrid.h //
 //-------------------------------------------------------//
 // author: Wanho Choi @ Dexter Studios                   //
-// last update: 2015.10.07                               //
+// last update: 2019.03.30                               //
 //-------------------------------------------------------//
 
 #ifndef _ZPointsHashGrid_h_
@@ -18,6 +18,9 @@ ZELOS_NAMESPACE_BEGIN
 	Each grid cell maps into a hash table of a fixed set of n buckets.
 	The buckets contain the linked lists of objects.
 	The grid itself is conceptual and does not use any memory.
+	build() fills the grid in parallel by a radix(counting) sort: the points are stored contiguously in the bucket order,
+	and the ids in each bucket are in ascending order.
+	add() can be still used after build(), and the queries search both of them.
 */
 class ZPointsHashGrid
 {
@@ -38,12 +41,16 @@ class ZPointsHashGrid
 			{}
 		};
 
-	public:
+	private:
 
 		int               _numBuckets;			///< The number of buckets.
 		float             _h;			///< The grid cell size.
 		ZPointsHashGrid::Item** _list;				///< The linked list of each bucket.
 
+		ZIntArray         _bucketStart;		///< The start index of each bucket in _ids (length: _numBuckets+1) by build().
+		ZIntArray         _ids;				///< The point ids sorted by the bucket by build().
+		ZPointArray       _positions;		///< The point positions sorted by the bucket by build().
+
 		// from "Real-time Collision Detection" p.288
 		static const int32_t _h1 = 0x8da6b343;	///< (= -1918454973) The large multiplicative constants
 		static const int32_t _h2 = 0xd8163841;	///< (= -669632447) The arbitrarily chosen primes
@@ -67,22 +74,51 @@ class ZPointsHashGrid
 
 		void add( int id, const ZPoint& pos );
 
+		// It replaces the current items with the given points (the id of each point is its index).
+		void build( const ZPointArray& points, bool useOpenMP=true );
+
+		// It moves the bucket table of build() out of the grid: the ids in the bucket b are ids[ bucketStart[b] ] ~ ids[ bucketStart[b+1]-1 ].
+		// The built points are removed from the grid (only the ones by add() remain).
+		void releaseBuckets( ZIntArray& bucketStart, ZIntArray& ids );
+
 		int findPoints( ZIntArray& neighbors, const ZPoint& p, float maxDistance, bool removeRedundancy, bool asAppending ) const;
+
+		// A convenience wrapper which runs the single-point findPoints() for each of points in parallel.
+		// (The queries are independent: nothing is shared between the points in the same cell.)
+		// The neighbors of points[i] are neighbors[ neighborStart[i] ] ~ neighbors[ neighborStart[i+1]-1 ].
+		// It returns the total number of the neighbors.
+		int findPoints( ZIntArray& neighborStart, ZIntArray& neighbors, const ZPointArray& points, float maxDistance, bool removeRedundancy, bool useOpenMP=true ) const;
+
+	private:
+
+		int _bucket( const ZPoint& p ) const;
+		void _clearList();
+
+		// not copyable (_list is owned)
+		ZPointsHashGrid( const ZPointsHashGrid& );
+		ZPointsHashGrid& operator=( const ZPointsHashGrid& );
 };
 
 inline int
 ZPointsHashGrid::index( int i, int j, int k ) const
 {
-	int32_t n = _h1*i + _h2*j + _h3*k;
+	// (in unsigned arithmetic: the signed overflow is undefined, and the optimizer breaks it when inlined)
+	int32_t n = (int32_t)( (uint32_t)_h1*(uint32_t)i + (uint32_t)_h2*(uint32_t)j + (uint32_t)_h3*(uint32_t)k );
 	n %= _numBuckets;
 	if( n < 0 ) { n += _numBuckets; }
 	return (int)n;
 }
 
+inline int
+ZPointsHashGrid::_bucket( const ZPoint& p ) const
+{
+	return index( int(p.x/_h), int(p.y/_h), int(p.z/_h) );
+}
+
 inline void
 ZPointsHashGrid::add( int id, const ZPoint& p )
 {
-	const int idx = index( int(p.x/_h), int(p.y/_h), int(p.z/_h) );
+	const int idx = _bucket( p );
 	ZPointsHashGrid::Item* newItem = new ZPointsHashGrid::Item( id, p, _list[idx] );
 	_list[idx] = newItem;
 }
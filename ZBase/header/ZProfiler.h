@@ -0,0 +1,172 @@
+//-------------//
+// ZProfiler.h //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.30                               //
+//-------------------------------------------------------//
+
+#ifndef _ZProfiler_h_
+#define _ZProfiler_h_
+
+#include <ZelosBase.h>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+	#include <x86intrin.h>
+	#define ZPROFILER_TSC
+#endif
+
+ZELOS_NAMESPACE_BEGIN
+
+///////////////////////////////////////////////////////////////////////////////
+// The profiling scopes are compiled in only when ZELOS_PROFILE is defined (ex: CCFLAGS += -DZELOS_PROFILE).
+// Otherwise ZPROFILE_SCOPE() expands to nothing, so it costs nothing in the release builds.
+// The name must be a string literal (or any string which outlives the profiler) because only its pointer is recorded.
+// ex) void ZVoxelizer::finalize() { ZPROFILE_SCOPE( "ZVoxelizer::finalize" ); ... }
+#define ZPROFILE_CONCAT_( a, b ) a##b
+#define ZPROFILE_CONCAT( a, b ) ZPROFILE_CONCAT_( a, b )
+
+#ifdef ZELOS_PROFILE
+	#define ZPROFILE_SCOPE( NAME ) Zelos::ZProfileScope ZPROFILE_CONCAT( _zProfileScope, __LINE__ )( NAME )
+#else
+	#define ZPROFILE_SCOPE( NAME )
+#endif
+
+/// @brief The aggregated statistics of a node of the call tree.
+struct ZProfileNode
+{
+	ZString name;
+	int     parent;		// the index of the parent node (-1: a root)
+	int     depth;		// 0 for the roots
+	int64_t count;		// the number of the calls
+	int     numThreads;	// the number of the threads which called it
+	double  total;		// the inclusive time in milliseconds (summed over the threads)
+	double  self;		// the exclusive time in milliseconds (total - the total of the children)
+	double  min;		// the shortest call in milliseconds
+	double  max;		// the longest call in milliseconds
+};
+
+/// @brief The hierarchical scoped profiler.
+/**
+	Each ZPROFILE_SCOPE() records one event (name, begin, end, depth) when it exits.
+	The events go to the buffer of the calling thread without any lock:
+	a thread takes the mutex only once to register its buffer (per clear()).
+	The buffers grow by the fixed size blocks, so the recorded events are never moved.
+	The time stamps are the TSC (time stamp counter) on x86 and std::chrono::steady_clock otherwise,
+	and they are converted to milliseconds by calibrating the TSC against the steady clock over the session.
+	The statistics are aggregated by the call paths (the names of the enclosing scopes in the same thread),
+	so the scopes in the worker threads of an OpenMP region show up as the roots.
+	clear(), getStatistics(), report() and exportChromeTrace() must be called while no profiled code is running
+	(clear() frees the buffers which the other threads may be writing through their cached pointers).
+	exportChromeTrace() writes the Chrome trace event format (chrome://tracing, https://ui.perfetto.dev).
+	global() is the process-wide profiler which ZPROFILE_SCOPE() uses (disabled until enable() is called).
+*/
+class ZProfiler
+{
+	private:
+
+		struct Thread;
+
+		std::atomic<bool>                    _enabled;
+		std::atomic<int>                     _generation;	// incremented by clear() to make the threads register again
+
+		std::vector<std::shared_ptr<Thread> > _threads;
+		mutable std::mutex                   _mutex;
+
+		uint64_t                             _startTicks;
+		std::chrono::steady_clock::time_point _startTime;
+
+	public:
+
+		ZProfiler();
+
+		static ZProfiler& global();
+
+		void enable( bool on=true );
+		bool enabled() const;
+
+		// It discards all the recorded events and restarts the session clock.
+		// (No profiled code may be running in any thread: the buffers are freed.)
+		void clear();
+
+		int numThreads() const;
+		int64_t numEvents() const;
+
+		// the call tree in the depth-first order (the children in the descending order of the total time)
+		void getStatistics( std::vector<ZProfileNode>& nodes ) const;
+
+		// the call tree as an indented table (the nodes below minPercent of the total time of the roots are omitted)
+		void report( ostream& os=cout, float minPercent=0.f ) const;
+
+		bool exportChromeTrace( const char* filePathName ) const;
+
+		double usedMemorySize( ZDataUnit::DataUnit dataUnit=ZDataUnit::zBytes ) const;
+
+		static uint64_t ticks();
+
+	private:
+
+		friend class ZProfileScope;
+
+		Thread* _thread();
+		uint64_t _open();
+		void _close( const char* name, uint64_t begin );
+
+		double _millisecondsPerTick() const;
+};
+
+inline bool
+ZProfiler::enabled() const
+{
+	return _enabled.load( std::memory_order_relaxed );
+}
+
+inline uint64_t
+ZProfiler::ticks()
+{
+	#ifdef ZPROFILER_TSC
+		return (uint64_t)__rdtsc();
+	#else
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+	#endif
+}
+
+ostream&
+operator<<( ostream& os, const ZProfiler& object );
+
+/// @brief The RAII scope of ZProfiler (use ZPROFILE_SCOPE() instead of this class directly).
+class ZProfileScope
+{
+	private:
+
+		const char* _name;
+		uint64_t    _begin;
+		bool        _on;
+
+	public:
+
+		explicit ZProfileScope( const char* name );
+		~ZProfileScope();
+
+	private:
+
+		ZProfileScope( const ZProfileScope& );
+		ZProfileScope& operator=( const ZProfileScope& );
+};
+
+inline
+ZProfileScope::ZProfileScope( const char* name )
+: _name(name), _begin(0), _on( ZProfiler::global().enabled() )
+{
+	if( _on ) { _begin = ZProfiler::global()._open(); }
+}
+
+inline
+ZProfileScope::~ZProfileScope()
+{
+	if( _on ) { ZProfiler::global()._close( _name, _begin ); }
+}
+
+ZELOS_NAMESPACE_END
+
+#endif
+
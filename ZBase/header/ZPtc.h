@@ -68,6 +68,11 @@ class ZPtc
 
 		bool save( const char* filePathName ) const;
 		bool load( const char* filePathName );
+
+		// the chunked cache file of ZCacheFile.h
+		// (loadCache() copies the arrays into the members; ZCacheReader::view() reads them from the file without any copy.)
+		bool saveCache( const char* filePathName ) const;
+		bool loadCache( const char* filePathName );
 		
 		bool savePtc( const char* filename) const;
 		bool loadPtc( const char* filename);
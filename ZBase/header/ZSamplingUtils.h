@@ -2,7 +2,7 @@
 // ZSamplingUtils.h //
 //-------------------------------------------------------//
 // author: Wanho Choi @ Dexter Studios                   //
-// last update: 2015.10.07                               //
+// last update: 2019.03.30                               //
 //-------------------------------------------------------//
 
 #ifndef _ZSampleringUtils_h_
@@ -20,6 +20,12 @@ int ScatterPoissonDisk2D( float radius, const ZPoint& minPt, const ZPoint& maxPt
 
 int ScatterPoissonDisk3D( float radius, const ZPoint& minPt, const ZPoint& maxPt, int seed, bool asAppending, ZPointArray& sample );
 
+// It selects a Poisson disk subset of the given (dense) candidate points by sample elimination.
+// Two selected points i and j are farther than max(radii[i],radii[j]) (the approximated geodesic distance when normals are given).
+// The selected indices are in ascending order, and the result does not depend on the number of threads.
+// The candidates should be in random order (ex. Monte Carlo samples) because the earlier ones have the priority.
+int SelectPoissonDisk( const ZPointArray& points, const ZVectorArray& normals, const ZFloatArray& radii, bool useOpenMP, ZIntArray& selected );
+
 ZELOS_NAMESPACE_END
 
 #endif
@@ -2,7 +2,7 @@
 // ZScalarField3D.h //
 //-------------------------------------------------------//
 // author: Wanho Choi @ Dexter Studios                   //
-// last update: 2016.07.05                               //
+// last update: 2019.03.30                               //
 //-------------------------------------------------------//
 
 #ifndef _ZScalarField3D_h_
@@ -45,6 +45,13 @@ class ZScalarField3D : public ZField3DBase, public ZFloatArray
 
 		float mcerp( const ZPoint& p ) const;
 
+		float catrom( const ZPoint& p ) const;
+
+		// the batch versions of lerp(), catrom() and mcerp() for many points (e.g. particles)
+		// The points are clamped into the domain, and values is resized to the number of the points.
+		bool sample( const ZPointArray& points, ZFloatArray& values,
+		             ZInterpolationType::InterpolationType type=ZInterpolationType::zLinear, bool useOpenMP=true ) const;
+
 		ZVector gradient( const ZPoint& p ) const;
 
 		float min( bool useOpenMP=false ) const;
@@ -52,6 +59,10 @@ class ZScalarField3D : public ZField3DBase, public ZFloatArray
 		void setMinMax( bool useOpenMP=false );
 		float absMax( bool useOpenMP=false ) const;
 
+		// by ZSimplexNoise::fBm4() along the rows (four cells at once)
+		void setNoise( const ZSimplexNoise& noise, float time, bool useOpenMP=true );
+		void setFBm( const ZSimplexNoise& noise, float time, int numOctaves, float amp, float freq, float rough, bool useOpenMP=true );
+
 		const ZString dataType() const;
 
 		void drawSlice( const ZInt3& whichSlice, const ZFloat3& sliceRatio,
@@ -202,6 +213,43 @@ ZScalarField3D::mcerp( const ZPoint& p ) const
 	return ZMCerp( kValues[0], kValues[1], kValues[2], kValues[3], fz );
 }
 
+inline float
+ZScalarField3D::catrom( const ZPoint& p ) const
+{
+	float x=p.x, y=p.y, z=p.z;
+	if( _location==ZFieldLocation::zCell ) { x-=_dxd2; y-=_dyd2; z-=_dzd2; }
+
+	x = ZClamp( (x-_minPt.x)*_ddx, 0.f, (float)_iMax );
+	y = ZClamp( (y-_minPt.y)*_ddy, 0.f, (float)_jMax );
+	z = ZClamp( (z-_minPt.z)*_ddz, 0.f, (float)_kMax );
+
+	const int i = ZMin( int(x), _iMax-1 );
+	const int j = ZMin( int(y), _jMax-1 );
+	const int k = ZMin( int(z), _kMax-1 );
+
+	const int is[4] = { ZMax(i-1,0), i, i+1, ZMin(i+2,_iMax) };
+	const int js[4] = { ZMax(j-1,0), j, j+1, ZMin(j+2,_jMax) };
+	const int ks[4] = { ZMax(k-1,0), k, k+1, ZMin(k+2,_kMax) };
+
+	float wx[4], wy[4], wz[4];
+	ZCatRomWeights( x-i, wx );
+	ZCatRomWeights( y-j, wy );
+	ZCatRomWeights( z-k, wz );
+
+	const float* _data = (const float*)ZFloatArray::pointer();
+
+	float est = 0.f;
+
+	FOR( kk, 0, 4 )
+	FOR( jj, 0, 4 )
+	{
+		const float* r = _data + _stride0*js[jj] + _stride1*ks[kk];
+		est += ( wz[kk] * wy[jj] ) * ( wx[0]*r[is[0]] + wx[1]*r[is[1]] + wx[2]*r[is[2]] + wx[3]*r[is[3]] );
+	}
+
+	return est;
+}
+
 inline ZVector
 ZScalarField3D::gradient( const ZPoint& p ) const
 {
@@ -0,0 +1,77 @@
+//---------------//
+// ZSellMatrix.h //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.29                               //
+//-------------------------------------------------------//
+
+#ifndef _ZSellMatrix_h_
+#define _ZSellMatrix_h_
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+/// @brief SELL-C-sigma sparse matrix of float.
+/**
+	"A unified sparse matrix data format for efficient general sparse matrix-vector multiplication
+	on modern processors with wide SIMD units" (Kreutzer et al., 2014)
+	The rows are sorted by their lengths in the descending order within each window of sigma rows,
+	and every C consecutive sorted rows make a chunk padded to its longest row.
+	The entries of a chunk are stored column by column, so that the SpMV runs C rows at once with the SIMD lanes.
+	The rows never leave their windows, so a thread working on the windows of a row range writes only the rows of that range.
+	It is converted from ZSparseMatrix<float> without the zero entries and the ones out of the columns (like -1).
+*/
+class ZSellMatrix
+{
+	public:
+
+		static const int C = 8; // the chunk height (two SSE vectors)
+
+	private:
+
+		int _m;				// the number of rows
+		int _n;				// the number of columns
+		int _nnz;			// the number of non-zero entries (without the padding)
+		int _sigma;			// the sorting window size (a multiple of C)
+
+	public: // but, they must be treated carefully like as the ones of ZSparseMatrix.
+
+		std::vector<int>   chunkStart;	// the array index of the first entry of each chunk (length: numChunks+1)
+		std::vector<int>   c;			// the column index of each entry (0 for the padding)
+		std::vector<float> v;			// the value of each entry (0 for the padding)
+		std::vector<int>   row;			// the original row of each sorted row (-1 for the padding rows of the last chunk)
+		std::vector<float> diag;		// the diagonal of each original row
+
+	public:
+
+		ZSellMatrix();
+		ZSellMatrix( const ZSparseMatrix<float>& A, int sigma=256 );
+
+		void reset();
+
+		bool set( const ZSparseMatrix<float>& A, int sigma=256, bool useOpenMP=true );
+
+		int m() const { return _m; }
+		int n() const { return _n; }
+		int nnz() const { return _nnz; }
+		int sigma() const { return _sigma; }
+
+		int numChunks() const { return ( (int)chunkStart.size() - 1 ); }
+
+		// nnz / the number of the stored entries
+		float efficiency() const;
+
+		// y = A*x
+		void multiply( const ZFloatArray& x, ZFloatArray& y, bool useOpenMP=true ) const;
+
+		double usedMemorySize( ZDataUnit::DataUnit dataUnit=ZDataUnit::zBytes ) const;
+};
+
+ostream&
+operator<<( ostream& os, const ZSellMatrix& object );
+
+ZELOS_NAMESPACE_END
+
+#endif
+
@@ -4,7 +4,7 @@
 // author: Jinhyuk Bae @ Dexter Studios                  //
 //         Wanho Choi @ Dexter Studios					 //
 //         Nayoung Kim @ Dexter Studios                  //
-// last update: 2016.03.15                               //
+// last update: 2019.03.30                               //
 //-------------------------------------------------------//
 
 #ifndef _ZSimplexNoise_h_
@@ -141,7 +141,8 @@ class ZSimplexNoise
 			y = sFreq.y * y + offset.y;
 			z = sFreq.z * z + offset.z;
 			w *= tFreq;
-			return ( scale * pureValue( x,y,z,w, dx,dy,dz,dz ) + lift );
+			float tmp = 0.f; // (dw is optional.)
+			return ( scale * pureValue( x,y,z,w, dx,dy,dz,(dw?dw:&tmp) ) + lift );
 		}
 
 		ZVector vector( float x, float y, float z, float w ) const
@@ -163,6 +164,24 @@ class ZSimplexNoise
 
 		float fBm( float x, float y, float z, float t, int numOctaves, float amp, float freq, float rough ) const;
 
+		// Batch evaluation: four points at once by SSE (if available) and OpenMP over the blocks of points.
+		// They give the same values as the scalar ones above (up to the float rounding).
+		// The gradients (if not NULL) are the analytic spatial derivatives of the results with respect to the points.
+
+		// values[i] = value( p.x, p.y, p.z, t )
+		void evaluate( const ZPointArray& points, float t, ZFloatArray& values, ZVectorArray* gradients=NULL, bool useOpenMP=true ) const;
+
+		// values[i] = turbulence( p.x, p.y, p.z, t, numOctaves )
+		void turbulence( const ZPointArray& points, float t, int numOctaves, ZFloatArray& values, ZVectorArray* gradients=NULL, bool useOpenMP=true ) const;
+
+		// values[i] = fBm( p.x, p.y, p.z, t, numOctaves, amp, freq, rough ) (all the octaves of a point in one pass)
+		void fBm( const ZPointArray& points, float t, int numOctaves, float amp, float freq, float rough, ZFloatArray& values, ZVectorArray* gradients=NULL, bool useOpenMP=true ) const;
+
+		// The kernel of the batch functions for the four points (x[i],y[i],z[i]) without any threading.
+		// (gx,gy,gz: NULL or the arrays of four floats)
+		void fBm4( const float x[4], const float y[4], const float z[4], float t, int numOctaves, float amp, float freq, float rough,
+				   float values[4], float* gx=NULL, float* gy=NULL, float* gz=NULL ) const;
+
 		// marble()
 		// cloud()
 		// fractal()
@@ -0,0 +1,76 @@
+//------------------//
+// ZSolverKernels.h //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.29                               //
+//-------------------------------------------------------//
+
+#ifndef _ZSolverKernels_h_
+#define _ZSolverKernels_h_
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+// The fused kernels of the iterative solvers.
+//
+// Each kernel works on the index range [i0,i1) without any threading inside,
+// so that a solver can run a whole iteration in a single parallel region:
+// every thread takes its own range by GetThreadRange(), and the partial dot products are summed by SumOverThreads().
+// The BLAS-1 loops are vectorized by SSE (if available), and the dot products are accumulated in double per block.
+// The columns out of [0,A.n()) are ignored like the -1 columns of Multiply().
+// The matrix kernels are overloaded for ZSparseMatrix<float>, ZSellMatrix, and ZLaplacianOperator.
+// The ZSellMatrix ones work on the sigma windows starting in [i0,i1), so they write the rows of those windows (not exactly [i0,i1)).
+// Every row still has only one writer, but a barrier is required before reading the output of the own range.
+
+// the static partition of [0,N) for the calling thread (the boundaries are aligned to 16 elements)
+void GetThreadRange( int N, int& i0, int& i1 );
+
+// It returns the sum of the values of all the threads of the current team in the thread order.
+// It must be called by all the threads of the team (or outside of any parallel region).
+// partial: the shared buffer of ZSolverKernelsPad*omp_get_max_threads() doubles
+double SumOverThreads( double value, double* partial );
+
+// the same as the above for two values at once (a and b are replaced by the sums)
+void SumOverThreads( double& a, double& b, double* partial );
+
+static const int ZSolverKernelsPad = 8; // one cache line per thread in SumOverThreads()
+
+// a.b
+double DotKernel( const float* a, const float* b, int i0, int i1 );
+
+// y = A*x (over the rows in [i0,i1)) for any m-by-n matrix
+void SpMVKernel( const ZSellMatrix& A, const float* x, float* y, int i0, int i1 );
+
+// Ap = A*p, and it returns p.Ap (over the rows in [i0,i1))
+// (A must be square, because p is also read by the row index for the dot product.)
+double SpMVDotKernel( const ZSparseMatrix<float>& A, const float* p, float* Ap, int i0, int i1 );
+double SpMVDotKernel( const ZSellMatrix&         A, const float* p, float* Ap, int i0, int i1 );
+double SpMVDotKernel( const ZLaplacianOperator&  A, const float* p, float* Ap, int i0, int i1 );
+
+// r = b - A*x, and it returns r.r
+double ResidualDotKernel( const ZSparseMatrix<float>& A, const float* x, const float* b, float* r, int i0, int i1 );
+double ResidualDotKernel( const ZSellMatrix&         A, const float* x, const float* b, float* r, int i0, int i1 );
+double ResidualDotKernel( const ZLaplacianOperator&  A, const float* x, const float* b, float* r, int i0, int i1 );
+
+// x += alpha*p, r -= alpha*Ap, and it returns r.r
+double AxpyDotKernel( float alpha, const float* p, const float* Ap, float* x, float* r, int i0, int i1 );
+
+// x += alpha*p, r -= alpha*Ap, z = invD*r, and rz = r.z, rr = r.r
+void AxpyScaleDotKernel( float alpha, const float* p, const float* Ap, const float* invD, float* x, float* r, float* z, int i0, int i1, double& rz, double& rr );
+
+// z = invD*r, and rz = r.z, zz = z.z
+void ScaleDotKernel( const float* invD, const float* r, float* z, int i0, int i1, double& rz, double& zz );
+
+// p = z + beta*p
+void XpbyKernel( const float* z, float beta, float* p, int i0, int i1 );
+
+// invD = 1/diagonal of A (0 for the zero or missing diagonals)
+void InverseDiagonalKernel( const ZSparseMatrix<float>& A, float* invD, int i0, int i1 );
+void InverseDiagonalKernel( const ZSellMatrix&         A, float* invD, int i0, int i1 );
+void InverseDiagonalKernel( const ZLaplacianOperator&  A, float* invD, int i0, int i1 );
+
+ZELOS_NAMESPACE_END
+
+#endif
+
@@ -0,0 +1,472 @@
+//------------------//
+// ZSparseField3D.h //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.25                               //
+//-------------------------------------------------------//
+
+#ifndef _ZSparseField3D_h_
+#define _ZSparseField3D_h_
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+/// @brief The data layer of the sparse 3D fields.
+/**
+	The elements of the active tiles are stored tile by tile (tileSize elements per tile).
+	An inactive tile has a single value for all of its elements (the tile value),
+	so the inside and the outside of a narrow band level set keep their own signs.
+*/
+template <class T>
+class ZSparseField3D : public ZSparseField3DBase
+{
+	protected:
+
+		T         _background;	// the initial tile value
+		ZArray<T> _tileValue;	// the value of each tile of the domain while it is inactive
+		ZArray<T> _data;		// the elements of the active tiles
+
+	public:
+
+		ZSparseField3D();
+		ZSparseField3D( const ZGrid3D& grid, ZFieldLocation::FieldLocation loc, const T& background );
+
+		void set( const ZGrid3D& grid, ZFieldLocation::FieldLocation loc, const T& background );
+
+		void reset();
+
+		const T& background() const { return _background; }
+
+		T value( int i, int j, int k ) const;
+
+		const T& tileValue( int ti, int tj, int tk ) const;
+
+		T* tileData( int slot );
+		const T* tileData( int slot ) const;
+
+		// It activates the tile and fills it with its tile value when it was inactive. (not thread-safe)
+		int activateTile( int ti, int tj, int tk );
+
+		// It returns the element after activating its tile. (not thread-safe)
+		T& activate( int i, int j, int k );
+
+		void setValue( int i, int j, int k, const T& v );
+
+		// It deactivates the tiles whose elements are all within the tolerance from their first element.
+		void prune( float tolerance=0.f, bool useOpenMP=true );
+
+		double usedMemorySize( ZDataUnit::DataUnit dataUnit=ZDataUnit::zBytes ) const;
+
+	protected:
+
+		T _lerp( const ZPoint& p ) const;
+
+		// dense: ZScalarField3D or ZVectorField3D
+		template <class DENSE> void _fromDense( const DENSE& dense, float tolerance, bool useOpenMP );
+		template <class DENSE> void _toDense( DENSE& dense, bool useOpenMP ) const;
+
+		void _writeData( ofstream& fout ) const;
+		bool _readData( ifstream& fin );
+
+		static bool _isEquivalent( const float& a, const float& b, float tolerance );
+		static bool _isEquivalent( const ZVector& a, const ZVector& b, float tolerance );
+};
+
+template <class T>
+inline
+ZSparseField3D<T>::ZSparseField3D()
+: _background(T())
+{}
+
+template <class T>
+inline
+ZSparseField3D<T>::ZSparseField3D( const ZGrid3D& grid, ZFieldLocation::FieldLocation loc, const T& background )
+{
+	ZSparseField3D<T>::set( grid, loc, background );
+}
+
+template <class T>
+inline void
+ZSparseField3D<T>::set( const ZGrid3D& grid, ZFieldLocation::FieldLocation loc, const T& background )
+{
+	ZSparseField3DBase::set( grid, loc );
+
+	_background = background;
+
+	_tileValue.assign( numTiles(), background );
+	_data.clear();
+}
+
+template <class T>
+inline void
+ZSparseField3D<T>::reset()
+{
+	ZSparseField3DBase::reset();
+
+	_background = T();
+
+	_tileValue.clear();
+	_data.clear();
+}
+
+template <class T>
+inline T
+ZSparseField3D<T>::value( int i, int j, int k ) const
+{
+	const size_t tIdx = tileIndex( i>>tileLog2, j>>tileLog2, k>>tileLog2 );
+	const int slot = _tileSlot[tIdx];
+
+	if( slot < 0 ) { return _tileValue[tIdx]; }
+	return _data[ (size_t)slot*tileSize + localIndex(i,j,k) ];
+}
+
+template <class T>
+inline const T&
+ZSparseField3D<T>::tileValue( int ti, int tj, int tk ) const
+{
+	return _tileValue[ tileIndex( ti, tj, tk ) ];
+}
+
+template <class T>
+inline T*
+ZSparseField3D<T>::tileData( int slot )
+{
+	return &_data[ (size_t)slot*tileSize ];
+}
+
+template <class T>
+inline const T*
+ZSparseField3D<T>::tileData( int slot ) const
+{
+	return &_data[ (size_t)slot*tileSize ];
+}
+
+template <class T>
+inline int
+ZSparseField3D<T>::activateTile( int ti, int tj, int tk )
+{
+	bool added = false;
+	const int slot = _addTile( ti, tj, tk, added );
+
+	if( added )
+	{
+		_data.resize( (size_t)(slot+1)*tileSize, _tileValue[ tileIndex( ti, tj, tk ) ] );
+	}
+
+	return slot;
+}
+
+template <class T>
+inline T&
+ZSparseField3D<T>::activate( int i, int j, int k )
+{
+	const int slot = activateTile( i>>tileLog2, j>>tileLog2, k>>tileLog2 );
+	return _data[ (size_t)slot*tileSize + localIndex(i,j,k) ];
+}
+
+template <class T>
+inline void
+ZSparseField3D<T>::setValue( int i, int j, int k, const T& v )
+{
+	activate( i, j, k ) = v;
+}
+
+template <class T>
+inline void
+ZSparseField3D<T>::prune( float tolerance, bool useOpenMP )
+{
+	const int numActive = _tileCoord.length();
+	if( !numActive ) { return; }
+
+	std::vector<char> keep( numActive, 0 );
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( s, 0, numActive )
+	{
+		int i0, i1, j0, j1, k0, k1;
+		getElementRange( s, i0, i1, j0, j1, k0, k1 );
+
+		const T* d = tileData( s );
+		const T& v0 = d[ localIndex(i0,j0,k0) ];
+
+		for( int k=k0; k<=k1 && !keep[s]; ++k )
+		for( int j=j0; j<=j1 && !keep[s]; ++j )
+		for( int i=i0; i<=i1; ++i )
+		{
+			if( !_isEquivalent( d[ localIndex(i,j,k) ], v0, tolerance ) ) { keep[s] = 1; break; }
+		}
+	}
+
+	// compaction: the kept tiles are moved to the front in their slot order
+	int count = 0;
+
+	FOR( s, 0, numActive )
+	{
+		const ZInt3 t = _tileCoord[s];
+		const size_t tIdx = tileIndex( t[0], t[1], t[2] );
+
+		if( !keep[s] )
+		{
+			int i0, i1, j0, j1, k0, k1;
+			getElementRange( s, i0, i1, j0, j1, k0, k1 );
+
+			_tileValue[tIdx] = tileData(s)[ localIndex(i0,j0,k0) ];
+			_tileSlot[tIdx]  = -1;
+
+			continue;
+		}
+
+		if( count != s )
+		{
+			std::copy( tileData(s), tileData(s)+tileSize, tileData(count) );
+			_tileCoord[count] = t;
+		}
+
+		_tileSlot[tIdx] = count++;
+	}
+
+	_tileCoord.resize( count );
+	_data.resize( (size_t)count*tileSize );
+}
+
+template <class T>
+inline double
+ZSparseField3D<T>::usedMemorySize( ZDataUnit::DataUnit dataUnit ) const
+{
+	double bytes = 0.0;
+	bytes += (double)_tileSlot.size() * sizeof(int);
+	bytes += (double)_tileCoord.size() * sizeof(ZInt3);
+	bytes += (double)_tileValue.size() * sizeof(T);
+	bytes += (double)_data.size() * sizeof(T);
+
+	switch( dataUnit )
+	{
+		case ZDataUnit::zBytes:     { return bytes; }
+		case ZDataUnit::zKilobytes: { return (bytes/1024.0); }
+		case ZDataUnit::zMegabytes: { return (bytes/ZPow2(1024.0)); }
+		case ZDataUnit::zGigabytes: { return (bytes/ZPow3(1024.0)); }
+		default: { cout << "Error@ZSparseField3D::usedMemorySize(): Invalid data unit." << endl; return 0.0; }
+	}
+}
+
+template <class T>
+inline T
+ZSparseField3D<T>::_lerp( const ZPoint& p ) const
+{
+	int i, j, k;
+	float fx, fy, fz;
+	_getLerpCoords( p, i, j, k, fx, fy, fz );
+
+	T val[8];
+
+	if( (i&tileMask)!=tileMask && (j&tileMask)!=tileMask && (k&tileMask)!=tileMask )
+	{
+		// all eight elements are in the same tile.
+		const size_t tIdx = tileIndex( i>>tileLog2, j>>tileLog2, k>>tileLog2 );
+		const int slot = _tileSlot[tIdx];
+
+		if( slot < 0 ) { return _tileValue[tIdx]; }
+
+		const int sj = tileWidth;
+		const int sk = tileWidth*tileWidth;
+
+		const T* d = &_data[ (size_t)slot*tileSize + localIndex(i,j,k) ];
+
+		val[0]=d[0];    val[1]=d[1];      val[2]=d[1+sk];      val[3]=d[sk];
+		val[4]=d[sj];   val[5]=d[sj+1];   val[6]=d[sj+1+sk];   val[7]=d[sj+sk];
+	}
+	else
+	{
+		val[0]=value(i,j,k);     val[1]=value(i+1,j,k);     val[2]=value(i+1,j,k+1);     val[3]=value(i,j,k+1);
+		val[4]=value(i,j+1,k);   val[5]=value(i+1,j+1,k);   val[6]=value(i+1,j+1,k+1);   val[7]=value(i,j+1,k+1);
+	}
+
+	const float _fx=1-fx, _fy=1-fy, _fz=1-fz;
+	const float wgt[8] = { _fx*_fy*_fz, fx*_fy*_fz, fx*_fy*fz, _fx*_fy*fz, _fx*fy*_fz, fx*fy*_fz, fx*fy*fz, _fx*fy*fz };
+
+	T est = wgt[0] * val[0];
+	FOR(l,1,8) { est += wgt[l] * val[l]; }
+
+	return est;
+}
+
+template <class T>
+template <class DENSE>
+inline void
+ZSparseField3D<T>::_fromDense( const DENSE& dense, float tolerance, bool useOpenMP )
+{
+	ZSparseField3D<T>::set( dense, dense.location(), _background );
+	if( _iMax < 0 ) { return; }
+
+	const int numTileRows = _tny * _tnz;
+
+	// 1st pass: which tiles are not constant (in parallel)
+	std::vector<char> active( numTiles(), 0 );
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( jk, 0, numTileRows )
+	{
+		const int tj = jk % _tny;
+		const int tk = jk / _tny;
+
+		const int j0 = tj<<tileLog2, j1 = ZMin( j0+tileMask, _jMax );
+		const int k0 = tk<<tileLog2, k1 = ZMin( k0+tileMask, _kMax );
+
+		FOR( ti, 0, _tnx )
+		{
+			const int i0 = ti<<tileLog2, i1 = ZMin( i0+tileMask, _iMax );
+
+			const size_t tIdx = tileIndex( ti, tj, tk );
+			const T& v0 = dense( i0, j0, k0 );
+
+			_tileValue[tIdx] = v0;
+
+			char& a = active[tIdx];
+
+			for( int k=k0; k<=k1 && !a; ++k )
+			for( int j=j0; j<=j1 && !a; ++j )
+			for( int i=i0; i<=i1; ++i )
+			{
+				if( !_isEquivalent( dense(i,j,k), v0, tolerance ) ) { a = 1; break; }
+			}
+		}
+	}
+
+	// 2nd pass: slot assignment in the tile order
+	FOR( tk, 0, _tnz )
+	FOR( tj, 0, _tny )
+	FOR( ti, 0, _tnx )
+	{
+		if( !active[ tileIndex( ti, tj, tk ) ] ) { continue; }
+
+		bool added = false;
+		_addTile( ti, tj, tk, added );
+	}
+
+	const int numActive = _tileCoord.length();
+
+	_data.resize( (size_t)numActive*tileSize );
+
+	// 3rd pass: copying the elements of the active tiles (in parallel)
+	#pragma omp parallel for if( useOpenMP )
+	FOR( s, 0, numActive )
+	{
+		const ZInt3& t = _tileCoord[s];
+
+		T* d = tileData( s );
+		std::fill( d, d+tileSize, _tileValue[ tileIndex( t[0], t[1], t[2] ) ] );
+
+		PER_EACH_ACTIVE_ELEMENT_3D( (*this), s )
+
+			d[ localIndex(i,j,k) ] = dense(i,j,k);
+
+		END_PER_EACH_ACTIVE_ELEMENT_3D
+	}
+}
+
+template <class T>
+template <class DENSE>
+inline void
+ZSparseField3D<T>::_toDense( DENSE& dense, bool useOpenMP ) const
+{
+	dense.set( (const ZGrid3D&)(*this), _location );
+	if( _iMax < 0 ) { return; }
+
+	const int numTileRows = _tny * _tnz;
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( jk, 0, numTileRows )
+	{
+		const int tj = jk % _tny;
+		const int tk = jk / _tny;
+
+		const int j0 = tj<<tileLog2, j1 = ZMin( j0+tileMask, _jMax );
+		const int k0 = tk<<tileLog2, k1 = ZMin( k0+tileMask, _kMax );
+
+		FOR( ti, 0, _tnx )
+		{
+			const int i0 = ti<<tileLog2, i1 = ZMin( i0+tileMask, _iMax );
+
+			const size_t tIdx = tileIndex( ti, tj, tk );
+			const int slot = _tileSlot[tIdx];
+
+			const T* d = ( slot < 0 ) ? (const T*)NULL : tileData( slot );
+
+			for( int k=k0; k<=k1; ++k )
+			for( int j=j0; j<=j1; ++j )
+			for( int i=i0; i<=i1; ++i )
+			{
+				dense(i,j,k) = d ? d[ localIndex(i,j,k) ] : _tileValue[tIdx];
+			}
+		}
+	}
+}
+
+template <class T>
+inline void
+ZSparseField3D<T>::_writeData( ofstream& fout ) const
+{
+	fout.write( (char*)&_background, sizeof(T) );
+
+	const size_t numTileValues = _tileValue.size();
+	const size_t numData       = _data.size();
+
+	fout.write( (char*)&numTileValues, sizeof(size_t) );
+	fout.write( (char*)&numData,       sizeof(size_t) );
+
+	if( numTileValues ) { fout.write( (char*)&_tileValue[0], numTileValues*sizeof(T) ); }
+	if( numData       ) { fout.write( (char*)&_data[0],      numData*sizeof(T)       ); }
+}
+
+// It must follow ZSparseField3DBase::read(): the sizes are checked against the tiles of the header.
+template <class T>
+inline bool
+ZSparseField3D<T>::_readData( ifstream& fin )
+{
+	fin.read( (char*)&_background, sizeof(T) );
+
+	size_t numTileValues = 0, numData = 0;
+
+	fin.read( (char*)&numTileValues, sizeof(size_t) );
+	fin.read( (char*)&numData,       sizeof(size_t) );
+
+	if( fin.fail() || ( numTileValues != numTiles() ) || ( numData != numActiveElements() ) )
+	{
+		cout << "Error@ZSparseField3D::_readData(): Invalid data size." << endl;
+		return false;
+	}
+
+	_tileValue.resize( numTileValues );
+	_data.resize( numData );
+
+	if( numTileValues ) { fin.read( (char*)&_tileValue[0], numTileValues*sizeof(T) ); }
+	if( numData       ) { fin.read( (char*)&_data[0],      numData*sizeof(T)       ); }
+
+	if( fin.fail() )
+	{
+		cout << "Error@ZSparseField3D::_readData(): Failed to read the data." << endl;
+		return false;
+	}
+
+	return true;
+}
+
+template <class T>
+inline bool
+ZSparseField3D<T>::_isEquivalent( const float& a, const float& b, float tolerance )
+{
+	return ( ZAbs(a-b) <= tolerance );
+}
+
+template <class T>
+inline bool
+ZSparseField3D<T>::_isEquivalent( const ZVector& a, const ZVector& b, float tolerance )
+{
+	return ( ZAbs(a.x-b.x) <= tolerance && ZAbs(a.y-b.y) <= tolerance && ZAbs(a.z-b.z) <= tolerance );
+}
+
+ZELOS_NAMESPACE_END
+
+#endif
+
@@ -0,0 +1,176 @@
+//----------------------//
+// ZSparseField3DBase.h //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.25                               //
+//-------------------------------------------------------//
+
+#ifndef _ZSparseField3DBase_h_
+#define _ZSparseField3DBase_h_
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+/// @brief The tile structure of the sparse 3D fields.
+/**
+	The elements are grouped into 8x8x8 tiles, and only the active tiles have their own memory.
+	The tile table has one slot index per tile of the whole domain (4 bytes per 512 elements).
+	The element indices are the same as those of the dense field of the same grid and location,
+	but the linear indices are 64-bit, so the domain is not limited by the int range.
+	Activating tiles is not thread-safe, while the read accesses and the per-tile loops can be run in parallel.
+*/
+class ZSparseField3DBase : public ZGrid3D
+{
+	public:
+
+		static const int tileLog2  = 3;
+		static const int tileWidth = 1 << tileLog2;			// 8
+		static const int tileMask  = tileWidth - 1;			// 7
+		static const int tileSize  = tileWidth*tileWidth*tileWidth;	// 512
+
+	protected:
+
+		ZFieldLocation::FieldLocation _location;
+
+		int              _iMax, _jMax, _kMax;	// max. element indices
+		int              _tnx, _tny, _tnz;		// # of tiles per each axis
+
+		std::vector<int> _tileSlot;				// slot of each tile of the domain (-1: inactive)
+		ZInt3Array       _tileCoord;			// tile coordinates of each active tile
+
+	public:
+
+		ZSparseField3DBase();
+		ZSparseField3DBase( const ZGrid3D& grid, ZFieldLocation::FieldLocation loc );
+
+		void set( const ZGrid3D& grid, ZFieldLocation::FieldLocation loc=ZFieldLocation::zCell );
+
+		void reset();
+
+		bool directComputable( const ZSparseField3DBase& other ) const;
+
+		ZFieldLocation::FieldLocation location() const { return _location; }
+
+		int iMax() const { return _iMax; }
+		int jMax() const { return _jMax; }
+		int kMax() const { return _kMax; }
+
+		int tnx() const { return _tnx; }
+		int tny() const { return _tny; }
+		int tnz() const { return _tnz; }
+
+		size_t numElements() const;
+		size_t numTiles() const;
+		int numActiveTiles() const;
+		size_t numActiveElements() const;
+
+		size_t tileIndex( int ti, int tj, int tk ) const;
+
+		int tileSlot( int ti, int tj, int tk ) const;
+		int tileSlotOfElement( int i, int j, int k ) const;
+		const ZInt3& tileCoord( int slot ) const;
+
+		// the element index range of the tile: [i0,i1]x[j0,j1]x[k0,k1]
+		void getElementRange( int slot, int& i0, int& i1, int& j0, int& j1, int& k0, int& k1 ) const;
+
+		static int localIndex( int i, int j, int k );
+
+		ZPoint position( int i, int j, int k ) const;
+
+		void write( ofstream& fout ) const;
+		bool read( ifstream& fin );
+
+	protected:
+
+		// It returns the slot of the tile, and whether it is newly added.
+		int _addTile( int ti, int tj, int tk, bool& added );
+
+		// the same cell/node lookup as ZScalarField3D::lerp()
+		void _getLerpCoords( const ZPoint& p, int& i, int& j, int& k, float& fx, float& fy, float& fz ) const;
+};
+
+inline size_t
+ZSparseField3DBase::tileIndex( int ti, int tj, int tk ) const
+{
+	return ( (size_t)ti + (size_t)_tnx * ( (size_t)tj + (size_t)_tny * (size_t)tk ) );
+}
+
+inline int
+ZSparseField3DBase::tileSlot( int ti, int tj, int tk ) const
+{
+	return _tileSlot[ tileIndex( ti, tj, tk ) ];
+}
+
+inline int
+ZSparseField3DBase::tileSlotOfElement( int i, int j, int k ) const
+{
+	return _tileSlot[ tileIndex( i>>tileLog2, j>>tileLog2, k>>tileLog2 ) ];
+}
+
+inline const ZInt3&
+ZSparseField3DBase::tileCoord( int slot ) const
+{
+	return _tileCoord[slot];
+}
+
+inline int
+ZSparseField3DBase::localIndex( int i, int j, int k )
+{
+	return ( (i&tileMask) | ((j&tileMask)<<tileLog2) | ((k&tileMask)<<(2*tileLog2)) );
+}
+
+inline void
+ZSparseField3DBase::getElementRange( int slot, int& i0, int& i1, int& j0, int& j1, int& k0, int& k1 ) const
+{
+	const ZInt3& t = _tileCoord[slot];
+
+	i0 = t[0] << tileLog2;   i1 = ZMin( i0+tileMask, _iMax );
+	j0 = t[1] << tileLog2;   j1 = ZMin( j0+tileMask, _jMax );
+	k0 = t[2] << tileLog2;   k1 = ZMin( k0+tileMask, _kMax );
+}
+
+inline ZPoint
+ZSparseField3DBase::position( int i, int j, int k ) const
+{
+	float x=i*_dx+_minPt.x, y=j*_dy+_minPt.y, z=k*_dz+_minPt.z;
+	if( _location==ZFieldLocation::zCell ) { x+=_dxd2; y+=_dyd2; z+=_dzd2; }
+	return ZPoint(x,y,z);
+}
+
+inline void
+ZSparseField3DBase::_getLerpCoords( const ZPoint& p, int& i, int& j, int& k, float& fx, float& fy, float& fz ) const
+{
+	float x=p.x, y=p.y, z=p.z;
+	if( _location==ZFieldLocation::zCell ){ x-=_dxd2; y-=_dyd2; z-=_dzd2; }
+
+	i=int(x=((x-_minPt.x)*_ddx)); fx=x-i;
+	j=int(y=((y-_minPt.y)*_ddy)); fy=y-j;
+	k=int(z=((z-_minPt.z)*_ddz)); fz=z-k;
+
+	if(i<0) {i=0;fx=0;} else if(i>=_iMax) {i=_iMax-1;fx=1;}
+	if(j<0) {j=0;fy=0;} else if(j>=_jMax) {j=_jMax-1;fy=1;}
+	if(k<0) {k=0;fz=0;} else if(k>=_kMax) {k=_kMax-1;fz=1;}
+}
+
+ostream&
+operator<<( ostream& os, const ZSparseField3DBase& object );
+
+////////////
+// macros //
+
+// per each element of the active tiles (slot: the tile slot)
+#define PER_EACH_ACTIVE_ELEMENT_3D( field, slot )                 \
+	{                                                             \
+		int i0, i1, j0, j1, k0, k1;                               \
+		field.getElementRange( slot, i0, i1, j0, j1, k0, k1 );    \
+		for( int k=k0; k<=k1; ++k ) {                             \
+		for( int j=j0; j<=j1; ++j ) {                             \
+		for( int i=i0; i<=i1; ++i ) {
+
+#define END_PER_EACH_ACTIVE_ELEMENT_3D }}}}
+
+ZELOS_NAMESPACE_END
+
+#endif
+
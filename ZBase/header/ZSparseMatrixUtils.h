@@ -5,7 +5,7 @@
 //         Wanho Choi @ Dexter Studios                   //
 //         Jaegwang Lim @ Dexter Studios                 //
 //         Nayoung Kim @ Dexter Studios                  //
-// last update: 2018.03.08                               //
+// last update: 2019.03.28                               //
 //-------------------------------------------------------//
 
 #ifndef _ZSparseMatrixUtils_h_
@@ -126,23 +126,15 @@ Multiply( const ZFloatArray& a, const ZFloatArray& b, float& result, const bool
 {
 	const int N = a.length();
 
-	result = 0.f;
+	double sum = 0.0;
 
-	const int numThreads = useOpenMP ? ZMin( omp_get_num_procs(), a.length() ) : 1;
-
-	ZFloatArray buffer( numThreads );
-
-	#pragma omp parallel for if( useOpenMP )
+	#pragma omp parallel for reduction( +: sum ) if( useOpenMP )
 	for( int i=0; i<N; ++i )
 	{
-		const int tid = omp_get_thread_num();
-		buffer[tid] += a[i]*b[i];
+		sum += a[i]*b[i];
 	}
 
-	for( int i=0; i<numThreads; ++i )
-	{
-		result += buffer[i];
-	}    
+	result = (float)sum;
 }
 
 inline void 
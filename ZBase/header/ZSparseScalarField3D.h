@@ -0,0 +1,73 @@
+//------------------------//
+// ZSparseScalarField3D.h //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.25                               //
+//-------------------------------------------------------//
+
+#ifndef _ZSparseScalarField3D_h_
+#define _ZSparseScalarField3D_h_
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+/// @brief The sparse (8x8x8 tiled) version of ZScalarField3D.
+/**
+	The samplers return the same values as those of ZScalarField3D of the same grid and location.
+	For a narrow band level set, set the background as the outside distance:
+	the tiles out of the band keep the constant value of their own side.
+*/
+class ZSparseScalarField3D : public ZSparseField3D<float>
+{
+	public:
+
+		ZSparseScalarField3D();
+		ZSparseScalarField3D( const ZGrid3D& grid, ZFieldLocation::FieldLocation loc=ZFieldLocation::zCell, float background=0.f );
+		ZSparseScalarField3D( const char* filePathName );
+
+		void set( const ZGrid3D& grid, ZFieldLocation::FieldLocation loc=ZFieldLocation::zCell, float background=0.f );
+
+		float lerp( const ZPoint& p ) const;
+
+		ZVector gradient( const ZPoint& p ) const;
+
+		// The tiles whose values are within the tolerance from each other are stored as constant tiles.
+		void fromDense( const ZScalarField3D& dense, float tolerance=0.f, bool useOpenMP=true );
+		void toDense( ZScalarField3D& dense, bool useOpenMP=true ) const;
+
+		const ZString dataType() const;
+
+		bool save( const char* filePathName ) const;
+		bool load( const char* filePathName );
+};
+
+inline float
+ZSparseScalarField3D::lerp( const ZPoint& p ) const
+{
+	return ZSparseField3D<float>::_lerp( p );
+}
+
+inline ZVector
+ZSparseScalarField3D::gradient( const ZPoint& p ) const
+{
+	int i, j, k;
+	float fx, fy, fz;
+	_getLerpCoords( p, i, j, k, fx, fy, fz );
+
+	float val[8];
+	val[0]=value(i,j,k);     val[1]=value(i+1,j,k);     val[2]=value(i+1,j,k+1);     val[3]=value(i,j,k+1);
+	val[4]=value(i,j+1,k);   val[5]=value(i+1,j+1,k);   val[6]=value(i+1,j+1,k+1);   val[7]=value(i,j+1,k+1);
+
+	return ZVector( ZLerp( ZLerp( val[1]-val[0], val[2]-val[3], fz ), ZLerp( val[5]-val[4], val[6]-val[7], fz ), fy ),
+					ZLerp( ZLerp( val[4]-val[0], val[7]-val[3], fz ), ZLerp( val[5]-val[1], val[6]-val[2], fz ), fx ),
+					ZLerp( ZLerp( val[3]-val[0], val[2]-val[1], fx ), ZLerp( val[7]-val[4], val[6]-val[5], fx ), fy ) ).normalize();
+}
+
+ostream&
+operator<<( ostream& os, const ZSparseScalarField3D& object );
+
+ZELOS_NAMESPACE_END
+
+#endif
+
@@ -0,0 +1,50 @@
+//------------------------//
+// ZSparseVectorField3D.h //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.25                               //
+//-------------------------------------------------------//
+
+#ifndef _ZSparseVectorField3D_h_
+#define _ZSparseVectorField3D_h_
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+/// @brief The sparse (8x8x8 tiled) version of ZVectorField3D.
+class ZSparseVectorField3D : public ZSparseField3D<ZVector>
+{
+	public:
+
+		ZSparseVectorField3D();
+		ZSparseVectorField3D( const ZGrid3D& grid, ZFieldLocation::FieldLocation loc=ZFieldLocation::zCell, const ZVector& background=ZVector(0.f) );
+		ZSparseVectorField3D( const char* filePathName );
+
+		void set( const ZGrid3D& grid, ZFieldLocation::FieldLocation loc=ZFieldLocation::zCell, const ZVector& background=ZVector(0.f) );
+
+		ZVector lerp( const ZPoint& p ) const;
+
+		// The tiles whose components are within the tolerance from each other are stored as constant tiles.
+		void fromDense( const ZVectorField3D& dense, float tolerance=0.f, bool useOpenMP=true );
+		void toDense( ZVectorField3D& dense, bool useOpenMP=true ) const;
+
+		const ZString dataType() const;
+
+		bool save( const char* filePathName ) const;
+		bool load( const char* filePathName );
+};
+
+inline ZVector
+ZSparseVectorField3D::lerp( const ZPoint& p ) const
+{
+	return ZSparseField3D<ZVector>::_lerp( p );
+}
+
+ostream&
+operator<<( ostream& os, const ZSparseVectorField3D& object );
+
+ZELOS_NAMESPACE_END
+
+#endif
+
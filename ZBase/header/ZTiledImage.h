@@ -0,0 +1,116 @@
+//---------------//
+// ZTiledImage.h //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.30                               //
+//-------------------------------------------------------//
+
+#ifndef _ZTiledImage_h_
+#define _ZTiledImage_h_
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+/// @brief A read-only mip-mapped image stored in square tiles.
+/**
+	Each mip level is stored in the tiles of TileSize x TileSize pixels (the pixels of a tile are contiguous),
+	so the neighboring lookups of the scattering and the baking stay in a few cache lines.
+	Level 0 is the original resolution, and each level has the half resolution of the previous one (2x2 box filter).
+	The (u,v) convention is the same as ZImageMap::fastValue(): u=[0,1] from left to right, v=[0,1] from bottom to top.
+*/
+class ZTiledImage
+{
+	public:
+
+		static const int TileSize = 64;
+
+	private:
+
+		struct Level
+		{
+			int                width;
+			int                height;
+			int                numTilesX;
+			std::vector<float> data;	// tile by tile (each tile is padded to TileSize x TileSize)
+		};
+
+		int                _numChannels;
+		std::vector<Level> _levels;
+		ZString            _filePathName;
+
+	public:
+
+		ZTiledImage();
+		ZTiledImage( const ZImageMap& img, bool useOpenMP=true );
+
+		void reset();
+
+		bool set( const ZImageMap& img, bool useOpenMP=true );
+
+		int width( int level=0 ) const  { return _levels[level].width;  }
+		int height( int level=0 ) const { return _levels[level].height; }
+		int numChannels() const         { return _numChannels;          }
+		int numLevels() const           { return (int)_levels.size();   }
+		bool empty() const              { return _levels.empty();       }
+
+		ZString filePathName() const { return _filePathName; }
+
+		// i: width, j: height, k: channel (clamped to the edge)
+		float texel( int i, int j, int k, int level=0 ) const;
+
+		// the nearest pixel of level 0 (the same value as ZImageMap::fastValue())
+		float fastValue( float u, float v, int k=0 ) const;
+
+		// the trilinear lookup: bilinear in each level, and linear between the two levels around lod
+		float sample( float u, float v, float lod=0.f, int k=0 ) const;
+
+		// 0.299*r + 0.587*g + 0.114*b (channel 0 for the single channel images)
+		float intensity( float u, float v, float lod=0.f ) const;
+
+		double usedMemorySize( ZDataUnit::DataUnit dataUnit=ZDataUnit::zBytes ) const;
+
+	private:
+
+		float _texel( const Level& L, int i, int j, int k ) const;
+		float _bilinear( const Level& L, float u, float v, int k ) const;
+
+		void _allocate( Level& L, int w, int h );
+};
+
+inline float
+ZTiledImage::_texel( const Level& L, int i, int j, int k ) const
+{
+	i = ZClamp( i, 0, L.width -1 );
+	j = ZClamp( j, 0, L.height-1 );
+
+	const int tile = (j/TileSize)*L.numTilesX + (i/TileSize);
+	const int pix  = (j%TileSize)*TileSize    + (i%TileSize);
+
+	return L.data[ (size_t)_numChannels*( (size_t)tile*TileSize*TileSize + pix ) + k ];
+}
+
+inline float
+ZTiledImage::fastValue( float u, float v, int k ) const
+{
+	const Level& L = _levels[0];
+
+	const int i = ZClamp( int(    u *L.width ), 0, L.width -1 );
+	const int j = ZClamp( int((1-v)*L.height), 0, L.height-1 );
+
+	return _texel( L, i, j, k );
+}
+
+inline float
+ZTiledImage::texel( int i, int j, int k, int level ) const
+{
+	return _texel( _levels[level], i, j, k );
+}
+
+ostream&
+operator<<( ostream& os, const ZTiledImage& object );
+
+ZELOS_NAMESPACE_END
+
+#endif
+
@@ -82,6 +82,11 @@ class ZTriMesh
 		bool save( const char* filePathName ) const;
 		bool load( const char* filePathName );
 
+		// the chunked cache file of ZCacheFile.h
+		// (loadCache() copies the arrays into the members; ZCacheReader::view() reads them from the file without any copy.)
+		bool saveCache( const char* filePathName ) const;
+		bool loadCache( const char* filePathName );
+
 		void drawVertices() const;
 		void drawWireframe() const;
 		void drawSurface( bool withNormal=false ) const;
@@ -2,7 +2,7 @@
 // ZTriMeshConnectionInfo.h //
 //-------------------------------------------------------//
 // author: Wanho Choi @ Dexter Studios                   //
-// last update: 2015.12.04                               //
+// last update: 2019.03.30                               //
 //-------------------------------------------------------//
 
 #ifndef _ZTriMeshConnectionInfo_h_
@@ -12,12 +12,25 @@
 
 ZELOS_NAMESPACE_BEGIN
 
+/// @brief The connectivity tables of a triangle mesh.
+/**
+	The half-edge 3*i+j goes from v2t[i][j] to v2t[i][(j+1)%3] of the i-th triangle, so next/prev/triangle are implicit.
+	The edges are found by sorting the half-edges by their (smaller, larger) vertex keys in the buckets of the smaller vertex.
+	The edges are numbered in the order of the keys, and all the lists are in the ascending order (independent of the number of threads).
+	The per-vertex lists are stored as the flat CSR (compressed sparse row) arrays:
+	the entries of the i-th vertex are xxxIndex[xxxOffset[i]], ..., xxxIndex[xxxOffset[i+1]-1].
+	Each build_xxx() builds only what it needs, and build() builds all the flat tables at once.
+	The calculate_xxx() functions fill the nested tables (v2v, e2v, ...) from the flat ones.
+	set() keeps the tables when the triangles are not changed (ex: a deforming mesh).
+	An edge shared by more than two triangles (non-manifold) has no twin half-edges.
+*/
 class ZTriMeshConnectionInfo
 {
 	private:
 
 		int  _numVertices;
 		int  _numTriangles;
+		int  _numEdges;
 
 	public: // v:vertex, e:edge, t:triangle
 
@@ -33,6 +46,16 @@ class ZTriMeshConnectionInfo
 		ZInt3Array    e2t;	// edges-to-triangle list
 		ZInt3Array    t2t;	// triangles-to-triangle list
 
+	public: // the flat tables
+
+		ZIntArray     heTwin;		// the opposite half-edge of each half-edge (-1: boundary or non-manifold)
+		ZIntArray     heEdge;		// the edge (index of v2e) of each half-edge (-1: degenerate)
+		ZIntArray     vertexHe;		// an outgoing half-edge of each vertex (the boundary one if any, -1: isolated)
+
+		ZIntArray     v2vOffset, v2vIndex;	// one-ring vertices (CSR)
+		ZIntArray     e2vOffset, e2vIndex;	// edges around each vertex (CSR)
+		ZIntArray     t2vOffset, t2vIndex;	// triangles around each vertex (CSR)
+
 	public:
 
 		ZTriMeshConnectionInfo();
@@ -42,19 +65,87 @@ class ZTriMeshConnectionInfo
 
 		void set( const ZTriMesh& mesh );
 
-		void calculate_v2v(); // from v2t
-		void calculate_e2v(); // from v2e
-		void calculate_t2v(); // from v2t
+		int numVertices() const;
+		int numTriangles() const;
+		int numEdges() const;
+
+		// the half-edge 3*i+j of the i-th triangle
+		static int heTriangle( int h );
+		static int heNext( int h );
+		static int hePrev( int h );
+		int heFrom( int h ) const;
+		int heTo( int h ) const;
+
+		void build( bool useOpenMP=true );					// all the flat tables
+
+		void build_halfEdges( bool useOpenMP=true );		// heTwin, heEdge, vertexHe, v2e, t2e, e2t, t2t
+		void build_v2v( bool useOpenMP=true );				// v2vOffset, v2vIndex (and the half-edges)
+		void build_e2v( bool useOpenMP=true );				// e2vOffset, e2vIndex (and the half-edges)
+		void build_t2v( bool useOpenMP=true );				// t2vOffset, t2vIndex
 
-		void calculate_v2e(); // from t2t
+		void calculate_v2v(); // from v2vOffset/v2vIndex
+		void calculate_e2v(); // from e2vOffset/e2vIndex
+		void calculate_t2v(); // from t2vOffset/t2vIndex
+
+		void calculate_v2e(); // from the half-edges
 		void calculate_e2e(); // none
-		void calculate_t2e(); // from t2e 
+		void calculate_t2e(); // from the half-edges
 
 		void calculate_v2t(); // none (v2t = mesh.v012)
-		void calculate_e2t(); // from e2v
-		void calculate_t2t(); // fromo v2t
+		void calculate_e2t(); // from the half-edges
+		void calculate_t2t(); // from the half-edges
+
+		double usedMemorySize( ZDataUnit::DataUnit dataUnit=ZDataUnit::zBytes ) const;
 };
 
+inline int
+ZTriMeshConnectionInfo::numVertices() const
+{
+	return _numVertices;
+}
+
+inline int
+ZTriMeshConnectionInfo::numTriangles() const
+{
+	return _numTriangles;
+}
+
+inline int
+ZTriMeshConnectionInfo::numEdges() const
+{
+	return _numEdges;
+}
+
+inline int
+ZTriMeshConnectionInfo::heTriangle( int h )
+{
+	return ( h / 3 );
+}
+
+inline int
+ZTriMeshConnectionInfo::heNext( int h )
+{
+	return ( ( h%3 == 2 ) ? ( h-2 ) : ( h+1 ) );
+}
+
+inline int
+ZTriMeshConnectionInfo::hePrev( int h )
+{
+	return ( ( h%3 == 0 ) ? ( h+2 ) : ( h-1 ) );
+}
+
+inline int
+ZTriMeshConnectionInfo::heFrom( int h ) const
+{
+	return v2t[h/3][h%3];
+}
+
+inline int
+ZTriMeshConnectionInfo::heTo( int h ) const
+{
+	return v2t[h/3][(h%3==2)?0:(h%3+1)];
+}
+
 ostream&
 operator<<( ostream& os, const ZTriMeshConnectionInfo& object );
 
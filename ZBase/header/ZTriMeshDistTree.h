@@ -3,7 +3,7 @@
 //-------------------------------------------------------//
 // author: Taeyong Kim @ nVidia                          //
 //         Wanho Choi @ Dexter Studios                   //
-// last update: 2016.02.04                               //
+// last update: 2019.03.20                               //
 //-------------------------------------------------------//
 
 #ifndef _ZTriMeshDistTree_h_
@@ -14,57 +14,28 @@
 ZELOS_NAMESPACE_BEGIN
 
 /// @brief Bounding box hierarchy for accelerating point-triangle distance query.
+/**
+	It is a thin wrapper of ZTriangleBVH.
+	maxLevel is the max. depth of the tree, and maxElements is the max. number of triangles per leaf.
+*/
 class ZTriMeshDistTree
 {
 	private:
 
-		/// Distance information used by KDTree structures
-		struct Data
-		{
-			int    id;		///< triangle id.
-			float  dist;	///< computed distance.
-			ZPoint pt;		///< computed point.
-			float  a, b;	///< barycentric coordinates
-
-			Data()
-			: id(-1), dist(Z_LARGE), a(0), b(0) {}
-
-			bool valid()   const { return (id>=0); }
-			bool invalid() const { return (id< 0); }
-		};
-
-		/// Each cell of spatial partitioning scheme
-		struct Cell
-		{
-			int          level;		///< suvdivision level of the cell
-			int          parent;	///< index of the parent
-			int          left;		///< index of the left child
-			int          right;		///< index of the right child
-			ZIntArray    ids;		///< element ID list
-			ZBoundingBox bBox;		///< bounding box of the cell
-
-			Cell( int subdLevel= -1 )
-			: level(subdLevel), parent(-1), left(-1), right(-1) {}
-
-			bool isLeaf() const { return ( (left<0) || (right<0) ); }
-		};
-
-	private:
-
-		ZTriMesh*                           _meshPtr;
-		int                                 _maxLevel;		///< The max. level of subdivision.
-		int                                 _maxElements;	///< The max. number of elements per each leaf node.
-		ZBoundingBoxArray                   _bBoxes;		///< The bounding boxes of triangles.
-		std::vector<ZTriMeshDistTree::Cell> _cells;			///< The cells.
+		ZTriMesh*         _meshPtr;
+		int               _maxLevel;		///< The max. level of subdivision.
+		int               _maxElements;		///< The max. number of elements per each leaf node.
+		ZBoundingBoxArray _bBoxes;			///< The bounding boxes of triangles.
+		ZTriangleBVH      _bvh;				///< The bounding volume hierarchy.
 
 	public:
 
-		ZTriMeshDistTree( int maxLevel=10, int maxElements=10 );
-		ZTriMeshDistTree( const ZTriMesh& mesh, int maxLevel=10, int maxElements=10 );
+		ZTriMeshDistTree( int maxLevel=32, int maxElements=4 );
+		ZTriMeshDistTree( const ZTriMesh& mesh, int maxLevel=32, int maxElements=4 );
 
 		void reset();
 
-		bool set( const ZTriMesh& mesh );
+		bool set( const ZTriMesh& mesh, bool useOpenMP=true );
 
 		const ZTriMesh& mesh() const;
 
@@ -73,6 +44,13 @@ class ZTriMeshDistTree
 		float getClosestPoint( const ZPoint& pt, int& closestTriangle, float& a, float& b, float maxDist=Z_LARGE ) const;
 		float getClosestPoint( const ZPoint& pt, ZPoint& closestPt, int& closestTriangle, float& a, float& b, float maxDist=Z_LARGE ) const;
 
+		// Batched versions of getClosestPoint(): the i-th outputs are the same as the results of the single query with points[i].
+		void getClosestPoints( const ZPointArray& points, ZFloatArray& dists, ZPointArray& closestPts, ZIntArray& closestTriangles, ZFloat3Array& baryCoords, float maxDist=Z_LARGE, bool useOpenMP=true ) const;
+
+		// Find the nearest triangle hit by the given ray(s) and return the distance along the normalized direction (Z_LARGE and -1 if no hit).
+		float intersectRay( const ZRay& ray, int& hitTriangle, ZFloat3& baryCoords ) const;
+		void intersectRays( const ZPointArray& origins, const ZVectorArray& directions, ZFloatArray& hitDists, ZIntArray& hitTriangles, ZFloat3Array& baryCoords, float maxDist=Z_LARGE, bool useOpenMP=true ) const;
+
 		// Find all triangles of which bounding boxes are colliding with the given bounding box.
 		void getTriangles( const ZBoundingBox& bBox, ZIntArray& triangles, bool accurate=true ) const;
 
@@ -85,36 +63,9 @@ class ZTriMeshDistTree
 		const ZBoundingBoxArray& boundingBoxes() const;
 		float averageNumTriangles() const;
 
-	private:
-
-		bool _initialize();
-		bool _subdividable( int cellId ) const;
-		void _splitCell( int cellId );
-		int _addCell( int level );
-
-		// Recursively find the closest triangle in the cell of the given index.
-		void _compute( int cellId, const ZPoint& point, ZTriMeshDistTree::Data& data ) const;
-
-		// Recursively find the cell index which is the deepest cell including the given bounding box.
-		int _findDeepestCellIncludingBox( int cellId, const ZBoundingBox& bBox ) const;
+		const ZTriangleBVH& bvh() const;
 };
 
-inline int
-ZTriMeshDistTree::_addCell( int level )
-{
-	_cells.push_back( ZTriMeshDistTree::Cell( level ) );
-	return ( (int)_cells.size()-1 );
-}
-
-inline bool
-ZTriMeshDistTree::_subdividable( int cellId ) const
-{
-	if( cellId >= (int)_cells.size() ) { return false; }
-	if( _cells[cellId].level >= _maxLevel ) { return false; }
-	if( _cells[cellId].ids.length() <= _maxElements ) { return false; }
-	return true;
-}
-
 ZELOS_NAMESPACE_END
 
 #endif
@@ -2,7 +2,7 @@
 // ZTriMeshIO.h //
 //-------------------------------------------------------//
 // author: Wanho Choi @ Dexter Studios                   //
-// last update: 2015.10.07                               //
+// last update: 2019.03.30                               //
 //-------------------------------------------------------//
 
 #ifndef _ZTriMeshIO_h_
@@ -12,7 +12,20 @@
 
 ZELOS_NAMESPACE_BEGIN
 
-bool Load_from_obj( ZTriMesh& mesh, const char* filePathName );
+class ZPolyMesh;
+class ZMesh;
+
+// Wavefront OBJ readers
+//
+// The file is memory-mapped and split into newline-aligned chunks which are parsed in parallel,
+// and the chunks are stitched by the prefix sums of their counts.
+// It reads v, vt, vn, and f (v, v/vt, v//vn, v/vt/vn, and the negative relative indices), and ignores the others.
+// ZTriMesh: the polygons are fan-triangulated, and uv has the vt of each triangle corner (if any vt).
+// ZPolyMesh: u, v, and uvIndices from vt, and vertexNormals from vn (if any).
+// ZMesh: zFace elements with the uv indices (if any vt).
+bool Load_from_obj( ZTriMesh&  mesh, const char* filePathName, bool useOpenMP=true );
+bool Load_from_obj( ZPolyMesh& mesh, const char* filePathName, bool useOpenMP=true );
+bool Load_from_obj( ZMesh&     mesh, const char* filePathName, bool useOpenMP=true );
 
 ZELOS_NAMESPACE_END
 
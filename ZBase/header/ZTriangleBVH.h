@@ -0,0 +1,180 @@
+//----------------//
+// ZTriangleBVH.h //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.20                               //
+//-------------------------------------------------------//
+
+#ifndef _ZTriangleBVH_h_
+#define _ZTriangleBVH_h_
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+// # of queries processed at once by the batched queries (SSE width)
+#define Z_BVH_PACKET_SIZE 4
+
+struct ZTriangleBVHBuildData;
+
+/// @brief Flat bounding volume hierarchy of triangles.
+/**
+	It is built by the binned SAH(surface area heuristic) split, and the sub-trees are built in parallel.
+	The nodes are stored in a flat array, and their bounding boxes are stored as SoA(structure of arrays).
+	The two children of a node are always adjacent (right = left+1).
+	The triangle vertices are copied in the leaf order, so the leaf tests do not touch the input mesh.
+	Ties of the closest distance are broken by the smaller triangle index, so the query results do not depend on the tree layout.
+	The batched queries use SSE packet kernels when available (x86-64 always has SSE2), and fall back to the single queries otherwise.
+*/
+class ZTriangleBVH
+{
+	private:
+
+		int         _maxDepth;			// max. depth of the tree
+		int         _maxLeafSize;		// max. # of triangles per leaf (unless the depth limit is reached)
+
+		int         _numNodes;			// # of nodes
+
+		// node bounding boxes (SoA)
+		ZFloatArray _minX, _minY, _minZ;
+		ZFloatArray _maxX, _maxY, _maxZ;
+
+		ZIntArray   _offset;			// interior: index of the left child, leaf: start index in _triIds
+		ZIntArray   _count;				// interior: 0, leaf: # of triangles
+
+		ZIntArray   _triIds;			// triangle indices in the leaf order
+
+		// triangle vertices in the leaf order
+		ZPointArray _p0, _p1, _p2;
+
+	public:
+
+		ZTriangleBVH( int maxDepth=32, int maxLeafSize=4 );
+
+		void reset();
+
+		bool build( const ZPointArray& points, const ZInt3Array& triangles, bool useOpenMP=true );
+		bool build( const ZPointArray& points, const ZInt3Array& triangles, const ZBoundingBoxArray& triBoxes, bool useOpenMP=true );
+
+		// the bounding box of each triangle (slightly expanded) as build() uses
+		static void getTriangleBoxes( const ZPointArray& points, const ZInt3Array& triangles, ZBoundingBoxArray& triBoxes, bool useOpenMP=true );
+
+		bool empty() const;
+
+		int maxDepth() const;
+		int maxLeafSize() const;
+
+		int numNodes() const;
+		int numLeafNodes() const;
+		int numTriangles() const;
+		float averageNumTriangles() const;
+
+		ZBoundingBox boundingBox( int node=0 ) const;
+
+		// It returns the closest distance, or Z_LARGE if no triangle is within maxDist.
+		// baryCoords: barycentric coordinates of the closest point w.r.t. the triangle vertices.
+		float closestPoint( const ZPoint& p, ZPoint& closestPt, int& closestTri, ZFloat3& baryCoords, float maxDist=Z_LARGE ) const;
+
+		// It returns the distance to the nearest hit within [ray.min(),ray.max()], or Z_LARGE if there is no hit.
+		// The distance is measured along the normalized ray direction.
+		float intersectRay( const ZRay& ray, int& hitTri, ZFloat3& baryCoords ) const;
+
+		// Batched versions of closestPoint() and intersectRay(): the queries are processed in packets of Z_BVH_PACKET_SIZE in parallel.
+		// The i-th outputs are the same as the results of the single query with the i-th input regardless of the packing or the thread count.
+		// closestPoints() packs the nearby queries together (in the Morton order), so the input order does not matter.
+		// intersectRays() packs them in the input order: the rays from nearby origins in similar directions should be consecutive.
+		void closestPoints( const ZPointArray& points, ZFloatArray& dists, ZPointArray& closestPts, ZIntArray& closestTris, ZFloat3Array& baryCoords, float maxDist=Z_LARGE, bool useOpenMP=true ) const;
+		void intersectRays( const ZPointArray& origins, const ZVectorArray& directions, ZFloatArray& hitDists, ZIntArray& hitTris, ZFloat3Array& baryCoords, float maxDist=Z_LARGE, bool useOpenMP=true ) const;
+
+		// It returns the indices of the triangles whose bounding boxes intersect the given box (in ascending order).
+		// If accurate is true, only the triangles intersecting the box itself are returned.
+		void getTriangles( const ZBoundingBox& bBox, ZIntArray& triangles, bool accurate=true ) const;
+
+		double usedMemorySize( ZDataUnit::DataUnit dataUnit=ZDataUnit::zBytes ) const;
+
+	private:
+
+		void _allocate( int numTriangles );
+		void _buildNode( ZTriangleBVHBuildData* d, int node, int begin, int end, int depth );
+		void _setBox( int node, const ZBoundingBox& box );
+
+		float _intersectRay( const ZPoint& o, const ZVector& dir, float tMin, float tMax, int& hitTri, ZFloat3& baryCoords ) const;
+
+		// packet kernels: Z_BVH_PACKET_SIZE queries at once
+		void _closestPointPacket( const ZPoint* p, float maxDist, float* dist, int* tri, ZPoint* q, ZFloat3* bary ) const;
+		void _intersectRayPacket( const ZPoint* o, const ZVector* dir, float tMax, float* dist, int* tri, ZFloat3* bary ) const;
+
+		float _squaredDistance( int node, const ZPoint& p ) const;
+		bool  _intersects( int node, const ZBoundingBox& box ) const;
+};
+
+inline bool
+ZTriangleBVH::empty() const
+{
+	return ( _numNodes == 0 );
+}
+
+inline int
+ZTriangleBVH::maxDepth() const
+{
+	return _maxDepth;
+}
+
+inline int
+ZTriangleBVH::maxLeafSize() const
+{
+	return _maxLeafSize;
+}
+
+inline int
+ZTriangleBVH::numNodes() const
+{
+	return _numNodes;
+}
+
+inline int
+ZTriangleBVH::numTriangles() const
+{
+	return _triIds.length();
+}
+
+inline void
+ZTriangleBVH::_setBox( int node, const ZBoundingBox& box )
+{
+	const ZPoint& m = box.minPoint();
+	const ZPoint& M = box.maxPoint();
+
+	_minX[node] = m.x;   _minY[node] = m.y;   _minZ[node] = m.z;
+	_maxX[node] = M.x;   _maxY[node] = M.y;   _maxZ[node] = M.z;
+}
+
+inline float
+ZTriangleBVH::_squaredDistance( int node, const ZPoint& p ) const
+{
+	const float dx = ZMax( ZMax( _minX[node]-p.x, p.x-_maxX[node] ), 0.f );
+	const float dy = ZMax( ZMax( _minY[node]-p.y, p.y-_maxY[node] ), 0.f );
+	const float dz = ZMax( ZMax( _minZ[node]-p.z, p.z-_maxZ[node] ), 0.f );
+
+	return ( dx*dx + dy*dy + dz*dz );
+}
+
+inline bool
+ZTriangleBVH::_intersects( int node, const ZBoundingBox& box ) const
+{
+	const ZPoint& m = box.minPoint();
+	const ZPoint& M = box.maxPoint();
+
+	if( M.x < _minX[node] || m.x > _maxX[node] ) { return false; }
+	if( M.y < _minY[node] || m.y > _maxY[node] ) { return false; }
+	if( M.z < _minZ[node] || m.z > _maxZ[node] ) { return false; }
+
+	return true;
+}
+
+ostream&
+operator<<( ostream& os, const ZTriangleBVH& object );
+
+ZELOS_NAMESPACE_END
+
+#endif
+
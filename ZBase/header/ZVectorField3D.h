@@ -2,7 +2,7 @@
 // ZVectorField3D.h //
 //-------------------------------------------------------//
 // author: Wanho Choi @ Dexter Studios                   //
-// last update: 2016.07.05                               //
+// last update: 2019.03.30                               //
 //-------------------------------------------------------//
 
 #ifndef _ZVectorField3D_h_
@@ -40,6 +40,19 @@ class ZVectorField3D : public ZField3DBase, public ZVectorArray
 
 		ZVector mcerp( const ZPoint& p ) const;
 
+		ZVector catrom( const ZPoint& p ) const;
+
+		// the batch versions of lerp(), catrom() and mcerp() for many points (e.g. particles)
+		// The points are clamped into the domain, and values is resized to the number of the points.
+		bool sample( const ZPointArray& points, ZVectorArray& values,
+		             ZInterpolationType::InterpolationType type=ZInterpolationType::zLinear, bool useOpenMP=true ) const;
+
+		// the same as ZSimplexNoise::vector() at each cell (four cells at once)
+		void setNoise( const ZSimplexNoise& noise, float time, bool useOpenMP=true );
+
+		// the same as ZCurlNoise::velocity() at each cell (four cells at once)
+		void setCurlNoise( const ZCurlNoise& noise, float time, bool useOpenMP=true );
+
 		const ZString dataType() const;
 
 		bool save( const char* filePathName ) const;
@@ -171,6 +184,47 @@ ZVectorField3D::mcerp( const ZPoint& p ) const
 					
 }
 
+inline ZVector
+ZVectorField3D::catrom( const ZPoint& p ) const
+{
+	float x=p.x, y=p.y, z=p.z;
+	if( _location==ZFieldLocation::zCell ) { x-=_dxd2; y-=_dyd2; z-=_dzd2; }
+
+	x = ZClamp( (x-_minPt.x)*_ddx, 0.f, (float)_iMax );
+	y = ZClamp( (y-_minPt.y)*_ddy, 0.f, (float)_jMax );
+	z = ZClamp( (z-_minPt.z)*_ddz, 0.f, (float)_kMax );
+
+	const int i = ZMin( int(x), _iMax-1 );
+	const int j = ZMin( int(y), _jMax-1 );
+	const int k = ZMin( int(z), _kMax-1 );
+
+	const int is[4] = { ZMax(i-1,0), i, i+1, ZMin(i+2,_iMax) };
+	const int js[4] = { ZMax(j-1,0), j, j+1, ZMin(j+2,_jMax) };
+	const int ks[4] = { ZMax(k-1,0), k, k+1, ZMin(k+2,_kMax) };
+
+	float wx[4], wy[4], wz[4];
+	ZCatRomWeights( x-i, wx );
+	ZCatRomWeights( y-j, wy );
+	ZCatRomWeights( z-k, wz );
+
+	const ZVector* _data = (const ZVector*)ZVectorArray::pointer();
+
+	x = y = z = 0.f;
+
+	FOR( kk, 0, 4 )
+	FOR( jj, 0, 4 )
+	{
+		const ZVector* r = _data + _stride0*js[jj] + _stride1*ks[kk];
+		const float    w = wz[kk] * wy[jj];
+
+		x += w * ( wx[0]*r[is[0]].x + wx[1]*r[is[1]].x + wx[2]*r[is[2]].x + wx[3]*r[is[3]].x );
+		y += w * ( wx[0]*r[is[0]].y + wx[1]*r[is[1]].y + wx[2]*r[is[2]].y + wx[3]*r[is[3]].y );
+		z += w * ( wx[0]*r[is[0]].z + wx[1]*r[is[1]].z + wx[2]*r[is[2]].z + wx[3]*r[is[3]].z );
+	}
+
+	return ZVector(x,y,z);
+}
+
 ostream&
 operator<<( ostream& os, const ZVectorField3D& object );
 
@@ -2,7 +2,7 @@
 // ZVoxelizer.h //
 //-------------------------------------------------------//
 // author: Wanho Choi @ Dexter Studios                   //
-// last update: 2015.10.07                               //
+// last update: 2019.03.26                               //
 //-------------------------------------------------------//
 
 #ifndef _ZVoxelizer_h_
@@ -58,10 +58,20 @@ class ZVoxelizer : public ZGrid3D
 
 		void finalize();
 
+		// the parallel path: a one-shot version of addMesh() + finalize() for a single mesh
+		// The triangles are rasterized tile by tile, the elements around the crossings get the exact distances,
+		// and the rest of the narrow band is filled by parallel fast sweeping.
+		// negRange, posRange: the narrow band widths in voxels (the values out of the band are clamped to them)
+		bool voxelize( ZScalarField3D& lvs, const ZTriMesh& mesh, float negRange, float posRange, bool useOpenMP=true );
+		bool voxelize( ZScalarField3D& lvs, ZVectorField3D& vel, const ZTriMesh& mesh, const ZVectorArray& vVel, float negRange, float posRange, bool useOpenMP=true );
+
 	private:
 
 		void _tagInterfacialElements();
 		void _update( const ZInt3& ijk, int sign );
+
+		bool _voxelize( ZScalarField3D& lvs, ZVectorField3D* vel, const ZTriMesh& mesh, const ZVectorArray* vVel, float negRange, float posRange, bool useOpenMP );
+		void _sweep( std::vector<float>& dst, std::vector<char>& sgn, const std::vector<char>& fixed, const std::vector<char>& band, int tnx, int tny, int tnz, bool useOpenMP );
 };
 
 ostream&
@@ -0,0 +1,109 @@
+//-----------------//
+// ZWebGenerator.h //
+//-------------------------------------------------------//
+// author: Jaegwang Lim @ Dexter Studios                 //
+// last update: 2019.03.18                               //
+//-------------------------------------------------------//
+
+#ifndef _ZWebGenerator_h_
+#define _ZWebGenerator_h_
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+/// @brief Web strand generator.
+/**
+	It generates web strands around guide curves.
+	All the strands of all the guides are written into one output ZCurves (strand k of guide g has the index g*numStrands+k).
+	The strands of a guide have the same number of CVs (numCVs(guide)*segScale), resampled evenly by arc length along the guide.
+	When the guides are dense samples of other curves (e.g. NURBS curves), guideCVCounts gives the CV counts of the original curves to use instead.
+	If the guides have no arc length table, a copy of them is made to build it, and it is reused while the guides are the same.
+	The radius noise is ZSimplexNoise unless noiseFunction is given.
+	(The Maya adapter gives the classic Perlin noise of glm, which the existing scenes were made with.)
+	Ramps are given as look-up tables sampled uniformly over [0,1]. (An empty table means the constant 1.)
+	The guide frames are kept between calls for temporal coherence, as long as the guide CV counts are not changed.
+*/
+class ZWebGenerator
+{
+	private:
+
+		ZCurves       _guides;			// copy of the guides with the arc length table when they have no table
+
+		// guide samples (all guides concatenated)
+		ZIntArray     _startIdx;		// start index of each guide
+		ZIntArray     _numSamples;		// # of samples of each guide
+		ZFloatArray   _guideLength;		// arc length of each guide
+		ZPointArray   _position;		// sample positions
+		ZVectorArray  _normal;			// sample normals
+		ZVectorArray  _biNormal;		// sample binormals
+		ZFloatArray   _swirlRampValue;	// swirl ramp value at each sample
+		ZFloatArray   _noiseRampValue;	// noise ramp value at each sample
+		ZFloatArray   _normalizedLength;// normalized arc length at each sample
+
+		ZSimplexNoise _noise;
+
+	public:
+
+		int         numStrands;			// # of strands per guide
+		int         seed;				// random seed
+		float       segScale;			// CV count scale w.r.t. the guide
+		float       radius;				// web radius
+		float       swirl;				// swirl amount
+		float       noiseFrequency;		// radius noise frequency
+		float       noiseOffset;		// radius noise offset
+		float       noiseScale;			// radius noise amplitude
+		int         noiseOctaves;		// # of octaves of the radius noise
+		ZFloatArray swirlRamp;			// swirl ramp look-up table over [0,1]
+		ZFloatArray noiseRamp;			// noise ramp look-up table over [0,1]
+		ZIntArray   guideCVCounts;		// CV count of each guide for the strands (empty: the CV counts of the guides)
+		float       (*noiseFunction)( float x );	// 1D noise for the radius (NULL: ZSimplexNoise::pureValue())
+
+	public:
+
+		ZWebGenerator();
+
+		void reset();
+
+		int numSamples( const ZCurves& guides, int i ) const;
+
+		bool compute( const ZCurves& guides, ZCurves& strands, bool useOpenMP=true );
+
+		const ZPointArray&  framePositions() const { return _position; }
+		const ZVectorArray& frameNormals()   const { return _normal;   }
+		const ZVectorArray& frameBiNormals() const { return _biNormal; }
+
+	private:
+
+		void _allocate( const ZCurves& guides );
+		void _computeFrames( const ZCurves& guides, int i );
+
+		float _radiusNoise( float a, float offset ) const;
+
+		static bool _isSame( const ZCurves& a, const ZCurves& b );
+
+		static float _lookUp( const ZFloatArray& lut, float a );
+};
+
+inline float
+ZWebGenerator::_lookUp( const ZFloatArray& lut, float a )
+{
+	const int n = lut.length();
+
+	if( !n    ) { return 1.f;    }
+	if( n==1  ) { return lut[0]; }
+
+	const float x = ZClamp( a, 0.f, 1.f ) * (n-1);
+	const int   i = ZMin( int(x), n-2 );
+	const float w = x - i;
+
+	return ( (1-w)*lut[i] + w*lut[i+1] );
+}
+
+ostream&
+operator<<( ostream& os, const ZWebGenerator& object );
+
+ZELOS_NAMESPACE_END
+
+#endif
+
@@ -61,10 +61,15 @@
 #include <stack>
 #include <queue>
 #include <vector>
+#include <memory>
 #include <iterator>
 #include <algorithm>
 
 #include <thread>
+#include <atomic>
+#include <mutex>
+#include <future>
+#include <chrono>
 
 #ifdef HIGH_GCC_VER
  #include <tr1/unordered_map>
@@ -89,9 +94,11 @@
  #include <stdint.h>
  #include <ifaddrs.h>     // for 'getifaddrs()'
  #include <sys/stat.h>
+ #include <sys/mman.h>    // for 'mmap()'
  #include <sys/time.h>
  #include <sys/utsname.h>
  #include <sys/utsname.h>
+ #include <unistd.h>
 #endif
 
 #if defined( __linux__ )
@@ -129,6 +136,7 @@ using namespace std;
 #include <ZDataUnit.h>
 #include <ZDataType.h>
 #include <ZFMMState.h>
+#include <ZCellType.h>
 #include <ZDirection.h>
 #include <ZColorSpace.h>
 #include <ZImageFormat.h>
@@ -140,6 +148,11 @@ using namespace std;
 #include <ZMeshElementType.h>
 #include <ZMeshDisplayMode.h>
 #include <ZPointDisplayMode.h>
+#include <ZOceanSpectrumType.h>
+#include <ZAdvectionScheme.h>
+#include <ZInterpolationType.h>
+
+#include <ZProfiler.h>
 
 #include <ZTuple.h>
 #include <ZVector.h>
@@ -185,6 +198,7 @@ using namespace std;
 #include <ZDoubleList.h>
 
 #include <ZArray.h>
+#include <ZArrayView.h>
 #include <ZCharArray.h>
 #include <ZUCharArray.h>
 #include <ZIntArray.h>
@@ -221,6 +235,7 @@ using namespace std;
 #include <ZStringUtils.h>
 #include <ZSystemUtils.h>
 #include <ZFileUtils.h>
+#include <ZCacheFile.h>
 #include <ZJSON.h>
 #include <ZMetaData.h>
 
@@ -228,6 +243,11 @@ using namespace std;
 #include <ZSparseMatrix.h>
 #include <ZDenseMatrixUtils.h>
 #include <ZSparseMatrixUtils.h>
+#include <ZSellMatrix.h>
+#include <ZLaplacianOperator.h>
+#include <ZSolverKernels.h>
+#include <ZMultigrid.h>
+#include <ZIncompleteCholesky.h>
 #include <ZLinearSystemSolver.h>
 
 #include <ZSimplexNoise.h>
@@ -237,6 +257,8 @@ using namespace std;
 
 #include <ZImageMap.h>
 #include <ZImageMapUtils.h>
+#include <ZTiledImage.h>
+#include <ZImageCache.h>
 
 #include <ZGrid2D.h>
 #include <ZGrid3D.h>
@@ -246,6 +268,7 @@ using namespace std;
 
 #include <ZCurve.h>
 #include <ZCurves.h>
+#include <ZWebGenerator.h>
 
 #include <ZTriMesh.h>
 #include <ZTriMeshConnectionInfo.h>
@@ -260,6 +283,7 @@ using namespace std;
 #include <ZMeshElementArray.h>
 #include <ZMesh.h>
 #include <ZMesh_Generation.h>
+#include <ZTriangleBVH.h>
 #include <ZMeshDistTree.h>
 #include <ZPointsHashGrid.h>
 #include <ZPointsDistTree.h>
@@ -267,6 +291,7 @@ using namespace std;
 
 #include <ZField2DBase.h>
 #include <ZField3DBase.h>
+#include <ZFieldLattice3D.h>
 #include <ZMarkerField2D.h>
 #include <ZMarkerField3D.h>
 #include <ZScalarField2D.h>
@@ -274,8 +299,14 @@ using namespace std;
 #include <ZVectorField2D.h>
 #include <ZVectorField3D.h>
 #include <ZComplexField2D.h>
+#include <ZFFT2D.h>
+#include <ZSparseField3DBase.h>
+#include <ZSparseField3D.h>
+#include <ZSparseScalarField3D.h>
+#include <ZSparseVectorField3D.h>
 #include <ZField2DUtils.h>
 #include <ZField3DUtils.h>
+#include <ZAdvector3D.h>
 #include <ZLevelSet2DUtils.h>
 #include <ZLevelSet3DUtils.h>
 #include <ZVoxelizer.h>
@@ -287,8 +318,10 @@ using namespace std;
 #include <ZPseudoSpring.h>
 
 #include <ZKmeanClustering.h>
+#include <ZPointArrayUtils.h>
 
 #include <ZGlslOcean.h>
+#include <ZFFTOcean.h>
 
 #include <ZPtc.h>
 
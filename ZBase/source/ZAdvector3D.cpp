@@ -0,0 +1,326 @@
+//-----------------//
+// ZAdvector3D.cpp //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.30                               //
+//-------------------------------------------------------//
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+// the component-wise range of the eight elements of a stencil
+template <int C>
+static inline void
+Range( const float* q, const ZFieldLattice3D& L, const ZFieldStencil3D& st, float* lo, float* hi )
+{
+	const int offsets[4] = { 0, C*L.s0, C*L.s1, C*(L.s0+L.s1) };
+	const float* q0 = q + C*st.base;
+
+	FOR( c, 0, C ) { lo[c] = hi[c] = q0[c]; }
+
+	FOR( n, 0, 4 )
+	{
+		const float* r = q0 + offsets[n];
+
+		FOR( c, 0, C )
+		{
+			lo[c] = ZMin( lo[c], ZMin( r[c], r[C+c] ) );
+			hi[c] = ZMax( hi[c], ZMax( r[c], r[C+c] ) );
+		}
+	}
+}
+
+static inline ZVector
+Velocity( const float* vel, const ZFieldLattice3D& V, const ZPoint& p )
+{
+	ZFieldStencil3D st;
+	ZGetStencil( V, p, st );
+
+	float u[3];
+	ZTrilerp<3>( vel, V, st, u );
+
+	return ZVector( u[0], u[1], u[2] );
+}
+
+// the position where p moves to for dt (u: the velocity at p)
+static inline ZPoint
+Trace( const float* vel, const ZFieldLattice3D& V, const ZPoint& p, const ZVector& u, float dt, int order )
+{
+	switch( order )
+	{
+		case 1:
+		{
+			return ( p + dt*u );
+		}
+
+		case 2: // midpoint
+		{
+			const ZVector u2 = Velocity( vel, V, p + (0.5f*dt)*u );
+			return ( p + dt*u2 );
+		}
+
+		default:
+		case 3: // Ralston
+		{
+			const ZVector u2 = Velocity( vel, V, p + (0.5f*dt)*u );
+			const ZVector u3 = Velocity( vel, V, p + (0.75f*dt)*u2 );
+			return ( p + (dt/9.f)*( 2.f*u + 3.f*u2 + 4.f*u3 ) );
+		}
+	}
+}
+
+// It calls kernel(i,j,k,idx) for all the elements by the tiles of T^3 elements.
+template <class KERNEL>
+static void
+ForEachTile( const ZFieldLattice3D& L, int T, bool useOpenMP, const KERNEL& kernel )
+{
+	T = ZMax( T, 1 );
+
+	const int ni = L.iMax+1, nj = L.jMax+1, nk = L.kMax+1;
+	const int ti = (ni+T-1)/T, tj = (nj+T-1)/T, tk = (nk+T-1)/T;
+	const int numTiles = ti*tj*tk;
+
+	#pragma omp parallel for schedule(dynamic) if( useOpenMP && ni*nj*nk>10000 )
+	FOR( t, 0, numTiles )
+	{
+		const int i0 = T*(t%ti), j0 = T*((t/ti)%tj), k0 = T*(t/(ti*tj));
+		const int i1 = ZMin(i0+T,ni), j1 = ZMin(j0+T,nj), k1 = ZMin(k0+T,nk);
+
+		FOR( k, k0, k1 )
+		FOR( j, j0, j1 )
+		{
+			int idx = i0 + L.s0*j + L.s1*k;
+
+			FOR( i, i0, i1 )
+			{
+				kernel( i, j, k, idx++ );
+			}
+		}
+	}
+}
+
+// the advection of the C-component data (data: the old values in and the new values out)
+// (vel may point into data (self-advection): data is only read until the final exchange.)
+template <int C, class T>
+static void
+Advect( ZArray<T>& data, const ZFieldLattice3D& F, const float* vel, const ZFieldLattice3D& V, bool sameLattice, float dt,
+        ZArray<T> buffer[2], ZPointArray& backPos, ZAdvectionScheme::AdvectionScheme scheme, int order, bool doClamp, int tileSize, bool useOpenMP )
+{
+	const int n = (int)data.size();
+
+	buffer[0].setLength( n, false );
+	if( scheme != ZAdvectionScheme::zSemiLagrangian ) { buffer[1].setLength( n, false ); backPos.setLength( n, false ); }
+
+	const float* q  = (const float*)&data[0];
+	float*       b0 = (float*)&buffer[0][0];
+	float*       b1 = ( scheme != ZAdvectionScheme::zSemiLagrangian ) ? (float*)&buffer[1][0] : (float*)NULL;
+	ZPoint*      bp = ( scheme != ZAdvectionScheme::zSemiLagrangian ) ? &backPos[0] : (ZPoint*)NULL;
+
+	// the velocity at the element (i,j,k)
+	#define ZADVECT_VELOCITY( p ) \
+		( sameLattice ? ZVector( vel[3*idx], vel[3*idx+1], vel[3*idx+2] ) : Velocity( vel, V, p ) )
+
+	// b0: the semi-Lagrangian advection of q
+	ForEachTile( F, tileSize, useOpenMP, [&]( int i, int j, int k, int idx )
+	{
+		const ZPoint  p( F.ox+i*F.dx, F.oy+j*F.dy, F.oz+k*F.dz );
+		const ZPoint  b = Trace( vel, V, p, ZADVECT_VELOCITY(p), -dt, order );
+
+		ZFieldStencil3D st;
+		ZGetStencil( F, b, st );
+		ZTrilerp<C>( q, F, st, b0+C*idx );
+
+		if( bp ) { bp[idx] = b; }
+	});
+
+	if( scheme == ZAdvectionScheme::zSemiLagrangian )
+	{
+		data.exchange( buffer[0] );
+		return;
+	}
+
+	// b1: q + (q - b0 advected back) / 2
+	// (zMacCormack: b0 + (q - b0 advected back) / 2 clamped directly)
+	const bool macCormack = ( scheme == ZAdvectionScheme::zMacCormack );
+
+	ForEachTile( F, tileSize, useOpenMP, [&]( int i, int j, int k, int idx )
+	{
+		const ZPoint p( F.ox+i*F.dx, F.oy+j*F.dy, F.oz+k*F.dz );
+		const ZPoint f = Trace( vel, V, p, ZADVECT_VELOCITY(p), dt, order );
+
+		ZFieldStencil3D st;
+		ZGetStencil( F, f, st );
+
+		float qBar[C];
+		ZTrilerp<C>( b0, F, st, qBar );
+
+		const float* q0 = q  + C*idx;
+		float*       q1 = b1 + C*idx;
+
+		if( macCormack )
+		{
+			FOR( c, 0, C ) { q1[c] = b0[C*idx+c] + 0.5f * ( q0[c] - qBar[c] ); }
+
+			if( doClamp )
+			{
+				float lo[C], hi[C];
+				ZGetStencil( F, bp[idx], st );
+				Range<C>( q, F, st, lo, hi );
+				FOR( c, 0, C ) { q1[c] = ZClamp( q1[c], lo[c], hi[c] ); }
+			}
+		}
+		else
+		{
+			FOR( c, 0, C ) { q1[c] = q0[c] + 0.5f * ( q0[c] - qBar[c] ); }
+		}
+	});
+
+	#undef ZADVECT_VELOCITY
+
+	if( macCormack )
+	{
+		data.exchange( buffer[1] );
+		return;
+	}
+
+	// b0: the semi-Lagrangian advection of b1 (zBFECC)
+	ForEachTile( F, tileSize, useOpenMP, [&]( int i, int j, int k, int idx )
+	{
+		ZFieldStencil3D st;
+		ZGetStencil( F, bp[idx], st );
+
+		float* q1 = b0 + C*idx;
+		ZTrilerp<C>( b1, F, st, q1 );
+
+		if( doClamp )
+		{
+			float lo[C], hi[C];
+			Range<C>( q, F, st, lo, hi );
+			FOR( c, 0, C ) { q1[c] = ZClamp( q1[c], lo[c], hi[c] ); }
+		}
+	});
+
+	data.exchange( buffer[0] );
+}
+
+ZAdvector3D::ZAdvector3D()
+{
+	ZAdvector3D::reset();
+}
+
+void
+ZAdvector3D::reset()
+{
+	FOR( i, 0, 2 )
+	{
+		_scalar[i].clear();
+		_vector[i].clear();
+	}
+
+	_backPos.clear();
+
+	scheme   = ZAdvectionScheme::zMacCormack;
+	order    = 2;
+	clamp    = true;
+	tileSize = 8;
+}
+
+bool
+ZAdvector3D::_check( const ZField3DBase& field, const ZField3DBase& velocity ) const
+{
+	if( ( field.location() != ZFieldLocation::zCell && field.location() != ZFieldLocation::zNode )
+	 || ( velocity.location() != ZFieldLocation::zCell && velocity.location() != ZFieldLocation::zNode ) )
+	{
+		cout << "Error@ZAdvector3D::advect(): Invalid location." << endl;
+		return false;
+	}
+
+	if( ( field.iMax() < 1 ) || ( field.jMax() < 1 ) || ( field.kMax() < 1 )
+	 || ( velocity.iMax() < 1 ) || ( velocity.jMax() < 1 ) || ( velocity.kMax() < 1 ) )
+	{
+		cout << "Error@ZAdvector3D::advect(): Too small fields." << endl;
+		return false;
+	}
+
+	if( ( scheme != ZAdvectionScheme::zSemiLagrangian ) && ( scheme != ZAdvectionScheme::zMacCormack ) && ( scheme != ZAdvectionScheme::zBFECC ) )
+	{
+		cout << "Error@ZAdvector3D::advect(): Invalid scheme." << endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool
+ZAdvector3D::advect( ZScalarField3D& field, const ZVectorField3D& velocity, float dt, bool useOpenMP )
+{
+	ZPROFILE_SCOPE( "ZAdvector3D::advect(scalar)" );
+
+	if( !_check( field, velocity ) ) { return false; }
+	if( (int)field.size() != field.numElements() || (int)velocity.size() != velocity.numElements() )
+	{
+		cout << "Error@ZAdvector3D::advect(): Invalid field data." << endl;
+		return false;
+	}
+
+	const bool sameLattice = field.directComputable( velocity );
+
+	Advect<1,float>( field, ZFieldLattice3D(field), (const float*)&velocity[0], ZFieldLattice3D(velocity), sameLattice, dt,
+	                 _scalar, _backPos, scheme, ZClamp(order,1,3), clamp, tileSize, useOpenMP );
+
+	return true;
+}
+
+bool
+ZAdvector3D::advect( ZVectorField3D& field, const ZVectorField3D& velocity, float dt, bool useOpenMP )
+{
+	ZPROFILE_SCOPE( "ZAdvector3D::advect(vector)" );
+
+	if( !_check( field, velocity ) ) { return false; }
+	if( (int)field.size() != field.numElements() || (int)velocity.size() != velocity.numElements() )
+	{
+		cout << "Error@ZAdvector3D::advect(): Invalid field data." << endl;
+		return false;
+	}
+
+	const bool sameLattice = field.directComputable( velocity );
+
+	Advect<3,ZVector>( field, ZFieldLattice3D(field), (const float*)&velocity[0], ZFieldLattice3D(velocity), sameLattice, dt,
+	                   _vector, _backPos, scheme, ZClamp(order,1,3), clamp, tileSize, useOpenMP );
+
+	return true;
+}
+
+double
+ZAdvector3D::usedMemorySize( ZDataUnit::DataUnit dataUnit ) const
+{
+	double bytes = 0.0;
+	FOR( i, 0, 2 ) { bytes += _scalar[i].usedMemorySize() + _vector[i].usedMemorySize(); }
+	bytes += _backPos.usedMemorySize();
+
+	switch( dataUnit )
+	{
+		case ZDataUnit::zBytes:     { return bytes; }
+		case ZDataUnit::zKilobytes: { return (bytes/1024.0); }
+		case ZDataUnit::zMegabytes: { return (bytes/ZPow2(1024.0)); }
+		case ZDataUnit::zGigabytes: { return (bytes/ZPow3(1024.0)); }
+		default: { cout << "Error@ZAdvector3D::usedMemorySize(): Invalid data unit." << endl; return 0.0; }
+	}
+}
+
+ostream&
+operator<<( ostream& os, const ZAdvector3D& object )
+{
+	os << "<ZAdvector3D>" << endl;
+	os << " scheme     : " << ZAdvectionScheme::name( object.scheme ) << endl;
+	os << " order      : " << object.order << endl;
+	os << " clamp      : " << ( object.clamp ? "true" : "false" ) << endl;
+	os << " tile size  : " << object.tileSize << endl;
+	os << " memory size: " << object.usedMemorySize(ZDataUnit::zMegabytes) << " mb." << endl;
+	os << endl;
+	return os;
+}
+
+ZELOS_NAMESPACE_END
+
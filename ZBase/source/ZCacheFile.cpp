@@ -0,0 +1,443 @@
+//----------------//
+// ZCacheFile.cpp //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.30                               //
+//-------------------------------------------------------//
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+static void
+WritePadding( ofstream& fout )
+{
+	static const char zeros[Z_CACHE_ALIGNMENT] = { 0 };
+
+	const int64_t pos = (int64_t)fout.tellp();
+	const int64_t pad = ( Z_CACHE_ALIGNMENT - ( pos % Z_CACHE_ALIGNMENT ) ) % Z_CACHE_ALIGNMENT;
+
+	if( pad ) { fout.write( zeros, pad ); }
+}
+
+// a unique name in the directory of the target, so that the rename is atomic
+static ZString
+TempPathName( const char* filePathName )
+{
+	#ifdef OS_LINUX
+	return ( ZString( filePathName ) + "." + ZString( (int)getpid() ) + ".tmp" );
+	#else
+	return ( ZString( filePathName ) + ".tmp" );
+	#endif
+}
+
+ZCacheWriter::ZCacheWriter()
+{}
+
+ZCacheWriter::ZCacheWriter( const char* filePathName )
+{
+	ZCacheWriter::open( filePathName );
+}
+
+ZCacheWriter::~ZCacheWriter()
+{
+	// Only an explicit close() replaces the target.
+	ZCacheWriter::abort();
+}
+
+bool
+ZCacheWriter::open( const char* filePathName )
+{
+	ZCacheWriter::abort();
+
+	// Truncating the target in place would corrupt (or SIGBUS) the readers mapping it.
+	_filePathName = filePathName;
+	_tempPathName = TempPathName( filePathName );
+
+	_fout.open( _tempPathName.asChar(), ios::out|ios::binary|ios::trunc );
+
+	if( _fout.fail() || !_fout.is_open() )
+	{
+		cout << "Error@ZCacheWriter::open(): Failed to save file: " << filePathName << endl;
+		return false;
+	}
+
+	// a placeholder which will be overwritten by close()
+	ZCacheHeader header;
+	memset( (char*)&header, 0, sizeof(ZCacheHeader) );
+	_fout.write( (char*)&header, sizeof(ZCacheHeader) );
+
+	return true;
+}
+
+bool
+ZCacheWriter::isOpened() const
+{
+	return _fout.is_open();
+}
+
+bool
+ZCacheWriter::add( const char* name, const char* type, const void* data, int count, int elementSize )
+{
+	if( !_fout.is_open() )
+	{
+		cout << "Error@ZCacheWriter::add(): Not opened." << endl;
+		return false;
+	}
+
+	if( ( strlen(name) >= sizeof(((ZCacheChunkInfo*)0)->name) ) || ( strlen(type) >= sizeof(((ZCacheChunkInfo*)0)->type) ) )
+	{
+		cout << "Error@ZCacheWriter::add(): Too long name or type: " << name << endl;
+		return false;
+	}
+
+	if( ( count < 0 ) || ( elementSize < 1 ) || ( count && !data ) )
+	{
+		cout << "Error@ZCacheWriter::add(): Invalid data: " << name << endl;
+		return false;
+	}
+
+	FOR( i, 0, (int)_chunks.size() )
+	{
+		if( !strcmp( _chunks[i].name, name ) )
+		{
+			cout << "Error@ZCacheWriter::add(): Duplicated name: " << name << endl;
+			return false;
+		}
+	}
+
+	WritePadding( _fout );
+
+	ZCacheChunkInfo info;
+	memset( (char*)&info, 0, sizeof(ZCacheChunkInfo) );
+
+	strcpy( info.name, name );
+	strcpy( info.type, type );
+
+	info.offset      = (int64_t)_fout.tellp();
+	info.bytes       = (int64_t)count * elementSize;
+	info.count       = count;
+	info.elementSize = elementSize;
+
+	if( info.bytes ) { _fout.write( (const char*)data, info.bytes ); }
+
+	if( _fout.fail() )
+	{
+		cout << "Error@ZCacheWriter::add(): Failed to write: " << name << endl;
+		return false;
+	}
+
+	_chunks.push_back( info );
+
+	return true;
+}
+
+bool
+ZCacheWriter::close()
+{
+	if( !_fout.is_open() ) { return false; }
+
+	WritePadding( _fout );
+
+	ZCacheHeader header;
+	memset( (char*)&header, 0, sizeof(ZCacheHeader) );
+
+	memcpy( header.magic, Z_CACHE_MAGIC, 8 );
+	header.version     = Z_CACHE_VERSION;
+	header.numChunks   = (int32_t)_chunks.size();
+	header.tableOffset = (int64_t)_fout.tellp();
+	header.fileSize    = header.tableOffset + (int64_t)_chunks.size() * sizeof(ZCacheChunkInfo);
+
+	if( !_chunks.empty() )
+	{
+		_fout.write( (const char*)&_chunks[0], _chunks.size()*sizeof(ZCacheChunkInfo) );
+	}
+
+	_fout.seekp( 0, ios::beg );
+	_fout.write( (const char*)&header, sizeof(ZCacheHeader) );
+
+	const bool ok = !_fout.fail();
+
+	_fout.close();
+	_chunks.clear();
+
+	if( !ok )
+	{
+		cout << "Error@ZCacheWriter::close(): Failed to write file: " << _filePathName << endl;
+		remove( _tempPathName.asChar() );
+		return false;
+	}
+
+	#ifndef OS_LINUX
+	remove( _filePathName.asChar() ); // rename() does not replace an existing file.
+	#endif
+
+	if( rename( _tempPathName.asChar(), _filePathName.asChar() ) )
+	{
+		cout << "Error@ZCacheWriter::close(): Failed to rename file: " << _tempPathName << " -> " << _filePathName << endl;
+		remove( _tempPathName.asChar() );
+		return false;
+	}
+
+	return true;
+}
+
+void
+ZCacheWriter::abort()
+{
+	if( !_fout.is_open() ) { return; }
+
+	_fout.close();
+	_chunks.clear();
+
+	remove( _tempPathName.asChar() );
+}
+
+#ifdef OS_LINUX
+
+struct ZCacheUnmapper
+{
+	size_t size;
+
+	ZCacheUnmapper( size_t s ) : size(s) {}
+
+	void operator()( const void* p ) const { munmap( (void*)p, size ); }
+};
+
+#else
+
+struct ZCacheDeleter
+{
+	void operator()( const void* p ) const { delete[] (const char*)p; }
+};
+
+#endif
+
+ZCacheReader::ZCacheReader()
+: _base(0), _fileSize(0)
+{}
+
+ZCacheReader::ZCacheReader( const char* filePathName )
+: _base(0), _fileSize(0)
+{
+	ZCacheReader::open( filePathName );
+}
+
+void
+ZCacheReader::close()
+{
+	_filePathName.clear();
+	_chunks.clear();
+
+	_mapping.reset(); // The views still own it if any.
+
+	_base     = 0;
+	_fileSize = 0;
+}
+
+bool
+ZCacheReader::open( const char* filePathName )
+{
+	ZCacheReader::close();
+
+	#ifdef OS_LINUX
+	{
+		const int fd = ::open( filePathName, O_RDONLY );
+
+		if( fd < 0 )
+		{
+			cout << "Error@ZCacheReader::open(): Failed to load file: " << filePathName << endl;
+			return false;
+		}
+
+		struct stat st;
+		if( ( fstat( fd, &st ) != 0 ) || ( st.st_size < (off_t)sizeof(ZCacheHeader) ) )
+		{
+			cout << "Error@ZCacheReader::open(): Invalid file: " << filePathName << endl;
+			::close( fd );
+			return false;
+		}
+
+		void* ptr = mmap( 0, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+
+		::close( fd ); // The mapping stays valid.
+
+		if( ptr == MAP_FAILED )
+		{
+			cout << "Error@ZCacheReader::open(): Failed to map file: " << filePathName << endl;
+			return false;
+		}
+
+		_mapping  = std::shared_ptr<const void>( ptr, ZCacheUnmapper( (size_t)st.st_size ) );
+		_fileSize = (int64_t)st.st_size;
+	}
+	#else
+	{
+		// no memory mapping: the whole file is read into the memory.
+		ifstream fin( filePathName, ios::in|ios::binary|ios::ate );
+
+		if( fin.fail() )
+		{
+			cout << "Error@ZCacheReader::open(): Failed to load file: " << filePathName << endl;
+			return false;
+		}
+
+		_fileSize = (int64_t)fin.tellg();
+		if( _fileSize < (int64_t)sizeof(ZCacheHeader) )
+		{
+			cout << "Error@ZCacheReader::open(): Invalid file: " << filePathName << endl;
+			return false;
+		}
+
+		char* buffer = new char[_fileSize];
+		fin.seekg( 0, ios::beg );
+		fin.read( buffer, _fileSize );
+
+		_mapping = std::shared_ptr<const void>( (const void*)buffer, ZCacheDeleter() );
+	}
+	#endif
+
+	_base = (const char*)_mapping.get();
+
+	ZCacheHeader header;
+	memcpy( (char*)&header, _base, sizeof(ZCacheHeader) );
+
+	if( memcmp( header.magic, Z_CACHE_MAGIC, 8 ) || ( header.version != Z_CACHE_VERSION ) )
+	{
+		cout << "Error@ZCacheReader::open(): Not a cache file of version " << Z_CACHE_VERSION << ": " << filePathName << endl;
+		ZCacheReader::close();
+		return false;
+	}
+
+	const int64_t tableEnd = header.tableOffset + (int64_t)header.numChunks * sizeof(ZCacheChunkInfo);
+
+	if( ( header.numChunks < 0 ) || ( header.tableOffset < (int64_t)sizeof(ZCacheHeader) ) || ( tableEnd > _fileSize ) )
+	{
+		cout << "Error@ZCacheReader::open(): Corrupted file: " << filePathName << endl;
+		ZCacheReader::close();
+		return false;
+	}
+
+	_chunks.resize( header.numChunks );
+
+	if( header.numChunks )
+	{
+		memcpy( (char*)&_chunks[0], _base + header.tableOffset, header.numChunks*sizeof(ZCacheChunkInfo) );
+	}
+
+	FOR( i, 0, header.numChunks )
+	{
+		ZCacheChunkInfo& info = _chunks[i];
+
+		info.name[sizeof(info.name)-1] = '\0';
+		info.type[sizeof(info.type)-1] = '\0';
+
+		const bool valid = ( info.offset % Z_CACHE_ALIGNMENT == 0 )
+						&& ( info.offset >= (int64_t)sizeof(ZCacheHeader) )
+						&& ( info.bytes == (int64_t)info.count * info.elementSize )
+						&& ( info.count >= 0 ) && ( info.elementSize > 0 )
+						&& ( info.offset + info.bytes <= header.tableOffset );
+
+		if( !valid )
+		{
+			cout << "Error@ZCacheReader::open(): Corrupted chunk: " << info.name << endl;
+			ZCacheReader::close();
+			return false;
+		}
+	}
+
+	_filePathName = filePathName;
+
+	return true;
+}
+
+bool
+ZCacheReader::isOpened() const
+{
+	return ( _base != 0 );
+}
+
+int
+ZCacheReader::numChunks() const
+{
+	return (int)_chunks.size();
+}
+
+const ZCacheChunkInfo&
+ZCacheReader::chunk( int i ) const
+{
+	return _chunks[i];
+}
+
+const ZCacheChunkInfo*
+ZCacheReader::find( const char* name ) const
+{
+	FOR( i, 0, (int)_chunks.size() )
+	{
+		if( !strcmp( _chunks[i].name, name ) ) { return &_chunks[i]; }
+	}
+
+	return (const ZCacheChunkInfo*)0;
+}
+
+bool
+ZCacheReader::has( const char* name ) const
+{
+	return ( ZCacheReader::find( name ) != 0 );
+}
+
+void
+ZCacheReader::prefetch( const char* name ) const
+{
+	#ifdef OS_LINUX
+	const ZCacheChunkInfo* info = ZCacheReader::find( name );
+	if( !info || !info->bytes ) { return; }
+
+	// madvise() requires a page aligned address.
+	const int64_t pageSize = (int64_t)sysconf( _SC_PAGESIZE );
+	const int64_t start    = ( info->offset / pageSize ) * pageSize;
+
+	madvise( (void*)( _base + start ), (size_t)( info->offset + info->bytes - start ), MADV_WILLNEED );
+	#endif
+}
+
+const ZCacheChunkInfo*
+ZCacheReader::_find( const char* name, const char* type, int elementSize, const char* func ) const
+{
+	if( !_base )
+	{
+		cout << "Error@ZCacheReader::" << func << "(): Not opened." << endl;
+		return (const ZCacheChunkInfo*)0;
+	}
+
+	const ZCacheChunkInfo* info = ZCacheReader::find( name );
+
+	if( !info ) { return (const ZCacheChunkInfo*)0; } // an optional attribute
+
+	if( strcmp( info->type, type ) || ( info->elementSize != elementSize ) )
+	{
+		cout << "Error@ZCacheReader::" << func << "(): Data type mismatch: " << name << endl;
+		return (const ZCacheChunkInfo*)0;
+	}
+
+	return info;
+}
+
+double
+ZCacheReader::usedMemorySize( ZDataUnit::DataUnit dataUnit ) const
+{
+	// the mapped pages belong to the page cache.
+	const double bytes = (double)_chunks.size() * sizeof(ZCacheChunkInfo);
+
+	switch( dataUnit )
+	{
+		case ZDataUnit::zBytes:     { return bytes; }
+		case ZDataUnit::zKilobytes: { return (bytes/1024.0); }
+		case ZDataUnit::zMegabytes: { return (bytes/ZPow2(1024.0)); }
+		case ZDataUnit::zGigabytes: { return (bytes/ZPow3(1024.0)); }
+		default: { cout << "Error@ZCacheReader::usedMemorySize(): Invalid data unit." << endl; return 0.0; }
+	}
+}
+
+ZELOS_NAMESPACE_END
+
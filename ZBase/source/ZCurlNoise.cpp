@@ -3,7 +3,7 @@
 //-------------------------------------------------------//
 // author: Wanho Choi @ Dexter Studios                   //
 //         Jinhyuk Bae @ Dexter Studios                  //
-// last update: 2015.10.07                               //
+// last update: 2019.03.30                               //
 //-------------------------------------------------------//
 
 #include <ZelosBase.h>
@@ -12,24 +12,85 @@ ZELOS_NAMESPACE_BEGIN
 
 ZCurlNoise::ZCurlNoise()
 : ZSimplexNoise()
+{}
+
+// The potential is ( value(x,y,z), value(y-19.1,z+33.4,x+47.2), value(z+74.2,x-124.5,y+99.4) ),
+// so the derivatives of the second and the third components are those of the permuted arguments.
+
+ZVector
+ZCurlNoise::velocity( float x, float y, float z, float t ) const
 {
-	_delta = 1e-4f;
-	_denom = 1 / (2*_delta);
+	float d0[4], d1[4], d2[4];
+
+	ZSimplexNoise::value( x,       y,        z,       t, &d0[0], &d0[1], &d0[2], &d0[3] );
+	ZSimplexNoise::value( y-19.1f, z+33.4f,  x+47.2f, t, &d1[0], &d1[1], &d1[2], &d1[3] );
+	ZSimplexNoise::value( z+74.2f, x-124.5f, y+99.4f, t, &d2[0], &d2[1], &d2[2], &d2[3] );
+
+	// the chain rule of value(): x -> sFreq.x*x+offset.x and the scale
+	FOR( i, 0, 3 )
+	{
+		d0[i] *= scale * sFreq[i];
+		d1[i] *= scale * sFreq[i];
+		d2[i] *= scale * sFreq[i];
+	}
+
+	return ZVector( d2[2] - d1[1],		// dPsi3/dy - dPsi2/dz
+                    d0[2] - d2[1],		// dPsi1/dz - dPsi3/dx
+                    d1[2] - d0[1] );	// dPsi2/dx - dPsi1/dy
 }
 
-ZVector
-ZCurlNoise::velocity( float x, float y, float z, float t )
+void
+ZCurlNoise::velocity4( const float x[4], const float y[4], const float z[4], float t, float vx[4], float vy[4], float vz[4] ) const
+{
+	float a[4], b[4], c[4], v[4];
+	float g0[3][4], g1[3][4], g2[3][4];
+
+	ZSimplexNoise::fBm4( x, y, z, t, 1, 1.f, 1.f, 1.f, v, g0[0], g0[1], g0[2] );
+
+	FOR( l, 0, 4 ) { a[l]=y[l]-19.1f; b[l]=z[l]+33.4f; c[l]=x[l]+47.2f; }
+	ZSimplexNoise::fBm4( a, b, c, t, 1, 1.f, 1.f, 1.f, v, g1[0], g1[1], g1[2] );
+
+	FOR( l, 0, 4 ) { a[l]=z[l]+74.2f; b[l]=x[l]-124.5f; c[l]=y[l]+99.4f; }
+	ZSimplexNoise::fBm4( a, b, c, t, 1, 1.f, 1.f, 1.f, v, g2[0], g2[1], g2[2] );
+
+	FOR( l, 0, 4 )
+	{
+		vx[l] = g2[2][l] - g1[1][l];
+		vy[l] = g0[2][l] - g2[1][l];
+		vz[l] = g1[2][l] - g0[1][l];
+	}
+}
+
+void
+ZCurlNoise::velocity( const ZPointArray& points, float t, ZVectorArray& velocities, bool useOpenMP ) const
 {
-	const ZVector x0( ZSimplexNoise::vector(x-_delta,y,z,t) );
-	const ZVector x1( ZSimplexNoise::vector(x+_delta,y,z,t) );
-	const ZVector y0( ZSimplexNoise::vector(x,y-_delta,z,t) );
-	const ZVector y1( ZSimplexNoise::vector(x,y+_delta,z,t) );
-	const ZVector z0( ZSimplexNoise::vector(x,y,z-_delta,t) );
-	const ZVector z1( ZSimplexNoise::vector(x,y,z+_delta,t) );
-
-	return ZVector( ((y1.z-y0.z)-(z1.y-z0.y))*_denom,
-                    ((z1.x-z0.x)-(x1.z-x0.z))*_denom,
-                    ((x1.y-x0.y)-(y1.x-y0.x))*_denom );
+	const int n = points.length();
+
+	velocities.setLength( n, false );
+
+	const int numBlocks = ( n + 3 ) / 4;
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( b, 0, numBlocks )
+	{
+		const int i0 = 4*b;
+		const int m  = ZMin( 4, n-i0 );
+
+		float x[4], y[4], z[4], vx[4], vy[4], vz[4];
+
+		FOR( l, 0, 4 )
+		{
+			const ZPoint& p = points[ i0 + ZMin( l, m-1 ) ]; // (The last one is repeated for the tail.)
+
+			x[l] = p.x;
+			y[l] = p.y;
+			z[l] = p.z;
+		}
+
+		ZCurlNoise::velocity4( x, y, z, t, vx, vy, vz );
+
+		FOR( l, 0, m ) { velocities[i0+l].set( vx[l], vy[l], vz[l] ); }
+	}
 }
 
 ostream&
@@ -9,21 +9,28 @@
 
 ZELOS_NAMESPACE_BEGIN
 
+// the sub-steps of the temporary arc length table of paramFromLength() and lengthFromParam() without buildArcLengthTable()
+static const int ZCurvesTempSubSteps = 8;
+
 ZCurves::ZCurves()
+: _arcSubSteps(0)
 {
 }
 
 ZCurves::ZCurves( const ZCurves& curve )
+: _arcSubSteps(0)
 {
 	*this = curve;
 }
 
 ZCurves::ZCurves( const ZIntArray& nCVs )
+: _arcSubSteps(0)
 {
 	set( nCVs );
 }
 
 ZCurves::ZCurves( const char* filePathName )
+: _arcSubSteps(0)
 {
 	load( filePathName );
 }
@@ -34,6 +41,8 @@ ZCurves::reset()
 	_numCVs   .clear();
 	_startIdx .clear();
 	_cv       .clear();
+
+	invalidateArcLengthTable();
 }
 
 ZCurves&
@@ -43,6 +52,10 @@ ZCurves::operator=( const ZCurves& other )
 	_startIdx = other._startIdx;
 	_cv       = other._cv;
 
+	_arcSubSteps = other._arcSubSteps;
+	_arcStartIdx = other._arcStartIdx;
+	_arcLength   = other._arcLength;
+
 	return (*this);
 }
 
@@ -58,6 +71,8 @@ void
 ZCurves::zeroize()
 {
 	_cv.zeroize();
+
+	invalidateArcLengthTable();
 }
 
 void
@@ -113,6 +128,8 @@ ZCurves::from( const vector<ZCurves>& curve, bool memAlloc )
 			}
 		}
 	}
+
+	invalidateArcLengthTable();
 }
 
 void
@@ -169,6 +186,8 @@ ZCurves::from( const ZCurves& other, const ZCharArray& mask )
 			}
 		}
 	}
+
+	invalidateArcLengthTable();
 }
 
 void
@@ -195,6 +214,8 @@ ZCurves::append( const ZCurves& other )
 	{
 		_startIdx[i] += nTotalCVs;
 	}
+
+	invalidateArcLengthTable();
 }
 
 // _numCVs must be set before!
@@ -212,6 +233,8 @@ ZCurves::_allocate()
 	}
 
 	_cv.setLength( nTotalCVs );
+
+	invalidateArcLengthTable();
 }
 
 ZPoint
@@ -384,6 +407,8 @@ ZCurves::getPositionAndTangent( int i, float t, ZPoint& P, ZVector& T ) const
 float
 ZCurves::curveLength( int i ) const
 {
+	if( _arcSubSteps ) { return arcLength(i); }
+
 	const int& nCVs   = _numCVs[i];
 	const int  nCVs_1 = nCVs-1;
 
@@ -431,6 +456,8 @@ ZCurves::curveLength( int i, float t0, float t1 ) const
 
 	if( t0 > t1 ) { ZSwap(t0,t1); }
 
+	if( _arcSubSteps ) { return ( lengthFromParam(i,t1) - lengthFromParam(i,t0) ); }
+
 	const int& nCVs   = _numCVs[i];
 	const int  nCVs_1 = nCVs-1;
 
@@ -683,9 +710,225 @@ ZCurves::deformByCCDIK( int i, const ZPoint& target, float rigidity, float maxAn
 		++itr;
 	}
 
+	if( _arcSubSteps )
+	{
+		_computeArcLengths( i, _arcSubSteps, &_arcLength[ _arcStartIdx[i] ] );
+	}
+
 	return itr;
 }
 
+// It samples each segment by the given # of sub-steps and accumulates the chord lengths.
+void
+ZCurves::buildArcLengthTable( int subSteps, bool useOpenMP )
+{
+	const int nCurves = numCurves();
+
+	_arcSubSteps = ZMax( subSteps, 1 );
+	_arcStartIdx.setLength( nCurves );
+
+	int nTotal = 0;
+	FOR( i, 0, nCurves )
+	{
+		_arcStartIdx[i] = nTotal;
+		nTotal += numSegments(i) * _arcSubSteps + 1;
+	}
+
+	_arcLength.setLength( nTotal, false );
+
+	#pragma omp parallel for schedule(dynamic,64) if( useOpenMP )
+	FOR( i, 0, nCurves )
+	{
+		_computeArcLengths( i, _arcSubSteps, &_arcLength[ _arcStartIdx[i] ] );
+	}
+}
+
+void
+ZCurves::invalidateArcLengthTable()
+{
+	_arcSubSteps = 0;
+	_arcStartIdx.clear();
+	_arcLength.clear();
+}
+
+float
+ZCurves::arcLength( int i ) const
+{
+	if( !_arcSubSteps ) { return curveLength(i); }
+
+	return _arcLength[ _arcStartIdx[i] + numSegments(i)*_arcSubSteps ];
+}
+
+// s: arc length from the root
+// It returns the curve parameter t in [0,1] by binary search on the arc length table.
+// (Without the table, a temporary one of this curve is used, the same as lengthFromParam(), so that they are the inverses of each other.)
+float
+ZCurves::paramFromLength( int i, float s ) const
+{
+	const int n = numSegments(i);
+	if( n < 1 ) { return 0.f; }
+
+	if( !_arcSubSteps )
+	{
+		ZFloatArray L( n*ZCurvesTempSubSteps+1 );
+		_computeArcLengths( i, ZCurvesTempSubSteps, &L[0] );
+
+		return _paramFromLength( &L[0], n*ZCurvesTempSubSteps, s );
+	}
+
+	return _paramFromLength( &_arcLength[ _arcStartIdx[i] ], n*_arcSubSteps, s );
+}
+
+// t: curve parameter in [0,1]
+// It returns the arc length from the root to t.
+float
+ZCurves::lengthFromParam( int i, float t ) const
+{
+	const int n = numSegments(i);
+	if( n < 1 ) { return 0.f; }
+
+	if( !_arcSubSteps )
+	{
+		ZFloatArray L( n*ZCurvesTempSubSteps+1 );
+		_computeArcLengths( i, ZCurvesTempSubSteps, &L[0] );
+
+		return _lengthFromParam( &L[0], n*ZCurvesTempSubSteps, t );
+	}
+
+	return _lengthFromParam( &_arcLength[ _arcStartIdx[i] ], n*_arcSubSteps, t );
+}
+
+// It resamples every curve to have evenly spaced CVs along its arc length.
+// nCVs: # of CVs of each resampled curve (<=0: the same as the current one)
+void
+ZCurves::resample( ZCurves& result, int nCVs, bool useOpenMP ) const
+{
+	const int nCurves = numCurves();
+
+	if( &result == this )
+	{
+		ZCurves tmp;
+		resample( tmp, nCVs, useOpenMP );
+		result = tmp;
+		return;
+	}
+
+	ZIntArray numNewCVs( nCurves );
+	FOR( i, 0, nCurves )
+	{
+		numNewCVs[i] = ( nCVs > 1 ) ? nCVs : _numCVs[i];
+	}
+
+	result.set( numNewCVs );
+
+	if( _arcSubSteps ) {
+
+		#pragma omp parallel for schedule(dynamic,64) if( useOpenMP )
+		FOR( i, 0, nCurves )
+		{
+			_resample( i, _arcSubSteps, &_arcLength[ _arcStartIdx[i] ], &result.cv(i,0), numNewCVs[i] );
+		}
+
+	} else {
+
+		const int subSteps = 8;
+
+		#pragma omp parallel if( useOpenMP )
+		{
+			ZFloatArray L; // per-thread scratch
+
+			#pragma omp for schedule(dynamic,64)
+			FOR( i, 0, nCurves )
+			{
+				L.setLength( numSegments(i)*subSteps+1, false );
+				_computeArcLengths( i, subSteps, &L[0] );
+				_resample( i, subSteps, &L[0], &result.cv(i,0), numNewCVs[i] );
+			}
+		}
+
+	}
+}
+
+// L: the table with m+1 entries
+float
+ZCurves::_lengthFromParam( const float* L, int m, float t )
+{
+	const float x = ZClamp( t, 0.f, 1.f ) * m;
+	const int   k = ZMin( int(x), m-1 );
+	const float w = x - k;
+
+	return ( (1-w)*L[k] + w*L[k+1] );
+}
+
+float
+ZCurves::_paramFromLength( const float* L, int m, float s )
+{
+	if( s <= 0.f  ) { return 0.f; }
+	if( s >= L[m] ) { return 1.f; }
+
+	const int k = int( std::upper_bound( L, L+m+1, s ) - L ) - 1;
+	const float w = ( L[k+1] > L[k] ) ? ( (s-L[k]) / (L[k+1]-L[k]) ) : 0.f;
+
+	return ( (k+w) / (float)m );
+}
+
+void
+ZCurves::_computeArcLengths( int i, int subSteps, float* L ) const
+{
+	const int nCVs_1 = _numCVs[i]-1;
+	const float du = 1 / (float)subSteps;
+
+	int k = 0;
+	L[k++] = 0.f;
+
+	ZPoint p0( root(i) ), p1;
+
+	FOR( j, 0, nCVs_1 )
+	{
+		const ZPoint& P0 = cv( i, ZMax(j-1,0)        );
+		const ZPoint& P1 = cv( i, j                  );
+		const ZPoint& P2 = cv( i, j+1                );
+		const ZPoint& P3 = cv( i, ZMin(j+2,nCVs_1)   );
+
+		FOR( q, 1, subSteps+1 )
+		{
+			p1 = ( q == subSteps ) ? P2 : _zeroDerivative( q*du, P0, P1, P2, P3 );
+
+			L[k] = L[k-1] + p0.distanceTo( p1 );
+			++k;
+
+			p0 = p1;
+		}
+	}
+}
+
+// The targets are monotonically increasing, so the table is walked forward instead of being searched.
+void
+ZCurves::_resample( int i, int subSteps, const float* L, ZPoint* p, int n ) const
+{
+	const int m = numSegments(i) * subSteps;
+	if( m < 1 || n < 2 ) { FOR( j, 0, n ) { p[j] = root(i); } return; }
+
+	const float totalLength = L[m];
+	const float ds = totalLength / (float)(n-1);
+
+	int k = 0;
+
+	p[0]   = root(i);
+	p[n-1] = tip(i);
+
+	FOR( j, 1, n-1 )
+	{
+		const float s = j * ds;
+
+		while( k < m-1 && L[k+1] < s ) { ++k; }
+
+		const float w = ( L[k+1] > L[k] ) ? ( (s-L[k]) / (L[k+1]-L[k]) ) : 0.f;
+
+		p[j] = position( i, (k+w) / (float)m );
+	}
+}
+
 void
 ZCurves::write( ofstream& fout ) const
 {
@@ -739,6 +982,55 @@ ZCurves::load( const char* filePathName )
 	return true;
 }
 
+bool
+ZCurves::saveCache( const char* filePathName ) const
+{
+	ZCacheWriter cache;
+	if( !cache.open( filePathName ) ) { return false; }
+
+	// other data don't need to be saved.
+	if( !cache.add( "numCVs", _numCVs ) ) { cache.abort(); return false; }
+	if( !cache.add( "cv",     _cv     ) ) { cache.abort(); return false; }
+
+	return cache.close();
+}
+
+bool
+ZCurves::loadCache( const char* filePathName )
+{
+	reset();
+
+	ZCacheReader cache;
+
+	if( !cache.open( filePathName ) )
+	{
+		cout << "Error@ZCurves::loadCache(): Failed to load file." << endl;
+		return false;
+	}
+
+	ZArrayView<ZPoint> cvs;
+
+	if( !cache.read( "numCVs", _numCVs ) || !cache.view( "cv", cvs ) )
+	{
+		cout << "Error@ZCurves::loadCache(): Invalid cache file: " << filePathName << endl;
+		reset();
+		return false;
+	}
+
+	_allocate();
+
+	if( _cv.length() != cvs.length() )
+	{
+		cout << "Error@ZCurves::loadCache(): The number of CVs mismatch." << endl;
+		reset();
+		return false;
+	}
+
+	cvs.copyTo( _cv );
+
+	return true;
+}
+
 void
 ZCurves::drawLine( int i, float dt ) const
 {
@@ -782,7 +1074,8 @@ ZCurves::drawCVs( int i ) const
 double
 ZCurves::usedMemorySize( ZDataUnit::DataUnit dataUnit ) const
 {
-	return ( _numCVs.usedMemorySize(dataUnit) + _startIdx.usedMemorySize(dataUnit) + _cv.usedMemorySize(dataUnit) );
+	return ( _numCVs.usedMemorySize(dataUnit) + _startIdx.usedMemorySize(dataUnit) + _cv.usedMemorySize(dataUnit)
+	       + _arcStartIdx.usedMemorySize(dataUnit) + _arcLength.usedMemorySize(dataUnit) );
 }
 
 void
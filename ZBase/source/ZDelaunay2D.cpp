@@ -2,451 +2,639 @@
 // ZDelaunay2D.cpp //
 //-------------------------------------------------------//
 // author: Wanho Choi @ Dexter Studios                   //
-// modified from Magic Software library                  //
-// last update: 2017.02.14                               //
+// last update: 2019.03.30                               //
 //-------------------------------------------------------//
 
 #include <ZelosBase.h>
 
 ZELOS_NAMESPACE_BEGIN
 
-ZDelaunay2D::ZDelaunay2D( ZFloat2Array& vertices, int& numTrifaces, ZIntArray& connectionInfo, ZIntArray& neighborInfo )
+/////////////////////////////////
+// the exact arithmetic (Shewchuk 1997)
+// An expansion is the sum of the non-overlapping doubles in the increasing order of the magnitude.
+
+static const double DelaunayEps       = 1.1102230246251565e-16; // 2^-53
+static const double DelaunayOrientErr = ( 3.0 + 16.0 * DelaunayEps ) * DelaunayEps;
+static const double DelaunayCircleErr = ( 10.0 + 96.0 * DelaunayEps ) * DelaunayEps;
+
+static inline void
+TwoSum( double a, double b, double& x, double& y )
 {
-	int numVertices = vertices.length();
+	x = a + b;
+	const double bv = x - a;
+	const double av = x - bv;
+	y = ( a - av ) + ( b - bv );
+}
 
-	m_kVertex.resize( numVertices );
+static inline void
+FastTwoSum( double a, double b, double& x, double& y ) // |a| >= |b|
+{
+	x = a + b;
+	y = b - ( x - a );
+}
 
-	// output values
-	numTrifaces = 0;
-	connectionInfo.clear();
-	neighborInfo.clear();
+static inline void
+TwoProduct( double a, double b, double& x, double& y )
+{
+	x = a * b;
+	y = std::fma( a, b, -x );
+}
 
-	// transform the points to [-1,1]^2 for numerical preconditioning
-	float fMin = vertices[0][0], fMax = fMin;
+// h = e + f
+static int
+ExpansionSum( int elen, const double* e, int flen, const double* f, double* h )
+{
+	FOR( i, 0, elen ) { h[i] = e[i]; }
+	int hlen = elen;
 
-	for( int i=0; i<numVertices; ++i )
+	FOR( j, 0, flen )
 	{
-		if( vertices[i][0] < fMin )
-			fMin = vertices[i][0];
-		else if( vertices[i][0] > fMax )
-			fMax = vertices[i][0];
-
-		if( vertices[i][1] < fMin )
-			fMin = vertices[i][1];
-		else if( vertices[i][1] > fMax )
-			fMax = vertices[i][1];
-	}
+		double q = f[j];
+		int    k = 0;
 
-	float fHalfRange = 0.5f * ( fMax - fMin );
-	float fInvHalfRange = 1 / fHalfRange;
+		FOR( i, 0, hlen )
+		{
+			double x, y;
+			TwoSum( q, h[i], x, y );
+			if( y != 0.0 ) { h[k++] = y; }
+			q = x;
+		}
 
-	// sort by x-component to prepare to remove duplicate vertices
-	for( int i=0; i<numVertices; ++i )
-	{
-		m_kVertex[i].m_kV[0] = -1.f + fInvHalfRange * ( vertices[i][0] - fMin );
-		m_kVertex[i].m_kV[1] = -1.f + fInvHalfRange * ( vertices[i][1] - fMin );
-		m_kVertex[i].m_iIndex = i;
+		if( ( q != 0.0 ) || ( k == 0 ) ) { h[k++] = q; }
+		hlen = k;
 	}
 
-	sort( m_kVertex.begin(),m_kVertex.end() );
-
-	// remove duplicate points
-	vector<ZDelaunay2D::ZD_SortedVertex>::iterator pkEnd = unique( m_kVertex.begin(),m_kVertex.end() );
-	m_kVertex.erase( pkEnd, m_kVertex.end() );
-
-	// construct supertriangle and add to triangle mesh
-	numVertices = (int)m_kVertex.size();
-	m_aiSuperV[0] = numVertices;
-	m_aiSuperV[1] = numVertices+1;
-	m_aiSuperV[2] = numVertices+2;
-	m_kVertex.push_back( ZDelaunay2D::ZD_SortedVertex( ZFloat2(-2,-2), m_aiSuperV[0] ) );
-	m_kVertex.push_back( ZDelaunay2D::ZD_SortedVertex( ZFloat2( 5,-2), m_aiSuperV[1] ) );
-	m_kVertex.push_back( ZDelaunay2D::ZD_SortedVertex( ZFloat2(-2, 5), m_aiSuperV[2] ) );
-
-	ZDelaunay2D::ZD_Triangle* pkTri = new ZDelaunay2D::ZD_Triangle( m_aiSuperV[0], m_aiSuperV[1], m_aiSuperV[2], NULL, NULL, NULL );
-	m_kTriangle.insert( pkTri );
-	m_apkSuperT[0] = pkTri;
-	m_apkSuperT[1] = pkTri;
-	m_apkSuperT[2] = pkTri;
-
-	// incrementally update the triangulation
-	for( int i=0; i<numVertices; ++i )
-	{
-		// construct the insertion polygon
-        set<ZD_Triangle*> kPolyTri;
-		GetInsertionPolygon( m_kVertex[i].m_kV, kPolyTri );
+	return hlen;
+}
 
-		vector<ZD_Edge> kPoly;
-		GetInsertionPolygonEdges( kPolyTri, kPoly );
+// h = b * e
+static int
+ScaleExpansion( int elen, const double* e, double b, double* h )
+{
+	double q, hh, p1, p0, s;
+	int k = 0;
 
-		// add new triangles formed by the point and insertion polygon edges
-		AddTriangles( i, kPoly );
+	TwoProduct( e[0], b, q, hh );
+	if( hh != 0.0 ) { h[k++] = hh; }
 
-		// remove insertion polygon
-		RemoveInsertionPolygon( kPolyTri );
+	FOR( i, 1, elen )
+	{
+		TwoProduct( e[i], b, p1, p0 );
+		TwoSum( q, p0, s, hh );
+		if( hh != 0.0 ) { h[k++] = hh; }
+		FastTwoSum( p1, s, q, hh );
+		if( hh != 0.0 ) { h[k++] = hh; }
 	}
 
-	// remove triangles sharing a vertex of the supertriangle
-	RemoveTriangles();
+	if( ( q != 0.0 ) || ( k == 0 ) ) { h[k++] = q; }
 
-	// assign integer values to the triangles for use by the caller
-	map<ZDelaunay2D::ZD_Triangle*,int> kPermute;
-	set<ZD_Triangle*>::iterator pkTIter = m_kTriangle.begin();
-	for( int i=0; pkTIter!=m_kTriangle.end(); pkTIter++ )
-	{
-		pkTri = *pkTIter;
-		kPermute[pkTri] = i++;
-	}
-	kPermute[NULL] = -1;
+	return k;
+}
 
-	// put Delaunay triangles into an array (vertices and adjacency info)
-	numTrifaces = (int)m_kTriangle.size();
-	if( numTrifaces > 0 )
+// h = e * f
+static int
+ProductExpansion( int elen, const double* e, int flen, const double* f, double* h )
+{
+	double t[64], s[512];
+
+	int hlen = 0;
+
+	FOR( i, 0, flen )
 	{
-		connectionInfo.setLength( 3*numTrifaces );
-		neighborInfo.setLength( 3*numTrifaces );
-		int i = 0;
-		pkTIter = m_kTriangle.begin();
-		for( ; pkTIter!=m_kTriangle.end(); pkTIter++ )
-		{
-			pkTri = *pkTIter;
-			connectionInfo[i] = m_kVertex[pkTri->m_aiV[0]].m_iIndex;
-			neighborInfo[i++] = kPermute[pkTri->m_apkAdj[0]];
-			connectionInfo[i] = m_kVertex[pkTri->m_aiV[1]].m_iIndex;
-			neighborInfo[i++] = kPermute[pkTri->m_apkAdj[1]];
-			connectionInfo[i] = m_kVertex[pkTri->m_aiV[2]].m_iIndex;
-			neighborInfo[i++] = kPermute[pkTri->m_apkAdj[2]];
-		}
+		const int tlen = ScaleExpansion( elen, e, f[i], t );
+		const int slen = ExpansionSum( hlen, h, tlen, t, s );
+		FOR( j, 0, slen ) { h[j] = s[j]; }
+		hlen = slen;
 	}
+
+	return hlen;
 }
 
-ZDelaunay2D::~ZDelaunay2D()
+// the exact a.x*b.y - b.x*a.y (4 components at most)
+static inline int
+CrossExpansion( double ax, double ay, double bx, double by, double* h )
 {
-	set<ZD_Triangle*>::iterator pkTIter = m_kTriangle.begin();
-	for( ; pkTIter!=m_kTriangle.end(); pkTIter++ )
-	{
-		delete *pkTIter;
-	}
+	double p[2], q[2];
+
+	TwoProduct(  ax, by, p[1], p[0] );
+	TwoProduct( -bx, ay, q[1], q[0] );
+
+	return ExpansionSum( 2, p, 2, q, h );
 }
 
-ZDelaunay2D::ZD_Triangle*
-ZDelaunay2D::getContaining( const ZFloat2& rkP ) const
+// the exact orient(a,b,c) = ab + bc + ca (12 components at most)
+static int
+Det3Expansion( double ax, double ay, double bx, double by, double cx, double cy, double* h )
 {
-	// start with supertriangle <S0,S1,V>
-	ZDelaunay2D::ZD_Triangle* pkTri = m_apkSuperT[0];
-	assert( pkTri->m_aiV[0] == m_aiSuperV[0] &&  pkTri->m_aiV[1] == m_aiSuperV[1] );
+	double ab[4], bc[4], ca[4], t[8];
 
-	const ZFloat2& rkS1 = m_kVertex[m_aiSuperV[1]].m_kV;
-	ZFloat2 kDiff = rkP - rkS1;
-	int iSIndex = 1;
-	int iVIndex = 2;  // local index following that of S1
+	const int ablen = CrossExpansion( ax, ay, bx, by, ab );
+	const int bclen = CrossExpansion( bx, by, cx, cy, bc );
+	const int calen = CrossExpansion( cx, cy, ax, ay, ca );
 
-	// The search should never iterate over more than all the triangles. But, just to be safe...
-	for( int i=0; i<(int)m_kTriangle.size(); ++i )
-	{
-		// test if P is inside the triangle
-		ZFloat2 kVmS1 = m_kVertex[pkTri->m_aiV[iVIndex]].m_kV - rkS1;
-		float fKross = kVmS1[0]*kDiff[1] - kVmS1[1]*kDiff[0];
-		if( fKross >= 0 ) { return pkTri; }
+	const int tlen = ExpansionSum( ablen, ab, bclen, bc, t );
 
-		pkTri = pkTri->m_apkAdj[iSIndex];
-		//assert( pkTri );
+	return ExpansionSum( tlen, t, calen, ca, h );
+}
+
+static inline int
+Sign( double x )
+{
+	return ( ( x > 0.0 ) ? 1 : ( ( x < 0.0 ) ? -1 : 0 ) );
+}
+
+// +1: c is on the left of a->b, -1: on the right, 0: collinear
+static int
+Orient2D( double ax, double ay, double bx, double by, double cx, double cy )
+{
+	const double l = ( ax - cx ) * ( by - cy );
+	const double r = ( ay - cy ) * ( bx - cx );
+	const double d = l - r;
 
-		if( pkTri->m_aiV[0] == m_aiSuperV[1] ) {
+	const double bound = DelaunayOrientErr * ( ZAbs(l) + ZAbs(r) );
+	if( ( d > bound ) || ( -d > bound ) ) { return Sign(d); }
 
-			iSIndex = 0;
-			iVIndex = 1;
+	double h[12];
+	const int hlen = Det3Expansion( ax, ay, bx, by, cx, cy, h );
 
-		} else if( pkTri->m_aiV[1] == m_aiSuperV[1] ) {
+	return Sign( h[hlen-1] );
+}
 
-			iSIndex = 1;
-			iVIndex = 2;
+// +1: d is inside of the circle through a, b, and c (counterclockwise), -1: outside, 0: cocircular
+static int
+InCircle( double ax, double ay, double bx, double by, double cx, double cy, double dx, double dy )
+{
+	const double adx = ax - dx, ady = ay - dy;
+	const double bdx = bx - dx, bdy = by - dy;
+	const double cdx = cx - dx, cdy = cy - dy;
 
-		} else if( pkTri->m_aiV[2] == m_aiSuperV[1] ) {
+	const double bc = bdx*cdy, cb = cdx*bdy, alift = adx*adx + ady*ady;
+	const double ca = cdx*ady, ac = adx*cdy, blift = bdx*bdx + bdy*bdy;
+	const double ab = adx*bdy, ba = bdx*ady, clift = cdx*cdx + cdy*cdy;
 
-			iSIndex = 2;
-			iVIndex = 0;
+	const double d = alift*(bc-cb) + blift*(ca-ac) + clift*(ab-ba);
 
-		} else {
+	const double permanent = ( ZAbs(bc) + ZAbs(cb) ) * alift
+	                       + ( ZAbs(ca) + ZAbs(ac) ) * blift
+	                       + ( ZAbs(ab) + ZAbs(ba) ) * clift;
 
-			cout << "Error@ZDelaunay2D::getContaining(): Failed." << endl;
-			return NULL;
-		}
+	const double bound = DelaunayCircleErr * permanent;
+	if( ( d > bound ) || ( -d > bound ) ) { return Sign(d); }
+
+	// the exact determinant of the rows (x, y, x^2+y^2, 1) of a, b, c, d:
+	// alift*bcd - blift*cda + clift*dab - dlift*abc
+	const double px[4] = { ax, bx, cx, dx };
+	const double py[4] = { ay, by, cy, dy };
+
+	double sum[512], tmp[512];
+	int sumlen = 0;
+
+	FOR( i, 0, 4 )
+	{
+		const int j = (i+1)%4, k = (i+2)%4, l = (i+3)%4;
+
+		double det[12], lift[4], x2[2], y2[2], term[128];
+
+		const int detlen = Det3Expansion( px[j], py[j], px[k], py[k], px[l], py[l], det );
+
+		TwoProduct( px[i], px[i], x2[1], x2[0] );
+		TwoProduct( py[i], py[i], y2[1], y2[0] );
+		const int liftlen = ExpansionSum( 2, x2, 2, y2, lift );
+
+		int termlen = ProductExpansion( detlen, det, liftlen, lift, term );
+
+		// the signs: +, -, +, - (The cyclic minors of the odd rows are negated.)
+		if( i%2 == 1 ) { FOR( m, 0, termlen ) { term[m] = -term[m]; } }
+
+		const int tmplen = ExpansionSum( sumlen, sum, termlen, term, tmp );
+		FOR( m, 0, tmplen ) { sum[m] = tmp[m]; }
+		sumlen = tmplen;
 	}
 
-	// by construction, point must be in some triangle in the mesh
-	return pkTri;
+	return Sign( sum[sumlen-1] );
 }
 
-bool
-ZDelaunay2D::isInsertionComponent( const ZFloat2& rkV, ZDelaunay2D::ZD_Triangle* pkTri ) const
+/////////////////////////////////
+// the insertion order
+
+static inline unsigned int
+DelaunayHash( unsigned int i )
+{
+	i = ( i ^ 12345391u ) * 2654435769u;
+	i ^= ( i << 6 ) ^ ( i >> 26 );
+	i *= 2654435769u;
+	i += ( i << 5 ) ^ ( i >> 12 );
+	return i;
+}
+
+// the distance along the Hilbert curve of the 2^16 x 2^16 grid
+static inline unsigned int
+HilbertIndex( unsigned int x, unsigned int y )
 {
-	// determine the number of vertices in common with the supertriangle
-	int iCommon = 0, j = -1;
-	for( int i=0; i<3; ++i )
+	unsigned int d = 0;
+
+	for( unsigned int s=(1u<<15); s>0; s>>=1 )
 	{
-		int iV = pkTri->m_aiV[i];
-		if( iV == m_aiSuperV[0] )
-		{
-			iCommon++;
-			j = i;
-		}
-		if( iV == m_aiSuperV[1] )
-		{
-			iCommon++;
-			j = i;
-		}
-		if ( iV == m_aiSuperV[2] )
+		const unsigned int rx = ( ( x & s ) > 0 );
+		const unsigned int ry = ( ( y & s ) > 0 );
+
+		d += s * s * ( ( 3 * rx ) ^ ry );
+
+		if( ry == 0 )
 		{
-			iCommon++;
-			j = i;
+			if( rx == 1 ) { x = 65535-x; y = 65535-y; }
+			std::swap( x, y );
 		}
 	}
 
-	if( iCommon == 0 )
+	return d;
+}
+
+struct DelaunayOrder
+{
+	uint64_t key;	// (round, Hilbert index)
+	float    x, y;
+	int      index;
+};
+
+// by the key, and the duplicate points next to each other (the smallest index first)
+static bool
+DelaunayCompare( const DelaunayOrder& a, const DelaunayOrder& b )
+{
+	if( a.key != b.key ) { return ( a.key < b.key ); }
+	if( a.x   != b.x   ) { return ( a.x   < b.x   ); }
+	if( a.y   != b.y   ) { return ( a.y   < b.y   ); }
+	return ( a.index < b.index );
+}
+
+/////////////////////////////////
+// ZDelaunay2D
+
+ZDelaunay2D::ZDelaunay2D( ZFloat2Array& vertices, int& numTrifaces, ZIntArray& connectionInfo, ZIntArray& neighborInfo )
+: _ghost(0), _last(-1)
+{
+	ZPROFILE_SCOPE( "ZDelaunay2D" );
+
+	// output values
+	numTrifaces = 0;
+	connectionInfo.clear();
+	neighborInfo.clear();
+
+	ZDelaunay2D::_order( vertices );
+
+	if( !ZDelaunay2D::_initialize() ) { return; } // less than three vertices, or all collinear
+
+	FOR( p, 3, _ghost )
 	{
-		return pkTri->pointInCircle( rkV,m_kVertex );
+		ZDelaunay2D::_insert( p );
 	}
 
-	if( iCommon == 1 )
+	// assign integer values to the (finite) triangles for use by the caller
+	const int numTris = (int)_tris.size();
+
+	vector<int> id( numTris, -1 );
+
+	FOR( t, 0, numTris )
 	{
-		return pkTri->pointLeftOfEdge( rkV, m_kVertex, (j+1)%3, (j+2)%3 );
+		if( ( _tris[t].v[0] < 0 ) || _isGhost(t) ) { continue; }
+		id[t] = numTrifaces++;
 	}
 
-    return pkTri->pointInTriangle( rkV, m_kVertex );
+	if( numTrifaces > 0 )
+	{
+		connectionInfo.setLength( 3*numTrifaces );
+		neighborInfo.setLength( 3*numTrifaces );
+
+		FOR( t, 0, numTris )
+		{
+			if( id[t] < 0 ) { continue; }
+
+			const Triangle& T = _tris[t];
+			const int i = 3*id[t];
+
+			FOR( e, 0, 3 )
+			{
+				connectionInfo[i+e] = _index[ T.v[e] ];
+				neighborInfo  [i+e] = id[ T.adj[e] ]; // -1 for the ghost triangles
+			}
+		}
+	}
 }
 
+ZDelaunay2D::~ZDelaunay2D()
+{}
+
 void
-ZDelaunay2D::GetInsertionPolygon( const ZFloat2& rkV, set<ZD_Triangle*>& rkPolyTri ) const
+ZDelaunay2D::_order( ZFloat2Array& vertices )
 {
-	// locate triangle containing input point, add to insertion polygon
-	ZDelaunay2D::ZD_Triangle* pkTri = getContaining( rkV );
-	//assert( isInsertionComponent(rkV,pkTri) );
-	rkPolyTri.insert( pkTri );
+	const int n0 = vertices.length();
+
+	vector<DelaunayOrder> v( n0 );
 
-	// breadth-first search for other triangles in the insertion polygon
-	set<ZD_Triangle*> kInterior, kBoundary;
-	kInterior.insert( pkTri );
-	ZDelaunay2D::ZD_Triangle* pkAdj;
+	float xMin=Z_LARGE, xMax=-Z_LARGE, yMin=Z_LARGE, yMax=-Z_LARGE;
 
-	for( int i=0; i<3; ++i )
+	FOR( i, 0, n0 )
 	{
-		pkAdj = pkTri->m_apkAdj[i];
-		if( pkAdj ) { kBoundary.insert( pkAdj ); }
+		// (+0.f turns -0.f into +0.f: the round is hashed from the bits, and the duplicates must have the same key.)
+		v[i].x     = vertices[i][0] + 0.f;
+		v[i].y     = vertices[i][1] + 0.f;
+		v[i].index = i;
+
+		xMin = ZMin( xMin, v[i].x );   xMax = ZMax( xMax, v[i].x );
+		yMin = ZMin( yMin, v[i].y );   yMax = ZMax( yMax, v[i].y );
 	}
 
-	while( kBoundary.size() > 0 )
+	// BRIO: each vertex falls in the last round with the probability 1/2, in the previous one with 1/4, and so on.
+	// In each round, the vertices are sorted along the Hilbert curve.
+	// (The round is hashed from the position, so the duplicate points have the same key.)
 	{
-		set<ZD_Triangle*> kExterior;
+		const double sx = 65535.0 / ZMax( (double)xMax-xMin, 1e-30 );
+		const double sy = 65535.0 / ZMax( (double)yMax-yMin, 1e-30 );
 
-		// process boundary triangles
-		set<ZD_Triangle*>::iterator pkIter;
+		int numRounds = 1;
+		while( ( 1 << numRounds ) < n0 ) { ++numRounds; }
 
-		for( pkIter = kBoundary.begin(); pkIter != kBoundary.end(); pkIter++ )
+		FOR( i, 0, n0 )
 		{
-			// current boundary triangle to process
-			pkTri = *pkIter;
-			if( isInsertionComponent( rkV, pkTri ) )
-			{
-				// triangle is an insertion component
-				rkPolyTri.insert(pkTri);
-
-				// locate adjacent, exterior triangles for later processing
-				for( int i=0; i<3; ++i )
-				{
-					pkAdj = pkTri->m_apkAdj[i];
-					if( pkAdj && kInterior.find(pkAdj) == kInterior.end() && kBoundary.find(pkAdj) == kBoundary.end() )
-					{
-						kExterior.insert( pkAdj );
-					}
-				}
-			}
-		}
+			unsigned int bx=0, by=0;
+			memcpy( &bx, &v[i].x, sizeof(float) );
+			memcpy( &by, &v[i].y, sizeof(float) );
 
-		// boundary triangles processed, move them to interior
-		for( pkIter = kBoundary.begin(); pkIter != kBoundary.end(); pkIter++ )
-		{
-			kInterior.insert( *pkIter );
+			const unsigned int h = DelaunayHash( bx ^ DelaunayHash( by ) );
+
+			int zeros = 0; // the number of the trailing zero bits
+			while( ( zeros < numRounds-1 ) && !( h & ( 1u << zeros ) ) ) { ++zeros; }
+
+			const uint64_t round   = (uint64_t)( numRounds-1 - zeros );
+			const uint64_t hilbert = HilbertIndex( (unsigned int)( ( v[i].x - xMin ) * sx ), (unsigned int)( ( v[i].y - yMin ) * sy ) );
+
+			v[i].key = ( round << 32 ) | hilbert;
 		}
 
-		// exterior triangles are next in line to be processed
-		kBoundary = kExterior;
+		sort( v.begin(), v.end(), DelaunayCompare );
 	}
 
-	// If the input point is outside the current convex hull, triangles
-	// sharing a supertriangle edge have to be added to the insertion polygon
-	// if the non-supertriangle vertex is shared by two edges that are visible
-	// to the input point.
-	for( int i=0; i<3; ++i )
+	// remove duplicate points (keeping the smallest index)
+	int n = 0;
+
+	FOR( i, 0, n0 )
 	{
-		pkTri = m_apkSuperT[i];
-		if( rkPolyTri.find(pkTri->m_apkAdj[1]) != rkPolyTri.end()
-		 && rkPolyTri.find(pkTri->m_apkAdj[2]) != rkPolyTri.end() )
-		{
-			rkPolyTri.insert( pkTri );
-		}
+		if( n && ( v[i].x == v[n-1].x ) && ( v[i].y == v[n-1].y ) ) { continue; }
+		v[n++] = v[i];
 	}
+
+	_x.resize( n );
+	_y.resize( n );
+	_index.resize( n );
+
+	FOR( i, 0, n )
+	{
+		_x[i]     = v[i].x;
+		_y[i]     = v[i].y;
+		_index[i] = v[i].index;
+	}
+
+	_ghost = n;
 }
 
-void
-ZDelaunay2D::GetInsertionPolygonEdges( set<ZD_Triangle*>& rkPolyTri, vector<ZD_Edge>& rkPoly ) const
+bool
+ZDelaunay2D::_initialize()
 {
-	// locate edges of the insertion polygon
-	map<int,ZD_Edge> kIPolygon;
-	int iV0, iV1;
-	ZDelaunay2D::ZD_Triangle* pkTri;
-	ZDelaunay2D::ZD_Triangle* pkAdj;
-	set<ZD_Triangle*>::iterator pkTIter;
-
-	for( pkTIter = rkPolyTri.begin(); pkTIter != rkPolyTri.end(); pkTIter++ )
+	const int n = _ghost;
+	if( n < 3 ) { return false; }
+
+	// the first vertex not collinear with the first two ones
+	int k = 2;
+	while( ( k < n ) && !_orient( 0, 1, k ) ) { ++k; }
+	if( k == n ) { return false; }
+
+	if( k != 2 )
 	{
-		// get an insertion polygon triangle
-		pkTri = *pkTIter;
-
-		// If an adjacent triangle is not an insertion polygon triangle, then
-		// the shared edge is a boundary edge of the insertion polygon.  Use
-		// this edge to create a new Delaunay triangle from the input vertex
-		// and the shared edge.
-		for( int j=0; j<3; ++j )
-		{
-			pkAdj = pkTri->m_apkAdj[j];
+		std::swap( _x[2],     _x[k]     );
+		std::swap( _y[2],     _y[k]     );
+		std::swap( _index[2], _index[k] );
+	}
 
-			if( pkAdj ) {
-				if( rkPolyTri.find(pkAdj) == rkPolyTri.end() )
-				{
-					// adjacent triangle is not part of insertion polygon
-					iV0 = pkTri->m_aiV[j];
-					iV1 = pkTri->m_aiV[(j+1)%3];
-					kIPolygon[iV0] = ZD_Edge(iV0,iV1,pkTri,pkAdj);
-				}
+	_tris.reserve( 2*n + 8 );
+	_stamp.reserve( 2*n + 8 );
+	_fan.resize( n+1, -1 );
 
-			} else {
+	// the first triangle (counterclockwise) and the three ghost triangles around it
+	const int a = 0;
+	const int b = ( _orient(0,1,2) > 0 ) ? 1 : 2;
+	const int c = 3 - b;
+
+	const int T  = _newTriangle( a, b, c );
+	const int G0 = _newTriangle( b, a, _ghost );
+	const int G1 = _newTriangle( c, b, _ghost );
+	const int G2 = _newTriangle( a, c, _ghost );
+
+	_tris[T ].adj[0] = G0;   _tris[T ].adj[1] = G1;   _tris[T ].adj[2] = G2;
+	_tris[G0].adj[0] = T;    _tris[G0].adj[1] = G2;   _tris[G0].adj[2] = G1;
+	_tris[G1].adj[0] = T;    _tris[G1].adj[1] = G0;   _tris[G1].adj[2] = G2;
+	_tris[G2].adj[0] = T;    _tris[G2].adj[1] = G1;   _tris[G2].adj[2] = G0;
+
+	_last = T;
+
+	return true;
+}
+
+int
+ZDelaunay2D::_newTriangle( int a, int b, int c )
+{
+	int t = 0;
+
+	if( _free.empty() ) {
+
+		t = (int)_tris.size();
+		_tris.push_back( Triangle() );
+		_stamp.push_back( -1 );
+
+	} else {
+
+		t = _free.back();
+		_free.pop_back();
 
-				// no adjacent triangle, edge is part of insertion polygon
-				iV0 = pkTri->m_aiV[j];
-				iV1 = pkTri->m_aiV[(j+1)%3];
-				kIPolygon[iV0] = ZD_Edge(iV0,iV1,pkTri,pkAdj);
-			}
-		}
 	}
 
-	// insertion polygon should be at least a triangle
-	int iSize = (int)kIPolygon.size();
-	//assert( iSize >= 3l  );
+	Triangle& T = _tris[t];
+
+	T.v[0] = a;   T.v[1] = b;   T.v[2] = c;
+	T.adj[0] = T.adj[1] = T.adj[2] = -1;
+
+	return t;
+}
+
+bool
+ZDelaunay2D::_isGhost( int t ) const
+{
+	const Triangle& T = _tris[t];
+	return ( ( T.v[0] == _ghost ) || ( T.v[1] == _ghost ) || ( T.v[2] == _ghost ) );
+}
+
+int
+ZDelaunay2D::_orient( int a, int b, int c ) const
+{
+	return Orient2D( _x[a], _y[a], _x[b], _y[b], _x[c], _y[c] );
+}
+
+int
+ZDelaunay2D::_incircle( int a, int b, int c, int d ) const
+{
+	return InCircle( _x[a], _y[a], _x[b], _y[b], _x[c], _y[c], _x[d], _y[d] );
+}
+
+// whether the circumcircle of the triangle contains the vertex p
+// (for the ghost triangles: the open half plane outside of the hull edge plus the open hull edge itself)
+bool
+ZDelaunay2D::_inConflict( int t, int p ) const
+{
+	const Triangle& T = _tris[t];
 
-	// sort the edges
-	map<int,ZD_Edge>::iterator pkE = kIPolygon.begin();
-	iV0 = pkE->second.m_iV0;
-	for( int i=0; i<iSize; ++i )
+	FOR( g, 0, 3 )
 	{
-		iV1 = pkE->second.m_iV1;
-		rkPoly.push_back(pkE->second);
-		pkE = kIPolygon.find(iV1);
-		//assert( pkE != kIPolygon.end() );
+		if( T.v[g] != _ghost ) { continue; }
+
+		const int a = T.v[(g+1)%3];
+		const int b = T.v[(g+2)%3];
+
+		const int o = _orient( a, b, p );
+		if( o ) { return ( o > 0 ); }
+
+		// on the line of the hull edge: only when strictly between a and b
+		if( _x[a] != _x[b] ) { return ( ( _x[p] > ZMin(_x[a],_x[b]) ) && ( _x[p] < ZMax(_x[a],_x[b]) ) ); }
+		return ( ( _y[p] > ZMin(_y[a],_y[b]) ) && ( _y[p] < ZMax(_y[a],_y[b]) ) );
 	}
-	//assert( iV1 == iV0 );
+
+	return ( _incircle( T.v[0], T.v[1], T.v[2], p ) > 0 );
 }
 
-void
-ZDelaunay2D::AddTriangles( int iV2, const vector<ZD_Edge>& rkPoly )
+// the triangle containing p (a ghost triangle in conflict with p when p is outside of the hull)
+int
+ZDelaunay2D::_locate( int p ) const
 {
-	// create new triangles
-	int iSize = (int)rkPoly.size();
-	vector<ZD_Triangle*> kTriangle( iSize );
-	ZDelaunay2D::ZD_Triangle* pkTri;
-	ZDelaunay2D::ZD_Triangle* pkAdj;
-	for( int i=0; i<iSize; ++i )
+	const int numTris = (int)_tris.size();
+
+	int t = _last;
+
+	// the visibility walk
+	FOR( step, 0, numTris )
 	{
-		const ZD_Edge& rkE = rkPoly[i];
-
-		// construct new triangle
-		pkTri = new ZDelaunay2D::ZD_Triangle( rkE.m_iV0, rkE.m_iV1, iV2,rkE.m_pkA, NULL, NULL );
-		kTriangle[i] = pkTri;
-		if( rkE.m_iV0 == m_aiSuperV[0] && rkE.m_iV1 == m_aiSuperV[1] )
-			m_apkSuperT[0] = pkTri;
-		else if( rkE.m_iV0 == m_aiSuperV[1] && rkE.m_iV1 == m_aiSuperV[2] )
-			m_apkSuperT[1] = pkTri;
-		else if ( rkE.m_iV0 == m_aiSuperV[2] && rkE.m_iV1 == m_aiSuperV[0] )
-			m_apkSuperT[2] = pkTri;
-
-		// update information of triangle adjacent to insertion polygon
-		pkAdj = rkE.m_pkA;
-		if( pkAdj )
+		const Triangle& T = _tris[t];
+
+		int g = -1;
+		FOR( i, 0, 3 ) { if( T.v[i] == _ghost ) { g = i; } }
+
+		if( g >= 0 )
 		{
-			for( int j=0; j<3; ++j )
-			{
-				if( pkAdj->m_apkAdj[j] == rkE.m_pkT )
-				{
-					pkAdj->m_apkAdj[j] = pkTri;
-					break;
-				}
-			}
+			if( _inConflict( t, p ) ) { return t; }
+
+			t = T.adj[(g+1)%3]; // the finite triangle across the hull edge
+			continue;
 		}
+
+		const int start = p % 3; // not to go around in circles on the degenerate cases
+
+		int next = -1;
+
+		FOR( k, 0, 3 )
+		{
+			const int e = ( start + k ) % 3;
+
+			if( _orient( T.v[e], T.v[(e+1)%3], p ) < 0 ) { next = T.adj[e]; break; }
+		}
+
+		if( next < 0 ) { return t; }
+
+		t = next;
 	}
 
-	// Insertion polygon is a star polygon with center vertex V2.  Finalize
-	// the triangles by setting the adjacency information.
-	for( int i=0; i<iSize; ++i )
+	// It should not happen, but just to be safe...
+	FOR( i, 0, numTris )
 	{
-		// current triangle
-		pkTri = kTriangle[i];
-
-		// connect to next new triangle
-		int iNext = i+1;
-		if( iNext == iSize ) { iNext = 0; }
-		pkTri->m_apkAdj[1] = kTriangle[iNext];
-
-		// connect to previous new triangle
-		int iPrev = i-1;
-		if( iPrev == -1 ) { iPrev = iSize-1; }
-		pkTri->m_apkAdj[2] = kTriangle[iPrev];
+		if( ( _tris[i].v[0] >= 0 ) && _inConflict( i, p ) ) { return i; }
 	}
 
-	// add the triangles to the mesh
-	for( int i=0; i<iSize; ++i )
-		m_kTriangle.insert( kTriangle[i] );
+	return _last;
 }
 
 void
-ZDelaunay2D::RemoveInsertionPolygon( set<ZD_Triangle*>& rkPolyTri )
+ZDelaunay2D::_insert( int p )
 {
-	set<ZD_Triangle*>::iterator pkTIter;
-	for( pkTIter=rkPolyTri.begin(); pkTIter!=rkPolyTri.end(); pkTIter++ )
+	const int t0 = _locate( p );
+
+	// the cavity: the triangles in conflict with p (connected to t0)
+	_stack.clear();
+	_cavity.clear();
+	_boundary.clear();
+
+	_stamp[t0] = p;
+	_stack.push_back( t0 );
+
+	while( !_stack.empty() )
 	{
-		ZDelaunay2D::ZD_Triangle* pkTri = *pkTIter;
-		m_kTriangle.erase( pkTri );
-		delete pkTri;
+		const int t = _stack.back();
+		_stack.pop_back();
+
+		_cavity.push_back( t );
+
+		FOR( e, 0, 3 )
+		{
+			const int n = _tris[t].adj[e];
+			if( _stamp[n] == p ) { continue; } // already in the cavity
+
+			if( _inConflict( n, p ) ) {
+
+				_stamp[n] = p;
+				_stack.push_back( n );
+
+			} else {
+
+				Edge E;
+				E.a       = _tris[t].v[e];
+				E.b       = _tris[t].v[(e+1)%3];
+				E.outside = n;
+
+				_boundary.push_back( E );
+
+			}
+		}
 	}
-}
 
-void
-ZDelaunay2D::RemoveTriangles()
-{
-	// identify those triangles sharing a vertex of the supertriangle
-	set<ZD_Triangle*> kRemoveTri;
-	ZDelaunay2D::ZD_Triangle* pkTri;
-	set<ZD_Triangle*>::iterator pkTIter = m_kTriangle.begin();
-	for( ; pkTIter!=m_kTriangle.end(); pkTIter++ )
+	// removing the cavity (The triangles are reused by the new ones.)
+	FOR( i, 0, (int)_cavity.size() )
+	{
+		_tris[ _cavity[i] ].v[0] = -1;
+		_free.push_back( _cavity[i] );
+	}
+
+	// the star of the new triangles (a,b,p) around p
+	const int numNew = (int)_boundary.size();
+
+	FOR( i, 0, numNew )
 	{
-		pkTri = *pkTIter;
-		for( int j=0; j<3; ++j )
+		const Edge& E = _boundary[i];
+
+		const int t = _newTriangle( E.a, E.b, p );
+		_tris[t].adj[0] = E.outside;
+
+		Triangle& O = _tris[E.outside];
+		FOR( k, 0, 3 )
 		{
-			int iV = pkTri->m_aiV[j];
-			if( iV == m_aiSuperV[0] || iV == m_aiSuperV[1] || iV == m_aiSuperV[2] )
-			{
-            	kRemoveTri.insert( pkTri );
-				break;
-			}
+			if( ( O.v[k] == E.b ) && ( O.v[(k+1)%3] == E.a ) ) { O.adj[k] = t; break; }
 		}
+
+		_fan[E.a] = t;
+		_last     = t;
 	}
 
-	// remove the triangles from the mesh
-	pkTIter = kRemoveTri.begin();
-	for( ; pkTIter!=kRemoveTri.end(); pkTIter++ )
+	FOR( i, 0, numNew )
 	{
-		pkTri = *pkTIter;
-		m_kTriangle.erase(pkTri);
-		delete pkTri;
+		const int t = _fan[ _boundary[i].a ];
+		const int s = _fan[ _boundary[i].b ]; // (b,c,p)
+
+		_tris[t].adj[1] = s;
+		_tris[s].adj[2] = t;
 	}
 }
 
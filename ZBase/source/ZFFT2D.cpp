@@ -0,0 +1,241 @@
+//------------//
+// ZFFT2D.cpp //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.30                               //
+//-------------------------------------------------------//
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+// the number of the columns transformed together
+// (16 complex numbers = two cache lines per row of a block)
+static const int ZFFT2D_BLOCK = 16;
+
+ZFFT2D::ZFFT2D()
+: _nx(0), _nz(0)
+{}
+
+ZFFT2D::ZFFT2D( int Nx, int Nz )
+: _nx(0), _nz(0)
+{
+	set( Nx, Nz );
+}
+
+void
+ZFFT2D::reset()
+{
+	_nx = _nz = 0;
+
+	_wx.reset();
+	_wz.reset();
+	_rx.reset();
+	_rz.reset();
+}
+
+static void
+Twiddles( int n, ZComplexArray& w, ZIntArray& r )
+{
+	w.setLength( ZMax( n/2, 1 ) );
+	FOR( j, 0, n/2 )
+	{
+		const double a = -2.0 * M_PI * j / (double)n; // (in double for the large n)
+		w[j].set( (float)cos(a), (float)sin(a) );
+	}
+
+	int bits = 0;
+	while( (1<<bits) < n ) { ++bits; }
+
+	r.setLength( n );
+	FOR( j, 0, n )
+	{
+		int v = 0;
+		FOR( b, 0, bits ) { if( j & (1<<b) ) { v |= 1 << (bits-1-b); } }
+		r[j] = v;
+	}
+}
+
+bool
+ZFFT2D::set( int Nx, int Nz )
+{
+	if( !isPowerOfTwo(Nx) || !isPowerOfTwo(Nz) )
+	{
+		cout << "Error@ZFFT2D::set(): The resolution must be a power of two." << endl;
+		reset();
+		return false;
+	}
+
+	if( ( Nx == _nx ) && ( Nz == _nz ) ) { return true; }
+
+	_nx = Nx;
+	_nz = Nz;
+
+	Twiddles( _nx, _wx, _rx );
+	Twiddles( _nz, _wz, _rz );
+
+	return true;
+}
+
+// the radix-2 butterflies of the n elements in the bit-reversed order
+// (Each element is 'width' complex numbers in a row, so the columns of a block are transformed together.)
+static void
+Butterflies( ZComplex* a, int n, int width, const ZComplex* w, bool inverse )
+{
+	const float sign = inverse ? -1.f : 1.f;
+
+	for( int h=1; h<n; h<<=1 )
+	{
+		const int step = n / (2*h);
+
+		for( int s=0; s<n; s+=2*h )
+		{
+			FOR( j, 0, h )
+			{
+				const float wr = w[j*step].r;
+				const float wi = sign * w[j*step].i;
+
+				ZComplex* p = a + (s+j)   * width;
+				ZComplex* q = a + (s+j+h) * width;
+
+				FOR( c, 0, width )
+				{
+					const float xr = q[c].r*wr - q[c].i*wi;
+					const float xi = q[c].r*wi + q[c].i*wr;
+
+					q[c].r = p[c].r - xr;   q[c].i = p[c].i - xi;
+					p[c].r += xr;           p[c].i += xi;
+				}
+			}
+		}
+	}
+}
+
+void
+ZFFT2D::_transform( ZComplex* data, bool inverse, float scale, bool useOpenMP ) const
+{
+	const int Nx = _nx;
+	const int Nz = _nz;
+	const int B  = ZMin( ZFFT2D_BLOCK, Nx );
+
+	const ZComplex* wx = _wx.pointer();
+	const ZComplex* wz = _wz.pointer();
+	const int*      rx = _rx.pointer();
+	const int*      rz = _rz.pointer();
+
+	#pragma omp parallel if( useOpenMP && Nx*Nz>4096 )
+	{
+		std::vector<ZComplex> buffer( ZMax( Nx, Nz*B ) );
+		ZComplex* buf = &buffer[0];
+
+		// rows (along x)
+		#pragma omp for
+		FOR( k, 0, Nz )
+		{
+			ZComplex* row = data + Nx*k;
+
+			FOR( i, 0, Nx ) { buf[i] = row[ rx[i] ]; }
+			Butterflies( buf, Nx, 1, wx, inverse );
+			FOR( i, 0, Nx ) { row[i] = buf[i]; }
+		}
+
+		// columns (along z) by the blocks of B columns
+		#pragma omp for
+		FOR( b, 0, Nx/B )
+		{
+			const int i0 = b * B;
+
+			FOR( k, 0, Nz )
+			{
+				const ZComplex* src = data + i0 + Nx*rz[k];
+				FOR( c, 0, B ) { buf[k*B+c] = src[c]; }
+			}
+
+			Butterflies( buf, Nz, B, wz, inverse );
+
+			FOR( k, 0, Nz )
+			{
+				ZComplex* dst = data + i0 + Nx*k;
+				FOR( c, 0, B ) { dst[c].r = scale*buf[k*B+c].r;  dst[c].i = scale*buf[k*B+c].i; }
+			}
+		}
+	}
+}
+
+void
+ZFFT2D::forward( ZComplex* data, bool useOpenMP ) const
+{
+	if( !_nx || !data ) { return; }
+	_transform( data, false, 1.f, useOpenMP );
+}
+
+void
+ZFFT2D::inverse( ZComplex* data, bool normalize, bool useOpenMP ) const
+{
+	if( !_nx || !data ) { return; }
+	_transform( data, true, ( normalize ? ( 1.f / ( (float)_nx * (float)_nz ) ) : 1.f ), useOpenMP );
+}
+
+bool
+ZFFT2D::_check( const ZComplexField2D& field, const char* funcName ) const
+{
+	if( field.location() != ZFieldLocation::zCell )
+	{
+		cout << "Error@ZFFT2D::" << funcName << "(): Invalid field location." << endl;
+		return false;
+	}
+
+	if( ( field.nx() != _nx ) || ( field.nz() != _nz ) || ( field.length() != _nx*_nz ) )
+	{
+		cout << "Error@ZFFT2D::" << funcName << "(): Resolution mismatch." << endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool
+ZFFT2D::forward( ZComplexField2D& field, bool useOpenMP ) const
+{
+	if( !_check( field, "forward" ) ) { return false; }
+	forward( field.pointer(), useOpenMP );
+	return true;
+}
+
+bool
+ZFFT2D::inverse( ZComplexField2D& field, bool normalize, bool useOpenMP ) const
+{
+	if( !_check( field, "inverse" ) ) { return false; }
+	inverse( field.pointer(), normalize, useOpenMP );
+	return true;
+}
+
+double
+ZFFT2D::usedMemorySize( ZDataUnit::DataUnit dataUnit ) const
+{
+	double bytes = 0.0;
+	bytes += _wx.usedMemorySize() + _wz.usedMemorySize();
+	bytes += _rx.usedMemorySize() + _rz.usedMemorySize();
+
+	switch( dataUnit )
+	{
+		case ZDataUnit::zBytes:     { return bytes; }
+		case ZDataUnit::zKilobytes: { return (bytes/1024.0); }
+		case ZDataUnit::zMegabytes: { return (bytes/ZPow2(1024.0)); }
+		case ZDataUnit::zGigabytes: { return (bytes/ZPow3(1024.0)); }
+		default: { cout << "Error@ZFFT2D::usedMemorySize(): Invalid data unit." << endl; return 0.0; }
+	}
+}
+
+ostream&
+operator<<( ostream& os, const ZFFT2D& object )
+{
+	os << "<ZFFT2D>" << endl;
+	os << " resolution : " << object.nx() << " x " << object.nz() << endl;
+	os << " memory size: " << object.usedMemorySize(ZDataUnit::zKilobytes) << " kb." << endl;
+	os << endl;
+	return os;
+}
+
+ZELOS_NAMESPACE_END
+
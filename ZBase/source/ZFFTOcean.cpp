@@ -0,0 +1,512 @@
+//---------------//
+// ZFFTOcean.cpp //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.30                               //
+//-------------------------------------------------------//
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+static const float ZFFTOcean_G        = 9.81f;		// the gravitational acceleration
+static const float ZFFTOcean_PHILLIPS = 0.0081f;	// the Phillips constant
+
+ZFFTOcean::ZFFTOcean()
+{
+	spectrumType      = ZOceanSpectrumType::zPhillips;
+	resolution        = 256;
+	patchSize         = 200.f;
+	numCascades       = 1;
+	cascadeRatio      = 5.3f;
+	windSpeed         = 10.f;
+	windDirection     = 0.f;
+	fetch             = 100.f;
+	peakEnhancement   = 3.3f;
+	directionalSpread = 5.f;
+	smallWaveCutoff   = 0.f;
+	depth             = 0.f;
+	amplitude         = 1.f;
+	choppiness        = 1.f;
+	repeatPeriod      = 0.f;
+	foamThreshold     = 0.3f;
+	foamDecay         = 0.f;
+	seed              = 0;
+
+	reset();
+}
+
+void
+ZFFTOcean::reset()
+{
+	_cascades.clear();
+	_fft.reset();
+	_builtKey.clear();
+
+	_time      = 0.f;
+	_evaluated = false;
+}
+
+std::vector<double>
+ZFFTOcean::_key() const
+{
+	std::vector<double> key;
+
+	key.push_back( (double)spectrumType );
+	key.push_back( resolution );
+	key.push_back( patchSize );
+	key.push_back( numCascades );
+	key.push_back( cascadeRatio );
+	key.push_back( windSpeed );
+	key.push_back( windDirection );
+	key.push_back( fetch );
+	key.push_back( peakEnhancement );
+	key.push_back( directionalSpread );
+	key.push_back( smallWaveCutoff );
+	key.push_back( depth );
+	key.push_back( amplitude );
+	key.push_back( repeatPeriod );
+	key.push_back( seed );
+
+	return key;
+}
+
+const ZFFTOcean::Cascade&
+ZFFTOcean::_cascade( int c ) const
+{
+	if( _cascades.empty() )
+	{
+		static const Cascade empty = Cascade();
+		return empty;
+	}
+
+	return _cascades[ ZClamp( c, 0, (int)_cascades.size()-1 ) ];
+}
+
+float
+ZFFTOcean::cascadePatchSize( int cascade ) const
+{
+	return _cascade( cascade ).patchSize;
+}
+
+const ZComplexField2D& ZFFTOcean::initialSpectrum( int cascade ) const { return _cascade( cascade ).h0;           }
+const ZVectorField2D&  ZFFTOcean::displacement( int cascade )    const { return _cascade( cascade ).displacement; }
+const ZVectorField2D&  ZFFTOcean::normal( int cascade )          const { return _cascade( cascade ).normal;       }
+const ZScalarField2D&  ZFFTOcean::jacobian( int cascade )        const { return _cascade( cascade ).jacobian;     }
+const ZScalarField2D&  ZFFTOcean::foam( int cascade )            const { return _cascade( cascade ).foam;         }
+
+float
+ZFFTOcean::_omega( float k ) const
+{
+	if( depth > 0.f ) { return sqrtf( ZFFTOcean_G * k * tanhf( k*depth ) ); }
+	return sqrtf( ZFFTOcean_G * k );
+}
+
+float
+ZFFTOcean::_dOmega( float k ) const
+{
+	const float w = _omega( k );
+	if( w <= 0.f ) { return 0.f; }
+
+	if( depth > 0.f )
+	{
+		const float kh = k * depth;
+		const float ch = coshf( ZMin( kh, 40.f ) );
+		return ( ZFFTOcean_G * ( tanhf(kh) + kh/(ch*ch) ) / ( 2*w ) );
+	}
+
+	return ( ZFFTOcean_G / ( 2*w ) );
+}
+
+float
+ZFFTOcean::_spectrum( float k ) const
+{
+	if( k <= 0.f ) { return 0.f; }
+
+	const float U = ZMax( windSpeed, 1e-3f );
+
+	if( spectrumType == ZOceanSpectrumType::zPhillips )
+	{
+		// F(k) = (alpha/2) * exp(-1/(k*L)^2) / k^3 (the variance per dk)
+		const float L = U * U / ZFFTOcean_G;
+		return ( 0.5f * ZFFTOcean_PHILLIPS * expf( -1.f / ZPow2( k*L ) ) / ZPow4( k ) );
+	}
+
+	if( spectrumType == ZOceanSpectrumType::zJONSWAP )
+	{
+		// (The dimensionless fetch g*F/U^2 is limited to the fully developed sea.)
+		const float F     = ZMin( ZMax( fetch, 1e-3f ) * 1000.f, 2.2e4f*U*U/ZFFTOcean_G ); // in meters
+		const float alpha = 0.076f * powf( U*U / ( F*ZFFTOcean_G ), 0.22f );
+		const float wp    = 22.f * powf( ZFFTOcean_G*ZFFTOcean_G / ( U*F ), 1.f/3.f );
+
+		const float w = _omega( k );
+		if( w <= 0.f ) { return 0.f; }
+
+		const float sigma = ( w <= wp ) ? 0.07f : 0.09f;
+		const float r     = expf( -ZPow2( w-wp ) / ( 2 * sigma*sigma * wp*wp ) );
+		const float S     = alpha * ZFFTOcean_G*ZFFTOcean_G / ZPow5( w ) * expf( -1.25f * ZPow4( wp/w ) ) * powf( ZMax( peakEnhancement, 1.f ), r );
+
+		// S(w)dw = S(w)*(dw/dk)dk
+		return ( S * _dOmega( k ) / k );
+	}
+
+	return 0.f;
+}
+
+// the seed of the wave vector (n,m) of the cascade c
+static inline unsigned int
+ModeSeed( int seed, int c, int n, int m )
+{
+	unsigned int h = (unsigned int)seed * 2654435761u;
+	h ^= (unsigned int)c * 0x85EBCA6Bu + 0x9E3779B9u + (h<<6) + (h>>2);
+	h ^= (unsigned int)n * 0xC2B2AE35u + 0x9E3779B9u + (h<<6) + (h>>2);
+	h ^= (unsigned int)m * 0x27D4EB2Fu + 0x9E3779B9u + (h<<6) + (h>>2);
+	return h;
+}
+
+void
+ZFFTOcean::_build( bool useOpenMP )
+{
+	ZPROFILE_SCOPE( "ZFFTOcean::build" );
+
+	const int N = resolution;
+	const int C = numCascades;
+
+	_cascades.clear();
+	_cascades.resize( C );
+	_fft.set( N, N );
+
+	// the normalization of cos^(2s)(theta/2) (its integral over [-pi,pi] is 1)
+	const double s = ZMax( directionalSpread, 0.f );
+	const float  Q = (float)( exp( 2*s*log(2.0) + 2*lgamma(s+1) - lgamma(2*s+1) ) / ( 2*M_PI ) );
+
+	const float windAngle = ZDegToRad( windDirection );
+	const float l2        = ZPow2( smallWaveCutoff );
+	const float w0        = ( repeatPeriod > 0.f ) ? ( Z_PIx2 / repeatPeriod ) : 0.f;
+
+	FOR( c, 0, C )
+	{
+		Cascade& cascade = _cascades[c];
+
+		const float L = patchSize / powf( cascadeRatio, (float)c );
+
+		cascade.patchSize = L;
+
+		// the band boundary: below half of the Nyquist of this cascade, and the sixth mode of the next one
+		cascade.kMin = ( c == 0 ) ? 0.f : _cascades[c-1].kMax;
+		cascade.kMax = ( c == C-1 ) ? Z_FLTMAX : ZMin( 0.5f*Z_PI*N/L, 6*Z_PIx2 / ( L/cascadeRatio ) );
+
+		cascade.h0.set( N, N, L, L );
+		cascade.h0c.set( N, N, L, L );
+		cascade.omega.setLength( N*N );
+		FOR( j, 0, 4 ) { cascade.packed[j].set( N, N, L, L ); }
+		cascade.displacement.set( N, N, L, L );
+		cascade.normal.set( N, N, L, L );
+		cascade.slope.set( N, N, L, L );
+		cascade.gradient.set( N, N, L, L );
+		cascade.jacobian.set( N, N, L, L );
+		cascade.foam.set( N, N, L, L );
+
+		const float dk   = Z_PIx2 / L;
+		const float kMin = cascade.kMin;
+		const float kMax = cascade.kMax;
+
+		ZComplex* h0    = cascade.h0.pointer();
+		float*    omega = cascade.omega.pointer();
+
+		#pragma omp parallel for if( useOpenMP )
+		FOR( k, 0, N )
+		{
+			const int m = ( k < N/2 ) ? k : ( k - N );
+
+			FOR( i, 0, N )
+			{
+				const int n   = ( i < N/2 ) ? i : ( i - N );
+				const int idx = i + N*k;
+
+				const float kx = n * dk;
+				const float kz = m * dk;
+				const float kk = sqrtf( kx*kx + kz*kz );
+
+				omega[idx] = ( w0 > 0.f ) ? ( floorf( _omega(kk) / w0 ) * w0 ) : _omega(kk);
+
+				// (The Nyquist modes are left out to keep the outputs real.)
+				if( ( kk <= 0.f ) || ( n == -N/2 ) || ( m == -N/2 ) || ( kk < kMin ) || ( kk >= kMax ) )
+				{
+					h0[idx].set( 0.f, 0.f );
+					continue;
+				}
+
+				const float theta = atan2f( kz, kx ) - windAngle;
+				const float D     = Q * powf( fabsf( cosf( 0.5f*theta ) ), (float)(2*s) );
+				const float psi   = _spectrum( kk ) * D * expf( -kk*kk*l2 );
+
+				// the Gaussian random numbers by the Box-Muller transform
+				const unsigned int h = ModeSeed( seed, c, n, m );
+				const float u1 = ZMax( ZRand( h ), 1e-12f );
+				const float u2 = ZRand( h ^ 0x5BD1E995u );
+				const float r  = sqrtf( -2.f * logf( u1 ) );
+
+				const float a = 0.5f * amplitude * sqrtf( psi ) * dk;
+
+				h0[idx].set( a * r * cosf( Z_PIx2*u2 ), a * r * sinf( Z_PIx2*u2 ) );
+			}
+		}
+
+		ZComplex* h0c = cascade.h0c.pointer();
+
+		#pragma omp parallel for if( useOpenMP )
+		FOR( k, 0, N )
+		{
+			FOR( i, 0, N )
+			{
+				const ZComplex& v = h0[ ((N-i)%N) + N*((N-k)%N) ];
+				h0c[ i + N*k ].set( v.r, -v.i );
+			}
+		}
+	}
+}
+
+void
+ZFFTOcean::_evaluate( Cascade& cascade, float time, float dt, bool useOpenMP )
+{
+	ZPROFILE_SCOPE( "ZFFTOcean::evaluate" );
+
+	const int   N  = resolution;
+	const float dk = Z_PIx2 / cascade.patchSize;
+
+	const ZComplex* h0    = cascade.h0.pointer();
+	const ZComplex* h0c   = cascade.h0c.pointer();
+	const float*    omega = cascade.omega.pointer();
+
+	ZComplex* P0 = cascade.packed[0].pointer();
+	ZComplex* P1 = cascade.packed[1].pointer();
+	ZComplex* P2 = cascade.packed[2].pointer();
+	ZComplex* P3 = cascade.packed[3].pointer();
+
+	// the spectra at the time (packed into pairs: A+I*B = (A.r-B.i, A.i+B.r))
+	#pragma omp parallel for if( useOpenMP )
+	FOR( k, 0, N )
+	{
+		const int m = ( k < N/2 ) ? k : ( k - N );
+
+		FOR( i, 0, N )
+		{
+			const int n   = ( i < N/2 ) ? i : ( i - N );
+			const int idx = i + N*k;
+
+			const float kx = n * dk;
+			const float kz = m * dk;
+			const float kk = sqrtf( kx*kx + kz*kz );
+
+			if( kk <= 0.f )
+			{
+				P0[idx].set( 0.f, 0.f );  P1[idx].set( 0.f, 0.f );
+				P2[idx].set( 0.f, 0.f );  P3[idx].set( 0.f, 0.f );
+				continue;
+			}
+
+			const float c = cosf( omega[idx]*time );
+			const float s = sinf( omega[idx]*time );
+
+			const ZComplex& a = h0[idx];
+			const ZComplex& b = h0c[idx];
+
+			// h(k,t)
+			const float hr = a.r*c - a.i*s + b.r*c + b.i*s;
+			const float hi = a.r*s + a.i*c + b.i*c - b.r*s;
+
+			const float ux = kx / kk;
+			const float uz = kz / kk;
+
+			// Dx=-I*ux*h, Dz=-I*uz*h, dh/dx=I*kx*h, dh/dz=I*kz*h, dDx/dx=kx*ux*h, dDz/dz=kz*uz*h, dDx/dz=kz*ux*h
+			const float dxr =  ux*hi, dxi = -ux*hr;
+			const float dzr =  uz*hi, dzi = -uz*hr;
+			const float sxr = -kx*hi, sxi =  kx*hr;
+			const float szr = -kz*hi, szi =  kz*hr;
+			const float gxx = kx*ux,  gzz = kz*uz,  gxz = kz*ux;
+
+			P0[idx].set( hr -     dxi, hi +     dxr );
+			P1[idx].set( dzr -    sxi, dzi +    sxr );
+			P2[idx].set( szr - gxx*hi, szi + gxx*hr );
+			P3[idx].set( gzz*hr - gxz*hi, gzz*hi + gxz*hr );
+		}
+	}
+
+	FOR( j, 0, 4 ) { _fft.inverse( cascade.packed[j].pointer(), false, useOpenMP ); }
+
+	const float lambda    = choppiness;
+	const float threshold = foamThreshold;
+	const float decay     = ( ( foamDecay > 0.f ) && ( dt > 0.f ) ) ? expf( -foamDecay*dt ) : 0.f;
+
+	ZVector* disp = cascade.displacement.pointer();
+	ZVector* nrm  = cascade.normal.pointer();
+	ZVector* slp  = cascade.slope.pointer();
+	ZVector* grd  = cascade.gradient.pointer();
+	float*   jac  = cascade.jacobian.pointer();
+	float*   foam = cascade.foam.pointer();
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( idx, 0, N*N )
+	{
+		disp[idx].set( lambda*P0[idx].i, P0[idx].r, lambda*P1[idx].r );
+		slp[idx].set( P1[idx].i, 0.f, P2[idx].r );
+		grd[idx].set( lambda*P2[idx].i, lambda*P3[idx].i, lambda*P3[idx].r );
+
+		const ZVector& g = grd[idx];
+
+		jac[idx] = (1+g.x)*(1+g.z) - g.y*g.y;
+		nrm[idx] = _normal( slp[idx], g );
+
+		const float f = ZClamp( threshold - jac[idx], 0.f, 1.f );
+		foam[idx] = ( decay > 0.f ) ? ZMax( f, decay*foam[idx] ) : f;
+	}
+}
+
+bool
+ZFFTOcean::update( float time, bool useOpenMP )
+{
+	ZPROFILE_SCOPE( "ZFFTOcean::update" );
+
+	if( !ZFFT2D::isPowerOfTwo( resolution ) || ( resolution < 2 ) )
+	{
+		cout << "Error@ZFFTOcean::update(): The resolution must be a power of two." << endl;
+		return false;
+	}
+
+	if( ( patchSize <= 0.f ) || ( numCascades < 1 ) || ( numCascades > 4 ) || ( ( numCascades > 1 ) && ( cascadeRatio <= 1.f ) ) )
+	{
+		cout << "Error@ZFFTOcean::update(): Invalid cascade parameters." << endl;
+		return false;
+	}
+
+	if( ( spectrumType != ZOceanSpectrumType::zPhillips ) && ( spectrumType != ZOceanSpectrumType::zJONSWAP ) )
+	{
+		cout << "Error@ZFFTOcean::update(): Invalid spectrum type." << endl;
+		return false;
+	}
+
+	const std::vector<double> key = _key();
+
+	if( key != _builtKey )
+	{
+		_build( useOpenMP );
+		_builtKey  = key;
+		_evaluated = false;
+	}
+
+	// (The foam is not accumulated over the first frame or a jump back in time.)
+	const float dt = _evaluated ? ( time - _time ) : 0.f;
+
+	FOR( c, 0, _cascades.size() ) { _evaluate( _cascades[c], time, dt, useOpenMP ); }
+
+	_time      = time;
+	_evaluated = true;
+
+	return true;
+}
+
+// the periodic bilinear interpolation of a cell-located field
+static inline ZVector
+PeriodicLerp( const ZVectorField2D& f, float x, float z )
+{
+	const int N = f.nx();
+
+	x = x / f.dx() - 0.5f;
+	z = z / f.dz() - 0.5f;
+
+	const float fx = floorf( x );
+	const float fz = floorf( z );
+
+	const float wx = x - fx;
+	const float wz = z - fz;
+
+	int i0 = (int)fx % N;   if( i0 < 0 ) { i0 += N; }
+	int k0 = (int)fz % N;   if( k0 < 0 ) { k0 += N; }
+
+	const int i1 = ( i0 + 1 ) % N;
+	const int k1 = ( k0 + 1 ) % N;
+
+	const ZVector* d = f.pointer();
+
+	return ( ( d[i0+N*k0]*(1-wx) + d[i1+N*k0]*wx ) * (1-wz) + ( d[i0+N*k1]*(1-wx) + d[i1+N*k1]*wx ) * wz );
+}
+
+void
+ZFFTOcean::sample( const ZPoint& p, ZVector& displacement, ZVector& normal, float& jacobian ) const
+{
+	ZVector slope, gradient;
+
+	displacement.zeroize();
+
+	FOR( c, 0, _cascades.size() )
+	{
+		const Cascade& cascade = _cascades[c];
+
+		displacement += PeriodicLerp( cascade.displacement, p.x, p.z );
+		slope        += PeriodicLerp( cascade.slope,        p.x, p.z );
+		gradient     += PeriodicLerp( cascade.gradient,     p.x, p.z );
+	}
+
+	jacobian = (1+gradient.x)*(1+gradient.z) - gradient.y*gradient.y;
+	normal   = _normal( slope, gradient );
+}
+
+void
+ZFFTOcean::sample( const ZPointArray& p, ZVectorArray& displacements, ZVectorArray& normals, ZFloatArray& jacobians, bool useOpenMP ) const
+{
+	const int n = p.length();
+
+	displacements.setLength( n );
+	normals.setLength( n );
+	jacobians.setLength( n );
+
+	#pragma omp parallel for if( useOpenMP && n>1000 )
+	FOR( i, 0, n )
+	{
+		sample( p[i], displacements[i], normals[i], jacobians[i] );
+	}
+}
+
+double
+ZFFTOcean::usedMemorySize( ZDataUnit::DataUnit dataUnit ) const
+{
+	double bytes = _fft.usedMemorySize();
+
+	FOR( c, 0, _cascades.size() )
+	{
+		const Cascade& cascade = _cascades[c];
+
+		bytes += cascade.h0.usedMemorySize() + cascade.h0c.usedMemorySize() + cascade.omega.usedMemorySize();
+		FOR( j, 0, 4 ) { bytes += cascade.packed[j].usedMemorySize(); }
+		bytes += cascade.displacement.usedMemorySize() + cascade.normal.usedMemorySize();
+		bytes += cascade.slope.usedMemorySize() + cascade.gradient.usedMemorySize();
+		bytes += cascade.jacobian.usedMemorySize() + cascade.foam.usedMemorySize();
+	}
+
+	switch( dataUnit )
+	{
+		case ZDataUnit::zBytes:     { return bytes; }
+		case ZDataUnit::zKilobytes: { return (bytes/1024.0); }
+		case ZDataUnit::zMegabytes: { return (bytes/ZPow2(1024.0)); }
+		case ZDataUnit::zGigabytes: { return (bytes/ZPow3(1024.0)); }
+		default: { cout << "Error@ZFFTOcean::usedMemorySize(): Invalid data unit." << endl; return 0.0; }
+	}
+}
+
+ostream&
+operator<<( ostream& os, const ZFFTOcean& object )
+{
+	os << "<ZFFTOcean>" << endl;
+	os << " spectrum   : " << ZOceanSpectrumType::name( object.spectrumType ) << endl;
+	os << " resolution : " << object.resolution << " x " << object.resolution << endl;
+	os << " cascades   : " << object.numCascades << " (" << object.patchSize << " m, ratio " << object.cascadeRatio << ")" << endl;
+	os << " wind       : " << object.windSpeed << " m/s, " << object.windDirection << " deg." << endl;
+	os << " time       : " << object.time() << endl;
+	os << " memory size: " << object.usedMemorySize(ZDataUnit::zMegabytes) << " mb." << endl;
+	os << endl;
+	return os;
+}
+
+ZELOS_NAMESPACE_END
+
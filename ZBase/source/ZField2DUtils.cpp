@@ -3,7 +3,7 @@
 //-------------------------------------------------------//
 // author: Wanho Choi @ Dexter Studios                   //
 //         Nayoung Kim @ Dexter Studios                  //
-// last update: 2016.09.19                               //
+// last update: 2019.03.30                               //
 //-------------------------------------------------------//
 
 #include <ZelosBase.h>
@@ -442,6 +442,49 @@ MapToScalarField( const ZImageMap& img, ZScalarField2D& field, int n, bool useOp
 	return true;
 }
 
+bool
+MapToScalarField( const char* imageFilePathName, ZScalarField2D& field, int n, int lod, bool useOpenMP )
+{
+	std::shared_ptr<const ZTiledImage> img = ZImageCache::global().get( imageFilePathName );
+
+	if( !img )
+	{
+		cout << "Error@ZField2DUtils::MapToScalarField(): Failed to load file: " << imageFilePathName << endl;
+		return false;
+	}
+
+	const int level = ZClamp( lod, 0, img->numLevels()-1 );
+
+	const int Nx = img->width( level );
+	const int Nz = img->height( level );
+
+	if( Nx != Nz )
+	{
+		cout << "Error@ZField2DUtils::MapToScalarField(): Image width and height values are not equal." << endl;
+		return false;
+	}
+
+	const int length = Nx * Nz;
+	const int numChannels = img->numChannels();
+
+	if( n+1 > numChannels )
+	{
+		cout << "Error@ZField2DUtils::MapToScalarField(): This image has only " << numChannels << " channels." << endl;
+		return false;
+	}
+
+	field.set( Nx, Nz );
+
+	#pragma omp parallel for if( useOpenMP && length>10000 )
+	PER_EACH_ELEMENT_2D( field )
+		const int idx = field.index(i,k);
+		float& val = field[idx];
+		val = img->texel(i,k,n,level);
+	END_PER_EACH_2D
+
+	return true;
+}
+
 bool
 ArrayToField( const ZVectorArray& arr, ZVectorField2D& field, bool useOpenMP )
 {
@@ -7,6 +7,10 @@
 
 #include <ZelosBase.h>
 
+#ifdef __SSE2__
+ #include <emmintrin.h>
+#endif
+
 ZELOS_NAMESPACE_BEGIN
 
 ZField3DBase::ZField3DBase()
@@ -173,6 +177,327 @@ ZField3DBase::read( ifstream& fin )
 	ZField3DBase::set( grid, loc );
 }
 
+ZFieldLattice3D::ZFieldLattice3D( const ZField3DBase& f )
+{
+	const ZPoint minPt = f.minPoint();
+	const bool   onCell = ( f.location() == ZFieldLocation::zCell );
+
+	dx = f.dx();   ddx = 1.f / dx;   ox = minPt.x + ( onCell ? (0.5f*dx) : 0.f );
+	dy = f.dy();   ddy = 1.f / dy;   oy = minPt.y + ( onCell ? (0.5f*dy) : 0.f );
+	dz = f.dz();   ddz = 1.f / dz;   oz = minPt.z + ( onCell ? (0.5f*dz) : 0.f );
+
+	iMax = f.iMax();
+	jMax = f.jMax();
+	kMax = f.kMax();
+
+	s0 = f.index( 0, 1, 0 );
+	s1 = f.index( 0, 0, 1 );
+}
+
+////////////////////
+// batch sampling //
+
+// the number of the points whose stencils are computed together
+static const int ZSAMPLE_BLOCK = 64;
+
+// how many points ahead the elements are prefetched
+static const int ZSAMPLE_PREFETCH = 4;
+
+// the number of the elements per axis of a bin by which the points are sorted
+static const int ZSAMPLE_BIN = 8;
+
+#if defined(__GNUC__)
+	#define ZSAMPLE_PREFETCH_ADDRESS( a ) __builtin_prefetch( (const void*)(a) )
+#else
+	#define ZSAMPLE_PREFETCH_ADDRESS( a )
+#endif
+
+// the lower corner elements and the fractions of a block of points (structure of arrays)
+struct ZSampleStencils
+{
+	int   i[ZSAMPLE_BLOCK], j[ZSAMPLE_BLOCK], k[ZSAMPLE_BLOCK];
+	int   base[ZSAMPLE_BLOCK];
+	float fx[ZSAMPLE_BLOCK], fy[ZSAMPLE_BLOCK], fz[ZSAMPLE_BLOCK];
+};
+
+// It is the same as ZGetStencil() for each point. (The positions are clamped into the domain.)
+// The SSE path computes the fractions of four points at once.
+static void
+ComputeStencils( const ZFieldLattice3D& L, const ZPoint* p, int n, ZSampleStencils& s )
+{
+	int m = 0;
+
+	#ifdef __SSE2__
+	{
+		const __m128 ox = _mm_set1_ps( L.ox ), ddx = _mm_set1_ps( L.ddx ), xMax = _mm_set1_ps( (float)L.iMax );
+		const __m128 oy = _mm_set1_ps( L.oy ), ddy = _mm_set1_ps( L.ddy ), yMax = _mm_set1_ps( (float)L.jMax );
+		const __m128 oz = _mm_set1_ps( L.oz ), ddz = _mm_set1_ps( L.ddz ), zMax = _mm_set1_ps( (float)L.kMax );
+
+		const __m128i iLast = _mm_set1_epi32( L.iMax-1 );
+		const __m128i jLast = _mm_set1_epi32( L.jMax-1 );
+		const __m128i kLast = _mm_set1_epi32( L.kMax-1 );
+
+		const __m128 zero = _mm_setzero_ps();
+
+		for( ; m+4 <= n; m+=4 )
+		{
+			const ZPoint* q = p + m;
+
+			// (_mm_min_ps() returns the second operand for a NaN, so a NaN position goes to the upper boundary.)
+			const __m128 u = _mm_max_ps( _mm_min_ps( _mm_mul_ps( _mm_sub_ps( _mm_setr_ps( q[0].x, q[1].x, q[2].x, q[3].x ), ox ), ddx ), xMax ), zero );
+			const __m128 v = _mm_max_ps( _mm_min_ps( _mm_mul_ps( _mm_sub_ps( _mm_setr_ps( q[0].y, q[1].y, q[2].y, q[3].y ), oy ), ddy ), yMax ), zero );
+			const __m128 w = _mm_max_ps( _mm_min_ps( _mm_mul_ps( _mm_sub_ps( _mm_setr_ps( q[0].z, q[1].z, q[2].z, q[3].z ), oz ), ddz ), zMax ), zero );
+
+			// the truncation of the non-negative values and the min with the last index (SSE2 has no _mm_min_epi32)
+			__m128i i = _mm_cvttps_epi32( u );
+			__m128i j = _mm_cvttps_epi32( v );
+			__m128i k = _mm_cvttps_epi32( w );
+
+			i = _mm_sub_epi32( i, _mm_and_si128( _mm_cmpgt_epi32( i, iLast ), _mm_sub_epi32( i, iLast ) ) );
+			j = _mm_sub_epi32( j, _mm_and_si128( _mm_cmpgt_epi32( j, jLast ), _mm_sub_epi32( j, jLast ) ) );
+			k = _mm_sub_epi32( k, _mm_and_si128( _mm_cmpgt_epi32( k, kLast ), _mm_sub_epi32( k, kLast ) ) );
+
+			_mm_storeu_si128( (__m128i*)( s.i + m ), i );
+			_mm_storeu_si128( (__m128i*)( s.j + m ), j );
+			_mm_storeu_si128( (__m128i*)( s.k + m ), k );
+
+			_mm_storeu_ps( s.fx + m, _mm_sub_ps( u, _mm_cvtepi32_ps( i ) ) );
+			_mm_storeu_ps( s.fy + m, _mm_sub_ps( v, _mm_cvtepi32_ps( j ) ) );
+			_mm_storeu_ps( s.fz + m, _mm_sub_ps( w, _mm_cvtepi32_ps( k ) ) );
+
+			// (in int: the strides times the indices may exceed the float precision)
+			FOR( l, m, m+4 ) { s.base[l] = s.i[l] + L.s0*s.j[l] + L.s1*s.k[l]; }
+		}
+	}
+	#endif
+
+	for( ; m < n; ++m )
+	{
+		ZFieldStencil3D st;
+		ZGetStencil( L, p[m], st );
+
+		s.i[m] = st.i;   s.fx[m] = st.fx;
+		s.j[m] = st.j;   s.fy[m] = st.fy;
+		s.k[m] = st.k;   s.fz[m] = st.fz;
+
+		s.base[m] = st.base;
+	}
+}
+
+// the four rows of the elements around the point m+ZSAMPLE_PREFETCH
+static inline void
+Prefetch( const float* q, int C, const ZFieldLattice3D& L, const ZSampleStencils& s, int m, int n )
+{
+	if( m+ZSAMPLE_PREFETCH >= n ) { return; }
+
+	const float* q0 = q + C*s.base[m+ZSAMPLE_PREFETCH];
+
+	ZSAMPLE_PREFETCH_ADDRESS( q0 );
+	ZSAMPLE_PREFETCH_ADDRESS( q0 + C*L.s0 );
+	ZSAMPLE_PREFETCH_ADDRESS( q0 + C*L.s1 );
+	ZSAMPLE_PREFETCH_ADDRESS( q0 + C*(L.s0+L.s1) );
+}
+
+template <int C>
+static void
+GatherLinear( const float* q, const ZFieldLattice3D& L, const ZSampleStencils& s, const int* order, int n, float* values )
+{
+	FOR( m, 0, n )
+	{
+		Prefetch( q, C, L, s, m, n );
+
+		ZTrilerp<C>( q, L, s.base[m], s.fx[m], s.fy[m], s.fz[m], values + C*( order ? order[m] : m ) );
+	}
+}
+
+// the offsets of the four elements of a cubic stencil along an axis (clamped at the boundaries)
+static inline void
+CubicOffsets( int i, int iMax, int stride, int o[4] )
+{
+	o[0] = stride * ZMax( i-1, 0 );
+	o[1] = stride * i;
+	o[2] = stride * (i+1);
+	o[3] = stride * ZMin( i+2, iMax );
+}
+
+template <int C>
+static void
+GatherCatrom( const float* q, const ZFieldLattice3D& L, const ZSampleStencils& s, const int* order, int n, float* values )
+{
+	FOR( m, 0, n )
+	{
+		Prefetch( q, C, L, s, m, n );
+
+		int xo[4], yo[4], zo[4];
+		CubicOffsets( s.i[m], L.iMax, 1,    xo );
+		CubicOffsets( s.j[m], L.jMax, L.s0, yo );
+		CubicOffsets( s.k[m], L.kMax, L.s1, zo );
+
+		float wx[4], wy[4], wz[4];
+		ZCatRomWeights( s.fx[m], wx );
+		ZCatRomWeights( s.fy[m], wy );
+		ZCatRomWeights( s.fz[m], wz );
+
+		float est[C];
+		FOR( c, 0, C ) { est[c] = 0.f; }
+
+		FOR( kk, 0, 4 )
+		FOR( jj, 0, 4 )
+		{
+			const float* r = q + C*( zo[kk] + yo[jj] );
+			const float  w = wz[kk] * wy[jj];
+
+			FOR( c, 0, C )
+			{
+				est[c] += w * ( wx[0]*r[C*xo[0]+c] + wx[1]*r[C*xo[1]+c] + wx[2]*r[C*xo[2]+c] + wx[3]*r[C*xo[3]+c] );
+			}
+		}
+
+		float* out = values + C*( order ? order[m] : m );
+		FOR( c, 0, C ) { out[c] = est[c]; }
+	}
+}
+
+template <int C>
+static void
+GatherMcerp( const float* q, const ZFieldLattice3D& L, const ZSampleStencils& s, const int* order, int n, float* values )
+{
+	FOR( m, 0, n )
+	{
+		Prefetch( q, C, L, s, m, n );
+
+		int xo[4], yo[4], zo[4];
+		CubicOffsets( s.i[m], L.iMax, 1,    xo );
+		CubicOffsets( s.j[m], L.jMax, L.s0, yo );
+		CubicOffsets( s.k[m], L.kMax, L.s1, zo );
+
+		const float fx = s.fx[m], fy = s.fy[m], fz = s.fz[m];
+
+		float* out = values + C*( order ? order[m] : m );
+
+		FOR( c, 0, C )
+		{
+			float kValues[4];
+
+			FOR( kk, 0, 4 )
+			{
+				float jValues[4];
+
+				FOR( jj, 0, 4 )
+				{
+					const float* r = q + C*( zo[kk] + yo[jj] ) + c;
+					jValues[jj] = ZMCerp( r[C*xo[0]], r[C*xo[1]], r[C*xo[2]], r[C*xo[3]], fx );
+				}
+
+				kValues[kk] = ZMCerp( jValues[0], jValues[1], jValues[2], jValues[3], fy );
+			}
+
+			out[c] = ZMCerp( kValues[0], kValues[1], kValues[2], kValues[3], fz );
+		}
+	}
+}
+
+// It sorts the points by the bins of ZSAMPLE_BIN^3 elements (stable, so the order is deterministic).
+// sorted[m] = p[order[m]]
+static void
+SortByBins( const ZFieldLattice3D& L, const ZPoint* p, int n, ZIntArray& order, ZPointArray& sorted, bool useOpenMP )
+{
+	const int bi = L.iMax/ZSAMPLE_BIN+1;
+	const int bj = L.jMax/ZSAMPLE_BIN+1;
+	const int bk = L.kMax/ZSAMPLE_BIN+1;
+
+	ZIntArray bins;
+	bins.setLength( n, false );
+
+	#pragma omp parallel for if( useOpenMP && n>10000 )
+	FOR( m, 0, n )
+	{
+		const int i = (int)ZClamp( (p[m].x-L.ox)*L.ddx, 0.f, (float)L.iMax ) / ZSAMPLE_BIN;
+		const int j = (int)ZClamp( (p[m].y-L.oy)*L.ddy, 0.f, (float)L.jMax ) / ZSAMPLE_BIN;
+		const int k = (int)ZClamp( (p[m].z-L.oz)*L.ddz, 0.f, (float)L.kMax ) / ZSAMPLE_BIN;
+
+		bins[m] = i + bi*( j + bj*k );
+	}
+
+	std::vector<int> start( bi*bj*bk+1, 0 );
+	FOR( m, 0, n ) { ++start[ bins[m]+1 ]; }
+	FOR( b, 0, bi*bj*bk ) { start[b+1] += start[b]; }
+
+	order.setLength( n, false );
+	sorted.setLength( n, false );
+
+	FOR( m, 0, n )
+	{
+		const int o = start[ bins[m] ]++;
+
+		order[o]  = m;
+		sorted[o] = p[m];
+	}
+}
+
+template <int C>
+static void
+SampleBlocks( const float* q, const ZFieldLattice3D& L, const ZPoint* p, const int* order, int n, float* values,
+              ZInterpolationType::InterpolationType type, bool useOpenMP )
+{
+	const int numBlocks = ( n + ZSAMPLE_BLOCK - 1 ) / ZSAMPLE_BLOCK;
+
+	#pragma omp parallel for schedule(static) if( useOpenMP && n>4096 )
+	FOR( b, 0, numBlocks )
+	{
+		const int m0 = b * ZSAMPLE_BLOCK;
+		const int nb = ZMin( ZSAMPLE_BLOCK, n-m0 );
+
+		// (sorted: the values of p[m0,m0+nb) go to order[m0,m0+nb))
+		const int* blockOrder  = order ? ( order + m0 ) : (const int*)NULL;
+		float*     blockValues = order ? values : ( values + C*m0 );
+
+		ZSampleStencils s;
+		ComputeStencils( L, p+m0, nb, s );
+
+		switch( type )
+		{
+			default:
+			case ZInterpolationType::zLinear:         { GatherLinear<C>( q, L, s, blockOrder, nb, blockValues ); break; }
+			case ZInterpolationType::zCatmullRom:     { GatherCatrom<C>( q, L, s, blockOrder, nb, blockValues ); break; }
+			case ZInterpolationType::zMonotonicCubic: { GatherMcerp<C> ( q, L, s, blockOrder, nb, blockValues ); break; }
+		}
+	}
+}
+
+bool
+ZField3DBase::_sample( const float* data, int numComponents, const ZPointArray& points, float* values,
+                       ZInterpolationType::InterpolationType type, bool useOpenMP ) const
+{
+	const int n = points.length();
+	if( !n ) { return true; }
+
+	if( ( _iMax < 1 ) || ( _jMax < 1 ) || ( _kMax < 1 ) || !data )
+	{
+		cout << "Error@ZField3DBase::_sample(): Too small field." << endl;
+		return false;
+	}
+
+	const ZFieldLattice3D L( *this );
+
+	// The points (e.g. particles mixed up after many steps) are sorted by bins when the field is too large for the cache,
+	// so the nearby points are sampled one after another. (The values are written back in the original order.)
+	const double fieldBytes = (double)_numElements * numComponents * sizeof(float);
+	const bool   doSort     = ( n >= 65536 ) && ( fieldBytes > 16.0*1024*1024 );
+
+	ZIntArray   order;
+	ZPointArray sorted;
+	if( doSort ) { SortByBins( L, points.pointer(), n, order, sorted, useOpenMP ); }
+
+	const ZPoint* p = doSort ? sorted.pointer() : points.pointer();
+	const int*    o = doSort ? order.pointer()  : (const int*)NULL;
+
+	if( numComponents == 3 ) { SampleBlocks<3>( data, L, p, o, n, values, type, useOpenMP ); }
+	else                     { SampleBlocks<1>( data, L, p, o, n, values, type, useOpenMP ); }
+
+	return true;
+}
+
 ostream& operator<<( ostream& os, const ZField3DBase& object )
 {
 	os << "<ZField3DBase>" << endl;
@@ -80,7 +80,7 @@ Gradient( ZVectorField3D& v, const ZScalarField3D& s, bool useOpenMP )
 bool
 Divergence( ZScalarField3D& s, const ZVectorField3D& v, bool useOpenMP )
 {
-	if( !s.directComputable(v) )
+	if( !s.directComputableWithoutLocation(v) ) // (The locations are checked below.)
 	{
 		cout << "Error@Divergence(): Not direct computable." << endl;
 		return false;
@@ -120,5 +120,231 @@ Divergence( ZScalarField3D& s, const ZVectorField3D& v, bool useOpenMP )
 	return true;
 }
 
+bool
+ZAdvect( ZScalarField3D& s, const ZVectorField3D& vel, float dt, bool useOpenMP )
+{
+	ZAdvector3D advector;
+	return advector.advect( s, vel, dt, useOpenMP );
+}
+
+bool
+ZAdvect( ZVectorField3D& v, const ZVectorField3D& vel, float dt, bool useOpenMP )
+{
+	ZAdvector3D advector;
+	return advector.advect( v, vel, dt, useOpenMP );
+}
+
+// It activates the tiles of "out" whose flags are set in the tile order, so that the slots are deterministic.
+template <class T>
+static void
+ActivateFlaggedTiles( ZSparseField3D<T>& out, const std::vector<char>& flags )
+{
+	FOR( tk, 0, out.tnz() )
+	FOR( tj, 0, out.tny() )
+	FOR( ti, 0, out.tnx() )
+	{
+		if( flags[ out.tileIndex( ti, tj, tk ) ] ) { out.activateTile( ti, tj, tk ); }
+	}
+}
+
+bool
+Gradient( ZSparseVectorField3D& v, const ZSparseScalarField3D& s, bool useOpenMP )
+{
+	if( s.location() == ZFieldLocation::zNone )
+	{
+		cout << "Error@Gradient(): Invalid location." << endl;
+		return false;
+	}
+
+	v.set( s, s.location(), ZVector(0.f) );
+
+	const int tnx = s.tnx();
+	const int tny = s.tny();
+	const int tnz = s.tnz();
+
+	// The gradient of a tile is zero when the tile and its face neighbors have the same constant value.
+	std::vector<char> flags( s.numTiles(), 0 );
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( jk, 0, tny*tnz )
+	{
+		const int tj = jk % tny;
+		const int tk = jk / tny;
+
+		FOR( ti, 0, tnx )
+		{
+			if( s.tileSlot(ti,tj,tk) >= 0 ) { flags[ s.tileIndex(ti,tj,tk) ] = 1; continue; }
+
+			const float c = s.tileValue( ti, tj, tk );
+
+			const int nbr[6][3] = { {ti-1,tj,tk}, {ti+1,tj,tk}, {ti,tj-1,tk}, {ti,tj+1,tk}, {ti,tj,tk-1}, {ti,tj,tk+1} };
+
+			FOR( l, 0, 6 )
+			{
+				const int& ni = nbr[l][0];
+				const int& nj = nbr[l][1];
+				const int& nk = nbr[l][2];
+
+				if( ni<0 || ni>=tnx || nj<0 || nj>=tny || nk<0 || nk>=tnz ) { continue; }
+
+				if( s.tileSlot(ni,nj,nk) >= 0 || s.tileValue(ni,nj,nk) != c )
+				{
+					flags[ s.tileIndex(ti,tj,tk) ] = 1;
+					break;
+				}
+			}
+		}
+	}
+
+	ActivateFlaggedTiles( v, flags );
+
+	const int iMax = v.iMax();
+	const int jMax = v.jMax();
+	const int kMax = v.kMax();
+
+	const float _dx = 1/v.dx();
+	const float _dy = 1/v.dy();
+	const float _dz = 1/v.dz();
+
+	const float _dx2 = 0.5f*_dx;
+	const float _dy2 = 0.5f*_dy;
+	const float _dz2 = 0.5f*_dz;
+
+	const int numActive = v.numActiveTiles();
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( slot, 0, numActive )
+	{
+		ZVector* d = v.tileData( slot );
+
+		PER_EACH_ACTIVE_ELEMENT_3D( v, slot )
+
+			// the same one-sided differences at the borders as the dense version
+			float _Dx=0; int i0=i, i1=i;
+			if( iMax > 0 )
+			{
+				if( i==0 )         { _Dx=_dx;  i1=i+1;         }
+				else if( i==iMax ) { _Dx=_dx;  i0=i-1;         }
+				else               { _Dx=_dx2; i0=i-1; i1=i+1; }
+			}
+
+			float _Dy=0; int j0=j, j1=j;
+			if( jMax > 0 )
+			{
+				if( j==0 )         { _Dy=_dy;  j1=j+1;         }
+				else if( j==jMax ) { _Dy=_dy;  j0=j-1;         }
+				else               { _Dy=_dy2; j0=j-1; j1=j+1; }
+			}
+
+			float _Dz=0; int k0=k, k1=k;
+			if( kMax > 0 )
+			{
+				if( k==0 )         { _Dz=_dz;  k1=k+1;         }
+				else if( k==kMax ) { _Dz=_dz;  k0=k-1;         }
+				else               { _Dz=_dz2; k0=k-1; k1=k+1; }
+			}
+
+			ZVector& vv = d[ ZSparseField3DBase::localIndex(i,j,k) ];
+			{
+				vv.x = ( s.value(i1,j,k) - s.value(i0,j,k) ) * _Dx;
+				vv.y = ( s.value(i,j1,k) - s.value(i,j0,k) ) * _Dy;
+				vv.z = ( s.value(i,j,k1) - s.value(i,j,k0) ) * _Dz;
+			}
+
+		END_PER_EACH_ACTIVE_ELEMENT_3D
+	}
+
+	v.prune( 0.f, useOpenMP );
+
+	return true;
+}
+
+bool
+Divergence( ZSparseScalarField3D& s, const ZSparseVectorField3D& v, bool useOpenMP )
+{
+	if( (ZGrid3D&)s != (const ZGrid3D&)v ) // (The locations are checked below.)
+	{
+		cout << "Error@Divergence(): Not direct computable." << endl;
+		return false;
+	}
+
+	if( s.location()!=ZFieldLocation::zCell || v.location()!=ZFieldLocation::zNode )
+	{
+		cout << "Error@Divergence(): Invalid location." << endl;
+		return false;
+	}
+
+	const int tnx = s.tnx();
+	const int tny = s.tny();
+	const int tnz = s.tnz();
+
+	// The cells of the tile (ti,tj,tk) read the nodes of the tiles (ti~ti+1,tj~tj+1,tk~tk+1),
+	// and their divergence is zero when all of them have the same constant value.
+	std::vector<char> flags( s.numTiles(), 0 );
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( jk, 0, tny*tnz )
+	{
+		const int tj = jk % tny;
+		const int tk = jk / tny;
+
+		FOR( ti, 0, tnx )
+		{
+			const ZVector& c = v.tileValue( ti, tj, tk );
+
+			bool needed = false;
+
+			for( int nk=tk; nk<=tk+1 && !needed; ++nk )
+			for( int nj=tj; nj<=tj+1 && !needed; ++nj )
+			for( int ni=ti; ni<=ti+1 && !needed; ++ni )
+			{
+				if( ni>=v.tnx() || nj>=v.tny() || nk>=v.tnz() ) { continue; }
+
+				if( v.tileSlot(ni,nj,nk) >= 0 || v.tileValue(ni,nj,nk) != c ) { needed = true; }
+			}
+
+			if( needed ) { flags[ s.tileIndex(ti,tj,tk) ] = 1; }
+		}
+	}
+
+	ActivateFlaggedTiles( s, flags );
+
+	const float dxdy = s.dx() * s.dy();
+	const float dydz = s.dy() * s.dz();
+	const float dzdx = s.dz() * s.dx();
+
+	const int numActive = s.numActiveTiles();
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( slot, 0, numActive )
+	{
+		float* d = s.tileData( slot );
+
+		PER_EACH_ACTIVE_ELEMENT_3D( s, slot )
+
+			// the same node ordering as ZGrid3D::getNodesOfCell()
+			const ZVector n0 = v.value( i  , j  , k   );
+			const ZVector n1 = v.value( i+1, j  , k   );
+			const ZVector n2 = v.value( i+1, j  , k+1 );
+			const ZVector n3 = v.value( i  , j  , k+1 );
+			const ZVector n4 = v.value( i  , j+1, k   );
+			const ZVector n5 = v.value( i+1, j+1, k   );
+			const ZVector n6 = v.value( i+1, j+1, k+1 );
+			const ZVector n7 = v.value( i  , j+1, k+1 );
+
+			float& dvg = d[ ZSparseField3DBase::localIndex(i,j,k) ];
+
+			dvg += dydz * ( ( n1.x + n2.x + n5.x + n6.x ) - ( n0.x + n3.x + n4.x + n7.x ) );
+			dvg += dzdx * ( ( n4.y + n5.y + n6.y + n7.y ) - ( n0.y + n1.y + n2.y + n3.y ) );
+			dvg += dxdy * ( ( n2.z + n3.z + n6.z + n7.z ) - ( n0.z + n1.z + n4.z + n5.z ) );
+
+		END_PER_EACH_ACTIVE_ELEMENT_3D
+	}
+
+	s.prune( 0.f, useOpenMP );
+
+	return true;
+}
+
 ZELOS_NAMESPACE_END
 
@@ -0,0 +1,252 @@
+//-----------------//
+// ZImageCache.cpp //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.30                               //
+//-------------------------------------------------------//
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+ZImageCache::ZImageCache( double memoryBudgetInMegabytes )
+: _budget( memoryBudgetInMegabytes*ZPow2(1024.0) ), _usedBytes(0.0), _numHits(0), _numMisses(0), _nextId(0)
+{}
+
+ZImageCache&
+ZImageCache::global()
+{
+	static ZImageCache cache; // (The initialization is thread-safe in C++11.)
+	return cache;
+}
+
+std::shared_ptr<const ZTiledImage>
+ZImageCache::get( const char* filePathName )
+{
+	ZPROFILE_SCOPE( "ZImageCache::get" );
+
+	struct stat st;
+
+	if( !filePathName || stat( filePathName, &st ) )
+	{
+		// Don't print error message! (the same as ZImageMap::load())
+		return Image();
+	}
+
+	const ZString key( filePathName );
+
+	std::promise<Image>       promise;
+	std::shared_future<Image> future;
+	int64_t                   id = -1;	// >=0 when this thread decodes the image
+
+	{
+		std::lock_guard<std::mutex> lock( _mutex );
+
+		std::map<ZString,Entry>::iterator itr = _entries.find( key );
+
+		// the file was modified after being cached
+		if( ( itr != _entries.end() ) && ( ( itr->second.mtime != st.st_mtime ) || ( itr->second.fileSize != (int64_t)st.st_size ) ) )
+		{
+			_usedBytes -= itr->second.bytes;
+			_lru.erase( itr->second.lru );
+			_entries.erase( itr );
+
+			itr = _entries.end();
+		}
+
+		if( itr != _entries.end() ) {
+
+			++_numHits;
+
+			_lru.splice( _lru.begin(), _lru, itr->second.lru );
+			future = itr->second.image;
+
+		} else {
+
+			++_numMisses;
+
+			id     = _nextId++;
+			future = promise.get_future().share();
+
+			_lru.push_front( key );
+
+			Entry& e = _entries[key];
+			e.image    = future;
+			e.id       = id;
+			e.mtime    = st.st_mtime;
+			e.fileSize = (int64_t)st.st_size;
+			e.bytes    = 0.0;
+			e.lru      = _lru.begin();
+
+		}
+	}
+
+	if( id < 0 ) { return future.get(); }
+
+	// decoding without locking the others out
+	// (An exception must not skip set_value(): the waiting threads would get a broken promise instead of a failure.)
+	Image image;
+	try
+	{
+		ZImageMap img;
+
+		if( img.load( filePathName ) )
+		{
+			std::shared_ptr<ZTiledImage> tiled( new ZTiledImage( img ) );
+			if( !tiled->empty() ) { image = tiled; }
+		}
+	}
+	catch( ... )
+	{
+		cout << "Error@ZImageCache::get(): Failed to load file: " << filePathName << endl;
+		image.reset();
+	}
+
+	promise.set_value( image );
+
+	{
+		std::lock_guard<std::mutex> lock( _mutex );
+
+		std::map<ZString,Entry>::iterator itr = _entries.find( key );
+
+		// (It may have been erased or replaced in the meantime.)
+		if( ( itr != _entries.end() ) && ( itr->second.id == id ) )
+		{
+			if( image ) {
+
+				itr->second.bytes = image->usedMemorySize();
+				_usedBytes += itr->second.bytes;
+
+				_evict();
+
+			} else {
+
+				// Failures are not cached, so a fixed file can be loaded next time.
+				_lru.erase( itr->second.lru );
+				_entries.erase( itr );
+
+			}
+		}
+	}
+
+	return image;
+}
+
+void
+ZImageCache::_evict()
+{
+	// from the least recently used one except the most recent one
+	std::list<ZString>::iterator itr = _lru.end();
+
+	while( ( _usedBytes > _budget ) && ( itr != _lru.begin() ) )
+	{
+		--itr;
+		if( itr == _lru.begin() ) { break; }
+
+		std::map<ZString,Entry>::iterator e = _entries.find( *itr );
+		if( e->second.bytes <= 0.0 ) { continue; } // being decoded
+
+		_usedBytes -= e->second.bytes;
+		_entries.erase( e );
+
+		itr = _lru.erase( itr );
+	}
+}
+
+void
+ZImageCache::setMemoryBudget( double memoryBudgetInMegabytes )
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+
+	_budget = memoryBudgetInMegabytes * ZPow2(1024.0);
+
+	_evict();
+}
+
+double
+ZImageCache::memoryBudget() const
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	return ( _budget / ZPow2(1024.0) );
+}
+
+void
+ZImageCache::erase( const char* filePathName )
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+
+	std::map<ZString,Entry>::iterator itr = _entries.find( ZString( filePathName ) );
+	if( itr == _entries.end() ) { return; }
+
+	_usedBytes -= itr->second.bytes;
+	_lru.erase( itr->second.lru );
+	_entries.erase( itr );
+}
+
+void
+ZImageCache::clear()
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+
+	_entries.clear();
+	_lru.clear();
+
+	_usedBytes = 0.0;
+	_numHits   = 0;
+	_numMisses = 0;
+}
+
+int
+ZImageCache::numImages() const
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	return (int)_entries.size();
+}
+
+int
+ZImageCache::numHits() const
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	return _numHits;
+}
+
+int
+ZImageCache::numMisses() const
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	return _numMisses;
+}
+
+double
+ZImageCache::usedMemorySize( ZDataUnit::DataUnit dataUnit ) const
+{
+	double bytes = 0.0;
+	{
+		std::lock_guard<std::mutex> lock( _mutex );
+		bytes = _usedBytes;
+	}
+
+	switch( dataUnit )
+	{
+		case ZDataUnit::zBytes:     { return bytes; }
+		case ZDataUnit::zKilobytes: { return (bytes/1024.0); }
+		case ZDataUnit::zMegabytes: { return (bytes/ZPow2(1024.0)); }
+		case ZDataUnit::zGigabytes: { return (bytes/ZPow3(1024.0)); }
+		default: { cout << "Error@ZImageCache::usedMemorySize(): Invalid data unit." << endl; return 0.0; }
+	}
+}
+
+ostream&
+operator<<( ostream& os, const ZImageCache& object )
+{
+	os << "<ZImageCache>" << endl;
+	os << " images      : " << object.numImages() << endl;
+	os << " hits        : " << object.numHits() << endl;
+	os << " misses      : " << object.numMisses() << endl;
+	os << " memory size : " << object.usedMemorySize(ZDataUnit::zMegabytes) << " / " << object.memoryBudget() << " mb." << endl;
+	os << endl;
+	return os;
+}
+
+ZELOS_NAMESPACE_END
+
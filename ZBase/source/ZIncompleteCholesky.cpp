@@ -0,0 +1,254 @@
+//-------------------------//
+// ZIncompleteCholesky.cpp //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.27                               //
+//-------------------------------------------------------//
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+ZIncompleteCholesky::ZIncompleteCholesky()
+{
+	ZIncompleteCholesky::reset();
+}
+
+void
+ZIncompleteCholesky::reset()
+{
+	_m = 0;
+
+	_lr.clear();   _lc.clear();   _lv.clear();
+	_ur.clear();   _uc.clear();   _uv.clear();
+
+	_precon.clear();
+
+	_levelStart.clear();
+	_levelRows.clear();
+
+	_q.clear();
+
+	_useOpenMP = true;
+}
+
+bool
+ZIncompleteCholesky::build( const ZSparseMatrix<float>& A, bool modified, float tau, float sigma, bool useOpenMP )
+{
+	ZPROFILE_SCOPE( "ZIncompleteCholesky::build" );
+
+	ZIncompleteCholesky::reset();
+
+	_useOpenMP = useOpenMP;
+
+	const int m = A.m();
+
+	if( ( m < 1 ) || ( A.n() != m ) )
+	{
+		cout << "Error@ZIncompleteCholesky::build(): Invalid dimension." << endl;
+		return false;
+	}
+
+	_m = m;
+
+	/////////////////////////////////////
+	// split A into L, diagonal, and U //
+
+	ZFloatArray diag( m );
+
+	_lr.setLength( m+1 );
+	_ur.setLength( m+1 );
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( i, 0, m )
+	{
+		FOR( e, A.r[i], A.r[i+1] )
+		{
+			const int& j = A.c[e];
+			if( ( j < 0 ) || ( j >= m ) || ( A.v[e] == 0.f ) ) { continue; }
+
+			if     ( j < i ) { ++_lr[i+1];      }
+			else if( j > i ) { ++_ur[i+1];      }
+			else             { diag[i] += A.v[e]; }
+		}
+	}
+
+	FOR( i, 0, m )
+	{
+		_lr[i+1] += _lr[i];
+		_ur[i+1] += _ur[i];
+	}
+
+	_lc.setLength( _lr[m], false );   _lv.setLength( _lr[m], false );
+	_uc.setLength( _ur[m], false );   _uv.setLength( _ur[m], false );
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( i, 0, m )
+	{
+		int l = _lr[i];
+		int u = _ur[i];
+
+		FOR( e, A.r[i], A.r[i+1] )
+		{
+			const int& j = A.c[e];
+			if( ( j < 0 ) || ( j >= m ) || ( A.v[e] == 0.f ) ) { continue; }
+
+			if     ( j < i ) { _lc[l] = j;   _lv[l++] = A.v[e]; }
+			else if( j > i ) { _uc[u] = j;   _uv[u++] = A.v[e]; }
+		}
+	}
+
+	////////////////////
+	// level schedule //
+
+	ZIntArray level( m );
+	int numLevels = 0;
+
+	FOR( i, 0, m )
+	{
+		int& lv = level[i];
+
+		FOR( e, _lr[i], _lr[i+1] )
+		{
+			lv = ZMax( lv, level[ _lc[e] ]+1 );
+		}
+
+		numLevels = ZMax( numLevels, lv+1 );
+	}
+
+	_levelStart.setLength( numLevels+1 );
+
+	FOR( i, 0, m ) { ++_levelStart[ level[i]+1 ]; }
+	FOR( l, 0, numLevels ) { _levelStart[l+1] += _levelStart[l]; }
+
+	_levelRows.setLength( m, false );
+	{
+		ZIntArray cursor( _levelStart );
+
+		FOR( i, 0, m )
+		{
+			_levelRows[ cursor[ level[i] ]++ ] = i;
+		}
+	}
+
+	///////////////////
+	// factorization //
+
+	// the sum of the off-diagonals in the upper part of each row for the dropped fill-ins of MIC(0)
+	ZFloatArray upperSum( m );
+
+	if( modified )
+	{
+		#pragma omp parallel for if( useOpenMP )
+		FOR( i, 0, m )
+		{
+			FOR( e, _ur[i], _ur[i+1] ) { upperSum[i] += _uv[e]; }
+		}
+	}
+
+	_precon.setLength( m );
+
+	FOR( l, 0, numLevels )
+	{
+		const int start = _levelStart[l];
+		const int end   = _levelStart[l+1];
+
+		#pragma omp parallel for if( useOpenMP && ( end-start > 256 ) )
+		FOR( s, start, end )
+		{
+			const int i = _levelRows[s];
+
+			if( diag[i] <= 0.f ) { _precon[i] = 0.f; continue; }
+
+			float e = diag[i];
+
+			FOR( p, _lr[i], _lr[i+1] )
+			{
+				const int&   k  = _lc[p];
+				const float& a  = _lv[p];
+				const float  pk = _precon[k];
+
+				e -= ZPow2( a * pk );
+
+				if( modified )
+				{
+					e -= tau * a * ( upperSum[k] - a ) * pk * pk;
+				}
+			}
+
+			if( e < sigma * diag[i] ) { e = diag[i]; }
+
+			_precon[i] = 1.f / sqrtf( e );
+		}
+	}
+
+	_q.setLength( m );
+
+	return true;
+}
+
+int
+ZIncompleteCholesky::numLevels() const
+{
+	return ZMax( _levelStart.length()-1, 0 );
+}
+
+void
+ZIncompleteCholesky::apply( const ZFloatArray& r, ZFloatArray& z )
+{
+	if( !_m ) { z = r; return; }
+
+	z.setLength( _m, false );
+
+	const int numLevels = ZIncompleteCholesky::numLevels();
+
+	// (E+L)E^{-1} q = r
+	FOR( l, 0, numLevels )
+	{
+		const int start = _levelStart[l];
+		const int end   = _levelStart[l+1];
+
+		#pragma omp parallel for if( _useOpenMP && ( end-start > 256 ) )
+		FOR( s, start, end )
+		{
+			const int i = _levelRows[s];
+
+			float t = r[i];
+
+			FOR( p, _lr[i], _lr[i+1] )
+			{
+				const int& k = _lc[p];
+				t -= _lv[p] * _precon[k] * _q[k];
+			}
+
+			_q[i] = t * _precon[i];
+		}
+	}
+
+	// E^{-1}(E+L)^T z = q
+	for( int l=numLevels-1; l>=0; --l )
+	{
+		const int start = _levelStart[l];
+		const int end   = _levelStart[l+1];
+
+		#pragma omp parallel for if( _useOpenMP && ( end-start > 256 ) )
+		FOR( s, start, end )
+		{
+			const int i = _levelRows[s];
+
+			const float pi = _precon[i];
+
+			float t = _q[i];
+
+			FOR( p, _ur[i], _ur[i+1] )
+			{
+				t -= _uv[p] * pi * z[ _uc[p] ];
+			}
+
+			z[i] = t * pi;
+		}
+	}
+}
+
+ZELOS_NAMESPACE_END
+
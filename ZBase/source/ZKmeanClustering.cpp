@@ -3,13 +3,92 @@
 //-------------------------------------------------------//
 // author: Wanho Choi @ Dexter Studios                   //
 //         Jinhyuk Bae @ Dexter Studios                  //
-// last update: 2015.10.07                               //
+// last update: 2019.03.30                               //
 //-------------------------------------------------------//
 
 #include <ZelosBase.h>
 
 ZELOS_NAMESPACE_BEGIN
 
+// the sum by the fixed size blocks (the same result for any number of threads)
+static double
+KmeansSum( const ZFloatArray& a, bool useOpenMP )
+{
+	const int N         = a.length();
+	const int blockSize = 65536;
+	const int numBlocks = ( N + blockSize-1 ) / blockSize;
+
+	ZDoubleArray partial( numBlocks );
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( b, 0, numBlocks )
+	{
+		const int end = ZMin( (b+1)*blockSize, N );
+
+		double sum = 0.0;
+		FOR( i, b*blockSize, end ) { sum += a[i]; }
+
+		partial[b] = sum;
+	}
+
+	double sum = 0.0;
+	FOR( b, 0, numBlocks ) { sum += partial[b]; }
+
+	return sum;
+}
+
+// the index of the random choice by the weights
+static int
+KmeansChoose( const ZFloatArray& weights, unsigned int seed )
+{
+	const int N = weights.length();
+
+	double total = 0.0;
+	FOR( i, 0, N ) { total += weights[i]; }
+
+	if( total <= 0.0 ) { return ZMin( (int)( ZRand(seed) * N ), N-1 ); }
+
+	const double target = ZRand(seed) * total;
+
+	double sum = 0.0;
+	FOR( i, 0, N )
+	{
+		sum += weights[i];
+		if( ( sum > target ) && ( weights[i] > 0.f ) ) { return i; }
+	}
+
+	for( int i=N-1; i>=0; --i ) { if( weights[i] > 0.f ) { return i; } }
+
+	return 0;
+}
+
+// the closest and the second closest centers (squared distances)
+static inline void
+KmeansClosestTwo( const ZPoint& p, const ZPointArray& centers, int& id, float& dist1, float& dist2 )
+{
+	const int K = centers.length();
+
+	id    = 0;
+	dist1 = dist2 = Z_LARGE;
+
+	FOR( k, 0, K )
+	{
+		const float d = p.squaredDistanceTo( centers[k] );
+
+		if( d < dist1 ) {
+
+			dist2 = dist1;
+			dist1 = d;
+			id    = k;
+
+		} else if( d < dist2 ) {
+
+			dist2 = d;
+
+		}
+	}
+}
+
 ZKmeanClustering::ZKmeanClustering()
 {
 	reset();
@@ -19,18 +98,18 @@ void
 ZKmeanClustering::reset()
 {
 	_points = (ZPoint*)NULL;
+	_numPtc = 0;
 
 	_clusterId.clear();
-	FOR( i, 0, _pointId.size() )
-	{
-		_pointId[i].clear();
-	}
+	_pointId.clear();
+	_covMatrix.clear();
 	_numPtcEachCluster.clear();
 	_centerPos.clear();
-	_centerPosNew.clear();
 
 	_tolerance = Z_LARGE;
 	_maxIter   = 0;
+	_numIter   = 0;
+	_seed      = 0;
 }
 
 void
@@ -40,20 +119,38 @@ ZKmeanClustering::setPointSet( ZPoint* posArray, int numPtc )
 	_numPtc = numPtc;
 }
 
-void 
+void
+ZKmeanClustering::setRandomSeed( unsigned int seed )
+{
+	_seed = seed;
+}
+
+int
+ZKmeanClustering::numClusters() const
+{
+	return _centerPos.length();
+}
+
+int
+ZKmeanClustering::numIterations() const
+{
+	return _numIter;
+}
+
+void
 ZKmeanClustering::getClusterNum( ZIntArray& numArray )
 {
 	numArray.resize( _numPtcEachCluster.length() );
 	numArray = _numPtcEachCluster;
 }
 
-void 
+void
 ZKmeanClustering::getClusterId( ZIntArray& idArray )
 {
 	idArray = _clusterId;
 }
 
-void 
+void
 ZKmeanClustering::getPointIndex( int k, ZIntArray& numArray )
 {
 	if( k < 0 || k >= _numPtcEachCluster.size() )
@@ -65,13 +162,13 @@ ZKmeanClustering::getPointIndex( int k, ZIntArray& numArray )
 	numArray = _pointId[k];
 }
 
-void 
+void
 ZKmeanClustering::getCenterPos( ZPointArray& centerPosArray )
 {
 	centerPosArray = _centerPos;
 }
 
-void 
+void
 ZKmeanClustering::getCenterPos( int k, ZPoint& centerPos )
 {
 	if( k < 0 || k >= _numPtcEachCluster.size() )
@@ -82,207 +179,455 @@ ZKmeanClustering::getCenterPos( int k, ZPoint& centerPos )
 	centerPos = _centerPos[k];
 }
 
-void 
+// the sum of the outer products of the deviations from the mean of the cluster (not divided by the count)
+void
 ZKmeanClustering::getCovMatrix( int k, ZMatrix& covMatrix )
 {
-	if( k < 0 || k >= _centerPos.size() )
+	if( k < 0 || k >= (int)_covMatrix.size() )
 	{
 		cout << "Error@ZKmeanClustering::getCovMatrix- Invalid index." << endl;
 		return;
 	}
 
-	const ZIntArray& idArray	= _pointId[k];
-	const int sizeOfKcluster	= _pointId[k].length();
-	const int numOfKcluster     = _numPtcEachCluster[k];
-	const ZPoint& centerPos 	= _centerPos[k];
+	covMatrix = _covMatrix[k];
+}
+
+void
+ZKmeanClustering::seed( int numK, ZPointArray& centers, bool useOpenMP ) const
+{
+	centers.clear();
+
+	const int N = _numPtc;
+	if( !_points || N<1 || numK<1 ) { return; }
+
+	const ZPoint* P = _points;
+
+	// 1. the candidates by k-means|| (Bahmani et al. 2012)
+	ZIntArray cand;
+	cand.push_back( ZMin( (int)( ZRand(_seed) * N ), N-1 ) );
+
+	ZFloatArray d2( N );		// the squared distance to the closest candidate
+	ZIntArray   nearest( N );	// the closest candidate
+	{
+		const ZPoint& c = P[cand[0]];
+
+		#pragma omp parallel for if( useOpenMP )
+		FOR( i, 0, N )
+		{
+			d2[i]      = P[i].squaredDistanceTo( c );
+			nearest[i] = 0;
+		}
+	}
+
+	const int    numRounds = 5;
+	const double l         = 2.0 * numK; // the oversampling factor
+
+	std::vector<char> picked( N );
+	ZPointArray       newPoints;
+	ZPointsDistTree   tree;
+
+	FOR( r, 0, numRounds )
+	{
+		const double phi = KmeansSum( d2, useOpenMP );
+		if( phi <= 0.0 ) { break; } // All the points are on the candidates.
+
+		const unsigned int roundSeed = _seed*2654435761u + (r+1)*0x9E3779B9u;
+
+		// each point is picked independently with the probability l*d2/phi.
+		#pragma omp parallel for if( useOpenMP )
+		FOR( i, 0, N )
+		{
+			picked[i] = ( ZRand( roundSeed + i ) < l * d2[i] / phi );
+		}
+
+		const int n0 = cand.length();
+		FOR( i, 0, N ) { if( picked[i] ) { cand.push_back( i ); } }
+
+		const int m = cand.length() - n0;
+		if( !m ) { continue; }
+
+		newPoints.setLength( m );
+		FOR( c, 0, m ) { newPoints[c] = P[ cand[n0+c] ]; }
+
+		tree.setPoints( newPoints );
+
+		#pragma omp parallel for if( useOpenMP )
+		FOR( i, 0, N )
+		{
+			int   id = -1;
+			float dd = Z_LARGE;
+			tree.findClosestPoint( P[i], id, dd );
+
+			if( ( id >= 0 ) && ( dd < d2[i] ) )
+			{
+				d2[i]      = dd;
+				nearest[i] = n0 + id;
+			}
+		}
+	}
+
+	const int C = cand.length();
 
-if( sizeOfKcluster != numOfKcluster ) 
-{ cout << "Error:: sizeOfKcluster, numOfKcluster=" << sizeOfKcluster << "," << numOfKcluster << endl; }
+	centers.reserve( numK );
 
-	// compute center
-	ZPoint center(0,0,0);
-	FOR( i, 0, sizeOfKcluster )
+	if( C <= numK )
 	{
-		center += _points[idArray[i]];
+		FOR( c, 0, C ) { centers.push_back( P[cand[c]] ); }
+
+		// not enough distinct points (only for the tiny sets)
+		FOR( k, C, numK ) { centers.push_back( P[ ZMin( (int)( ZRand(_seed+7u*k+3u) * N ), N-1 ) ] ); }
+
+		return;
 	}
-	center.x /= (float)sizeOfKcluster;
-	center.y /= (float)sizeOfKcluster;
-	center.z /= (float)sizeOfKcluster;
-
-	// compute the matrix elements
-	float xx = 0;
-	float yy = 0;
-	float zz = 0;
-	float xy = 0;
-	float xz = 0;
-	float yz = 0;
-	
-	FOR(  i, 0, sizeOfKcluster )
+
+	// 2. the weights of the candidates: the number of the points closest to each one
+	ZFloatArray w( C );
+	FOR( i, 0, N ) { w[ nearest[i] ] += 1.f; }
+
+	// 3. reducing the candidates to numK centers by the weighted k-means++
+	ZPointArray cp( C );
+	FOR( c, 0, C ) { cp[c] = P[cand[c]]; }
+
+	ZFloatArray cd2( C, Z_LARGE ), prob( C );
+
+	int next = KmeansChoose( w, _seed*7919u + 1u );
+
+	FOR( k, 0, numK )
 	{
-		const ZPoint& pt = _points[idArray[i]];
-		float xValue = pt.x - center.x;
-		float yValue = pt.y - center.y;
-		float zValue = pt.z - center.z;
-		xx += xValue*xValue;
-		yy += yValue*yValue;
-		zz += zValue*zValue;
-		xy += xValue*yValue;
-		xz += xValue*zValue;
-		yz += yValue*zValue;
+		const ZPoint c( cp[next] );
+		centers.push_back( c );
+
+		if( k == numK-1 ) { break; }
+
+		#pragma omp parallel for if( useOpenMP )
+		FOR( j, 0, C )
+		{
+			cd2[j]  = ZMin( cd2[j], cp[j].squaredDistanceTo( c ) );
+			prob[j] = w[j] * cd2[j];
+		}
+
+		next = KmeansChoose( prob, _seed*7919u + k + 2u );
 	}
+}
 
-	covMatrix.set( xx, xy, xz, 0,
-				   xy, yy, yz, 0,
-				   xz, yz, zz, 0,
-				   0, 0, 0,    1 );
+void
+ZKmeanClustering::_initCenters( int numK, const ZPointArray& initPos, bool useOpenMP )
+{
+	if( initPos.length() == numK ) {
+
+		_centerPos = initPos;
+
+	} else {
+
+		ZKmeanClustering::seed( numK, _centerPos, useOpenMP );
+
+	}
 }
 
 void
-ZKmeanClustering::run( int numK, float tol, int maxItr, const ZPointArray& initPos )
+ZKmeanClustering::run( int numK, float tol, int maxItr, const ZPointArray& initPos, bool useOpenMP )
 {
-	int numPtc = _numPtc; //_points->length();
+	ZPROFILE_SCOPE( "ZKmeanClustering::run" );
 
-	// initialize
+	const int N = _numPtc;
+
+	_tolerance = tol;
+	_maxIter   = maxItr;
+	_numIter   = 0;
+
+	if( !_points || N<1 || numK<1 )
+	{
+		cout << "Error@ZKmeanClustering::run(): Invalid input." << endl;
+		return;
+	}
+
+	ZKmeanClustering::_initCenters( numK, initPos, useOpenMP );
+
+	const ZPoint* P = _points;
+	ZPointArray&  C = _centerPos;
+
+	_clusterId.setLength( N, false );
+
+	// Hamerly's bounds (not squared)
+	ZFloatArray upper( N );	// of the distance to the assigned center
+	ZFloatArray lower( N );	// of the distance to the second closest center
+
+	ZIntArray from( N );	// the previous cluster of the reassigned points (-1: not reassigned)
+
+	// the first assignment
+	#pragma omp parallel for if( useOpenMP )
+	FOR( i, 0, N )
 	{
-		_clusterId.resize( numPtc, -1 );
-		_numPtcEachCluster.resize( numK, 0 );
-		_pointId.resize( numK );
+		float d1=0.f, d2=0.f;
+		KmeansClosestTwo( P[i], C, _clusterId[i], d1, d2 );
 
-		_centerPos.resize( numK );
-		_centerPosNew.resize( numK );
+		upper[i] = sqrtf( d1 );
+		lower[i] = sqrtf( d2 );
 	}
 
-	// initialize center pos 
+	// the sums of the positions of each cluster (updated only by the reassigned points afterwards)
+	ZDoubleArray sx( numK ), sy( numK ), sz( numK );
+	ZIntArray    count( numK );
+
+	FOR( i, 0, N )
 	{
-		if ( initPos.size() != numK )
-		{
-			FOR( k, 0, numK )
-			{
-				if(k%2 == 0)
-					_centerPos[k] = (_points)[k];
-				else 
-					_centerPos[k] = (_points)[numPtc-k-1];
-			}
-		}
-		else
-		{
-			_centerPos = initPos;
-		}
+		const int& k = _clusterId[i];
+
+		sx[k] += P[i].x;
+		sy[k] += P[i].y;
+		sz[k] += P[i].z;
+
+		++count[k];
 	}
 
-	bool loop = true;
-	int  cnt = 0;
-	while( loop )
+	ZFloatArray move( numK );	// how far each center moved
+	ZFloatArray half( numK );	// the half distance to the closest other center
+
+	for( _numIter=1; ; ++_numIter )
 	{
-		// initialize 
-		_clusterId.fill( -1 );
+		// the new centers
+		float maxMove2 = 0.f;
+
 		FOR( k, 0, numK )
 		{
-			_numPtcEachCluster[k] = 0;
+			if( !count[k] ) { move[k] = 0.f; continue; } // An empty cluster keeps its center.
+
+			const double denom = 1 / (double)count[k];
+			const ZPoint c( sx[k]*denom, sy[k]*denom, sz[k]*denom );
+
+			const float m2 = C[k].squaredDistanceTo( c );
+
+			move[k]  = sqrtf( m2 );
+			maxMove2 = ZMax( maxMove2, m2 );
+
+			C[k] = c;
 		}
 
-		//===========================
-		// searching nearest centerPos 
-		//
-		// set : _clusterId, _numPtcEachCluster
-		FOR( i, 0, numPtc )
+		if( ( maxMove2 < tol ) || ( _numIter > maxItr ) ) { break; }
+
+		// the largest two moves
+		int   kMax  = 0;
+		float move1 = 0.f, move2 = 0.f;
+
+		FOR( k, 0, numK )
 		{
-			const ZPoint& pPos = (_points)[i];
-			float minDistSQ = Z_LARGE;
+			if( move[k] > move1 ) {
 
-			FOR( k, 0, numK )
-			{
-				const ZPoint& cPos = _centerPos[k];
-				float distSQ = pPos.squaredDistanceTo( cPos );
-				if( distSQ < minDistSQ )
-				{
-					minDistSQ = distSQ;
-					_clusterId[i] = k;
-				}
-			}
+				move2 = move1;
+				move1 = move[k];
+				kMax  = k;
+
+			} else if( move[k] > move2 ) {
+
+				move2 = move[k];
 
-			FOR( k, 0, numK )
-			{
-				if( _clusterId[i] == k ) {
-					_numPtcEachCluster[k]++;
-					continue;
-				}
 			}
 		}
 
-		// set : _pointId at each cluster 
+		#pragma omp parallel for if( useOpenMP )
 		FOR( k, 0, numK )
 		{
-			_pointId[k].reset();
+			float d2 = Z_LARGE;
+			FOR( j, 0, numK ) { if( j != k ) { d2 = ZMin( d2, C[k].squaredDistanceTo( C[j] ) ); } }
+
+			half[k] = 0.5f * sqrtf( d2 );
 		}
 
-		// set : pointId at each cluster
-		FOR( i, 0, numPtc )
+		int numReassigned = 0;
+
+		#pragma omp parallel for reduction(+:numReassigned) if( useOpenMP )
+		FOR( i, 0, N )
 		{
-			FOR( k, 0, numK )
+			int& a = _clusterId[i];
+
+			from[i] = -1;
+
+			upper[i] += move[a];
+			lower[i] -= ( a == kMax ) ? move2 : move1;
+
+			const float bound = ZMax( half[a], lower[i] );
+			if( upper[i] <= bound ) { continue; }
+
+			// tightening the upper bound
+			upper[i] = sqrtf( P[i].squaredDistanceTo( C[a] ) );
+			if( upper[i] <= bound ) { continue; }
+
+			int   b  = a;
+			float d1 = 0.f, d2 = 0.f;
+			KmeansClosestTwo( P[i], C, b, d1, d2 );
+
+			upper[i] = sqrtf( d1 );
+			lower[i] = sqrtf( d2 );
+
+			if( b != a )
 			{
-				if( _clusterId[i] == k )
-				{
-					_pointId[k].push_back(i);
-					//continue;
-				}
+				from[i] = a;
+				a = b;
+				++numReassigned;
 			}
 		}
-		
-		//===========================
-		// compute center of cluster
-		//
-		FOR( k, 0, numK )
-		{
-			_centerPosNew[k] = ZPoint(0,0,0);
-		}
 
-		FOR( i, 0, numPtc )
+		if( !numReassigned ) { break; }
+
+		FOR( i, 0, N )
 		{
-			FOR( k, 0, numK )
-			{
-				if( _clusterId[i] == k )
-				{
-					_centerPosNew[k] += (_points)[i];
-					continue;
-				}
-			}			
+			const int& k0 = from[i];
+			if( k0 < 0 ) { continue; }
+
+			const int&    k1 = _clusterId[i];
+			const ZPoint& p  = P[i];
+
+			sx[k0] -= p.x;   sy[k0] -= p.y;   sz[k0] -= p.z;   --count[k0];
+			sx[k1] += p.x;   sy[k1] += p.y;   sz[k1] += p.z;   ++count[k1];
 		}
+	}
 
-		FOR( k, 0, numK )
+	ZKmeanClustering::_finalize( useOpenMP );
+}
+
+void
+ZKmeanClustering::runMiniBatch( int numK, int batchSize, int maxItr, const ZPointArray& initPos, bool useOpenMP )
+{
+	ZPROFILE_SCOPE( "ZKmeanClustering::runMiniBatch" );
+
+	const int N = _numPtc;
+
+	_tolerance = 0.f;
+	_maxIter   = maxItr;
+	_numIter   = 0;
+
+	if( !_points || N<1 || numK<1 || batchSize<1 )
+	{
+		cout << "Error@ZKmeanClustering::runMiniBatch(): Invalid input." << endl;
+		return;
+	}
+
+	ZKmeanClustering::_initCenters( numK, initPos, useOpenMP );
+
+	const ZPoint* P = _points;
+	ZPointArray&  C = _centerPos;
+
+	ZIntArray numUpdates( numK );	// the per-center learning rate is 1/numUpdates.
+	ZIntArray sample( batchSize );
+	ZIntArray closest( batchSize );
+
+	ZPointsDistTree tree;
+
+	for( _numIter=0; _numIter<maxItr; ++_numIter )
+	{
+		const unsigned int batchSeed = ( _seed + 1 )*2654435761u + (unsigned int)_numIter*(unsigned int)batchSize;
+
+		tree.setPoints( C );
+
+		#pragma omp parallel for if( useOpenMP )
+		FOR( s, 0, batchSize )
 		{
-			_centerPosNew[k] /= _numPtcEachCluster[k];
+			sample[s] = ZMin( (int)( ZRand( batchSeed + s ) * N ), N-1 );
+
+			float dist2 = 0.f;
+			tree.findClosestPoint( P[sample[s]], closest[s], dist2 );
 		}
 
-		//===========================
-		// check for loop conditions
-		//
-		float maxTol = 0;
-		FOR( k, 0, numK )
+		// in the order of the batch
+		FOR( s, 0, batchSize )
 		{
-			float distSQ = _centerPos[k].squaredDistanceTo( _centerPosNew[k] );
-			if( maxTol < distSQ )
-				maxTol = distSQ;
+			const int& k = closest[s];
+
+			const float eta = 1 / (float)( ++numUpdates[k] );
+
+			C[k] += ( P[sample[s]] - C[k] ) * eta;
 		}
+	}
+
+	ZKmeanClustering::_assignAll( useOpenMP );
+	ZKmeanClustering::_finalize( useOpenMP );
+}
+
+void
+ZKmeanClustering::_assignAll( bool useOpenMP )
+{
+	const int N = _numPtc;
+
+	_clusterId.setLength( N, false );
 
-		_centerPos = _centerPosNew;
+	ZPointsDistTree tree( _centerPos );
 
-		if( cnt++ > maxItr ||  maxTol < tol )
-			loop = false;
+	#pragma omp parallel for if( useOpenMP )
+	FOR( i, 0, N )
+	{
+		float dist2 = 0.f;
+		tree.findClosestPoint( _points[i], _clusterId[i], dist2 );
 	}
+}
+
+// the point lists and the covariance matrices of the clusters
+void
+ZKmeanClustering::_finalize( bool useOpenMP )
+{
+	const int N = _numPtc;
+	const int K = _centerPos.length();
+
+	_numPtcEachCluster.setLength( K );
+	FOR( i, 0, N ) { ++_numPtcEachCluster[ _clusterId[i] ]; }
+
+	_pointId.resize( K );
+	FOR( k, 0, K ) { _pointId[k].setLength( _numPtcEachCluster[k], false ); }
 
-	// error checking
-	FOR( k, 0, numK )
 	{
-		if ( _pointId[k].length() != _numPtcEachCluster[k] )
-		{ 
-			cout << "Error::ZKmeanClustering::run()" << endl;
-			cout << "K, _pointId[k].length(), _numPtcEachCluster[k]=" << k << ", " 
-																	  << _pointId[k].length() << "," 
-																	  << _numPtcEachCluster[k] << endl; 
+		ZIntArray n( K );
+		FOR( i, 0, N ) { const int& k = _clusterId[i]; _pointId[k][ n[k]++ ] = i; }
+	}
+
+	_covMatrix.resize( K );
+
+	#pragma omp parallel for schedule(dynamic,16) if( useOpenMP )
+	FOR( k, 0, K )
+	{
+		const ZIntArray& ids = _pointId[k];
+		const int        n   = ids.length();
+
+		if( !n ) { _covMatrix[k].set( 0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,1 ); continue; }
+
+		double cx=0, cy=0, cz=0;
+
+		FOR( i, 0, n )
+		{
+			const ZPoint& p = _points[ ids[i] ];
+			cx += p.x;   cy += p.y;   cz += p.z;
 		}
+
+		cx /= n;   cy /= n;   cz /= n;
+
+		double xx=0, yy=0, zz=0, xy=0, xz=0, yz=0;
+
+		FOR( i, 0, n )
+		{
+			const ZPoint& p = _points[ ids[i] ];
+
+			const double x = p.x - cx;
+			const double y = p.y - cy;
+			const double z = p.z - cz;
+
+			xx += x*x;   yy += y*y;   zz += z*z;
+			xy += x*y;   xz += x*z;   yz += y*z;
+		}
+
+		_covMatrix[k].set( xx, xy, xz, 0,
+		                   xy, yy, yz, 0,
+		                   xz, yz, zz, 0,
+		                   0,  0,  0,  1 );
 	}
 }
 
+ostream&
+operator<<( ostream& os, const ZKmeanClustering& object )
+{
+	os << "<ZKmeanClustering>" << endl;
+	os << " # of clusters   : " << object.numClusters() << endl;
+	os << " # of iterations : " << object.numIterations() << endl;
+	os << endl;
+	return os;
+}
+
 ZELOS_NAMESPACE_END
 
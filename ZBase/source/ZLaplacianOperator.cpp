@@ -0,0 +1,204 @@
+//------------------------//
+// ZLaplacianOperator.cpp //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.29                               //
+//-------------------------------------------------------//
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+ZLaplacianOperator::ZLaplacianOperator()
+{
+	ZLaplacianOperator::reset();
+}
+
+void
+ZLaplacianOperator::reset()
+{
+	_nx = _ny = _nz = 0;
+	_scale = 1.f;
+
+	std::vector<unsigned char>().swap( _mask  );
+	std::vector<unsigned char>().swap( _count );
+}
+
+bool
+ZLaplacianOperator::set( const ZMarkerField3D& marker, float scale, bool useOpenMP )
+{
+	ZLaplacianOperator::reset();
+
+	if( marker.location() != ZFieldLocation::zCell )
+	{
+		cout << "Error@ZLaplacianOperator::set(): Not a cell-centered marker field." << endl;
+		return false;
+	}
+
+	const int nx = _nx = marker.iMax()+1;
+	const int ny = _ny = marker.jMax()+1;
+	const int nz = _nz = marker.kMax()+1;
+
+	_scale = scale;
+
+	const int nxy = nx * ny;
+	const int N   = nxy * nz;
+
+	_mask .resize( N );
+	_count.resize( N );
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( n, 0, N )
+	{
+		const int i = n % nx;
+		const int j = ( n / nx ) % ny;
+		const int k = n / nxy;
+
+		unsigned char mask  = 0;
+		unsigned char count = 0;
+
+		if( marker[n] == ZCellType::zFluid )
+		{
+			mask |= zFluidCell;
+
+			// the neighbors out of the domain are solid.
+			const int  neighbor[6] = { n-1, n+1, n-nx, n+nx, n-nxy, n+nxy };
+			const bool inside[6]   = { i>0, i<nx-1, j>0, j<ny-1, k>0, k<nz-1 };
+
+			FOR( q, 0, 6 )
+			{
+				if( !inside[q] ) { continue; }
+
+				const int& type = marker[ neighbor[q] ];
+
+				if( type != ZCellType::zSolid ) { ++count; }
+				if( type == ZCellType::zFluid ) { mask |= (unsigned char)( 1 << q ); }
+			}
+		}
+
+		_mask [n] = mask;
+		_count[n] = count;
+	}
+
+	return true;
+}
+
+int
+ZLaplacianOperator::numFluidCells() const
+{
+	const int N = (int)_mask.size();
+
+	int count = 0;
+
+	FOR( n, 0, N )
+	{
+		if( _mask[n] & zFluidCell ) { ++count; }
+	}
+
+	return count;
+}
+
+void
+ZLaplacianOperator::multiply( const ZFloatArray& x, ZFloatArray& y, bool useOpenMP ) const
+{
+	const int N = m();
+
+	if( x.length() != N )
+	{
+		cout << "Error@ZLaplacianOperator::multiply(): Invalid dimension." << endl;
+		return;
+	}
+
+	y.setLength( N, false );
+
+	#pragma omp parallel if( useOpenMP )
+	{
+		int i0, i1;
+		GetThreadRange( N, i0, i1 );
+
+		SpMVDotKernel( *this, &x[0], &y[0], i0, i1 );
+	}
+}
+
+void
+ZLaplacianOperator::getSparseMatrix( ZSparseMatrix<float>& A ) const
+{
+	const int nx=_nx, ny=_ny, nz=_nz, nxy=nx*ny, N=nxy*nz;
+
+	int nnz = 0;
+
+	FOR( n, 0, N )
+	{
+		const unsigned char& mask = _mask[n];
+		if( !( mask & zFluidCell ) ) { continue; }
+
+		++nnz;
+		FOR( q, 0, 6 ) { if( mask & (1<<q) ) { ++nnz; } }
+	}
+
+	A.set( N, N, nnz );
+
+	// the columns in ascending order: -z, -y, -x, center, +x, +y, +z
+	const int order [7] = { 4, 2, 0, -1, 1, 3, 5 };
+	const int offset[6] = { -1, 1, -nx, nx, -nxy, nxy };
+
+	int e = 0;
+
+	FOR( n, 0, N )
+	{
+		A.r[n] = e;
+
+		const unsigned char& mask = _mask[n];
+		if( !( mask & zFluidCell ) ) { continue; }
+
+		FOR( s, 0, 7 )
+		{
+			const int& q = order[s];
+
+			if( q < 0 )
+			{
+				A.c[e] = n;
+				A.v[e] = _scale * _count[n];
+				++e;
+			}
+			else if( mask & (1<<q) )
+			{
+				A.c[e] = n + offset[q];
+				A.v[e] = -_scale;
+				++e;
+			}
+		}
+	}
+
+	A.r[N] = e;
+}
+
+double
+ZLaplacianOperator::usedMemorySize( ZDataUnit::DataUnit dataUnit ) const
+{
+	const double bytes = (double)( _mask.size() + _count.size() ) * sizeof(unsigned char);
+
+	switch( dataUnit )
+	{
+		case ZDataUnit::zBytes:     { return bytes; }
+		case ZDataUnit::zKilobytes: { return (bytes/1024.0); }
+		case ZDataUnit::zMegabytes: { return (bytes/ZPow2(1024.0)); }
+		case ZDataUnit::zGigabytes: { return (bytes/ZPow3(1024.0)); }
+		default: { cout << "Error@ZLaplacianOperator::usedMemorySize(): Invalid data unit." << endl; return 0.0; }
+	}
+}
+
+ostream&
+operator<<( ostream& os, const ZLaplacianOperator& object )
+{
+	os << "<ZLaplacianOperator>" << endl;
+	os << " resolution  : " << object.nx() << " x " << object.ny() << " x " << object.nz() << endl;
+	os << " scale       : " << object.scale() << endl;
+	os << " fluid cells : " << object.numFluidCells() << endl;
+	os << " memory size : " << object.usedMemorySize(ZDataUnit::zMegabytes) << " mb." << endl;
+	os << endl;
+	return os;
+}
+
+ZELOS_NAMESPACE_END
+
@@ -3,7 +3,7 @@
 //-------------------------------------------------------//
 // author: Taeyong Kim @ nVidia                          //
 //         Wanho Choi @ Dexter Studios                   //
-// last update: 2018.03.08                               //
+// last update: 2019.03.30                               //
 //-------------------------------------------------------//
 
 #include <ZelosBase.h>
@@ -908,95 +908,140 @@ ZMesh::getTetrahedronIndices( ZInt4Array& tetConnections ) const
 	}
 }
 
+// It finds the clusters of the points closer than epsilon (with the transitive closure),
+// and rep[i] is the smallest index of the cluster of the i-th point.
+// The candidates come from the buckets of the bulk-built ZPointsHashGrid, and each point is united with the later ones around it
+// as they are found, so no neighbor list is kept and the result does not depend on the number of threads.
+static int
+FindWeldRepresentatives( const ZPointArray& points, float epsilon, ZIntArray& rep, bool useOpenMP )
+{
+	const int n = points.length();
+
+	rep.setLength( n, false );
+	if( !n ) { return 0; }
+
+	// the normalized coordinates: the cell size of the grid becomes 1 (= 2*epsilon, so a query visits 2x2x2 cells),
+	// but it is not smaller than 1e-7 of the extent to keep the cell indices in int.
+	const ZBoundingBox bBox = points.boundingBox( useOpenMP );
+
+	const float h    = ZMax( 2*epsilon, bBox.maxWidth()*1e-7f, 1e-30f );
+	const float invH = 1.f / h;
+
+	const ZPoint& minPt = bBox.minPoint();
+
+	ZPointArray q( n );
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( i, 0, n )
+	{
+		q[i] = ( points[i] - minPt ) * invH;
+	}
+
+	ZPointsHashGrid grid( n, 1.f );
+	grid.build( q, useOpenMP );
+
+	ZIntArray bucketStart, ids;
+	grid.releaseBuckets( bucketStart, ids ); // (grid.index() still gives the bucket of a cell)
+
+	// (the strict comparison misses the coincident points for epsilon=0)
+	const float r  = ZMax( epsilon*invH, 1e-6f );
+	const float r2 = ZPow2( r );
+
+	// A point at the same position as an earlier one has the same neighbors,
+	// so it is only united with that one and not searched again (e.g. a lot of the UVs at the origin).
+	std::vector<char> skip( n, 0 );
+
+	// union-find (the root is the smallest index)
+	FOR( i, 0, n ) { rep[i] = i; }
+
+	FOR( i, 0, n )
+	{
+		if( skip[i] ) { continue; }
+
+		const ZPoint& p = q[i];
+
+		const int i0=(int)(p.x-r), i1=(int)(p.x+r)+1;
+		const int j0=(int)(p.y-r), j1=(int)(p.y+r)+1;
+		const int k0=(int)(p.z-r), k1=(int)(p.z+r)+1;
+
+		for( int ci=i0; ci<i1; ++ci )
+		for( int cj=j0; cj<j1; ++cj )
+		for( int ck=k0; ck<k1; ++ck )
+		{{{
+			const int idx = grid.index( ci, cj, ck );
+
+			FOR( m, bucketStart[idx], bucketStart[idx+1] )
+			{
+				int b = ids[m];
+				if( b <= i || skip[b] ) { continue; }
+
+				const ZPoint& pb = q[b];
+				if( p.squaredDistanceTo( pb ) >= r2 ) { continue; }
+
+				if( ( pb.x == p.x ) && ( pb.y == p.y ) && ( pb.z == p.z ) ) { skip[b] = 1; }
+
+				int a = i;
+
+				while( rep[a] != a ) { a = rep[a] = rep[rep[a]]; }
+				while( rep[b] != b ) { b = rep[b] = rep[rep[b]]; }
+
+				if( a < b ) { rep[b] = a; }
+				else if( b < a ) { rep[a] = b; }
+			}
+		}}}
+	}
+
+	int numMerged = 0;
+
+	FOR( i, 0, n )
+	{
+		rep[i] = rep[ rep[i] ]; // the roots precede, so they are already final.
+		if( rep[i] != i ) { ++numMerged; }
+	}
+
+	return numMerged;
+}
+
+// It merges the vertices (and the UVs) closer than epsilon.
+// Each merged vertex keeps the position of the vertex with the smallest index in its cluster.
 void
-ZMesh::weld( float epsilon )
-{
-//	if( _points.empty() ) { return; }
-//
-//	const int nVerts = numVertices();
-//	const int nUVs   = numUVs();
-//	const int nElems = numElements();
-//
-//	///////////////////////
-//	// for vertex points //
-//
-//	ZIntArray closePts;
-//	ZIntArray tagPts( nVerts, -1 );
-//	ZBoundingBox bBox;
-//	bBox = _points.boundingBox();
-//	ZHashGrid3D hashGrdPts( bBox.diagonalLength()/powf(_points.length(),1/3.f) );
-//
-//	// mark close vertices for deletion
-//	FOR( i, 0, nVerts )
-//	{
-//		if( tagPts[i] >= 0 ) { continue; } // already marked for deletion
-//
-//		hashGrdPts.getCandidates( closePts, _points[i], epsilon );
-//
-//		const int n = closePts.length();
-//		FOR( j, 0, n )
-//       	{
-//			int toDel = closePts[j];
-//			if( toDel == i ) { continue; } // same vertex
-//			if( tagPts[toDel] >= 0 ) { continue; } // already marked
-//			tagPts[toDel] = i;
-//   	    }
-//    }
-//
-//	// update face vertex id for deleted vertices
-//	FOR( i, 0, nElems )
-//	{
-//		ZMeshElement& e = _elements[i];
-//
-//		const int n = e.count();
-//		FOR( j, 0, n )
-//		{
-//			int v = e[j];
-//			if( tagPts[v] < 0 ) { continue; } // not deleted
-//			e[j] = tagPts[v];
-//		}
-//	}
-//
-//	/////////////
-//	// for UVs //
-//
-//	ZIntArray closeUVs;
-//	ZIntArray tagUVs( nUVs, -1 );
-//	bBox = _uvs.boundingBox();
-//	ZHashGrid3D hashGrdUVs( 1/powf(_uvs.length(),1/3.f) );
-//
-//	// mark close UVs for deletion
-//	FOR( i, 0, nUVs )
-//	{
-//		if( tagUVs[i] >= 0 ) { continue; } // already marked for deletion
-//
-//		hashGrdUVs.getCandidates( closeUVs, _uvs[i], epsilon );
-//
-//		const int n = closeUVs.length();
-//		FOR( j, 0, n )
-//       	{
-//			int toDel = closeUVs[j];
-//			if( toDel == i ) { continue; } // same UV
-//			if( tagUVs[toDel] >= 0 ) { continue; } // already marked
-//			tagUVs[toDel] = i;
-//   	    }
-//    }
-//
-//	// update face UV id for deleted UVs
-//	FOR( i, 0, nElems )
-//	{
-//		ZMeshElement& e = _elements[i];
-//
-//		const int n = e.count();
-//		FOR( j, 0, n )
-//		{
-//			int v = e(j);
-//			if( tagUVs[v] < 0 ) { continue; } // not deleted
-//			e(j) = tagUVs[v];
-//		}
-//	}
-//
-//	deleteUnusedPointsAndUVs();
+ZMesh::weld( float epsilon, bool useOpenMP )
+{
+	ZPROFILE_SCOPE( "ZMesh::weld" );
+
+	if( _points.empty() ) { return; }
+
+	const int nElems = numElements();
+
+	ZIntArray repPts, repUVs;
+
+	const int numMergedPts = FindWeldRepresentatives( _points, epsilon, repPts, useOpenMP );
+	const int numMergedUVs = FindWeldRepresentatives( _uvs,    epsilon, repUVs, useOpenMP );
+
+	if( !( numMergedPts + numMergedUVs ) ) { return; }
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( i, 0, nElems )
+	{
+		ZMeshElement& e = _elements[i];
+
+		const int n = e.count();
+
+		FOR( j, 0, n )
+		{
+			e[j] = repPts[ e[j] ];
+		}
+
+		if( numMergedUVs )
+		{
+			FOR( j, 0, n )
+			{
+				e(j) = repUVs[ e(j) ];
+			}
+		}
+	}
+
+	deleteUnusedPointsAndUVs();
 }
 
 void
@@ -0,0 +1,477 @@
+//----------------//
+// ZMultigrid.cpp //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.29                               //
+//-------------------------------------------------------//
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+ZMultigrid::ZMultigrid()
+{
+	ZMultigrid::reset();
+}
+
+void
+ZMultigrid::reset()
+{
+	_levels.clear();
+
+	_useOpenMP = true;
+
+	numSmoothings   = 2;
+	numCoarseSweeps = 32;
+	minCoarseSize   = 4;
+}
+
+bool
+ZMultigrid::build( const ZSparseMatrix<float>& A, int nx, int ny, int nz, bool useOpenMP )
+{
+	ZPROFILE_SCOPE( "ZMultigrid::build" );
+
+	_levels.clear();
+
+	_useOpenMP = useOpenMP;
+
+	if( ( nx < 1 ) || ( ny < 1 ) || ( nz < 1 ) || ( A.m() != nx*ny*nz ) || ( A.n() != A.m() ) )
+	{
+		cout << "Error@ZMultigrid::build(): Invalid dimension." << endl;
+		return false;
+	}
+
+	const int nxy = nx * ny;
+	const int m   = nxy * nz;
+
+	_levels.resize( 1 );
+
+	Level& L = _levels[0];
+	L.nx = nx;   L.ny = ny;   L.nz = nz;
+
+	L.d .setLength( m );
+	L.ax.setLength( m );
+	L.ay.setLength( m );
+	L.az.setLength( m );
+	L.r .setLength( m );
+
+	bool isStencil = true;
+
+	#pragma omp parallel for reduction(&&:isStencil) if( useOpenMP )
+	FOR( n, 0, m )
+	{
+		const int i = n % nx;
+		const int j = ( n / nx ) % ny;
+		const int k = n / nxy;
+
+		FOR( e, A.r[n], A.r[n+1] )
+		{
+			const int&   col = A.c[e];
+			const float& v   = A.v[e];
+
+			if( ( col < 0 ) || ( col >= m ) || ( v == 0.f ) ) { continue; }
+
+			const int offset = col - n;
+
+			if     ( offset == 0                  ) { L.d [n] += v; }
+			else if( offset ==  1   && i < nx-1   ) { L.ax[n]  = v; }
+			else if( offset == -1   && i > 0      ) {}
+			else if( offset ==  nx  && j < ny-1   ) { L.ay[n]  = v; }
+			else if( offset == -nx  && j > 0      ) {}
+			else if( offset ==  nxy && k < nz-1   ) { L.az[n]  = v; }
+			else if( offset == -nxy && k > 0      ) {}
+			else { isStencil = false; }
+		}
+	}
+
+	if( !isStencil )
+	{
+		cout << "Error@ZMultigrid::build(): Not a 7-point stencil matrix." << endl;
+		_levels.clear();
+		return false;
+	}
+
+	_coarsenAll();
+
+	return true;
+}
+
+bool
+ZMultigrid::build( const ZLaplacianOperator& A, bool useOpenMP )
+{
+	ZPROFILE_SCOPE( "ZMultigrid::build" );
+
+	_levels.clear();
+
+	_useOpenMP = useOpenMP;
+
+	const int nx=A.nx(), ny=A.ny(), nz=A.nz();
+
+	if( ( nx < 1 ) || ( ny < 1 ) || ( nz < 1 ) )
+	{
+		cout << "Error@ZMultigrid::build(): Invalid dimension." << endl;
+		return false;
+	}
+
+	const int m = nx * ny * nz;
+
+	_levels.resize( 1 );
+
+	Level& L = _levels[0];
+	L.nx = nx;   L.ny = ny;   L.nz = nz;
+
+	L.d .setLength( m );
+	L.ax.setLength( m );
+	L.ay.setLength( m );
+	L.az.setLength( m );
+	L.r .setLength( m );
+
+	const float s = -A.scale();
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( n, 0, m )
+	{
+		const unsigned char mask = A.mask(n);
+
+		L.d [n] = A.diagonal(n);
+		L.ax[n] = ( mask & ZLaplacianOperator::zFluidI1 ) ? s : 0.f;
+		L.ay[n] = ( mask & ZLaplacianOperator::zFluidJ1 ) ? s : 0.f;
+		L.az[n] = ( mask & ZLaplacianOperator::zFluidK1 ) ? s : 0.f;
+	}
+
+	_coarsenAll();
+
+	return true;
+}
+
+int
+ZMultigrid::numLevels() const
+{
+	return (int)_levels.size();
+}
+
+void
+ZMultigrid::apply( const ZFloatArray& r, ZFloatArray& z )
+{
+	ZPROFILE_SCOPE( "ZMultigrid::apply" );
+
+	if( _levels.empty() ) { z = r; return; }
+
+	z.setLength( r.length(), false );
+
+	_vCycle( 0, &z[0], &r[0], true );
+}
+
+void
+ZMultigrid::vCycle( ZFloatArray& x, const ZFloatArray& b )
+{
+	ZPROFILE_SCOPE( "ZMultigrid::vCycle" );
+
+	if( _levels.empty() ) { return; }
+
+	if( x.length() != b.length() ) { x.setLength( b.length() ); }
+
+	_vCycle( 0, &x[0], &b[0], false );
+}
+
+void
+ZMultigrid::_vCycle( int l, float* x, const float* b, bool fromZero )
+{
+	Level& L = _levels[l];
+
+	if( fromZero )
+	{
+		memset( (char*)x, 0, L.nx*L.ny*L.nz*sizeof(float) );
+	}
+
+	// coarsest level: symmetric red-black sweeps
+	if( l == (int)_levels.size()-1 )
+	{
+		FOR( s, 0, numCoarseSweeps ) { _smooth( l, x, b, 0 ); _smooth( l, x, b, 1 ); }
+		FOR( s, 0, numCoarseSweeps ) { _smooth( l, x, b, 1 ); _smooth( l, x, b, 0 ); }
+		return;
+	}
+
+	FOR( s, 0, numSmoothings ) { _smooth( l, x, b, 0 ); _smooth( l, x, b, 1 ); }
+
+	_residual( l, x, b, &L.r[0] );
+	_restrict( l, &L.r[0] );
+
+	Level& C = _levels[l+1];
+	_vCycle( l+1, &C.x[0], &C.b[0], true );
+
+	_prolongate( l, x );
+
+	FOR( s, 0, numSmoothings ) { _smooth( l, x, b, 1 ); _smooth( l, x, b, 0 ); }
+}
+
+// one Gauss-Seidel sweep over the cells of the given color ((i+j+k)%2)
+void
+ZMultigrid::_smooth( int l, float* x, const float* b, int color )
+{
+	const Level& L = _levels[l];
+
+	const int nx=L.nx, ny=L.ny, nz=L.nz, nxy=nx*ny;
+
+	const float* d  = &L.d [0];
+	const float* ax = &L.ax[0];
+	const float* ay = &L.ay[0];
+	const float* az = &L.az[0];
+
+	#pragma omp parallel for if( _useOpenMP && ( nxy*nz > 4096 ) )
+	FOR( jk, 0, ny*nz )
+	{
+		const int j = jk % ny;
+		const int k = jk / ny;
+
+		for( int i=(j+k+color)&1; i<nx; i+=2 )
+		{
+			const int n = i + nx*jk;
+
+			if( d[n] == 0.f ) { x[n] = 0.f; continue; }
+
+			float s = b[n];
+
+			if( i > 0    ) { s -= ax[n-1  ] * x[n-1  ]; }
+			if( i < nx-1 ) { s -= ax[n    ] * x[n+1  ]; }
+			if( j > 0    ) { s -= ay[n-nx ] * x[n-nx ]; }
+			if( j < ny-1 ) { s -= ay[n    ] * x[n+nx ]; }
+			if( k > 0    ) { s -= az[n-nxy] * x[n-nxy]; }
+			if( k < nz-1 ) { s -= az[n    ] * x[n+nxy]; }
+
+			x[n] = s / d[n];
+		}
+	}
+}
+
+void
+ZMultigrid::_residual( int l, const float* x, const float* b, float* r )
+{
+	const Level& L = _levels[l];
+
+	const int nx=L.nx, ny=L.ny, nz=L.nz, nxy=nx*ny;
+
+	const float* d  = &L.d [0];
+	const float* ax = &L.ax[0];
+	const float* ay = &L.ay[0];
+	const float* az = &L.az[0];
+
+	#pragma omp parallel for if( _useOpenMP && ( nxy*nz > 4096 ) )
+	FOR( jk, 0, ny*nz )
+	{
+		const int j = jk % ny;
+		const int k = jk / ny;
+
+		FOR( i, 0, nx )
+		{
+			const int n = i + nx*jk;
+
+			float s = b[n] - d[n] * x[n];
+
+			if( i > 0    ) { s -= ax[n-1  ] * x[n-1  ]; }
+			if( i < nx-1 ) { s -= ax[n    ] * x[n+1  ]; }
+			if( j > 0    ) { s -= ay[n-nx ] * x[n-nx ]; }
+			if( j < ny-1 ) { s -= ay[n    ] * x[n+nx ]; }
+			if( k > 0    ) { s -= az[n-nxy] * x[n-nxy]; }
+			if( k < nz-1 ) { s -= az[n    ] * x[n+nxy]; }
+
+			r[n] = ( d[n] == 0.f ) ? 0.f : s;
+		}
+	}
+}
+
+// the 1D weight of the cell-centered linear interpolation from the coarse cell I to the fine cell i
+// (3/4 from the parent, 1/4 from the nearest one of its neighbors, and 1 from the parent at the boundary)
+static inline float
+ProlongationWeight( int i, int I, int coarseN )
+{
+	const int parent   = i >> 1;
+	const int neighbor = ( i & 1 ) ? ( parent+1 ) : ( parent-1 );
+	const bool inside  = ( neighbor >= 0 ) && ( neighbor < coarseN );
+
+	if( I == parent   ) { return ( inside ? 0.75f : 1.f ); }
+	if( I == neighbor ) { return ( inside ? 0.25f : 0.f ); }
+
+	return 0.f;
+}
+
+// P^T: the transpose of the trilinear prolongation
+void
+ZMultigrid::_restrict( int l, const float* r )
+{
+	const Level& F = _levels[l];
+	Level&       C = _levels[l+1];
+
+	const int nx=F.nx, ny=F.ny, nz=F.nz;
+
+	#pragma omp parallel for if( _useOpenMP && ( C.nx*C.ny*C.nz > 4096 ) )
+	FOR( JK, 0, C.ny*C.nz )
+	{
+		const int J = JK % C.ny;
+		const int K = JK / C.ny;
+
+		FOR( I, 0, C.nx )
+		{
+			float sum = 0.f;
+
+			for( int k=ZMax(2*K-1,0); k<ZMin(2*K+3,nz); ++k )
+			{
+				const float wz = ProlongationWeight( k, K, C.nz );
+				if( wz == 0.f ) { continue; }
+
+				for( int j=ZMax(2*J-1,0); j<ZMin(2*J+3,ny); ++j )
+				{
+					const float wyz = wz * ProlongationWeight( j, J, C.ny );
+					if( wyz == 0.f ) { continue; }
+
+					const float* rj = r + nx*(j+ny*k);
+
+					for( int i=ZMax(2*I-1,0); i<ZMin(2*I+3,nx); ++i )
+					{
+						sum += wyz * ProlongationWeight( i, I, C.nx ) * rj[i];
+					}
+				}
+			}
+
+			C.b[ I + C.nx*JK ] = sum;
+		}
+	}
+}
+
+// P: x += the trilinear interpolation of the coarse correction
+void
+ZMultigrid::_prolongate( int l, float* x )
+{
+	const Level& F = _levels[l];
+	const Level& C = _levels[l+1];
+
+	const int nx=F.nx, ny=F.ny, nz=F.nz;
+
+	#pragma omp parallel for if( _useOpenMP && ( nx*ny*nz > 4096 ) )
+	FOR( jk, 0, ny*nz )
+	{
+		const int j = jk % ny;
+		const int k = jk / ny;
+
+		int   J[2], K[2];
+		float wy[2], wz[2];
+
+		J[0] = j>>1;   J[1] = ZClamp( (j&1) ? J[0]+1 : J[0]-1, 0, C.ny-1 );
+		K[0] = k>>1;   K[1] = ZClamp( (k&1) ? K[0]+1 : K[0]-1, 0, C.nz-1 );
+
+		wy[0] = ProlongationWeight( j, J[0], C.ny );   wy[1] = ( J[1] == J[0] ) ? 0.f : ProlongationWeight( j, J[1], C.ny );
+		wz[0] = ProlongationWeight( k, K[0], C.nz );   wz[1] = ( K[1] == K[0] ) ? 0.f : ProlongationWeight( k, K[1], C.nz );
+
+		FOR( i, 0, nx )
+		{
+			const int n = i + nx*jk;
+			if( F.d[n] == 0.f ) { continue; }
+
+			const int I0 = i>>1;
+			const int I1 = ZClamp( (i&1) ? I0+1 : I0-1, 0, C.nx-1 );
+
+			const float wx0 = ProlongationWeight( i, I0, C.nx );
+			const float wx1 = ( I1 == I0 ) ? 0.f : ProlongationWeight( i, I1, C.nx );
+
+			float sum = 0.f;
+
+			FOR( b, 0, 2 )
+			FOR( a, 0, 2 )
+			{{
+				const float* xc = &C.x[ C.nx*( J[a] + C.ny*K[b] ) ];
+				sum += wz[b] * wy[a] * ( wx0 * xc[I0] + wx1 * xc[I1] );
+			}}
+
+			x[n] += sum;
+		}
+	}
+}
+
+// The Dirichlet part of the coarse diagonal is scaled by 0.6 instead of 1/2.
+// 1/2 is exact for the boundaries on the cell faces, but it moves the ones at the ghost cell centers
+// (like the air cells of the fluid solvers) outward level by level, and the V-cycle diverges at the fine resolutions.
+static const float DirichletScale = 0.6f;
+
+// It adds the coarse levels until the coarsest one is small enough.
+void
+ZMultigrid::_coarsenAll()
+{
+	while( true )
+	{
+		const Level& F = _levels.back();
+		if( ZMax( F.nx, F.ny, F.nz ) <= ZMax( minCoarseSize, 1 ) ) { break; }
+
+		_coarsen( (int)_levels.size()-1 );
+	}
+}
+
+// the Galerkin product (P^T*A*P)/2 for the 2x2x2 aggregates (except for the DirichletScale above)
+void
+ZMultigrid::_coarsen( int l )
+{
+	_levels.resize( l+2 );
+
+	const Level& F = _levels[l];
+	Level&       C = _levels[l+1];
+
+	const int nx=F.nx, ny=F.ny, nz=F.nz;
+
+	C.nx = (nx+1)>>1;
+	C.ny = (ny+1)>>1;
+	C.nz = (nz+1)>>1;
+
+	const int m = C.nx * C.ny * C.nz;
+
+	C.d .setLength( m );
+	C.ax.setLength( m );
+	C.ay.setLength( m );
+	C.az.setLength( m );
+	C.x .setLength( m );
+	C.b .setLength( m );
+	C.r .setLength( m );
+
+	#pragma omp parallel for if( _useOpenMP && ( m > 4096 ) )
+	FOR( JK, 0, C.ny*C.nz )
+	{
+		const int J = JK % C.ny;
+		const int K = JK / C.ny;
+
+		FOR( I, 0, C.nx )
+		{
+			float d=0.f, ax=0.f, ay=0.f, az=0.f, excess=0.f;
+
+			for( int k=2*K; k<ZMin(2*K+2,nz); ++k )
+			for( int j=2*J; j<ZMin(2*J+2,ny); ++j )
+			for( int i=2*I; i<ZMin(2*I+2,nx); ++i )
+			{{{
+				const int n = i + nx*(j+ny*k);
+
+				if( F.d[n] == 0.f ) { continue; }
+
+				d += F.d[n];
+
+				// the part of the diagonal not balanced by the couplings (the Dirichlet boundaries)
+				excess += F.d[n] + F.ax[n] + F.ay[n] + F.az[n];
+				if( i > 0 ) { excess += F.ax[n-1];     }
+				if( j > 0 ) { excess += F.ay[n-nx];    }
+				if( k > 0 ) { excess += F.az[n-nx*ny]; }
+
+				// the couplings inside the aggregate go to the diagonal (twice by the symmetry),
+				// and the ones crossing the +x(y,z) face go to the coarse coupling.
+				if( i&1 ) { ax += F.ax[n]; } else { d += 2*F.ax[n]; }
+				if( j&1 ) { ay += F.ay[n]; } else { d += 2*F.ay[n]; }
+				if( k&1 ) { az += F.az[n]; } else { d += 2*F.az[n]; }
+			}}}
+
+			const int N = I + C.nx*JK;
+
+			C.d [N] = 0.5f * d + ( DirichletScale - 0.5f ) * excess;
+			C.ax[N] = 0.5f * ax;
+			C.ay[N] = 0.5f * ay;
+			C.az[N] = 0.5f * az;
+		}
+	}
+}
+
+ZELOS_NAMESPACE_END
+
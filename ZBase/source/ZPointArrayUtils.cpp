@@ -2,7 +2,7 @@
 // ZPointArrayUtils.cpp //
 //-------------------------------------------------------//
 // author: Wanho Choi @ Dexter Studios                   //
-// last update: 2018.03.08                               //
+// last update: 2019.03.30                               //
 //-------------------------------------------------------//
 
 #include <ZelosBase.h>
@@ -58,6 +58,7 @@ DoKMeansClustering( const ZPointArray& nPoints, const ZPointArray& kInitCentroid
 	if( K==1 )
 	{
 		ZIntArray indices( N );
+		FOR( i, 0, N ) { indices[i] = i; }
 		clusterIndices.push_back( indices );
 		return 0;
 	}
@@ -89,57 +90,16 @@ DoKMeansClustering( const ZPointArray& nPoints, const ZPointArray& kInitCentroid
 			kPtc[k].set( (wp.x-min.x)*_dx, (wp.y-min.y)*_dy, (wp.z-min.z)*_dz );
 		}
 	}
-	ZDoubleArray cx(K), cy(K), cz(K);
-	ZIntArray count(K);
 
-	ZIntArray closestCentroidId( N, -1 );
-	ZIntArray closestCentroidId0( N, -1 );
+	// Hamerly's bound pruning and the parallel assignment in ZKmeanClustering
+	ZKmeanClustering kmeans;
+	kmeans.setPointSet( (ZPoint*)nPtc.pointer(), N );
+	kmeans.run( K, tolerance, maxIterations, kPtc, useOpenMP );
 
-	ZPointsDistTree kdTree;
+	clusterIndices.resize( K );
+	FOR( k, 0, K ) { kmeans.getPointIndex( k, clusterIndices[k] ); }
 
-	int numIters = 1;
-	FOR( itr, 0, maxIterations )
-	{
-		kdTree.setPoints( kPtc );
-
-		#pragma omp parallel for if( useOpenMP )
-		FOR( i, 0, N )
-		{
-			int& centroidId = closestCentroidId[i];
-			float dist2 = 0.f;
-			kdTree.findClosestPoint( nPtc[i], centroidId, dist2 );
-		}
-
-		{
-			cx.zeroize();
-			cy.zeroize();
-			cz.zeroize();
-			count.zeroize();
-
-			FOR( i, 0, N )
-			{
-				const ZPoint& p = nPtc[i];
-				const int& k = closestCentroidId[i];
-				cx[k] += p.x;
-				cy[k] += p.y;
-				cz[k] += p.z;
-				++count[k];
-			}
-
-			FOR( k, 0, K )
-			{
-				ZPoint& p = kPtc[k];
-				const double denom = 1 / (double)count[k];
-				p.x = cx[k] * denom; 
-				p.y = cy[k] * denom; 
-				p.z = cz[k] * denom; 
-			}
-		}
-
-		++numIters;
-	}
-
-	return numIters;
+	return kmeans.numIterations();
 }
 
 ZELOS_NAMESPACE_END
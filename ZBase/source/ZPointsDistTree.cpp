@@ -2,7 +2,7 @@
 // ZPointsDistTree.cpp //
 //-------------------------------------------------------//
 // author: Wanho Choi @ Dexter Studios                   //
-// last update: 2017.11.01                               //
+// last update: 2019.03.30                               //
 //-------------------------------------------------------//
 
 #include <ZelosBase.h>
@@ -353,13 +353,19 @@ ZPointsDistTree::findClosestPoint( const ZPoint& p, int& closestPointId, float&
 		return;
 	}
 
-	ZIntArray result;
-	ZFloatArray dist2;
+	// without any heap allocation (It is called for every point in the parallel loops.)
+	int   id = -1;
+	float dist2 = Z_LARGE, radius = Z_LARGE;
 
-	ZPointsDistTree::findNPoints( p, 1, Z_LARGE, result, dist2 );
+	if( !_findNPoints( p, 1, Z_LARGE, &id, &dist2, radius ) )
+	{
+		closestPointId = -1;
+		closestDist2 = Z_LARGE;
+		return;
+	}
 
-	closestPointId = result[0];
-	closestDist2 = dist2[0];
+	closestPointId = _ids[id];
+	closestDist2 = dist2;
 }
 
 void
@@ -2,7 +2,7 @@
 // ZPointsHashGrid.cpp //
 //-------------------------------------------------------//
 // author: Wanho Choi @ Dexter Studios                   //
-// last update: 2017.12.19                               //
+// last update: 2019.03.22                               //
 //-------------------------------------------------------//
 
 #include <ZelosBase.h>
@@ -36,10 +36,23 @@ ZPointsHashGrid::ZPointsHashGrid( int numBuckets, float voxelSize )
 ZPointsHashGrid::~ZPointsHashGrid()
 {
 	reset();
+
+	delete[] _list;
 }
 
+// It keeps the number of buckets and the voxel size so that the grid can be filled again.
 void
 ZPointsHashGrid::reset()
+{
+	_clearList();
+
+	_bucketStart .clear();
+	_ids         .clear();
+	_positions   .clear();
+}
+
+void
+ZPointsHashGrid::_clearList()
 {
 	FOR( i, 0, _numBuckets )
 	{
@@ -51,10 +64,129 @@ ZPointsHashGrid::reset()
 			delete itr;
 			itr = next;
 		}
+
+		_list[i] = (ZPointsHashGrid::Item*)NULL;
+	}
+}
+
+void
+ZPointsHashGrid::build( const ZPointArray& points, bool useOpenMP )
+{
+	ZPROFILE_SCOPE( "ZPointsHashGrid::build" );
+
+	reset();
+
+	const int numPoints = points.length();
+	if( !numPoints ) { return; }
+
+	ZIntArray keys, tmpKeys, tmpIds;
+	keys    .setLength( numPoints, false );
+	tmpKeys .setLength( numPoints, false );
+	tmpIds  .setLength( numPoints, false );
+	_ids    .setLength( numPoints, false );
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( i, 0, numPoints )
+	{
+		keys[i] = _bucket( points[i] );
+		_ids[i] = i;
+	}
+
+	// stable LSD radix sort of the ids by the bucket index
+	// Each chunk has its own histogram, so no atomic operation is needed, and the result does not depend on the # of chunks.
+	const int radixBits = 11;
+	const int radix     = 1 << radixBits;
+
+	int numBits = 1;
+	while( numBits < 31 && (1<<numBits) < _numBuckets ) { ++numBits; }
+
+	const int numChunks = useOpenMP ? ZMin( omp_get_max_threads(), (numPoints+radix-1)/radix ) : 1;
+	const int chunkSize = ( numPoints + numChunks-1 ) / numChunks;
+
+	ZIntArray hist( numChunks*radix );
+
+	for( int shift=0; shift<numBits; shift+=radixBits )
+	{
+		hist.zeroize();
+
+		#pragma omp parallel for if( useOpenMP )
+		FOR( c, 0, numChunks )
+		{
+			int* h = &hist[c*radix];
+
+			const int end = ZMin( (c+1)*chunkSize, numPoints );
+
+			for( int i=c*chunkSize; i<end; ++i )
+			{
+				++h[ (keys[i]>>shift) & (radix-1) ];
+			}
+		}
+
+		// exclusive prefix sum in the (digit, chunk) order
+		int sum = 0;
+		FOR( d, 0, radix )
+		FOR( c, 0, numChunks )
+		{{
+			int& h = hist[c*radix+d];
+			const int count = h;
+			h = sum;
+			sum += count;
+		}}
+
+		#pragma omp parallel for if( useOpenMP )
+		FOR( c, 0, numChunks )
+		{
+			int* h = &hist[c*radix];
+
+			const int end = ZMin( (c+1)*chunkSize, numPoints );
+
+			for( int i=c*chunkSize; i<end; ++i )
+			{
+				const int slot = h[ (keys[i]>>shift) & (radix-1) ]++;
+
+				tmpKeys[slot] = keys[i];
+				tmpIds[slot]  = _ids[i];
+			}
+		}
+
+		keys.swap( tmpKeys );
+		_ids.swap( tmpIds );
+	}
+
+	// bucket ranges: the buckets in (keys[i-1],keys[i]] start at i.
+	_bucketStart.setLength( _numBuckets+1, false );
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( i, 0, numPoints+1 )
+	{
+		const int prev = i ? keys[i-1] : -1;
+		const int curr = ( i < numPoints ) ? keys[i] : _numBuckets;
+
+		for( int b=prev+1; b<=curr; ++b )
+		{
+			_bucketStart[b] = i;
+		}
 	}
 
-	_numBuckets = 0;
-	_h = 0;
+	_positions.setLength( numPoints, false );
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( i, 0, numPoints )
+	{
+		_positions[i] = points[ _ids[i] ];
+	}
+}
+
+void
+ZPointsHashGrid::releaseBuckets( ZIntArray& bucketStart, ZIntArray& ids )
+{
+	bucketStart.clear();
+	ids.clear();
+
+	bucketStart.exchange( _bucketStart );
+	ids.exchange( _ids );
+
+	_positions.clear();
 }
 
 float
@@ -70,6 +202,8 @@ ZPointsHashGrid::numItems( int i ) const
 
 	int count = 0;
 
+	if( _bucketStart.length() ) { count += _bucketStart[i+1] - _bucketStart[i]; }
+
 	ZPointsHashGrid::Item* itr = _list[i];
 	for( ; itr; itr=itr->next )
 	{
@@ -82,11 +216,15 @@ ZPointsHashGrid::numItems( int i ) const
 int
 ZPointsHashGrid::numTotalItems() const
 {
-	int count = 0;
+	int count = _ids.length();
 
 	FOR( i, 0, _numBuckets )
 	{
-		count += numItems( i );
+		ZPointsHashGrid::Item* itr = _list[i];
+		for( ; itr; itr=itr->next )
+		{
+			++count;
+		}
 	}
 
 	return count;
@@ -99,6 +237,8 @@ ZPointsHashGrid::findPoints( ZIntArray& neighbors, const ZPoint& p, float maxDis
 
 	const float maxDist2 = ZPow2( maxDist );
 
+	const bool built = ( _bucketStart.length() > 0 );
+
 	const int i0=(int)((p.x-maxDist)/_h), i1=(int)((p.x+maxDist)/_h)+1;
 	const int j0=(int)((p.y-maxDist)/_h), j1=(int)((p.y+maxDist)/_h)+1;
 	const int k0=(int)((p.z-maxDist)/_h), k1=(int)((p.z+maxDist)/_h)+1;
@@ -108,6 +248,20 @@ ZPointsHashGrid::findPoints( ZIntArray& neighbors, const ZPoint& p, float maxDis
 	for( int k=k0; k<k1; ++k )
 	{{{
 		const int idx = index( i, j, k );
+
+		if( built )
+		{
+			const int end = _bucketStart[idx+1];
+
+			for( int n=_bucketStart[idx]; n<end; ++n )
+			{
+				if( p.squaredDistanceTo( _positions[n] ) < maxDist2 )
+				{
+					neighbors.push_back( _ids[n] );
+				}
+			}
+		}
+
 		ZPointsHashGrid::Item* itr = _list[idx];
 		for( ; itr; itr=itr->next )
 		{
@@ -126,6 +280,57 @@ ZPointsHashGrid::findPoints( ZIntArray& neighbors, const ZPoint& p, float maxDis
 	return neighbors.length();
 }
 
+int
+ZPointsHashGrid::findPoints( ZIntArray& neighborStart, ZIntArray& neighbors, const ZPointArray& points, float maxDist, bool removeRedundancy, bool useOpenMP ) const
+{
+	const int numPoints = points.length();
+
+	neighborStart.setLength( numPoints+1 );
+	neighbors.clear();
+
+	if( !numPoints ) { return 0; }
+
+	// Each block of queries is gathered into its own buffer, and the buffers are concatenated in order.
+	const int blockSize = 256;
+	const int numBlocks = ( numPoints + blockSize-1 ) / blockSize;
+
+	std::vector<ZIntArray> blockNeighbors( numBlocks );
+
+	#pragma omp parallel for schedule(dynamic,1) if( useOpenMP )
+	FOR( b, 0, numBlocks )
+	{
+		ZIntArray& result = blockNeighbors[b];
+		ZIntArray  tmp;
+
+		const int start = b * blockSize;
+		const int end   = ZMin( start+blockSize, numPoints );
+
+		FOR( i, start, end )
+		{
+			neighborStart[i+1] = findPoints( tmp, points[i], maxDist, removeRedundancy, false );
+			result.append( tmp );
+		}
+	}
+
+	FOR( i, 0, numPoints )
+	{
+		neighborStart[i+1] += neighborStart[i];
+	}
+
+	neighbors.setLength( neighborStart[numPoints], false );
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( b, 0, numBlocks )
+	{
+		const ZIntArray& result = blockNeighbors[b];
+		if( result.empty() ) { continue; }
+
+		memcpy( (char*)&neighbors[ neighborStart[b*blockSize] ], (char*)&result[0], result.length()*sizeof(int) );
+	}
+
+	return neighbors.length();
+}
+
 ostream&
 operator<<( ostream& os, const ZPointsHashGrid& hash )
 {
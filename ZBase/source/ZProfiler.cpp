@@ -0,0 +1,477 @@
+//---------------//
+// ZProfiler.cpp //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.30                               //
+//-------------------------------------------------------//
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+struct ZProfiler::Thread
+{
+	struct Event
+	{
+		const char* name;
+		uint64_t    begin;
+		uint64_t    end;
+		int         depth;
+	};
+
+	enum { BlockSize = 4096 }; // events per block
+
+	std::vector<std::unique_ptr<Event[]> > blocks;
+	int64_t                               count;
+	int                                   depth;	// the number of the open scopes
+	int                                   index;	// the order of the registration
+
+	Thread( int i )
+	: count(0), depth(0), index(i)
+	{}
+
+	void push( const char* name, uint64_t begin, uint64_t end, int d )
+	{
+		const size_t b = (size_t)( count / BlockSize );
+		if( b == blocks.size() ) { blocks.emplace_back( new Event[BlockSize] ); }
+
+		Event& e = blocks[b][ count % BlockSize ];
+		e.name = name;  e.begin = begin;  e.end = end;  e.depth = d;
+
+		++count;
+	}
+
+	const Event& event( int64_t i ) const
+	{
+		return blocks[ (size_t)(i/BlockSize) ][ i % BlockSize ];
+	}
+};
+
+ZProfiler::ZProfiler()
+: _enabled(false), _generation(0)
+{
+	_startTicks = ZProfiler::ticks();
+	_startTime  = std::chrono::steady_clock::now();
+}
+
+ZProfiler&
+ZProfiler::global()
+{
+	static ZProfiler profiler; // (The initialization is thread-safe in C++11.)
+	return profiler;
+}
+
+void
+ZProfiler::enable( bool on )
+{
+	_enabled.store( on );
+}
+
+void
+ZProfiler::clear()
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+
+	_threads.clear();
+	_generation.fetch_add( 1 );
+
+	_startTicks = ZProfiler::ticks();
+	_startTime  = std::chrono::steady_clock::now();
+}
+
+int
+ZProfiler::numThreads() const
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	return (int)_threads.size();
+}
+
+int64_t
+ZProfiler::numEvents() const
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+
+	int64_t n = 0;
+	FOR( i, 0, _threads.size() ) { n += _threads[i]->count; }
+	return n;
+}
+
+ZProfiler::Thread*
+ZProfiler::_thread()
+{
+	// the buffer of the calling thread (registered once per clear())
+	static thread_local Thread*          thread     = nullptr;
+	static thread_local const ZProfiler* owner      = nullptr;
+	static thread_local int              generation = -1;
+
+	if( thread && ( owner == this ) && ( generation == _generation.load( std::memory_order_relaxed ) ) )
+	{
+		return thread;
+	}
+
+	std::lock_guard<std::mutex> lock( _mutex );
+
+	_threads.emplace_back( new Thread( (int)_threads.size() ) );
+
+	thread     = _threads.back().get();
+	owner      = this;
+	generation = _generation.load();
+
+	return thread;
+}
+
+uint64_t
+ZProfiler::_open()
+{
+	++_thread()->depth;
+	return ZProfiler::ticks();
+}
+
+void
+ZProfiler::_close( const char* name, uint64_t begin )
+{
+	const uint64_t end = ZProfiler::ticks();
+
+	Thread* t = _thread();
+
+	// (The depth is zero when the scope was opened before clear().)
+	t->depth = ZMax( t->depth-1, 0 );
+
+	t->push( name, begin, end, t->depth );
+}
+
+double
+ZProfiler::_millisecondsPerTick() const
+{
+	#ifdef ZPROFILER_TSC
+
+		// the TSC calibrated against the steady clock over the session
+		const uint64_t dTicks = ZProfiler::ticks() - _startTicks;
+		const double   dTime  = std::chrono::duration<double,std::milli>( std::chrono::steady_clock::now() - _startTime ).count();
+
+		return ( ( dTicks > 0 ) ? ( dTime / (double)dTicks ) : 1e-6 );
+
+	#else
+
+		return 1e-6; // nanoseconds
+
+	#endif
+}
+
+void
+ZProfiler::getStatistics( std::vector<ZProfileNode>& nodes ) const
+{
+	nodes.clear();
+
+	std::lock_guard<std::mutex> lock( _mutex );
+
+	const double msPerTick = _millisecondsPerTick();
+
+	// the nodes in the order of creation
+	struct Node
+	{
+		ZString          name;
+		int              parent;
+		int              depth;
+		int64_t          count;
+		int              numThreads;
+		int              lastThread;
+		uint64_t         total;
+		uint64_t         childTotal;
+		uint64_t         min, max;
+		std::vector<int> children;
+	};
+
+	std::vector<Node> tree;
+
+	std::map<std::pair<int,const char*>,int> byPointer; // the same name may have different pointers (ex: different translation units)
+	std::map<std::pair<int,std::string>,int> byName;
+	std::vector<int> roots;
+
+	std::vector<int64_t> order;
+	std::vector<int> stack;		// the node of each enclosing event
+	std::vector<int64_t> stackEvent;
+
+	FOR( t, 0, _threads.size() )
+	{
+		const Thread& thread = *_threads[t];
+
+		// by the begin time (the parents before their children)
+		order.resize( (size_t)thread.count );
+		for( int64_t i=0; i<thread.count; ++i ) { order[i] = i; }
+
+		std::sort( order.begin(), order.end(), [&]( int64_t a, int64_t b )
+		{
+			const Thread::Event& ea = thread.event(a);
+			const Thread::Event& eb = thread.event(b);
+			if( ea.begin != eb.begin ) { return ( ea.begin < eb.begin ); }
+			return ( ea.depth < eb.depth );
+		} );
+
+		stack.clear();
+		stackEvent.clear();
+
+		for( int64_t k=0; k<thread.count; ++k )
+		{
+			const Thread::Event& e = thread.event( order[k] );
+
+			// Pop the events which don't enclose this one.
+			while( !stack.empty() )
+			{
+				const Thread::Event& top = thread.event( stackEvent.back() );
+
+				if( ( (int)stack.size() > e.depth ) || ( e.end > top.end ) || ( e.begin >= top.end ) )
+				{
+					stack.pop_back();
+					stackEvent.pop_back();
+				}
+				else
+				{
+					break;
+				}
+			}
+
+			const int parent = stack.empty() ? -1 : stack.back();
+
+			int node = -1;
+			{
+				const std::pair<int,const char*> pKey( parent, e.name );
+				std::map<std::pair<int,const char*>,int>::const_iterator itr = byPointer.find( pKey );
+
+				if( itr != byPointer.end() )
+				{
+					node = itr->second;
+				}
+				else
+				{
+					const std::pair<int,std::string> nKey( parent, std::string( e.name ) );
+					std::map<std::pair<int,std::string>,int>::const_iterator jtr = byName.find( nKey );
+
+					if( jtr != byName.end() )
+					{
+						node = jtr->second;
+					}
+					else
+					{
+						node = (int)tree.size();
+
+						Node n;
+						n.name       = e.name;
+						n.parent     = parent;
+						n.depth      = ( parent < 0 ) ? 0 : ( tree[parent].depth + 1 );
+						n.count      = 0;
+						n.numThreads = 0;
+						n.lastThread = -1;
+						n.total      = n.childTotal = 0;
+						n.min        = std::numeric_limits<uint64_t>::max();
+						n.max        = 0;
+						tree.push_back( n );
+
+						if( parent < 0 ) { roots.push_back( node ); }
+						else             { tree[parent].children.push_back( node ); }
+
+						byName[nKey] = node;
+					}
+
+					byPointer[pKey] = node;
+				}
+			}
+
+			Node& n = tree[node];
+
+			const uint64_t duration = ( e.end > e.begin ) ? ( e.end - e.begin ) : 0;
+
+			++n.count;
+			n.total += duration;
+			n.min    = ZMin( n.min, duration );
+			n.max    = ZMax( n.max, duration );
+
+			if( n.lastThread != t ) { ++n.numThreads;  n.lastThread = t; }
+
+			if( parent >= 0 ) { tree[parent].childTotal += duration; }
+
+			stack.push_back( node );
+			stackEvent.push_back( order[k] );
+		}
+	}
+
+	// depth-first (the children in the descending order of the total time)
+	std::vector<pair<int,int> > dfs; // (tree node, parent in nodes)
+	{
+		struct ByTotal
+		{
+			const std::vector<Node>& tree;
+			ByTotal( const std::vector<Node>& t ) : tree(t) {}
+			bool operator()( int a, int b ) const { return ( tree[a].total > tree[b].total ); }
+		};
+
+		std::sort( roots.begin(), roots.end(), ByTotal( tree ) );
+		for( int i=(int)roots.size()-1; i>=0; --i ) { dfs.push_back( pair<int,int>( roots[i], -1 ) ); }
+
+		while( !dfs.empty() )
+		{
+			const pair<int,int> item = dfs.back();
+			dfs.pop_back();
+
+			Node& n = tree[item.first];
+
+			ZProfileNode p;
+			p.name       = n.name;
+			p.parent     = item.second;
+			p.depth      = n.depth;
+			p.count      = n.count;
+			p.numThreads = n.numThreads;
+			p.total      = n.total * msPerTick;
+			p.self       = ( ( n.total > n.childTotal ) ? ( n.total - n.childTotal ) : 0 ) * msPerTick;
+			p.min        = n.min * msPerTick;
+			p.max        = n.max * msPerTick;
+
+			const int index = (int)nodes.size();
+			nodes.push_back( p );
+
+			std::sort( n.children.begin(), n.children.end(), ByTotal( tree ) );
+			for( int i=(int)n.children.size()-1; i>=0; --i ) { dfs.push_back( pair<int,int>( n.children[i], index ) ); }
+		}
+	}
+}
+
+void
+ZProfiler::report( ostream& os, float minPercent ) const
+{
+	std::vector<ZProfileNode> nodes;
+	getStatistics( nodes );
+
+	double rootTotal = 0.0;
+	FOR( i, 0, nodes.size() ) { if( nodes[i].parent < 0 ) { rootTotal += nodes[i].total; } }
+
+	const ios::fmtflags flags = os.flags();
+	const streamsize precision = os.precision();
+
+	os << "<ZProfiler>" << endl;
+	os << " threads : " << numThreads() << endl;
+	os << " events  : " << numEvents() << endl;
+
+	os << fixed << setprecision(3);
+	os << setw(12) << "total(ms)" << setw(12) << "self(ms)" << setw(8) << "%" << setw(10) << "calls";
+	os << setw(12) << "min(ms)" << setw(12) << "max(ms)" << setw(8) << "threads" << "  name" << endl;
+
+	int skipDepth = -1; // skipping the subtree below this depth
+
+	FOR( i, 0, nodes.size() )
+	{
+		const ZProfileNode& n = nodes[i];
+
+		if( ( skipDepth >= 0 ) && ( n.depth > skipDepth ) ) { continue; }
+		skipDepth = -1;
+
+		const double percent = ( rootTotal > 0.0 ) ? ( 100.0 * n.total / rootTotal ) : 0.0;
+		if( percent < minPercent ) { skipDepth = n.depth; continue; }
+
+		os << setw(12) << n.total << setw(12) << n.self << setprecision(1) << setw(8) << percent << setprecision(3);
+		os << setw(10) << n.count << setw(12) << n.min << setw(12) << n.max << setw(8) << n.numThreads;
+		os << "  " << string( 2*n.depth, ' ' ) << n.name.asChar() << endl;
+	}
+
+	os.flags( flags );
+	os.precision( precision );
+}
+
+// the JSON string (the names are the C++ identifiers mostly)
+static void
+WriteJsonString( ostream& os, const char* s )
+{
+	os << '"';
+	for( ; *s; ++s )
+	{
+		const unsigned char c = (unsigned char)*s;
+
+		if( ( c == '"' ) || ( c == '\\' ) ) { os << '\\' << (char)c; }
+		else if( c < 0x20 )                 { os << ' '; }
+		else                                { os << (char)c; }
+	}
+	os << '"';
+}
+
+bool
+ZProfiler::exportChromeTrace( const char* filePathName ) const
+{
+	ofstream file( filePathName, ios::out );
+
+	if( !file.is_open() )
+	{
+		cout << "Error@ZProfiler::exportChromeTrace(): Failed to open file: " << filePathName << endl;
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock( _mutex );
+
+	const double usPerTick = 1000.0 * _millisecondsPerTick();
+
+	file << fixed << setprecision(3);
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << endl;
+
+	bool first = true;
+
+	FOR( t, 0, _threads.size() )
+	{
+		const Thread& thread = *_threads[t];
+
+		file << ( first ? "" : ",\n" );
+		file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread.index;
+		file << ",\"args\":{\"name\":\"thread " << thread.index << "\"}}";
+		first = false;
+
+		for( int64_t i=0; i<thread.count; ++i )
+		{
+			const Thread::Event& e = thread.event(i);
+
+			const double ts  = (double)(int64_t)( e.begin - _startTicks ) * usPerTick;
+			const double dur = ( e.end > e.begin ) ? ( (double)( e.end - e.begin ) * usPerTick ) : 0.0;
+
+			file << ",\n{\"name\":";
+			WriteJsonString( file, e.name );
+			file << ",\"cat\":\"Zelos\",\"ph\":\"X\",\"ts\":" << ts << ",\"dur\":" << dur;
+			file << ",\"pid\":0,\"tid\":" << thread.index << "}";
+		}
+	}
+
+	file << endl << "]}" << endl;
+
+	if( file.fail() )
+	{
+		cout << "Error@ZProfiler::exportChromeTrace(): Failed to write file: " << filePathName << endl;
+		return false;
+	}
+
+	return true;
+}
+
+double
+ZProfiler::usedMemorySize( ZDataUnit::DataUnit dataUnit ) const
+{
+	double bytes = 0.0;
+	{
+		std::lock_guard<std::mutex> lock( _mutex );
+		FOR( i, 0, _threads.size() ) { bytes += _threads[i]->blocks.size() * Thread::BlockSize * sizeof(Thread::Event); }
+	}
+
+	switch( dataUnit )
+	{
+		case ZDataUnit::zBytes:     { return bytes; }
+		case ZDataUnit::zKilobytes: { return (bytes/1024.0); }
+		case ZDataUnit::zMegabytes: { return (bytes/ZPow2(1024.0)); }
+		case ZDataUnit::zGigabytes: { return (bytes/ZPow3(1024.0)); }
+		default: { cout << "Error@ZProfiler::usedMemorySize(): Invalid data unit." << endl; return 0.0; }
+	}
+}
+
+ostream&
+operator<<( ostream& os, const ZProfiler& object )
+{
+	object.report( os );
+	os << endl;
+	return os;
+}
+
+ZELOS_NAMESPACE_END
+
@@ -324,6 +324,89 @@ ZPtc::load( const char* filePathName )
 	return false;
 }
 
+bool
+ZPtc::saveCache( const char* filePathName ) const
+{
+	ZCacheWriter cache;
+	if( !cache.open( filePathName ) ) { return false; }
+
+	bool ok = true;
+
+	ok = ok && cache.add( "name", ZCacheType<char>::name(), name.asChar(), (int)name.length(), sizeof(char) );
+	ok = ok && cache.addValue( "lIdx", lIdx );
+	ok = ok && cache.addValue( "gUid", gUid );
+	ok = ok && cache.addValue( "gClr", gClr );
+	ok = ok && cache.addValue( "aabb", aabb );
+	ok = ok && cache.addValue( "tScl", tScl );
+
+	// only the existing attributes
+	if( uid.size() ) { ok = ok && cache.add( "uid", uid ); }
+	if( pos.size() ) { ok = ok && cache.add( "pos", pos ); }
+	if( vel.size() ) { ok = ok && cache.add( "vel", vel ); }
+	if( rad.size() ) { ok = ok && cache.add( "rad", rad ); }
+	if( clr.size() ) { ok = ok && cache.add( "clr", clr ); }
+	if( nrm.size() ) { ok = ok && cache.add( "nrm", nrm ); }
+	if( vrt.size() ) { ok = ok && cache.add( "vrt", vrt ); }
+	if( dst.size() ) { ok = ok && cache.add( "dst", dst ); }
+	if( sdt.size() ) { ok = ok && cache.add( "sdt", sdt ); }
+	if( uvw.size() ) { ok = ok && cache.add( "uvw", uvw ); }
+	if( age.size() ) { ok = ok && cache.add( "age", age ); }
+	if( lfs.size() ) { ok = ok && cache.add( "lfs", lfs ); }
+	if( sts.size() ) { ok = ok && cache.add( "sts", sts ); }
+	if( typ.size() ) { ok = ok && cache.add( "typ", typ ); }
+
+	if( !ok ) { cache.abort(); return false; }
+
+	return cache.close();
+}
+
+bool
+ZPtc::loadCache( const char* filePathName )
+{
+	reset();
+
+	ZCacheReader cache;
+
+	if( !cache.open( filePathName ) )
+	{
+		cout << "Error@ZPtc::loadCache(): Failed to load file." << endl;
+		return false;
+	}
+
+	ZArrayView<char> nameView;
+	if( cache.view( "name", nameView ) ) { name = std::string( nameView.begin(), nameView.end() ); }
+
+	cache.readValue( "lIdx", lIdx );
+	cache.readValue( "gUid", gUid );
+	cache.readValue( "gClr", gClr );
+	cache.readValue( "aabb", aabb );
+	cache.readValue( "tScl", tScl );
+
+	if( !cache.read( "pos", pos ) )
+	{
+		cout << "Error@ZPtc::loadCache(): Invalid cache file: " << filePathName << endl;
+		reset();
+		return false;
+	}
+
+	// The missing attributes are cleared by read().
+	cache.read( "uid", uid );
+	cache.read( "vel", vel );
+	cache.read( "rad", rad );
+	cache.read( "clr", clr );
+	cache.read( "nrm", nrm );
+	cache.read( "vrt", vrt );
+	cache.read( "dst", dst );
+	cache.read( "sdt", sdt );
+	cache.read( "uvw", uvw );
+	cache.read( "age", age );
+	cache.read( "lfs", lfs );
+	cache.read( "sts", sts );
+	cache.read( "typ", typ );
+
+	return true;
+}
+
 bool
 ZPtc::savePtc( const char* filename ) const
 {
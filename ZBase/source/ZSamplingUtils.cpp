@@ -2,7 +2,7 @@
 // ZSamplingUtils.cpp //
 //-------------------------------------------------------//
 // author: Wanho Choi @ Dexter Studios                   //
-// last update: 2015.10.07                               //
+// last update: 2019.03.30                               //
 //-------------------------------------------------------//
 
 #include <ZelosBase.h>
@@ -345,5 +345,245 @@ ScatterPoissonDisk3D( float radius, const ZPoint& minPt, const ZPoint& maxPt, in
 	return points.length();
 }
 
+// the candidates in the same cell: the ascending order of the cell key, and then the index
+struct ZPoissonDiskCellCompare
+{
+	const std::vector<int64_t>& key;
+
+	ZPoissonDiskCellCompare( const std::vector<int64_t>& inKey ) : key(inKey) {}
+
+	bool operator()( const int& a, const int& b ) const
+	{
+		if( key[a] != key[b] ) { return ( key[a] < key[b] ); }
+		return ( a < b );
+	}
+};
+
+// Sample elimination over the grid of the cell size >= the max. radius.
+// The cells of the same parity (phase) never share any neighbor, so they are processed concurrently,
+// and the cells of the eight phases take their turns in each round.
+// In each round, each cell accepts at most one candidate (the first one in the index order which does not conflict),
+// so the cells are filled evenly as the serial one-per-cell sweep used to do.
+// The accepted candidates of a cell are stored in the front of its own range of ids[] in place.
+int
+SelectPoissonDisk( const ZPointArray& points, const ZVectorArray& normals, const ZFloatArray& radii, bool useOpenMP, ZIntArray& selected )
+{
+	selected.clear();
+
+	const int n = points.length();
+	if( !n ) { return 0; }
+
+	if( ( radii.length() != n ) || ( normals.length() && ( normals.length() != n ) ) )
+	{
+		cout << "Error@SelectPoissonDisk(): Invalid array length." << endl;
+		return 0;
+	}
+
+	const bool useNormals = ( normals.length() == n );
+
+	float minR=0.f, maxR=0.f;
+	radii.getMinMax( minR, maxR, useOpenMP );
+
+	// the normalized coordinates: the cell size becomes 1 (>= the max. radius, so a query visits 3x3x3 cells),
+	// but it is not smaller than 1e-6 of the extent to keep the cell keys in int64_t.
+	const ZBoundingBox bBox = points.boundingBox( useOpenMP );
+
+	const float h    = ZMax( 1.001f*maxR, bBox.maxWidth()*1e-6f, 1e-30f );
+	const float invH = 1.f / h;
+
+	const ZPoint& minPt = bBox.minPoint();
+	const ZPoint& maxPt = bBox.maxPoint();
+
+	const int64_t nx = (int64_t)( ( maxPt.x - minPt.x ) * invH ) + 2;
+	const int64_t ny = (int64_t)( ( maxPt.y - minPt.y ) * invH ) + 2;
+	// (The z extent is not needed: the key is x + nx*( y + ny*z ).)
+
+	ZPointArray q( n );
+	std::vector<int64_t> key( n );
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( i, 0, n )
+	{
+		q[i] = ( points[i] - minPt ) * invH;
+
+		key[i] = (int64_t)q[i].x + nx * ( (int64_t)q[i].y + ny * (int64_t)q[i].z );
+	}
+
+	// the candidates sorted by the bucket (the cells are not mixed up yet)
+	ZPointsHashGrid grid( n, 1.f );
+	grid.build( q, useOpenMP );
+
+	ZIntArray ids, bucketStart;
+	grid.releaseBuckets( bucketStart, ids ); // (Only index() of the grid is used after this.)
+
+	const int numBuckets = bucketStart.length() - 1;
+
+	// cells: the runs of the same key in each bucket
+	ZIntArray bucketCells( numBuckets+1 ); // the first cell of each bucket
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( b, 0, numBuckets )
+	{
+		const int& s = bucketStart[b];
+		const int& e = bucketStart[b+1];
+
+		std::sort( ids.begin()+s, ids.begin()+e, ZPoissonDiskCellCompare( key ) );
+
+		int count = 0;
+
+		FOR( k, s, e )
+		{
+			if( ( k == s ) || ( key[ids[k]] != key[ids[k-1]] ) ) { ++count; }
+		}
+
+		bucketCells[b+1] = count;
+	}
+
+	FOR( b, 0, numBuckets ) { bucketCells[b+1] += bucketCells[b]; }
+
+	const int numCells = bucketCells[numBuckets];
+
+	ZIntArray cellStart( numCells+1 );
+	std::vector<int64_t> cellKey( numCells );
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( b, 0, numBuckets )
+	{
+		int c = bucketCells[b];
+
+		FOR( k, bucketStart[b], bucketStart[b+1] )
+		{
+			if( ( k == bucketStart[b] ) || ( key[ids[k]] != key[ids[k-1]] ) )
+			{
+				cellStart[c] = k;
+				cellKey[c]   = key[ids[k]];
+				++c;
+			}
+		}
+	}
+
+	cellStart[numCells] = n;
+
+	// the active cells of each phase
+	ZIntArray active[8];
+
+	FOR( c, 0, numCells )
+	{
+		const int64_t& k = cellKey[c];
+		const int phase = int( k % nx ) % 2 + 2 * ( int( (k/nx) % ny ) % 2 ) + 4 * ( int( k/(nx*ny) ) % 2 );
+		active[phase].push_back( c );
+	}
+
+	ZIntArray cursor( numCells ); // the next candidate of each cell
+	ZIntArray numAcc( numCells ); // the # of the accepted candidates of each cell
+
+	FOR( c, 0, numCells ) { cursor[c] = cellStart[c]; }
+
+	while( 1 )
+	{
+		int numActive = 0;
+		FOR( phase, 0, 8 ) { numActive += active[phase].length(); }
+		if( !numActive ) { break; }
+
+		FOR( phase, 0, 8 )
+		{
+			ZIntArray& cells = active[phase];
+			const int numActiveCells = cells.length();
+
+			#pragma omp parallel for schedule(dynamic,64) if( useOpenMP )
+			FOR( i, 0, numActiveCells )
+			{
+				const int& c = cells[i];
+
+				const int64_t& k = cellKey[c];
+				const int ci = int( k % nx );
+				const int cj = int( (k/nx) % ny );
+				const int ck = int( k/(nx*ny) );
+
+				int nbrs[27], numNbrs = 0;
+
+				for( int kk=ck-1; kk<=ck+1; ++kk )
+				for( int jj=cj-1; jj<=cj+1; ++jj )
+				for( int ii=ci-1; ii<=ci+1; ++ii )
+				{{{
+					if( ( ii < 0 ) || ( jj < 0 ) || ( kk < 0 ) ) { continue; }
+
+					const int64_t nk = ii + nx * ( jj + ny * (int64_t)kk );
+					const int b = grid.index( ii, jj, kk );
+
+					FOR( m, bucketCells[b], bucketCells[b+1] )
+					{
+						if( cellKey[m] == nk ) { nbrs[numNbrs++] = m; break; }
+					}
+				}}}
+
+				while( cursor[c] < cellStart[c+1] )
+				{
+					const int j = ids[ cursor[c]++ ];
+
+					const ZPoint& pj = points[j];
+					const float&  rj = radii[j];
+
+					bool conflicted = false;
+
+					for( int m=0; ( m<numNbrs ) && !conflicted; ++m )
+					{
+						const int& nc = nbrs[m];
+
+						FOR( a, cellStart[nc], cellStart[nc]+numAcc[nc] )
+						{
+							const int& s = ids[a];
+							const float r = ZMax( rj, radii[s] );
+
+							if( pj.squaredDistanceTo( points[s] ) > r*r ) { continue; }
+
+							// (DST() is not less than the Euclidean distance.)
+							if( !useNormals || ( DST( points[s], pj, normals[s], normals[j] ) <= r ) )
+							{
+								conflicted = true;
+								break;
+							}
+						}
+					}
+
+					if( !conflicted )
+					{
+						ids[ cellStart[c] + numAcc[c]++ ] = j; // (never ahead of the cursor)
+						break;
+					}
+				}
+			}
+
+			int numRemained = 0;
+
+			FOR( i, 0, numActiveCells )
+			{
+				const int& c = cells[i];
+				if( cursor[c] < cellStart[c+1] ) { cells[numRemained++] = c; }
+			}
+
+			cells.resize( numRemained );
+		}
+	}
+
+	ZIntArray flags( n );
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( c, 0, numCells )
+	{
+		FOR( a, cellStart[c], cellStart[c]+numAcc[c] )
+		{
+			flags[ ids[a] ] = 1;
+		}
+	}
+
+	FOR( i, 0, n )
+	{
+		if( flags[i] ) { selected.push_back( i ); }
+	}
+
+	return selected.length();
+}
+
 ZELOS_NAMESPACE_END
 
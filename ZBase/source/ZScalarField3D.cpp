@@ -2,7 +2,7 @@
 // ZScalarField3D.cpp //
 //-------------------------------------------------------//
 // author: Wanho Choi @ Dexter Studios                   //
-// last update: 2015.10.07                               //
+// last update: 2019.03.30                               //
 //-------------------------------------------------------//
 
 #include <ZelosBase.h>
@@ -124,6 +124,62 @@ ZScalarField3D::absMax( bool useOpenMP ) const
 	return ZFloatArray::absMax( useOpenMP );
 }
 
+bool
+ZScalarField3D::sample( const ZPointArray& points, ZFloatArray& values, ZInterpolationType::InterpolationType type, bool useOpenMP ) const
+{
+	ZPROFILE_SCOPE( "ZScalarField3D::sample" );
+
+	values.setLength( points.length(), false );
+
+	if( (int)ZFloatArray::size() != _numElements )
+	{
+		cout << "Error@ZScalarField3D::sample(): Invalid field data." << endl;
+		return false;
+	}
+
+	return ZField3DBase::_sample( ZFloatArray::pointer(), 1, points, values.pointer(), type, useOpenMP );
+}
+
+void
+ZScalarField3D::setNoise( const ZSimplexNoise& noise, float time, bool useOpenMP )
+{
+	// value( x, y, z, time ) = fBm( x, y, z, time, 1, 1, 1, 1 )
+	ZScalarField3D::setFBm( noise, time, 1, 1.f, 1.f, 1.f, useOpenMP );
+}
+
+void
+ZScalarField3D::setFBm( const ZSimplexNoise& noise, float time, int numOctaves, float amp, float freq, float rough, bool useOpenMP )
+{
+	float* _data = (float*)ZFloatArray::pointer();
+
+	const int numRows = (_jMax+1)*(_kMax+1);
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( r, 0, numRows )
+	{
+		const int j = r % (_jMax+1);
+		const int k = r / (_jMax+1);
+
+		float x[4], y[4], z[4], v[4];
+
+		for( int i=0; i<=_iMax; i+=4 )
+		{
+			const int m = ZMin( 4, _iMax+1-i );
+
+			FOR( l, 0, 4 )
+			{
+				const ZPoint p( this->position( i+ZMin(l,m-1), j, k ) );
+				x[l]=p.x; y[l]=p.y; z[l]=p.z;
+			}
+
+			noise.fBm4( x, y, z, time, numOctaves, amp, freq, rough, v );
+
+			const int idx = ZField3DBase::index(i,j,k);
+			FOR( l, 0, m ) { _data[idx+l] = v[l]; }
+		}
+	}
+}
+
 const ZString
 ZScalarField3D::dataType() const
 {
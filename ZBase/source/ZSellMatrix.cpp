@@ -0,0 +1,210 @@
+//-----------------//
+// ZSellMatrix.cpp //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.29                               //
+//-------------------------------------------------------//
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+ZSellMatrix::ZSellMatrix()
+{
+	ZSellMatrix::reset();
+}
+
+ZSellMatrix::ZSellMatrix( const ZSparseMatrix<float>& A, int sigma )
+{
+	ZSellMatrix::set( A, sigma );
+}
+
+void
+ZSellMatrix::reset()
+{
+	_m = _n = _nnz = 0;
+	_sigma = C;
+
+	chunkStart.clear();
+	c   .clear();
+	v   .clear();
+	row .clear();
+	diag.clear();
+}
+
+// the longer rows first, and the original order for the same lengths
+struct ZSellRowLengthCompare
+{
+	const std::vector<int>& length;
+
+	ZSellRowLengthCompare( const std::vector<int>& inLength ) : length(inLength) {}
+
+	bool operator()( const int& a, const int& b ) const
+	{
+		if( length[a] != length[b] ) { return ( length[a] > length[b] ); }
+		return ( a < b );
+	}
+};
+
+bool
+ZSellMatrix::set( const ZSparseMatrix<float>& A, int sigma, bool useOpenMP )
+{
+	ZSellMatrix::reset();
+
+	const int m = A.m();
+	const int n = A.n();
+
+	if( m < 1 )
+	{
+		cout << "Error@ZSellMatrix::set(): Empty matrix." << endl;
+		return false;
+	}
+
+	_m     = m;
+	_n     = n;
+	_sigma = ZMax( ( ( sigma + C - 1 ) / C ) * C, (int)C );
+
+	// the valid entries per row
+	std::vector<int> length( m, 0 );
+	diag.assign( m, 0.f );
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( i, 0, m )
+	{
+		FOR( e, A.r[i], A.r[i+1] )
+		{
+			const int& j = A.c[e];
+			if( ( j < 0 ) || ( j >= n ) || ( A.v[e] == 0.f ) ) { continue; }
+
+			++length[i];
+			if( j == i ) { diag[i] += A.v[e]; }
+		}
+	}
+
+	// sorting in each window
+	const int numChunks  = ( m + C - 1 ) / C;
+	const int numWindows = ( m + _sigma - 1 ) / _sigma;
+
+	row.assign( numChunks*C, -1 );
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( w, 0, numWindows )
+	{
+		const int start = w * _sigma;
+		const int end   = ZMin( start + _sigma, m );
+
+		FOR( i, start, end ) { row[i] = i; }
+
+		std::sort( row.begin()+start, row.begin()+end, ZSellRowLengthCompare( length ) );
+	}
+
+	// chunk widths
+	chunkStart.resize( numChunks+1 );
+	chunkStart[0] = 0;
+
+	FOR( ch, 0, numChunks )
+	{
+		int width = 0;
+
+		FOR( l, 0, C )
+		{
+			const int& i = row[ ch*C + l ];
+			if( i >= 0 ) { width = ZMax( width, length[i] ); }
+		}
+
+		chunkStart[ch+1] = chunkStart[ch] + width*C;
+	}
+
+	c.assign( chunkStart[numChunks], 0   );
+	v.assign( chunkStart[numChunks], 0.f );
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( ch, 0, numChunks )
+	{
+		FOR( l, 0, C )
+		{
+			const int& i = row[ ch*C + l ];
+			if( i < 0 ) { continue; }
+
+			int idx = chunkStart[ch] + l;
+
+			FOR( e, A.r[i], A.r[i+1] )
+			{
+				const int& j = A.c[e];
+				if( ( j < 0 ) || ( j >= n ) || ( A.v[e] == 0.f ) ) { continue; }
+
+				c[idx] = j;
+				v[idx] = A.v[e];
+
+				idx += C;
+			}
+		}
+	}
+
+	FOR( i, 0, m ) { _nnz += length[i]; }
+
+	return true;
+}
+
+float
+ZSellMatrix::efficiency() const
+{
+	if( v.empty() ) { return 1.f; }
+	return ( (float)_nnz / (float)v.size() );
+}
+
+void
+ZSellMatrix::multiply( const ZFloatArray& x, ZFloatArray& y, bool useOpenMP ) const
+{
+	if( x.length() != _n )
+	{
+		cout << "Error@ZSellMatrix::multiply(): Invalid dimension." << endl;
+		return;
+	}
+
+	y.setLength( _m, false );
+
+	#pragma omp parallel if( useOpenMP )
+	{
+		int i0, i1;
+		GetThreadRange( _m, i0, i1 );
+
+		SpMVKernel( *this, &x[0], &y[0], i0, i1 );
+	}
+}
+
+double
+ZSellMatrix::usedMemorySize( ZDataUnit::DataUnit dataUnit ) const
+{
+	double bytes = 0.0;
+	bytes += (double)chunkStart.size() * sizeof(int);
+	bytes += (double)c.size() * sizeof(int);
+	bytes += (double)v.size() * sizeof(float);
+	bytes += (double)row.size() * sizeof(int);
+	bytes += (double)diag.size() * sizeof(float);
+
+	switch( dataUnit )
+	{
+		case ZDataUnit::zBytes:     { return bytes; }
+		case ZDataUnit::zKilobytes: { return (bytes/1024.0); }
+		case ZDataUnit::zMegabytes: { return (bytes/ZPow2(1024.0)); }
+		case ZDataUnit::zGigabytes: { return (bytes/ZPow3(1024.0)); }
+		default: { cout << "Error@ZSellMatrix::usedMemorySize(): Invalid data unit." << endl; return 0.0; }
+	}
+}
+
+ostream&
+operator<<( ostream& os, const ZSellMatrix& object )
+{
+	os << "<ZSellMatrix>" << endl;
+	os << " dimension   : " << object.m() << " x " << object.n() << endl;
+	os << " non-zeros   : " << object.nnz() << endl;
+	os << " C, sigma    : " << ZSellMatrix::C << ", " << object.sigma() << endl;
+	os << " efficiency  : " << object.efficiency() << endl;
+	os << " memory size : " << object.usedMemorySize(ZDataUnit::zMegabytes) << " mb." << endl;
+	os << endl;
+	return os;
+}
+
+ZELOS_NAMESPACE_END
+
@@ -4,11 +4,16 @@
 // author: Jinhyuk Bae @ Dexter Studios                  //
 //         Wanho Choi @ Dexter Studios					 //
 //         Nayoung Kim @ Dexter Studios                  //
-// last update: 2018.03.08                               //
+// last update: 2019.03.30                               //
 //-------------------------------------------------------//
 
 #include <ZelosBase.h>
 
+#ifdef __SSE2__
+ #include <emmintrin.h>
+ #define Z_NOISE_SSE
+#endif
+
 ZELOS_NAMESPACE_BEGIN
 
 // Gradient vectors preset for 2D lattice
@@ -95,7 +100,7 @@ ZSimplexNoise&
 ZSimplexNoise::operator=( const ZSimplexNoise& s )
 {
 	_seed = s._seed;
-	memcpy( (char*)_perm, (char*)s._perm, 512*sizeof(int) );
+	memcpy( (char*)_perm, (char*)s._perm, 512*sizeof(unsigned char) );
 
 	offset = s.offset;
 	sFreq  = s.sFreq;
@@ -652,10 +657,10 @@ ZSimplexNoise::pureValue
 		*dz += t40 * gz0 + t41 * gz1 + t42 * gz2 + t43 * gz3 + t44 * gz4;
 		*dw += t40 * gw0 + t41 * gw1 + t42 * gw2 + t43 * gw3 + t44 * gw4;
 
-		*dx *= 28.f; // Scale derivative to match the noise scaling
-		*dy *= 28.f;
-		*dz *= 28.f;
-		*dw *= 28.f;
+		*dx *= 27.f; // Scale derivative to match the noise scaling
+		*dy *= 27.f;
+		*dz *= 27.f;
+		*dw *= 27.f;
 	}
 
 	return noise;
@@ -692,6 +697,328 @@ ZSimplexNoise::fBm( float x, float y, float z, float t, int numOctaves, float am
 	return sum;
 }
 
+#ifdef Z_NOISE_SSE
+
+// floor() of each lane (SSE2 has no rounding instruction): the integers and the floats of them
+static inline __m128
+FloorPS( __m128 x, __m128i& i )
+{
+	__m128i t = _mm_cvttps_epi32( x );
+
+	// -1 where the truncation went upward (the negative non-integers)
+	const __m128 m = _mm_cmpgt_ps( _mm_cvtepi32_ps( t ), x );
+	t = _mm_add_epi32( t, _mm_castps_si128( m ) );
+
+	i = t;
+	return _mm_cvtepi32_ps( t );
+}
+
+// The 4D simplex noise of four points: the same as ZSimplexNoise::pureValue( x,y,z,w, dx,dy,dz,dw ) lane by lane.
+// The simplex is found by the ranks of the coordinates instead of the lookup table, and the corners out of reach are
+// handled by max(t,0) instead of the branches. Only the permutation and the gradient lookups are done per lane.
+static inline __m128
+SimplexNoise4D( __m128 x, __m128 y, __m128 z, __m128 w, const unsigned char* perm, const float (*grad4)[4], __m128* d )
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one  = _mm_set1_ps( 1.f );
+	const __m128 G4   = _mm_set1_ps( 0.138196601f );
+
+	// skewing
+	const __m128 s = _mm_mul_ps( _mm_add_ps( _mm_add_ps( _mm_add_ps( x, y ), z ), w ), _mm_set1_ps( 0.309016994f ) );
+
+	__m128i i, j, k, l;
+	const __m128 fi = FloorPS( _mm_add_ps( x, s ), i );
+	const __m128 fj = FloorPS( _mm_add_ps( y, s ), j );
+	const __m128 fk = FloorPS( _mm_add_ps( z, s ), k );
+	const __m128 fl = FloorPS( _mm_add_ps( w, s ), l );
+
+	// unskewing
+	const __m128 t = _mm_mul_ps( _mm_cvtepi32_ps( _mm_add_epi32( _mm_add_epi32( _mm_add_epi32( i, j ), k ), l ) ), G4 );
+
+	__m128 cx[5], cy[5], cz[5], cw[5]; // the offsets from the five corners
+
+	cx[0] = _mm_sub_ps( x, _mm_sub_ps( fi, t ) );
+	cy[0] = _mm_sub_ps( y, _mm_sub_ps( fj, t ) );
+	cz[0] = _mm_sub_ps( z, _mm_sub_ps( fk, t ) );
+	cw[0] = _mm_sub_ps( w, _mm_sub_ps( fl, t ) );
+
+	// the rank of each coordinate (3: the largest)
+	const __m128 c1 = _mm_cmpgt_ps( cx[0], cy[0] );
+	const __m128 c2 = _mm_cmpgt_ps( cx[0], cz[0] );
+	const __m128 c3 = _mm_cmpgt_ps( cy[0], cz[0] );
+	const __m128 c4 = _mm_cmpgt_ps( cx[0], cw[0] );
+	const __m128 c5 = _mm_cmpgt_ps( cy[0], cw[0] );
+	const __m128 c6 = _mm_cmpgt_ps( cz[0], cw[0] );
+
+	const __m128 rx = _mm_add_ps( _mm_add_ps( _mm_and_ps   ( c1, one ), _mm_and_ps   ( c2, one ) ), _mm_and_ps   ( c4, one ) );
+	const __m128 ry = _mm_add_ps( _mm_add_ps( _mm_andnot_ps( c1, one ), _mm_and_ps   ( c3, one ) ), _mm_and_ps   ( c5, one ) );
+	const __m128 rz = _mm_add_ps( _mm_add_ps( _mm_andnot_ps( c2, one ), _mm_andnot_ps( c3, one ) ), _mm_and_ps   ( c6, one ) );
+	const __m128 rw = _mm_add_ps( _mm_add_ps( _mm_andnot_ps( c4, one ), _mm_andnot_ps( c5, one ) ), _mm_andnot_ps( c6, one ) );
+
+	// the integer offsets of the corners (the c-th corner: 1 for the coordinates of rank >= 4-c)
+	__m128i oi[5], oj[5], ok[5], ol[5];
+
+	oi[0] = oj[0] = ok[0] = ol[0] = _mm_setzero_si128();
+	oi[4] = oj[4] = ok[4] = ol[4] = _mm_set1_epi32( 1 );
+
+	FOR( c, 1, 4 )
+	{
+		const __m128 th = _mm_set1_ps( (float)(4-c) );
+
+		const __m128 ox = _mm_and_ps( _mm_cmpge_ps( rx, th ), one );
+		const __m128 oy = _mm_and_ps( _mm_cmpge_ps( ry, th ), one );
+		const __m128 oz = _mm_and_ps( _mm_cmpge_ps( rz, th ), one );
+		const __m128 ow = _mm_and_ps( _mm_cmpge_ps( rw, th ), one );
+
+		oi[c] = _mm_cvttps_epi32( ox );
+		oj[c] = _mm_cvttps_epi32( oy );
+		ok[c] = _mm_cvttps_epi32( oz );
+		ol[c] = _mm_cvttps_epi32( ow );
+
+		const __m128 cG4 = _mm_set1_ps( c * 0.138196601f );
+
+		cx[c] = _mm_add_ps( _mm_sub_ps( cx[0], ox ), cG4 );
+		cy[c] = _mm_add_ps( _mm_sub_ps( cy[0], oy ), cG4 );
+		cz[c] = _mm_add_ps( _mm_sub_ps( cz[0], oz ), cG4 );
+		cw[c] = _mm_add_ps( _mm_sub_ps( cw[0], ow ), cG4 );
+	}
+
+	{
+		const __m128 c4G4 = _mm_set1_ps( 4.f * 0.138196601f - 1.f );
+
+		cx[4] = _mm_add_ps( cx[0], c4G4 );
+		cy[4] = _mm_add_ps( cy[0], c4G4 );
+		cz[4] = _mm_add_ps( cz[0], c4G4 );
+		cw[4] = _mm_add_ps( cw[0], c4G4 );
+	}
+
+	// the gradients of the corners
+	const __m128i mask = _mm_set1_epi32( 0xff );
+
+	int I[4], J[4], K[4], L[4];
+	_mm_storeu_si128( (__m128i*)I, _mm_and_si128( i, mask ) );
+	_mm_storeu_si128( (__m128i*)J, _mm_and_si128( j, mask ) );
+	_mm_storeu_si128( (__m128i*)K, _mm_and_si128( k, mask ) );
+	_mm_storeu_si128( (__m128i*)L, _mm_and_si128( l, mask ) );
+
+	__m128 n  = zero;
+	__m128 dd[4] = { zero, zero, zero, zero }; // sum of t^3*(g.c)*c
+	__m128 gg[4] = { zero, zero, zero, zero }; // sum of t^4*g
+
+	FOR( c, 0, 5 )
+	{
+		int OI[4], OJ[4], OK[4], OL[4];
+		_mm_storeu_si128( (__m128i*)OI, oi[c] );
+		_mm_storeu_si128( (__m128i*)OJ, oj[c] );
+		_mm_storeu_si128( (__m128i*)OK, ok[c] );
+		_mm_storeu_si128( (__m128i*)OL, ol[c] );
+
+		const float* g[4];
+
+		FOR( lane, 0, 4 )
+		{
+			const int h = perm[ I[lane]+OI[lane] + perm[ J[lane]+OJ[lane] + perm[ K[lane]+OK[lane] + perm[ L[lane]+OL[lane] ] ] ] ];
+			g[lane] = grad4[ h & 31 ];
+		}
+
+		const __m128 gx = _mm_set_ps( g[3][0], g[2][0], g[1][0], g[0][0] );
+		const __m128 gy = _mm_set_ps( g[3][1], g[2][1], g[1][1], g[0][1] );
+		const __m128 gz = _mm_set_ps( g[3][2], g[2][2], g[1][2], g[0][2] );
+		const __m128 gw = _mm_set_ps( g[3][3], g[2][3], g[1][3], g[0][3] );
+
+		__m128 t0 = _mm_sub_ps( _mm_set1_ps( 0.6f ), _mm_mul_ps( cx[c], cx[c] ) );
+		t0 = _mm_sub_ps( t0, _mm_mul_ps( cy[c], cy[c] ) );
+		t0 = _mm_sub_ps( t0, _mm_mul_ps( cz[c], cz[c] ) );
+		t0 = _mm_sub_ps( t0, _mm_mul_ps( cw[c], cw[c] ) );
+		t0 = _mm_max_ps( t0, zero );
+
+		const __m128 t2 = _mm_mul_ps( t0, t0 );
+		const __m128 t4 = _mm_mul_ps( t2, t2 );
+
+		const __m128 dot = _mm_add_ps( _mm_add_ps( _mm_mul_ps( gx, cx[c] ), _mm_mul_ps( gy, cy[c] ) ),
+		                               _mm_add_ps( _mm_mul_ps( gz, cz[c] ), _mm_mul_ps( gw, cw[c] ) ) );
+
+		n = _mm_add_ps( n, _mm_mul_ps( t4, dot ) );
+
+		if( d )
+		{
+			const __m128 tmp = _mm_mul_ps( _mm_mul_ps( t2, t0 ), dot );
+
+			dd[0] = _mm_add_ps( dd[0], _mm_mul_ps( tmp, cx[c] ) );
+			dd[1] = _mm_add_ps( dd[1], _mm_mul_ps( tmp, cy[c] ) );
+			dd[2] = _mm_add_ps( dd[2], _mm_mul_ps( tmp, cz[c] ) );
+			dd[3] = _mm_add_ps( dd[3], _mm_mul_ps( tmp, cw[c] ) );
+
+			gg[0] = _mm_add_ps( gg[0], _mm_mul_ps( t4, gx ) );
+			gg[1] = _mm_add_ps( gg[1], _mm_mul_ps( t4, gy ) );
+			gg[2] = _mm_add_ps( gg[2], _mm_mul_ps( t4, gz ) );
+			gg[3] = _mm_add_ps( gg[3], _mm_mul_ps( t4, gw ) );
+		}
+	}
+
+	const __m128 s27 = _mm_set1_ps( 27.f );
+
+	if( d )
+	{
+		const __m128 m8 = _mm_set1_ps( -8.f );
+		FOR( a, 0, 4 ) { d[a] = _mm_mul_ps( s27, _mm_add_ps( _mm_mul_ps( m8, dd[a] ), gg[a] ) ); }
+	}
+
+	return _mm_mul_ps( s27, n );
+}
+
+#endif
+
+void
+ZSimplexNoise::fBm4( const float x[4], const float y[4], const float z[4], float t, int numOctaves, float amp, float freq, float rough,
+					 float values[4], float* gx, float* gy, float* gz ) const
+{
+	const bool toGetGradients = ( gx && gy && gz );
+
+	#ifdef Z_NOISE_SSE
+	{
+		const __m128 px = _mm_loadu_ps( x );
+		const __m128 py = _mm_loadu_ps( y );
+		const __m128 pz = _mm_loadu_ps( z );
+		const __m128 pw = _mm_set1_ps( t * tFreq );
+
+		__m128 sum = _mm_setzero_ps();
+		__m128 sx  = _mm_setzero_ps();
+		__m128 sy  = _mm_setzero_ps();
+		__m128 sz  = _mm_setzero_ps();
+
+		__m128 d[4];
+
+		// all the octaves in registers
+		FOR( o, 0, numOctaves )
+		{
+			// value( freq*x, freq*y, freq*z, t )
+			const __m128 f = _mm_set1_ps( freq );
+
+			const __m128 qx = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( sFreq.x ), _mm_mul_ps( f, px ) ), _mm_set1_ps( offset.x ) );
+			const __m128 qy = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( sFreq.y ), _mm_mul_ps( f, py ) ), _mm_set1_ps( offset.y ) );
+			const __m128 qz = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( sFreq.z ), _mm_mul_ps( f, pz ) ), _mm_set1_ps( offset.z ) );
+
+			const __m128 n = SimplexNoise4D( qx, qy, qz, pw, _perm, _grad4lut, toGetGradients ? d : (__m128*)NULL );
+
+			const __m128 v = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( scale ), n ), _mm_set1_ps( lift ) );
+
+			sum = _mm_add_ps( sum, _mm_mul_ps( v, _mm_set1_ps( amp ) ) );
+
+			if( toGetGradients )
+			{
+				const float c = amp * scale * freq; // the chain rule
+
+				sx = _mm_add_ps( sx, _mm_mul_ps( d[0], _mm_set1_ps( c * sFreq.x ) ) );
+				sy = _mm_add_ps( sy, _mm_mul_ps( d[1], _mm_set1_ps( c * sFreq.y ) ) );
+				sz = _mm_add_ps( sz, _mm_mul_ps( d[2], _mm_set1_ps( c * sFreq.z ) ) );
+			}
+
+			amp  *= rough;
+			freq *= 2.f;
+		}
+
+		_mm_storeu_ps( values, sum );
+
+		if( toGetGradients )
+		{
+			_mm_storeu_ps( gx, sx );
+			_mm_storeu_ps( gy, sy );
+			_mm_storeu_ps( gz, sz );
+		}
+	}
+	#else
+	{
+		FOR( lane, 0, 4 )
+		{
+			float a = amp, f = freq;
+			float sum=0.f, sx=0.f, sy=0.f, sz=0.f;
+
+			FOR( o, 0, numOctaves )
+			{
+				float dx=0.f, dy=0.f, dz=0.f, dw=0.f;
+
+				const float n = pureValue( sFreq.x*(f*x[lane])+offset.x, sFreq.y*(f*y[lane])+offset.y, sFreq.z*(f*z[lane])+offset.z, t*tFreq,
+										   toGetGradients ? &dx : (float*)NULL, &dy, &dz, &dw );
+
+				sum += ( scale * n + lift ) * a;
+
+				sx += dx * ( a * scale * f * sFreq.x );
+				sy += dy * ( a * scale * f * sFreq.y );
+				sz += dz * ( a * scale * f * sFreq.z );
+
+				a *= rough;
+				f *= 2.f;
+			}
+
+			values[lane] = sum;
+
+			if( toGetGradients ) { gx[lane]=sx; gy[lane]=sy; gz[lane]=sz; }
+		}
+	}
+	#endif
+}
+
+void
+ZSimplexNoise::fBm( const ZPointArray& points, float t, int numOctaves, float amp, float freq, float rough, ZFloatArray& values, ZVectorArray* gradients, bool useOpenMP ) const
+{
+	const int n = points.length();
+
+	values.setLength( n, false );
+	if( gradients ) { gradients->setLength( n, false ); }
+
+	const int numBlocks = ( n + 3 ) / 4;
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( b, 0, numBlocks )
+	{
+		const int i0 = 4*b;
+		const int m  = ZMin( 4, n-i0 );
+
+		float x[4], y[4], z[4], v[4], gx[4], gy[4], gz[4];
+
+		FOR( l, 0, 4 )
+		{
+			const ZPoint& p = points[ i0 + ZMin( l, m-1 ) ]; // (The last one is repeated for the tail.)
+
+			x[l] = p.x;
+			y[l] = p.y;
+			z[l] = p.z;
+		}
+
+		if( gradients ) {
+
+			fBm4( x, y, z, t, numOctaves, amp, freq, rough, v, gx, gy, gz );
+
+			FOR( l, 0, m )
+			{
+				values[i0+l] = v[l];
+				(*gradients)[i0+l].set( gx[l], gy[l], gz[l] );
+			}
+
+		} else {
+
+			fBm4( x, y, z, t, numOctaves, amp, freq, rough, v );
+
+			FOR( l, 0, m ) { values[i0+l] = v[l]; }
+
+		}
+	}
+}
+
+void
+ZSimplexNoise::evaluate( const ZPointArray& points, float t, ZFloatArray& values, ZVectorArray* gradients, bool useOpenMP ) const
+{
+	ZSimplexNoise::fBm( points, t, 1, 1.f, 1.f, 1.f, values, gradients, useOpenMP );
+}
+
+void
+ZSimplexNoise::turbulence( const ZPointArray& points, float t, int numOctaves, ZFloatArray& values, ZVectorArray* gradients, bool useOpenMP ) const
+{
+	// the amplitude 1/freq for the frequency 2^o
+	ZSimplexNoise::fBm( points, t, numOctaves, 1.f, 1.f, 0.5f, values, gradients, useOpenMP );
+}
+
 ostream&
 operator<<( ostream& os, const ZSimplexNoise& object )
 {
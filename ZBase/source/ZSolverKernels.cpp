@@ -0,0 +1,517 @@
+//--------------------//
+// ZSolverKernels.cpp //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.29                               //
+//-------------------------------------------------------//
+
+#include <ZelosBase.h>
+
+#ifdef __SSE2__
+ #include <emmintrin.h>
+ #define Z_SOLVER_SSE
+#endif
+
+ZELOS_NAMESPACE_BEGIN
+
+// The float SIMD partial sums are flushed into the double sum every block.
+#define Z_DOT_BLOCK 1024
+
+#ifdef Z_SOLVER_SSE
+
+static inline double
+HorizontalSum( __m128 v )
+{
+	float f[4];
+	_mm_storeu_ps( f, v );
+	return ( ( (double)f[0] + (double)f[1] ) + ( (double)f[2] + (double)f[3] ) );
+}
+
+#endif
+
+void
+GetThreadRange( int N, int& i0, int& i1 )
+{
+	const int numThreads = omp_get_num_threads();
+	const int tid        = omp_get_thread_num();
+
+	const int numBlocks = ( N + 15 ) >> 4;
+
+	i0 = ZMin( (int)( ( (long long)numBlocks * tid     ) / numThreads ) << 4, N );
+	i1 = ZMin( (int)( ( (long long)numBlocks * (tid+1) ) / numThreads ) << 4, N );
+}
+
+double
+SumOverThreads( double value, double* partial )
+{
+	const int numThreads = omp_get_num_threads();
+
+	partial[ omp_get_thread_num() * ZSolverKernelsPad ] = value;
+
+	#pragma omp barrier
+
+	double sum = 0.0;
+
+	FOR( t, 0, numThreads )
+	{
+		sum += partial[ t * ZSolverKernelsPad ];
+	}
+
+	// nobody may overwrite the buffer before all of the threads have read it
+	#pragma omp barrier
+
+	return sum;
+}
+
+void
+SumOverThreads( double& a, double& b, double* partial )
+{
+	const int numThreads = omp_get_num_threads();
+
+	double* myPartial = partial + omp_get_thread_num() * ZSolverKernelsPad;
+	myPartial[0] = a;
+	myPartial[1] = b;
+
+	#pragma omp barrier
+
+	a = b = 0.0;
+
+	FOR( t, 0, numThreads )
+	{
+		a += partial[ t * ZSolverKernelsPad     ];
+		b += partial[ t * ZSolverKernelsPad + 1 ];
+	}
+
+	#pragma omp barrier
+}
+
+double
+DotKernel( const float* a, const float* b, int i0, int i1 )
+{
+	double sum = 0.0;
+	int i = i0;
+
+	#ifdef Z_SOLVER_SSE
+	while( i+4 <= i1 )
+	{
+		const int end = ZMin( i+Z_DOT_BLOCK, i1 );
+
+		__m128 acc = _mm_setzero_ps();
+
+		for( ; i+4<=end; i+=4 )
+		{
+			acc = _mm_add_ps( acc, _mm_mul_ps( _mm_loadu_ps(a+i), _mm_loadu_ps(b+i) ) );
+		}
+
+		sum += HorizontalSum( acc );
+	}
+	#endif
+
+	for( ; i<i1; ++i )
+	{
+		sum += (double)( a[i] * b[i] );
+	}
+
+	return sum;
+}
+
+double
+SpMVDotKernel( const ZSparseMatrix<float>& A, const float* p, float* Ap, int i0, int i1 )
+{
+	const int*   r = &A.r[0];
+	const int*   c = &A.c[0];
+	const float* v = &A.v[0];
+
+	const unsigned int n = (unsigned int)A.n();
+
+	double sum = 0.0;
+
+	for( int i=i0; i<i1; ++i )
+	{
+		float s = 0.f;
+
+		for( int e=r[i]; e<r[i+1]; ++e )
+		{
+			const unsigned int j = (unsigned int)c[e]; // -1 -> out of range
+			if( j < n ) { s += v[e] * p[j]; }
+		}
+
+		Ap[i] = s;
+		sum += (double)( s * p[i] );
+	}
+
+	return sum;
+}
+
+double
+ResidualDotKernel( const ZSparseMatrix<float>& A, const float* x, const float* b, float* r, int i0, int i1 )
+{
+	const int*   row = &A.r[0];
+	const int*   c   = &A.c[0];
+	const float* v   = &A.v[0];
+
+	const unsigned int n = (unsigned int)A.n();
+
+	double sum = 0.0;
+
+	for( int i=i0; i<i1; ++i )
+	{
+		float s = b[i];
+
+		for( int e=row[i]; e<row[i+1]; ++e )
+		{
+			const unsigned int j = (unsigned int)c[e];
+			if( j < n ) { s -= v[e] * x[j]; }
+		}
+
+		r[i] = s;
+		sum += (double)( s * s );
+	}
+
+	return sum;
+}
+
+// MODE 0: y = A*x, and it returns x.y (only for a square matrix: x is read by the row index)
+// MODE 1: y = b - A*x, and it returns y.y
+// MODE 2: y = A*x, and it returns 0
+template <int MODE>
+static double
+SellKernel( const ZSellMatrix& A, const float* x, const float* b, float* y, int i0, int i1 )
+{
+	const int C     = ZSellMatrix::C;
+	const int sigma = A.sigma();
+
+	// the windows starting in [i0,i1)
+	const int ch0 = ( ( i0 + sigma - 1 ) / sigma ) * ( sigma / C );
+	const int ch1 = ZMin( ( ( i1 + sigma - 1 ) / sigma ) * ( sigma / C ), A.numChunks() );
+
+	const int*   chunkStart = &A.chunkStart[0];
+	const int*   row        = &A.row[0];
+
+	double sum = 0.0;
+
+	for( int ch=ch0; ch<ch1; ++ch )
+	{
+		const int start = chunkStart[ch];
+		const int width = ( chunkStart[ch+1] - start ) / C;
+
+		const int*   c = &A.c[0] + start;
+		const float* v = &A.v[0] + start;
+
+		float s[C];
+
+		#ifdef Z_SOLVER_SSE
+		{
+			__m128 acc0 = _mm_setzero_ps();
+			__m128 acc1 = _mm_setzero_ps();
+
+			for( int j=0; j<width; ++j, c+=C, v+=C )
+			{
+				const __m128 x0 = _mm_set_ps( x[c[3]], x[c[2]], x[c[1]], x[c[0]] );
+				const __m128 x1 = _mm_set_ps( x[c[7]], x[c[6]], x[c[5]], x[c[4]] );
+
+				acc0 = _mm_add_ps( acc0, _mm_mul_ps( _mm_loadu_ps(v  ), x0 ) );
+				acc1 = _mm_add_ps( acc1, _mm_mul_ps( _mm_loadu_ps(v+4), x1 ) );
+			}
+
+			_mm_storeu_ps( s,   acc0 );
+			_mm_storeu_ps( s+4, acc1 );
+		}
+		#else
+		{
+			FOR( l, 0, C ) { s[l] = 0.f; }
+
+			for( int j=0; j<width; ++j, c+=C, v+=C )
+			{
+				FOR( l, 0, C ) { s[l] += v[l] * x[c[l]]; }
+			}
+		}
+		#endif
+
+		FOR( l, 0, C )
+		{
+			const int& i = row[ ch*C + l ];
+			if( i < 0 ) { continue; }
+
+			if( MODE == 0 )
+			{
+				y[i] = s[l];
+				sum += (double)( s[l] * x[i] );
+			}
+			else if( MODE == 1 )
+			{
+				y[i] = b[i] - s[l];
+				sum += (double)( y[i] * y[i] );
+			}
+			else
+			{
+				y[i] = s[l];
+			}
+		}
+	}
+
+	return sum;
+}
+
+// MODE 0: y = A*x, and it returns x.y
+// MODE 1: y = b - A*x, and it returns y.y
+template <int MODE>
+static double
+LaplacianKernel( const ZLaplacianOperator& A, const float* x, const float* b, float* y, int i0, int i1 )
+{
+	const int   nx    = A.nx();
+	const int   nxy   = nx * A.ny();
+	const float scale = A.scale();
+
+	double sum = 0.0;
+
+	for( int i=i0; i<i1; ++i )
+	{
+		const unsigned char mask = A.mask(i);
+
+		float s = 0.f;
+
+		if( mask & ZLaplacianOperator::zFluidCell )
+		{
+			float neighbors = 0.f;
+
+			if( mask & ZLaplacianOperator::zFluidI0 ) { neighbors += x[i-1  ]; }
+			if( mask & ZLaplacianOperator::zFluidI1 ) { neighbors += x[i+1  ]; }
+			if( mask & ZLaplacianOperator::zFluidJ0 ) { neighbors += x[i-nx ]; }
+			if( mask & ZLaplacianOperator::zFluidJ1 ) { neighbors += x[i+nx ]; }
+			if( mask & ZLaplacianOperator::zFluidK0 ) { neighbors += x[i-nxy]; }
+			if( mask & ZLaplacianOperator::zFluidK1 ) { neighbors += x[i+nxy]; }
+
+			s = A.diagonal(i) * x[i] - scale * neighbors;
+		}
+
+		if( MODE == 0 )
+		{
+			y[i] = s;
+			sum += (double)( s * x[i] );
+		}
+		else
+		{
+			y[i] = b[i] - s;
+			sum += (double)( y[i] * y[i] );
+		}
+	}
+
+	return sum;
+}
+
+void
+SpMVKernel( const ZSellMatrix& A, const float* x, float* y, int i0, int i1 )
+{
+	SellKernel<2>( A, x, (const float*)0, y, i0, i1 );
+}
+
+double
+SpMVDotKernel( const ZSellMatrix& A, const float* p, float* Ap, int i0, int i1 )
+{
+	return SellKernel<0>( A, p, (const float*)0, Ap, i0, i1 );
+}
+
+double
+SpMVDotKernel( const ZLaplacianOperator& A, const float* p, float* Ap, int i0, int i1 )
+{
+	return LaplacianKernel<0>( A, p, (const float*)0, Ap, i0, i1 );
+}
+
+double
+ResidualDotKernel( const ZSellMatrix& A, const float* x, const float* b, float* r, int i0, int i1 )
+{
+	return SellKernel<1>( A, x, b, r, i0, i1 );
+}
+
+double
+ResidualDotKernel( const ZLaplacianOperator& A, const float* x, const float* b, float* r, int i0, int i1 )
+{
+	return LaplacianKernel<1>( A, x, b, r, i0, i1 );
+}
+
+double
+AxpyDotKernel( float alpha, const float* p, const float* Ap, float* x, float* r, int i0, int i1 )
+{
+	double sum = 0.0;
+	int i = i0;
+
+	#ifdef Z_SOLVER_SSE
+	const __m128 a = _mm_set1_ps( alpha );
+
+	while( i+4 <= i1 )
+	{
+		const int end = ZMin( i+Z_DOT_BLOCK, i1 );
+
+		__m128 acc = _mm_setzero_ps();
+
+		for( ; i+4<=end; i+=4 )
+		{
+			const __m128 xi = _mm_add_ps( _mm_loadu_ps(x+i), _mm_mul_ps( a, _mm_loadu_ps(p +i) ) );
+			const __m128 ri = _mm_sub_ps( _mm_loadu_ps(r+i), _mm_mul_ps( a, _mm_loadu_ps(Ap+i) ) );
+
+			_mm_storeu_ps( x+i, xi );
+			_mm_storeu_ps( r+i, ri );
+
+			acc = _mm_add_ps( acc, _mm_mul_ps( ri, ri ) );
+		}
+
+		sum += HorizontalSum( acc );
+	}
+	#endif
+
+	for( ; i<i1; ++i )
+	{
+		x[i] += alpha * p [i];
+		r[i] -= alpha * Ap[i];
+
+		sum += (double)( r[i] * r[i] );
+	}
+
+	return sum;
+}
+
+void
+AxpyScaleDotKernel( float alpha, const float* p, const float* Ap, const float* invD, float* x, float* r, float* z, int i0, int i1, double& rz, double& rr )
+{
+	rz = rr = 0.0;
+	int i = i0;
+
+	#ifdef Z_SOLVER_SSE
+	const __m128 a = _mm_set1_ps( alpha );
+
+	while( i+4 <= i1 )
+	{
+		const int end = ZMin( i+Z_DOT_BLOCK, i1 );
+
+		__m128 accRZ = _mm_setzero_ps();
+		__m128 accRR = _mm_setzero_ps();
+
+		for( ; i+4<=end; i+=4 )
+		{
+			const __m128 xi = _mm_add_ps( _mm_loadu_ps(x+i), _mm_mul_ps( a, _mm_loadu_ps(p +i) ) );
+			const __m128 ri = _mm_sub_ps( _mm_loadu_ps(r+i), _mm_mul_ps( a, _mm_loadu_ps(Ap+i) ) );
+			const __m128 zi = _mm_mul_ps( _mm_loadu_ps(invD+i), ri );
+
+			_mm_storeu_ps( x+i, xi );
+			_mm_storeu_ps( r+i, ri );
+			_mm_storeu_ps( z+i, zi );
+
+			accRZ = _mm_add_ps( accRZ, _mm_mul_ps( ri, zi ) );
+			accRR = _mm_add_ps( accRR, _mm_mul_ps( ri, ri ) );
+		}
+
+		rz += HorizontalSum( accRZ );
+		rr += HorizontalSum( accRR );
+	}
+	#endif
+
+	for( ; i<i1; ++i )
+	{
+		x[i] += alpha * p [i];
+		r[i] -= alpha * Ap[i];
+		z[i]  = invD[i] * r[i];
+
+		rz += (double)( r[i] * z[i] );
+		rr += (double)( r[i] * r[i] );
+	}
+}
+
+void
+ScaleDotKernel( const float* invD, const float* r, float* z, int i0, int i1, double& rz, double& zz )
+{
+	rz = zz = 0.0;
+	int i = i0;
+
+	#ifdef Z_SOLVER_SSE
+	while( i+4 <= i1 )
+	{
+		const int end = ZMin( i+Z_DOT_BLOCK, i1 );
+
+		__m128 accRZ = _mm_setzero_ps();
+		__m128 accZZ = _mm_setzero_ps();
+
+		for( ; i+4<=end; i+=4 )
+		{
+			const __m128 ri = _mm_loadu_ps( r+i );
+			const __m128 zi = _mm_mul_ps( _mm_loadu_ps(invD+i), ri );
+
+			_mm_storeu_ps( z+i, zi );
+
+			accRZ = _mm_add_ps( accRZ, _mm_mul_ps( ri, zi ) );
+			accZZ = _mm_add_ps( accZZ, _mm_mul_ps( zi, zi ) );
+		}
+
+		rz += HorizontalSum( accRZ );
+		zz += HorizontalSum( accZZ );
+	}
+	#endif
+
+	for( ; i<i1; ++i )
+	{
+		z[i] = invD[i] * r[i];
+
+		rz += (double)( r[i] * z[i] );
+		zz += (double)( z[i] * z[i] );
+	}
+}
+
+void
+XpbyKernel( const float* z, float beta, float* p, int i0, int i1 )
+{
+	int i = i0;
+
+	#ifdef Z_SOLVER_SSE
+	const __m128 b = _mm_set1_ps( beta );
+
+	for( ; i+4<=i1; i+=4 )
+	{
+		_mm_storeu_ps( p+i, _mm_add_ps( _mm_loadu_ps(z+i), _mm_mul_ps( b, _mm_loadu_ps(p+i) ) ) );
+	}
+	#endif
+
+	for( ; i<i1; ++i )
+	{
+		p[i] = z[i] + beta * p[i];
+	}
+}
+
+void
+InverseDiagonalKernel( const ZSparseMatrix<float>& A, float* invD, int i0, int i1 )
+{
+	for( int i=i0; i<i1; ++i )
+	{
+		invD[i] = 0.f;
+
+		for( int e=A.r[i]; e<A.r[i+1]; ++e )
+		{
+			if( ( A.c[e] == i ) && ( A.v[e] != 0.f ) )
+			{
+				invD[i] = 1.f / A.v[e];
+				break;
+			}
+		}
+	}
+}
+
+void
+InverseDiagonalKernel( const ZSellMatrix& A, float* invD, int i0, int i1 )
+{
+	for( int i=i0; i<i1; ++i )
+	{
+		invD[i] = ( A.diag[i] != 0.f ) ? ( 1.f / A.diag[i] ) : 0.f;
+	}
+}
+
+void
+InverseDiagonalKernel( const ZLaplacianOperator& A, float* invD, int i0, int i1 )
+{
+	for( int i=i0; i<i1; ++i )
+	{
+		const float d = A.diagonal(i);
+		invD[i] = ( d != 0.f ) ? ( 1.f / d ) : 0.f;
+	}
+}
+
+ZELOS_NAMESPACE_END
+
@@ -0,0 +1,231 @@
+//------------------------//
+// ZSparseField3DBase.cpp //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.25                               //
+//-------------------------------------------------------//
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+ZSparseField3DBase::ZSparseField3DBase()
+{
+	ZSparseField3DBase::reset();
+}
+
+ZSparseField3DBase::ZSparseField3DBase( const ZGrid3D& grid, ZFieldLocation::FieldLocation loc )
+{
+	ZSparseField3DBase::set( grid, loc );
+}
+
+void
+ZSparseField3DBase::set( const ZGrid3D& grid, ZFieldLocation::FieldLocation loc )
+{
+	ZGrid3D::operator=( grid );
+
+	switch( loc )
+	{
+		case ZFieldLocation::zCell:
+		{
+			_iMax = _nx-1;
+			_jMax = _ny-1;
+			_kMax = _nz-1;
+
+			break;
+		}
+
+		case ZFieldLocation::zNode:
+		{
+			_iMax = _nx;
+			_jMax = _ny;
+			_kMax = _nz;
+
+			break;
+		}
+
+		default:
+		{
+			cout << "Error@ZSparseField3DBase::set(): Not supported location." << endl;
+			ZSparseField3DBase::reset();
+			return;
+		}
+	}
+
+	_location = loc;
+
+	_tnx = ( _iMax + tileWidth ) >> tileLog2;
+	_tny = ( _jMax + tileWidth ) >> tileLog2;
+	_tnz = ( _kMax + tileWidth ) >> tileLog2;
+
+	std::vector<int>( numTiles(), -1 ).swap( _tileSlot );
+	_tileCoord.clear();
+}
+
+void
+ZSparseField3DBase::reset()
+{
+	ZGrid3D::reset();
+
+	_location = ZFieldLocation::zNone;
+
+	_iMax = _jMax = _kMax = -1;
+	_tnx  = _tny  = _tnz  = 0;
+
+	std::vector<int>().swap( _tileSlot );
+	_tileCoord.clear();
+}
+
+bool
+ZSparseField3DBase::directComputable( const ZSparseField3DBase& other ) const
+{
+	if( _location != other._location ) { return false; }
+	if( _iMax != other._iMax || _jMax != other._jMax || _kMax != other._kMax ) { return false; }
+	return true;
+}
+
+size_t
+ZSparseField3DBase::numElements() const
+{
+	if( _iMax < 0 ) { return 0; }
+	return ( (size_t)(_iMax+1) * (size_t)(_jMax+1) * (size_t)(_kMax+1) );
+}
+
+size_t
+ZSparseField3DBase::numTiles() const
+{
+	return ( (size_t)_tnx * (size_t)_tny * (size_t)_tnz );
+}
+
+int
+ZSparseField3DBase::numActiveTiles() const
+{
+	return _tileCoord.length();
+}
+
+size_t
+ZSparseField3DBase::numActiveElements() const
+{
+	return ( (size_t)_tileCoord.length() * (size_t)tileSize );
+}
+
+int
+ZSparseField3DBase::_addTile( int ti, int tj, int tk, bool& added )
+{
+	int& slot = _tileSlot[ tileIndex( ti, tj, tk ) ];
+
+	added = ( slot < 0 );
+
+	if( added )
+	{
+		slot = _tileCoord.length();
+		_tileCoord.push_back( ZInt3( ti, tj, tk ) );
+	}
+
+	return slot;
+}
+
+void
+ZSparseField3DBase::write( ofstream& fout ) const
+{
+	ZGrid3D::write( fout );
+	fout.write( (char*)&_location, sizeof(int) );
+	_tileCoord.write( fout, true );
+}
+
+// Everything from the file is checked before it is used as an index,
+// so a truncated or corrupt file fails here instead of writing out of the tile table.
+bool
+ZSparseField3DBase::read( ifstream& fin )
+{
+	ZGrid3D grid;
+	grid.read( fin );
+
+	ZFieldLocation::FieldLocation loc;
+	fin.read( (char*)&loc, sizeof(int) );
+
+	if( fin.fail() )
+	{
+		cout << "Error@ZSparseField3DBase::read(): Failed to read the header." << endl;
+		ZSparseField3DBase::reset();
+		return false;
+	}
+
+	if( ( grid.nx() <= 0 ) || ( grid.ny() <= 0 ) || ( grid.nz() <= 0 ) )
+	{
+		cout << "Error@ZSparseField3DBase::read(): Invalid resolution." << endl;
+		ZSparseField3DBase::reset();
+		return false;
+	}
+
+	if( ( loc != ZFieldLocation::zCell ) && ( loc != ZFieldLocation::zNode ) )
+	{
+		cout << "Error@ZSparseField3DBase::read(): Invalid location." << endl;
+		ZSparseField3DBase::reset();
+		return false;
+	}
+
+	ZSparseField3DBase::set( grid, loc );
+
+	int numActive = 0;
+	fin.read( (char*)&numActive, sizeof(int) );
+
+	if( fin.fail() || ( numActive < 0 ) || ( (size_t)numActive > numTiles() ) )
+	{
+		cout << "Error@ZSparseField3DBase::read(): Invalid number of active tiles." << endl;
+		ZSparseField3DBase::reset();
+		return false;
+	}
+
+	_tileCoord.setLength( numActive );
+	_tileCoord.read( fin, false );
+
+	if( fin.fail() )
+	{
+		cout << "Error@ZSparseField3DBase::read(): Failed to read the active tiles." << endl;
+		ZSparseField3DBase::reset();
+		return false;
+	}
+
+	FOR( s, 0, numActive )
+	{
+		const ZInt3& t = _tileCoord[s];
+
+		if( ( t[0] < 0 ) || ( t[0] >= _tnx ) || ( t[1] < 0 ) || ( t[1] >= _tny ) || ( t[2] < 0 ) || ( t[2] >= _tnz ) )
+		{
+			cout << "Error@ZSparseField3DBase::read(): Invalid tile coordinates." << endl;
+			ZSparseField3DBase::reset();
+			return false;
+		}
+
+		int& slot = _tileSlot[ tileIndex( t[0], t[1], t[2] ) ];
+
+		if( slot >= 0 )
+		{
+			cout << "Error@ZSparseField3DBase::read(): Duplicated tile." << endl;
+			ZSparseField3DBase::reset();
+			return false;
+		}
+
+		slot = s;
+	}
+
+	return true;
+}
+
+ostream&
+operator<<( ostream& os, const ZSparseField3DBase& object )
+{
+	os << "<ZSparseField3DBase>" << endl;
+	os << " resolution  : " << object.nx() << " x " << object.ny() << " x " << object.nz() << endl;
+	os << " dimension   : " << object.lx() << " x " << object.ly() << " x " << object.lz() << endl;
+	os << " cell size   : " << object.dx() << " x " << object.dy() << " x " << object.dz() << endl;
+	os << " domain      : " << object.minPoint() << " ~ " << object.maxPoint() << endl;
+	os << " location    : " << ZFieldLocation::name(object.location()) << endl;
+	os << " active tiles: " << object.numActiveTiles() << " / " << object.numTiles() << endl;
+	os << endl;
+	return os;
+}
+
+ZELOS_NAMESPACE_END
+
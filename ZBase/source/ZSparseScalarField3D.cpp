@@ -0,0 +1,119 @@
+//--------------------------//
+// ZSparseScalarField3D.cpp //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.25                               //
+//-------------------------------------------------------//
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+ZSparseScalarField3D::ZSparseScalarField3D()
+: ZSparseField3D<float>()
+{
+}
+
+ZSparseScalarField3D::ZSparseScalarField3D( const ZGrid3D& grid, ZFieldLocation::FieldLocation loc, float background )
+: ZSparseField3D<float>()
+{
+	set( grid, loc, background );
+}
+
+ZSparseScalarField3D::ZSparseScalarField3D( const char* filePathName )
+: ZSparseField3D<float>()
+{
+	load( filePathName );
+}
+
+void
+ZSparseScalarField3D::set( const ZGrid3D& grid, ZFieldLocation::FieldLocation loc, float background )
+{
+	ZSparseField3D<float>::set( grid, loc, background );
+}
+
+void
+ZSparseScalarField3D::fromDense( const ZScalarField3D& dense, float tolerance, bool useOpenMP )
+{
+	ZSparseField3D<float>::_fromDense( dense, tolerance, useOpenMP );
+}
+
+void
+ZSparseScalarField3D::toDense( ZScalarField3D& dense, bool useOpenMP ) const
+{
+	ZSparseField3D<float>::_toDense( dense, useOpenMP );
+	dense.setMinMax( useOpenMP );
+}
+
+const ZString
+ZSparseScalarField3D::dataType() const
+{
+	return ZString( "ZSparseScalarField3D" );
+}
+
+bool
+ZSparseScalarField3D::save( const char* filePathName ) const
+{
+	ofstream fout( filePathName, ios::out|ios::binary|ios::trunc );
+
+	if( fout.fail() || !fout.is_open() )
+	{
+		cout << "Error@ZSparseScalarField3D::save(): Failed to save file: " << filePathName << endl;
+		return false;
+	}
+
+	ZSparseScalarField3D::dataType().write( fout, true );
+	ZSparseField3DBase::write( fout );
+	ZSparseField3D<float>::_writeData( fout );
+	fout.close();
+	return true;
+}
+
+bool
+ZSparseScalarField3D::load( const char* filePathName )
+{
+	ifstream fin( filePathName, ios::in|ios::binary );
+
+	if( fin.fail() )
+	{
+		reset();
+		cout << "Error@ZSparseScalarField3D::load(): Failed to load file " << filePathName << endl;
+		return false;
+	}
+
+	ZString type;
+	type.read( fin, true );
+	if( type != dataType() )
+	{
+		cout << "Error@ZSparseScalarField3D::load(): Data type mismatch." << endl;
+		reset();
+		return false;
+	}
+	if( !ZSparseField3DBase::read( fin ) || !ZSparseField3D<float>::_readData( fin ) )
+	{
+		cout << "Error@ZSparseScalarField3D::load(): Invalid file: " << filePathName << endl;
+		reset();
+		return false;
+	}
+
+	fin.close();
+	return true;
+}
+
+ostream&
+operator<<( ostream& os, const ZSparseScalarField3D& object )
+{
+	os << "<ZSparseScalarField3D>" << endl;
+	os << " resolution  : " << object.nx() << " x " << object.ny() << " x " << object.nz() << endl;
+	os << " dimension   : " << object.lx() << " x " << object.ly() << " x " << object.lz() << endl;
+	os << " cell size   : " << object.dx() << " x " << object.dy() << " x " << object.dz() << endl;
+	os << " domain      : " << object.minPoint() << " ~ " << object.maxPoint() << endl;
+	os << " location    : " << ZFieldLocation::name(object.location()) << endl;
+	os << " active tiles: " << object.numActiveTiles() << " / " << object.numTiles() << endl;
+	os << " memory size : " << object.usedMemorySize(ZDataUnit::zMegabytes) << " mb." << endl;
+	os << endl;
+	return os;
+}
+
+ZELOS_NAMESPACE_END
+
@@ -0,0 +1,118 @@
+//--------------------------//
+// ZSparseVectorField3D.cpp //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.25                               //
+//-------------------------------------------------------//
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+ZSparseVectorField3D::ZSparseVectorField3D()
+: ZSparseField3D<ZVector>()
+{
+}
+
+ZSparseVectorField3D::ZSparseVectorField3D( const ZGrid3D& grid, ZFieldLocation::FieldLocation loc, const ZVector& background )
+: ZSparseField3D<ZVector>()
+{
+	set( grid, loc, background );
+}
+
+ZSparseVectorField3D::ZSparseVectorField3D( const char* filePathName )
+: ZSparseField3D<ZVector>()
+{
+	load( filePathName );
+}
+
+void
+ZSparseVectorField3D::set( const ZGrid3D& grid, ZFieldLocation::FieldLocation loc, const ZVector& background )
+{
+	ZSparseField3D<ZVector>::set( grid, loc, background );
+}
+
+void
+ZSparseVectorField3D::fromDense( const ZVectorField3D& dense, float tolerance, bool useOpenMP )
+{
+	ZSparseField3D<ZVector>::_fromDense( dense, tolerance, useOpenMP );
+}
+
+void
+ZSparseVectorField3D::toDense( ZVectorField3D& dense, bool useOpenMP ) const
+{
+	ZSparseField3D<ZVector>::_toDense( dense, useOpenMP );
+}
+
+const ZString
+ZSparseVectorField3D::dataType() const
+{
+	return ZString( "ZSparseVectorField3D" );
+}
+
+bool
+ZSparseVectorField3D::save( const char* filePathName ) const
+{
+	ofstream fout( filePathName, ios::out|ios::binary|ios::trunc );
+
+	if( fout.fail() || !fout.is_open() )
+	{
+		cout << "Error@ZSparseVectorField3D::save(): Failed to save file: " << filePathName << endl;
+		return false;
+	}
+
+	ZSparseVectorField3D::dataType().write( fout, true );
+	ZSparseField3DBase::write( fout );
+	ZSparseField3D<ZVector>::_writeData( fout );
+	fout.close();
+	return true;
+}
+
+bool
+ZSparseVectorField3D::load( const char* filePathName )
+{
+	ifstream fin( filePathName, ios::in|ios::binary );
+
+	if( fin.fail() )
+	{
+		reset();
+		cout << "Error@ZSparseVectorField3D::load(): Failed to load file " << filePathName << endl;
+		return false;
+	}
+
+	ZString type;
+	type.read( fin, true );
+	if( type != dataType() )
+	{
+		cout << "Error@ZSparseVectorField3D::load(): Data type mismatch." << endl;
+		reset();
+		return false;
+	}
+	if( !ZSparseField3DBase::read( fin ) || !ZSparseField3D<ZVector>::_readData( fin ) )
+	{
+		cout << "Error@ZSparseVectorField3D::load(): Invalid file: " << filePathName << endl;
+		reset();
+		return false;
+	}
+
+	fin.close();
+	return true;
+}
+
+ostream&
+operator<<( ostream& os, const ZSparseVectorField3D& object )
+{
+	os << "<ZSparseVectorField3D>" << endl;
+	os << " resolution  : " << object.nx() << " x " << object.ny() << " x " << object.nz() << endl;
+	os << " dimension   : " << object.lx() << " x " << object.ly() << " x " << object.lz() << endl;
+	os << " cell size   : " << object.dx() << " x " << object.dy() << " x " << object.dz() << endl;
+	os << " domain      : " << object.minPoint() << " ~ " << object.maxPoint() << endl;
+	os << " location    : " << ZFieldLocation::name(object.location()) << endl;
+	os << " active tiles: " << object.numActiveTiles() << " / " << object.numTiles() << endl;
+	os << " memory size : " << object.usedMemorySize(ZDataUnit::zMegabytes) << " mb." << endl;
+	os << endl;
+	return os;
+}
+
+ZELOS_NAMESPACE_END
+
@@ -0,0 +1,200 @@
+//-----------------//
+// ZTiledImage.cpp //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.30                               //
+//-------------------------------------------------------//
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+ZTiledImage::ZTiledImage()
+: _numChannels(0)
+{}
+
+ZTiledImage::ZTiledImage( const ZImageMap& img, bool useOpenMP )
+: _numChannels(0)
+{
+	ZTiledImage::set( img, useOpenMP );
+}
+
+void
+ZTiledImage::reset()
+{
+	_numChannels = 0;
+	_levels.clear();
+	_filePathName.clear();
+}
+
+void
+ZTiledImage::_allocate( Level& L, int w, int h )
+{
+	L.width     = w;
+	L.height    = h;
+	L.numTilesX = ( w + TileSize-1 ) / TileSize;
+
+	const int numTilesY = ( h + TileSize-1 ) / TileSize;
+
+	L.data.resize( (size_t)L.numTilesX * numTilesY * TileSize*TileSize * _numChannels );
+}
+
+bool
+ZTiledImage::set( const ZImageMap& img, bool useOpenMP )
+{
+	ZTiledImage::reset();
+
+	const int w = img.width();
+	const int h = img.height();
+	const int c = img.numChannels();
+
+	if( w<1 || h<1 || c<1 || !img.pointer() )
+	{
+		cout << "Error@ZTiledImage::set(): Invalid image." << endl;
+		return false;
+	}
+
+	_numChannels  = c;
+	_filePathName = img.filePathName();
+
+	int numLevels = 1;
+	{
+		int s = ZMax( w, h );
+		while( s > 1 ) { s /= 2; ++numLevels; }
+	}
+
+	_levels.resize( numLevels );
+
+	// level 0: from the scanlines into the tiles
+	{
+		Level& L = _levels[0];
+		_allocate( L, w, h );
+
+		#pragma omp parallel for if( useOpenMP )
+		FOR( j, 0, h )
+		{
+			FOR( i, 0, w )
+			{
+				const int tile = (j/TileSize)*L.numTilesX + (i/TileSize);
+				const int pix  = (j%TileSize)*TileSize    + (i%TileSize);
+
+				float* dst = &L.data[ (size_t)c*( (size_t)tile*TileSize*TileSize + pix ) ];
+
+				FOR( k, 0, c ) { dst[k] = img(i,j,k); }
+			}
+		}
+	}
+
+	// the coarser levels by the 2x2 box filter
+	FOR( l, 1, numLevels )
+	{
+		const Level& P = _levels[l-1];
+		Level&       L = _levels[l];
+
+		_allocate( L, ZMax( P.width/2, 1 ), ZMax( P.height/2, 1 ) );
+
+		#pragma omp parallel for if( useOpenMP )
+		FOR( j, 0, L.height )
+		{
+			FOR( i, 0, L.width )
+			{
+				const int tile = (j/TileSize)*L.numTilesX + (i/TileSize);
+				const int pix  = (j%TileSize)*TileSize    + (i%TileSize);
+
+				float* dst = &L.data[ (size_t)c*( (size_t)tile*TileSize*TileSize + pix ) ];
+
+				FOR( k, 0, c )
+				{
+					dst[k] = 0.25f * ( _texel( P, 2*i, 2*j,   k ) + _texel( P, 2*i+1, 2*j,   k )
+									 + _texel( P, 2*i, 2*j+1, k ) + _texel( P, 2*i+1, 2*j+1, k ) );
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+float
+ZTiledImage::_bilinear( const Level& L, float u, float v, int k ) const
+{
+	// the pixel centers are at (i+0.5, j+0.5).
+	const float x = u * L.width - 0.5f;
+	const float y = (1-v) * L.height - 0.5f;
+
+	const int i = (int)floorf( x );
+	const int j = (int)floorf( y );
+
+	const float fx = x - i;
+	const float fy = y - j;
+
+	const float v00 = _texel( L, i,   j,   k );
+	const float v10 = _texel( L, i+1, j,   k );
+	const float v01 = _texel( L, i,   j+1, k );
+	const float v11 = _texel( L, i+1, j+1, k );
+
+	return ( ( v00*(1-fx) + v10*fx ) * (1-fy) + ( v01*(1-fx) + v11*fx ) * fy );
+}
+
+float
+ZTiledImage::sample( float u, float v, float lod, int k ) const
+{
+	const int numLevels = (int)_levels.size();
+
+	lod = ZClamp( lod, 0.f, (float)(numLevels-1) );
+
+	const int   l = ZMin( (int)lod, numLevels-1 );
+	const float f = lod - l;
+
+	const float v0 = _bilinear( _levels[l], u, v, k );
+	if( ( f <= 0.f ) || ( l+1 >= numLevels ) ) { return v0; }
+
+	const float v1 = _bilinear( _levels[l+1], u, v, k );
+
+	return ( v0*(1-f) + v1*f );
+}
+
+float
+ZTiledImage::intensity( float u, float v, float lod ) const
+{
+	if( _numChannels < 3 ) { return ZTiledImage::sample( u, v, lod, 0 ); }
+
+	return ( 0.299f * ZTiledImage::sample( u, v, lod, 0 )
+		   + 0.587f * ZTiledImage::sample( u, v, lod, 1 )
+		   + 0.114f * ZTiledImage::sample( u, v, lod, 2 ) );
+}
+
+double
+ZTiledImage::usedMemorySize( ZDataUnit::DataUnit dataUnit ) const
+{
+	double bytes = 0.0;
+	FOR( l, 0, (int)_levels.size() ) { bytes += (double)_levels[l].data.size() * sizeof(float); }
+
+	switch( dataUnit )
+	{
+		case ZDataUnit::zBytes:     { return bytes; }
+		case ZDataUnit::zKilobytes: { return (bytes/1024.0); }
+		case ZDataUnit::zMegabytes: { return (bytes/ZPow2(1024.0)); }
+		case ZDataUnit::zGigabytes: { return (bytes/ZPow3(1024.0)); }
+		default: { cout << "Error@ZTiledImage::usedMemorySize(): Invalid data unit." << endl; return 0.0; }
+	}
+}
+
+ostream&
+operator<<( ostream& os, const ZTiledImage& object )
+{
+	os << "<ZTiledImage>" << endl;
+	os << " file        : " << object.filePathName() << endl;
+	if( !object.empty() )
+	{
+		os << " resolution  : " << object.width() << " x " << object.height() << endl;
+		os << " channels    : " << object.numChannels() << endl;
+		os << " levels      : " << object.numLevels() << endl;
+	}
+	os << " memory size : " << object.usedMemorySize(ZDataUnit::zMegabytes) << " mb." << endl;
+	os << endl;
+	return os;
+}
+
+ZELOS_NAMESPACE_END
+
@@ -432,17 +432,15 @@ ZTriMesh::getTriangleCenterValue( const char* densityMapFilePathName, ZFloatArra
 
 	values.setLength( nTriangles );
 
-	ZImageMap densityMap;
-	if( !densityMap.load( densityMapFilePathName ) )
+	// (decoded only once for all the calls by the image cache)
+	std::shared_ptr<const ZTiledImage> densityMap = ZImageCache::global().get( densityMapFilePathName );
+
+	if( !densityMap )
 	{
 		values.fill( 1.f );
 		return;
 	}
 
-	// image width / height
-	const int w = densityMap.width();
-	const int h = densityMap.height();
-
 	#pragma omp parallel for if( useOpenMP )
 	FOR( i, 0, nTriangles )
 	{
@@ -458,11 +456,11 @@ ZTriMesh::getTriangleCenterValue( const char* densityMapFilePathName, ZFloatArra
 
 		if( channels < 0 ) {
 
-			values[i] = densityMap.intensity( uC, vC );
+			values[i] = densityMap->intensity( uC, vC );
 
 		} else {
 
-			values[i] = densityMap.fastValue( uC, vC, channels );
+			values[i] = densityMap->fastValue( uC, vC, channels );
 
 		}
 	}
@@ -646,6 +644,44 @@ ZTriMesh::load( const char* filePathName )
 	return true;
 }
 
+bool
+ZTriMesh::saveCache( const char* filePathName ) const
+{
+	ZCacheWriter cache;
+	if( !cache.open( filePathName ) ) { return false; }
+
+	if( !cache.add( "p",    p    ) ) { cache.abort(); return false; }
+	if( !cache.add( "v012", v012 ) ) { cache.abort(); return false; }
+	if( !cache.add( "uv",   uv   ) ) { cache.abort(); return false; }
+
+	return cache.close();
+}
+
+bool
+ZTriMesh::loadCache( const char* filePathName )
+{
+	reset();
+
+	ZCacheReader cache;
+
+	if( !cache.open( filePathName ) )
+	{
+		cout << "Error@ZTriMesh::loadCache(): Failed to load file." << endl;
+		return false;
+	}
+
+	if( !cache.read( "p", p ) || !cache.read( "v012", v012 ) )
+	{
+		cout << "Error@ZTriMesh::loadCache(): Invalid cache file: " << filePathName << endl;
+		reset();
+		return false;
+	}
+
+	cache.read( "uv", uv ); // optional
+
+	return true;
+}
+
 void
 ZTriMesh::drawVertices() const
 {
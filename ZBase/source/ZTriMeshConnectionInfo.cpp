@@ -2,17 +2,80 @@
 // ZTriMeshConnectionInfo.cpp //
 //-------------------------------------------------------//
 // author: Wanho Choi @ Dexter Studios                   //
-// last update: 2018.10.24                               //
+// last update: 2019.03.30                               //
 //-------------------------------------------------------//
 
 #include <ZelosBase.h>
 
 ZELOS_NAMESPACE_BEGIN
 
+// It groups the entries 0,...,m-1 by their keys in [0,n) (the negative keys are skipped).
+// The counting sort is stable, so the entries of each key are in the ascending order.
+static void
+GroupByKeys( int n, const ZIntArray& keys, ZIntArray& offset, ZIntArray& index )
+{
+	const int m = keys.length();
+
+	offset.setLength( n+1 );
+
+	FOR( i, 0, m )
+	{
+		if( keys[i] >= 0 ) { ++offset[keys[i]+1]; }
+	}
+
+	FOR( i, 0, n )
+	{
+		offset[i+1] += offset[i];
+	}
+
+	index.setLength( offset[n], false );
+
+	ZIntArray next( offset );
+
+	FOR( i, 0, m )
+	{
+		if( keys[i] >= 0 ) { index[ next[keys[i]]++ ] = i; }
+	}
+}
+
+static void
+CopyToList( const ZIntArray& offset, const ZIntArray& index, ZIntArrayList& list, bool useOpenMP )
+{
+	const int n = offset.length()-1;
+
+	list.reset();
+	list.resize( ZMax( n, 0 ) );
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( i, 0, n )
+	{
+		const int count = offset[i+1] - offset[i];
+		if( count == 0 ) { continue; }
+
+		list[i].setLength( count, false );
+		memcpy( (char*)list[i].pointer(), (char*)index.pointer(offset[i]), count*sizeof(int) );
+	}
+}
+
+static double
+ListMemorySize( const ZIntArrayList& list )
+{
+	double bytes = 0.0;
+
+	FOR( i, 0, list.length() )
+	{
+		bytes += list[i].usedMemorySize();
+	}
+
+	return bytes;
+}
+
 ZTriMeshConnectionInfo::ZTriMeshConnectionInfo()
+: _numVertices(0), _numTriangles(0), _numEdges(0)
 {}
 
 ZTriMeshConnectionInfo::ZTriMeshConnectionInfo( const ZTriMesh& mesh )
+: _numVertices(0), _numTriangles(0), _numEdges(0)
 {
 	set( mesh );
 }
@@ -22,6 +85,7 @@ ZTriMeshConnectionInfo::reset()
 {
 	_numVertices  = 0;
 	_numTriangles = 0;
+	_numEdges     = 0;
 
 	v2v.reset();
 	e2v.reset();
@@ -34,11 +98,25 @@ ZTriMeshConnectionInfo::reset()
 	v2t.reset();
 	e2t.reset();
 	t2t.reset();
+
+	heTwin.reset();
+	heEdge.reset();
+	vertexHe.reset();
+
+	v2vOffset.reset();   v2vIndex.reset();
+	e2vOffset.reset();   e2vIndex.reset();
+	t2vOffset.reset();   t2vIndex.reset();
 }
 
 void
 ZTriMeshConnectionInfo::set( const ZTriMesh& mesh )
 {
+	// The topology of a deforming mesh does not change, so the tables are still valid.
+	if( ( _numTriangles > 0 ) && ( _numVertices == mesh.numVertices() ) && ( _numTriangles == mesh.numTriangles() ) )
+	{
+		if( !memcmp( (char*)v2t.pointer(), (char*)mesh.v012.pointer(), _numTriangles*sizeof(ZInt3) ) ) { return; }
+	}
+
 	reset();
 
 	_numVertices  = mesh.numVertices();
@@ -48,227 +126,347 @@ ZTriMeshConnectionInfo::set( const ZTriMesh& mesh )
 }
 
 void
-ZTriMeshConnectionInfo::calculate_v2v()
+ZTriMeshConnectionInfo::build( bool useOpenMP )
 {
-    if( v2v.length() > 0 ) { return; } // already done
-
-    v2v.reset();
-    v2v.resize( _numVertices );
-
-    FOR( iTriangle, 0, _numTriangles )
-    {
-        const int& v0 = v2t[iTriangle][0];
-        const int& v1 = v2t[iTriangle][1];
-        const int& v2 = v2t[iTriangle][2];
-
-        ZIntArray& list0 = v2v[v0];
-        if( list0.findTheFirstIndex( v1 ) < 0 ) { list0.append( v1 ); }
-        if( list0.findTheFirstIndex( v2 ) < 0 ) { list0.append( v2 ); }
+	ZTriMeshConnectionInfo::build_halfEdges( useOpenMP );
+	ZTriMeshConnectionInfo::build_v2v( useOpenMP );
+	ZTriMeshConnectionInfo::build_e2v( useOpenMP );
+	ZTriMeshConnectionInfo::build_t2v( useOpenMP );
+}
 
-        ZIntArray& list1 = v2v[v1];
-        if( list1.findTheFirstIndex( v2 ) < 0 ) { list1.append( v2 ); }
-        if( list1.findTheFirstIndex( v0 ) < 0 ) { list1.append( v0 ); }
+void
+ZTriMeshConnectionInfo::build_halfEdges( bool useOpenMP )
+{
+	ZPROFILE_SCOPE( "ZTriMeshConnectionInfo::build_halfEdges" );
 
-        ZIntArray& list2 = v2v[v2];
-        if( list2.findTheFirstIndex( v0 ) < 0 ) { list2.append( v0 ); }
-        if( list2.findTheFirstIndex( v1 ) < 0 ) { list2.append( v1 ); }
-    }
+	if( heEdge.length() > 0 ) { return; } // already done
+
+	const int nv = _numVertices;
+	const int nt = _numTriangles;
+	const int nh = 3 * nt;
+
+	if( nh == 0 ) { return; }
+
+	// the key of each half-edge: (the smaller vertex, the larger vertex)
+	ZIntArray lower( nh ), upper( nh );
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( t, 0, nt )
+	{
+		const ZInt3& v = v2t[t];
+
+		FOR( j, 0, 3 )
+		{
+			const int a = v[j];
+			const int b = v[(j==2)?0:(j+1)];
+
+			lower[3*t+j] = ( a == b ) ? -1 : ZMin( a, b ); // -1: degenerate
+			upper[3*t+j] = ZMax( a, b );
+		}
+	}
+
+	// the half-edges in the buckets of the smaller vertex sorted by the larger one
+	// (The half-edges of an edge are contiguous.)
+	ZIntArray offset, index;
+	GroupByKeys( nv, lower, offset, index );
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( v, 0, nv )
+	{
+		std::sort( index.pointer(offset[v]), index.pointer(offset[v+1]), [&]( int h0, int h1 )
+		{
+			if( upper[h0] != upper[h1] ) { return ( upper[h0] < upper[h1] ); }
+			return ( h0 < h1 );
+		} );
+	}
+
+	// the edges of each bucket
+	ZIntArray first( nv+1 );
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( v, 0, nv )
+	{
+		int count = 0;
+
+		FOR( i, offset[v], offset[v+1] )
+		{
+			if( ( i == offset[v] ) || ( upper[index[i]] != upper[index[i-1]] ) ) { ++count; }
+		}
+
+		first[v+1] = count;
+	}
+
+	FOR( v, 0, nv )
+	{
+		first[v+1] += first[v];
+	}
+
+	_numEdges = first[nv];
+
+	v2e.setLength( _numEdges, false );
+	t2e.setLength( _numEdges, false );
+
+	heEdge.setLength( nh, false );   heEdge.fill( -1 );
+	heTwin.setLength( nh, false );   heTwin.fill( -1 );
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( v, 0, nv )
+	{
+		int e = first[v];
+		int i = offset[v];
+
+		while( i < offset[v+1] )
+		{
+			const int h0 = index[i];
+
+			int j = i+1;
+			while( ( j < offset[v+1] ) && ( upper[index[j]] == upper[h0] ) ) { ++j; }
+
+			FOR( k, i, j ) { heEdge[index[k]] = e; }
+
+			v2e[e] = ZInt2( v, upper[h0] );
+			t2e[e] = ZInt2( h0/3, ( j-i > 1 ) ? ( index[i+1]/3 ) : -1 );
+
+			if( j-i == 2 )
+			{
+				const int h1 = index[i+1];
+				heTwin[h0] = h1;
+				heTwin[h1] = h0;
+			}
+
+			++e;
+			i = j;
+		}
+	}
+
+	e2t.setLength( nt, false );
+	t2t.setLength( nt, false );
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( t, 0, nt )
+	{
+		FOR( j, 0, 3 )
+		{
+			const int h = 3*t+j;
+
+			e2t[t][j] = heEdge[h];
+			t2t[t][j] = ( heTwin[h] < 0 ) ? -1 : ( heTwin[h] / 3 );
+		}
+	}
+
+	// an outgoing half-edge of each vertex
+	// The boundary one is preferred, so the rotation h -> heTwin[hePrev(h)] visits all the triangles around it.
+	vertexHe.setLength( nv, false );
+	vertexHe.fill( -1 );
+
+	FOR( t, 0, nt )
+	{
+		FOR( j, 0, 3 )
+		{
+			const int h = 3*t+j;
+			if( heEdge[h] < 0 ) { continue; }
+
+			int& out = vertexHe[ v2t[t][j] ];
+
+			if( ( out < 0 ) || ( ( heTwin[h] < 0 ) && ( heTwin[out] >= 0 ) ) ) { out = h; }
+		}
+	}
 }
 
 void
-ZTriMeshConnectionInfo::calculate_e2v()
+ZTriMeshConnectionInfo::build_v2v( bool useOpenMP )
 {
-    if( e2v.length() > 0 ) { return; } // already done
+	ZPROFILE_SCOPE( "ZTriMeshConnectionInfo::build_v2v" );
 
-    ZTriMeshConnectionInfo::calculate_v2e();
+	if( v2vOffset.length() > 0 ) { return; } // already done
 
-    e2v.reset();
-    e2v.resize( _numVertices );
+	ZTriMeshConnectionInfo::build_halfEdges( useOpenMP );
 
-    const int numEdges = v2e.length();
+	// both directions of each edge
+	// The edges are in the order of their keys, so the result is in the ascending order.
+	ZIntArray keys( 2*_numEdges );
 
-    FOR( iEdge, 0, numEdges )
-    {
-        const int& v0 = v2e[iEdge][0];
-        const int& v1 = v2e[iEdge][1];
+	#pragma omp parallel for if( useOpenMP )
+	FOR( e, 0, _numEdges )
+	{
+		keys[2*e  ] = v2e[e][0];
+		keys[2*e+1] = v2e[e][1];
+	}
 
-        e2v[v0].append( iEdge );
-        e2v[v1].append( iEdge );
-    }
+	GroupByKeys( _numVertices, keys, v2vOffset, v2vIndex );
+
+	const int n = v2vIndex.length();
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( i, 0, n )
+	{
+		const int k = v2vIndex[i];
+		v2vIndex[i] = v2e[k/2][1-(k%2)];
+	}
 }
 
 void
-ZTriMeshConnectionInfo::calculate_t2v()
+ZTriMeshConnectionInfo::build_e2v( bool useOpenMP )
 {
-    if( t2v.length() > 0 ) { return; } // already done
+	ZPROFILE_SCOPE( "ZTriMeshConnectionInfo::build_e2v" );
+
+	if( e2vOffset.length() > 0 ) { return; } // already done
 
-    ZTriMeshConnectionInfo::calculate_v2t();
+	ZTriMeshConnectionInfo::build_halfEdges( useOpenMP );
 
-    t2v.reset();
-    t2v.resize( _numVertices );
+	ZIntArray keys( 2*_numEdges );
 
-    FOR( iTriangle, 0, _numTriangles )
-    {
-        const int& v0 = v2t[iTriangle][0];
-        const int& v1 = v2t[iTriangle][1];
-        const int& v2 = v2t[iTriangle][2];
+	#pragma omp parallel for if( useOpenMP )
+	FOR( e, 0, _numEdges )
+	{
+		keys[2*e  ] = v2e[e][0];
+		keys[2*e+1] = v2e[e][1];
+	}
 
-        ZIntArray& list0 = t2v[v0];
-        if( list0.findTheFirstIndex( iTriangle ) < 0 ) { list0.append( iTriangle ); }
+	GroupByKeys( _numVertices, keys, e2vOffset, e2vIndex );
 
-        ZIntArray& list1 = t2v[v1];
-        if( list1.findTheFirstIndex( iTriangle ) < 0 ) { list1.append( iTriangle ); }
+	const int n = e2vIndex.length();
 
-        ZIntArray& list2 = t2v[v2];
-        if( list2.findTheFirstIndex( iTriangle ) < 0 ) { list2.append( iTriangle ); }
-    }
+	#pragma omp parallel for if( useOpenMP )
+	FOR( i, 0, n )
+	{
+		e2vIndex[i] /= 2;
+	}
 }
 
 void
-ZTriMeshConnectionInfo::calculate_v2e()
+ZTriMeshConnectionInfo::build_t2v( bool useOpenMP )
 {
-    if( v2e.length() > 0 ) { return; } // already done
+	ZPROFILE_SCOPE( "ZTriMeshConnectionInfo::build_t2v" );
+
+	if( t2vOffset.length() > 0 ) { return; } // already done
+
+	const int nh = 3 * _numTriangles;
 
-    ZTriMeshConnectionInfo::calculate_v2v();
+	// the corners (a repeated vertex of a degenerate triangle counts once)
+	ZIntArray keys( nh );
 
-    v2e.reset();
-    v2e.reserve( _numTriangles*2 );
+	#pragma omp parallel for if( useOpenMP )
+	FOR( t, 0, _numTriangles )
+	{
+		const ZInt3& v = v2t[t];
 
-    FOR( iVertex, 0, _numVertices )
-    {
-        const ZIntArray& list = v2v[iVertex];
+		keys[3*t  ] = v[0];
+		keys[3*t+1] = ( v[1] == v[0] ) ? -1 : v[1];
+		keys[3*t+2] = ( ( v[2] == v[0] ) || ( v[2] == v[1] ) ) ? -1 : v[2];
+	}
 
-        FOR( j, 0, list.length() )
-        {
-            const int& jVertex = list[j];
+	GroupByKeys( _numVertices, keys, t2vOffset, t2vIndex );
 
-            if( iVertex < jVertex ) { v2e.append( ZInt2( iVertex, jVertex ) ); }
-        }
-    }
+	const int n = t2vIndex.length();
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( i, 0, n )
+	{
+		t2vIndex[i] /= 3;
+	}
 }
 
 void
-ZTriMeshConnectionInfo::calculate_e2e()
+ZTriMeshConnectionInfo::calculate_v2v()
 {
-    // no thing to do (no meaning)
+	if( v2v.length() > 0 ) { return; } // already done
+
+	ZTriMeshConnectionInfo::build_v2v();
+
+	CopyToList( v2vOffset, v2vIndex, v2v, true );
 }
 
 void
-ZTriMeshConnectionInfo::calculate_t2e()
+ZTriMeshConnectionInfo::calculate_e2v()
 {
-    if( t2e.length() > 0 ) { return; } // already done
+	if( e2v.length() > 0 ) { return; } // already done
 
-    ZTriMeshConnectionInfo::calculate_e2v();
+	ZTriMeshConnectionInfo::build_e2v();
 
-    const int numEdges = v2e.length();
+	CopyToList( e2vOffset, e2vIndex, e2v, true );
+}
 
-    t2e.reset();
-    t2e.setLength( numEdges );
-    t2e.fill( ZInt2(-1) );
+void
+ZTriMeshConnectionInfo::calculate_t2v()
+{
+	if( t2v.length() > 0 ) { return; } // already done
 
-    FOR( iTriangle, 0, _numTriangles )
-    {
-        FOR( iVertex, 0, 3 )
-        {
-            const int& v0 = v2t[iTriangle][iVertex];
-            const int& v1 = v2t[iTriangle][(iVertex+1)%3];
+	ZTriMeshConnectionInfo::build_t2v();
 
-            const ZIntArray& list = e2v[v0];
+	CopyToList( t2vOffset, t2vIndex, t2v, true );
+}
 
-            FOR( i, 0, list.length() )
-            {
-                const int& iEdge = list[i];
+void
+ZTriMeshConnectionInfo::calculate_v2e()
+{
+	ZTriMeshConnectionInfo::build_halfEdges();
+}
 
-                const int& ev0 = v2e[iEdge][0];
-                const int& ev1 = v2e[iEdge][1];
+void
+ZTriMeshConnectionInfo::calculate_e2e()
+{
+	// no thing to do (no meaning)
+}
 
-                if( ( ev0 == v1 ) || ( ev1 == v1 ) )
-                {
-                    if( t2e[iEdge][0] < 0 ) { t2e[iEdge][0] = iTriangle; }
-                    else                    { t2e[iEdge][1] = iTriangle; }
-                }
-            }
-        }
-    }
+void
+ZTriMeshConnectionInfo::calculate_t2e()
+{
+	ZTriMeshConnectionInfo::build_halfEdges();
 }
 
 void
 ZTriMeshConnectionInfo::calculate_v2t()
 {
-    // v2t = mesh.triangles: already done
+	// v2t = mesh.triangles: already done
 }
 
 void
 ZTriMeshConnectionInfo::calculate_e2t()
 {
-    if( e2t.length() > 0 ) { return; } // already done
-
-    ZTriMeshConnectionInfo::calculate_e2v();
-
-    e2t.reset();
-    e2t.setLength( _numTriangles );
-    e2t.fill( ZInt3(-1) );
-
-    FOR( iTriangle, 0, _numTriangles )
-    {
-        FOR( iVertex, 0, 3 )
-        {
-            const int& v0 = v2t[iTriangle][iVertex];
-            const int& v1 = v2t[iTriangle][(iVertex+1)%3];
-
-            const ZIntArray& list = e2v[v0];
-
-            FOR( i, 0, list.length() )
-            {
-                const int& iEdge = list[i];
-
-                if( ( v2e[iEdge][0] == v1 ) || ( v2e[iEdge][1] == v1 ) )
-                {
-                    e2t[iTriangle][iVertex] = iEdge;
-                    break;
-                }
-            }
-        }
-    }
+	ZTriMeshConnectionInfo::build_halfEdges();
 }
 
 void
 ZTriMeshConnectionInfo::calculate_t2t()
 {
-    if( t2t.length() > 0 ) { return; } // already done
-
-    ZTriMeshConnectionInfo::calculate_t2v();
-
-    t2t.reset();
-    t2t.setLength( _numTriangles );
-    t2t.fill( ZInt3(-1) );
-
-    FOR( iTriangle, 0, _numTriangles )
-    {
-        FOR( iVertex, 0, 3 )
-        {
-            const int& v0 = v2t[iTriangle][iVertex];
-            const int& v1 = v2t[iTriangle][(iVertex+1)%3];
-
-            const ZIntArray& list = t2v[v0];
-
-            FOR( j, 0, list.length() )
-            {
-                const int& jTriangle = list[j];
-                if( jTriangle == iTriangle ) { continue; }
-
-                if( v2t[jTriangle][0] == v1 ) { t2t[iTriangle][iVertex]=jTriangle; break; }
-                if( v2t[jTriangle][1] == v1 ) { t2t[iTriangle][iVertex]=jTriangle; break; }
-                if( v2t[jTriangle][2] == v1 ) { t2t[iTriangle][iVertex]=jTriangle; break; }
-            }
-        }
-    }
+	ZTriMeshConnectionInfo::build_halfEdges();
+}
+
+double
+ZTriMeshConnectionInfo::usedMemorySize( ZDataUnit::DataUnit dataUnit ) const
+{
+	double bytes = 0.0;
+
+	bytes += ListMemorySize( v2v ) + ListMemorySize( e2v ) + ListMemorySize( t2v ) + ListMemorySize( e2e );
+
+	bytes += v2e.usedMemorySize() + t2e.usedMemorySize();
+	bytes += v2t.usedMemorySize() + e2t.usedMemorySize() + t2t.usedMemorySize();
+
+	bytes += heTwin.usedMemorySize() + heEdge.usedMemorySize() + vertexHe.usedMemorySize();
+
+	bytes += v2vOffset.usedMemorySize() + v2vIndex.usedMemorySize();
+	bytes += e2vOffset.usedMemorySize() + e2vIndex.usedMemorySize();
+	bytes += t2vOffset.usedMemorySize() + t2vIndex.usedMemorySize();
+
+	switch( dataUnit )
+	{
+		case ZDataUnit::zBytes:     { return bytes; }
+		case ZDataUnit::zKilobytes: { return (bytes/1024.0); }
+		case ZDataUnit::zMegabytes: { return (bytes/ZPow2(1024.0)); }
+		case ZDataUnit::zGigabytes: { return (bytes/ZPow3(1024.0)); }
+		default: { cout << "Error@ZTriMeshConnectionInfo::usedMemorySize(): Invalid data unit." << endl; return 0.0; }
+	}
 }
 
 ostream&
 operator<<( ostream& os, const ZTriMeshConnectionInfo& object )
 {
 	os << "<ZTriMeshConnectionInfo>" << endl;
+	os << " # of vertices  : " << object.numVertices() << endl;
+	os << " # of triangles : " << object.numTriangles() << endl;
+	os << " # of edges     : " << object.numEdges() << endl;
+	os << " memory size    : " << object.usedMemorySize(ZDataUnit::zMegabytes) << " mb." << endl;
 	os << endl;
 
 	return os;
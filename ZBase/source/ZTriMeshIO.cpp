@@ -2,73 +2,642 @@
 // ZTriMeshIO.cpp //
 //-------------------------------------------------------//
 // author: Wanho Choi @ Dexter Studios                   //
-// last update: 2015.10.07                               //
+// last update: 2019.03.30                               //
 //-------------------------------------------------------//
 
 #include <ZelosBase.h>
 
 ZELOS_NAMESPACE_BEGIN
 
-bool
-Load_from_obj( ZTriMesh& mesh, const char* filePathName )
+// the parsed data of a chunk of lines
+struct ZObjChunk
 {
-	mesh.reset();
+	ZPointArray  v;					// positions
+	ZPointArray  vt;				// texture coordinates
+	ZVectorArray vn;				// normals
 
-	ifstream fin( filePathName, ios::in );
-	if( fin.fail() )
+	ZIntArray    counts;			// the number of vertices of each face
+	ZIntArray    fv, ft, fn;		// the (v,vt,vn) indices of each face-vertex (0-based, -1 for none, ZObjBadIndex for 0)
+	ZIntArray    relV, relT, relN;	// the face-vertices with the relative (negative) indices to be shifted by the chunk offsets
+
+	void release()
 	{
-		cout << "Failed to open file: " << filePathName << endl;
-		return false;
+		ZPointArray().exchange( v );   ZPointArray().exchange( vt );   ZVectorArray().exchange( vn );
+		ZIntArray().exchange( counts );
+		ZIntArray().exchange( fv );    ZIntArray().exchange( ft );     ZIntArray().exchange( fn );
+		ZIntArray().exchange( relV );  ZIntArray().exchange( relT );   ZIntArray().exchange( relN );
 	}
+};
+
+// the index 0 and the relative indices before the first element (rejected after stitching)
+static const int ZObjBadIndex = -2;
+
+// the whole data after stitching
+struct ZObjData
+{
+	ZPointArray  v, vt;
+	ZVectorArray vn;
+
+	ZIntArray    counts;
+	ZIntArray    fv, ft, fn;
+
+	ZIntArray    chunkFace;		// the first face of each chunk (length: numChunks+1)
+	ZIntArray    chunkCorner;	// the first face-vertex of each chunk
+	ZIntArray    chunkTri;		// the first triangle of each chunk (by fan triangulation)
+};
+
+static inline const char*
+SkipSpaces( const char* s, const char* e )
+{
+	while( ( s < e ) && ( ( *s == ' ' ) || ( *s == '\t' ) ) ) { ++s; }
+	return s;
+}
+
+static inline bool
+IsDigit( char c )
+{
+	return ( ( c >= '0' ) && ( c <= '9' ) );
+}
+
+// It parses a number by strtof() (for the cases ParseFloat() cannot round correctly, inf, and nan).
+static const char*
+StrToFloat( const char* s, const char* e, float& value )
+{
+	const char* t = s;
+	while( ( t < e ) && ( *t != ' ' ) && ( *t != '\t' ) && ( *t != '\r' ) ) { ++t; }
+
+	char buffer[64];
+	std::string longToken;
+
+	const char* token = buffer;
+
+	if( t-s < (int)sizeof(buffer) ) { memcpy( buffer, s, t-s ); buffer[t-s] = '\0'; }
+	else { longToken.assign( s, t ); token = longToken.c_str(); }
+
+	char* end = 0;
+	const float v = strtof( token, &end );
+
+	if( end == token ) { return s; }
+
+	value = v;
+	return ( s + ( end - token ) );
+}
+
+// whether d is exactly halfway between two adjacent floats (where (float)d may round the other way than the exact value)
+static inline bool
+IsHalfwayFloat( double d )
+{
+	uint64_t bits;
+	memcpy( &bits, &d, sizeof(double) );
+	return ( ( bits & 0x1FFFFFFFULL ) == 0x10000000ULL ); // the 29 bits dropped from the double mantissa
+}
+
+// It parses a decimal floating point number (no locale, no allocation).
+// The fast path is exact: a mantissa up to 2^53 times or divided by 10^22 at most is correctly rounded in double,
+// and the double is rounded once more to float only when it is not a tie between two floats.
+// The other cases go to strtof().
+// It returns s itself if there is no number.
+static inline const char*
+ParseFloat( const char* s, const char* e, float& value )
+{
+	static const double pow10[23] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	                                  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+	const char* start = s;
+
+	bool negative = false;
+	if( ( s < e ) && ( ( *s == '-' ) || ( *s == '+' ) ) ) { negative = ( *s == '-' ); ++s; }
+
+	unsigned long long mantissa = 0;
+	int  exponent  = 0;
+	int  numDigits = 0; // significant digits in mantissa
+	bool hasDigits = false;
+	bool truncated = false;
+
+	for( ; ( s < e ) && IsDigit(*s); ++s )
+	{
+		hasDigits = true;
+		if( numDigits < 19 ) { mantissa = mantissa*10 + ( *s - '0' ); if( mantissa ) { ++numDigits; } }
+		else { ++exponent; truncated = true; }
+	}
+
+	if( ( s < e ) && ( *s == '.' ) )
+	{
+		for( ++s; ( s < e ) && IsDigit(*s); ++s )
+		{
+			hasDigits = true;
+			if( numDigits < 19 ) { mantissa = mantissa*10 + ( *s - '0' ); if( mantissa ) { ++numDigits; } --exponent; }
+			else { truncated = true; }
+		}
+	}
+
+	if( !hasDigits )
+	{
+		const char c = ( s < e ) ? ( *s | 0x20 ) : 0; // lower case
+		if( ( c == 'i' ) || ( c == 'n' ) ) { return StrToFloat( start, e, value ); } // inf or nan
+		return start;
+	}
+
+	if( ( s < e ) && ( ( *s == 'e' ) || ( *s == 'E' ) ) )
+	{
+		const char* t = s+1;
+
+		bool negExp = false;
+		if( ( t < e ) && ( ( *t == '-' ) || ( *t == '+' ) ) ) { negExp = ( *t == '-' ); ++t; }
+
+		if( ( t < e ) && IsDigit(*t) )
+		{
+			int exp = 0;
+			for( ; ( t < e ) && IsDigit(*t); ++t ) { if( exp < 10000 ) { exp = exp*10 + ( *t - '0' ); } }
+
+			exponent += negExp ? -exp : exp;
+			s = t;
+		}
+	}
+
+	if( truncated || ( mantissa > ( 1ULL << 53 ) ) || ( exponent > 22 ) || ( exponent < -22 ) )
+	{
+		return StrToFloat( start, e, value );
+	}
+
+	double d = (double)mantissa;
 
-	ZPointArray& p    = mesh.p;
-	ZInt3Array&  v012 = mesh.v012;
-	ZPointArray& uv   = mesh.uv;
+	if     ( exponent > 0 ) { d *= pow10[ exponent]; }
+	else if( exponent < 0 ) { d /= pow10[-exponent]; }
 
-	string line, attr, token;
-	ZPoint pt;
+	if( IsHalfwayFloat( d ) ) { return StrToFloat( start, e, value ); }
 
-	while( getline( fin, line ) )
+	value = (float)( negative ? -d : d );
+
+	return s;
+}
+
+static inline const char*
+ParseInt( const char* s, const char* e, int& value, bool& ok )
+{
+	bool negative = false;
+	if( ( s < e ) && ( ( *s == '-' ) || ( *s == '+' ) ) ) { negative = ( *s == '-' ); ++s; }
+
+	ok = ( s < e ) && IsDigit(*s);
+
+	int i = 0;
+	for( ; ( s < e ) && IsDigit(*s); ++s ) { i = i*10 + ( *s - '0' ); }
+
+	value = negative ? -i : i;
+
+	return s;
+}
+
+// 1-based absolute index -> 0-based global index
+// negative relative index -> 0-based chunk-local index (to be shifted by the chunk offset later)
+static inline int
+ResolveIndex( int idx, int localCount, ZIntArray& relative, int position )
+{
+	if( idx > 0 ) { return ( idx - 1 ); }
+	if( !idx ) { return ZObjBadIndex; }
+
+	relative.push_back( position );
+	return ( localCount + idx );
+}
+
+// faceLines: the chunk-local line number (0-based) of each face if not NULL
+static void
+ParseObjChunk( const char* s, const char* e, ZObjChunk& chunk, ZIntArray* faceLines=(ZIntArray*)NULL )
+{
+	for( int line=0; s<e; ++line )
 	{
-		attr = line.substr(0,2);
+		const char* eol = (const char*)memchr( s, '\n', e-s );
+		if( !eol ) { eol = e; }
 
-		if( attr == "v " ) { // vertex position
+		const char* c = SkipSpaces( s, eol );
+		s = eol + 1;
 
-			istringstream s( line.substr(2) );
+		if( ( c+1 >= eol ) ) { continue; }
 
-			s >> pt.x >> pt.y >> pt.z;
-			p.push_back( pt );
+		if( c[0] == 'v' )
+		{
+			if( ( c[1] == ' ' ) || ( c[1] == '\t' ) ) // position
+			{
+				ZPoint p;
+				c = ParseFloat( SkipSpaces(c+2,eol), eol, p.x );
+				c = ParseFloat( SkipSpaces(c  ,eol), eol, p.y );
+				c = ParseFloat( SkipSpaces(c  ,eol), eol, p.z );
+				chunk.v.push_back( p );
+			}
+			else if( ( c[1] == 't' ) && ( c+2 < eol ) && ( ( c[2] == ' ' ) || ( c[2] == '\t' ) ) ) // texture coordinates
+			{
+				ZPoint t;
+				c = ParseFloat( SkipSpaces(c+3,eol), eol, t.x );
+				c = ParseFloat( SkipSpaces(c  ,eol), eol, t.y );
+				c = ParseFloat( SkipSpaces(c  ,eol), eol, t.z );
+				chunk.vt.push_back( t );
+			}
+			else if( ( c[1] == 'n' ) && ( c+2 < eol ) && ( ( c[2] == ' ' ) || ( c[2] == '\t' ) ) ) // normal
+			{
+				ZVector n;
+				c = ParseFloat( SkipSpaces(c+3,eol), eol, n.x );
+				c = ParseFloat( SkipSpaces(c  ,eol), eol, n.y );
+				c = ParseFloat( SkipSpaces(c  ,eol), eol, n.z );
+				chunk.vn.push_back( n );
+			}
+		}
+		else if( ( c[0] == 'f' ) && ( ( c[1] == ' ' ) || ( c[1] == '\t' ) ) ) // face: v, v/vt, v//vn, or v/vt/vn
+		{
+			const int corner0 = chunk.fv.length();
+			const int relV0   = chunk.relV.length();
+			const int relT0   = chunk.relT.length();
+			const int relN0   = chunk.relN.length();
 
-		} else if( attr == "f " ) { // poly-connections
+			int  count = 0;
+			bool ok    = true;
 
-			istringstream s( line.substr(2) );
+			c = SkipSpaces( c+2, eol );
 
-			int count = 0;
-			ZIntArray tmp;
-			while( getline(s,token,' ') )
+			while( ( c < eol ) && ( *c != '\r' ) && ( *c != '#' ) )
 			{
-				tmp.push_back( atoi(token.c_str()) );
+				const int position = corner0 + count;
+
+				int idx = 0;
+				c = ParseInt( c, eol, idx, ok );
+				if( !ok ) { break; }
+
+				int v = ResolveIndex( idx, chunk.v.length(), chunk.relV, position );
+				int t = -1;
+				int n = -1;
+
+				if( ( c < eol ) && ( *c == '/' ) )
+				{
+					++c;
+
+					if( ( c < eol ) && ( *c != '/' ) )
+					{
+						c = ParseInt( c, eol, idx, ok );
+						if( !ok ) { break; }
+						t = ResolveIndex( idx, chunk.vt.length(), chunk.relT, position );
+					}
+
+					if( ( c < eol ) && ( *c == '/' ) )
+					{
+						c = ParseInt( c+1, eol, idx, ok );
+						if( !ok ) { break; }
+						n = ResolveIndex( idx, chunk.vn.length(), chunk.relN, position );
+					}
+				}
+
+				chunk.fv.push_back( v );
+				chunk.ft.push_back( t );
+				chunk.fn.push_back( n );
 				++count;
+
+				c = SkipSpaces( c, eol );
 			}
 
-			const int numVerts = tmp.length();
-			FOR( j, 0, numVerts-2 )
+			if( !ok || ( count < 3 ) ) // roll back the broken face
 			{
-				v012.push_back( ZInt3( tmp[0]-1, tmp[j+1]-1, tmp[j+2]-1 ) );
+				chunk.fv.resize( corner0 );   chunk.ft.resize( corner0 );   chunk.fn.resize( corner0 );
+				chunk.relV.resize( relV0 );   chunk.relT.resize( relT0 );   chunk.relN.resize( relN0 );
+				continue;
 			}
 
-		} else if( attr == "vt" ) { // texture coordinates
+			chunk.counts.push_back( count );
+			if( faceLines ) { faceLines->push_back( line ); }
+		}
+	}
+}
+
+// the memory of a file (mapped if possible)
+class ZObjFile
+{
+	public:
+
+		const char* data;
+		size_t      size;
 
-		} else if( attr == "vn" ) { // vertex normals
+	private:
+
+		std::vector<char> _buffer;
+
+	public:
+
+		ZObjFile() : data(0), size(0) {}
+
+		~ZObjFile()
+		{
+			#ifdef OS_LINUX
+			if( data && _buffer.empty() ) { munmap( (void*)data, size ); }
+			#endif
+		}
+
+		bool open( const char* filePathName )
+		{
+			#ifdef OS_LINUX
+			{
+				const int fd = ::open( filePathName, O_RDONLY );
+				if( fd < 0 ) { return false; }
 
-		} else if( attr == "vp" ) { // parameter space vertex positions
+				struct stat st;
+				if( fstat( fd, &st ) != 0 ) { ::close( fd ); return false; }
 
-		} else if( line[0] == '#' ) {}
+				size = (size_t)st.st_size;
 
-		else {}
+				if( size == 0 ) { ::close( fd ); _buffer.resize(1); data = &_buffer[0]; return true; }
+
+				void* ptr = mmap( 0, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+				::close( fd );
+
+				if( ptr == MAP_FAILED ) { size = 0; return false; }
+
+				madvise( ptr, size, MADV_SEQUENTIAL );
+
+				data = (const char*)ptr;
+				return true;
+			}
+			#else
+			{
+				ifstream fin( filePathName, ios::in|ios::binary|ios::ate );
+				if( fin.fail() ) { return false; }
+
+				size = (size_t)fin.tellg();
+				_buffer.resize( size+1 );
+
+				fin.seekg( 0, ios::beg );
+				fin.read( &_buffer[0], size );
+
+				data = &_buffer[0];
+				return true;
+			}
+			#endif
+		}
+};
+
+static bool
+ReadObj( const char* filePathName, ZObjData& obj, bool useOpenMP )
+{
+	ZPROFILE_SCOPE( "ReadObj" );
+
+	ZObjFile file;
+
+	if( !file.open( filePathName ) )
+	{
+		cout << "Error@ZTriMeshIO::Load_from_obj(): Failed to open file: " << filePathName << endl;
+		return false;
+	}
+
+	const char* begin = file.data;
+	const char* end   = file.data + file.size;
+
+	// the newline-aligned chunks (several per thread for the load balance)
+	const int numThreads = useOpenMP ? omp_get_max_threads() : 1;
+	const int numChunks  = (int)ZClamp( (long long)( file.size >> 20 ), 1LL, (long long)( numThreads*8 ) );
+
+	std::vector<const char*> bound( numChunks+1 );
+	bound[0]         = begin;
+	bound[numChunks] = end;
+
+	FOR( i, 1, numChunks )
+	{
+		const char* s = begin + ( file.size / numChunks ) * i;
+		if( s < bound[i-1] ) { s = bound[i-1]; }
+
+		const char* eol = (const char*)memchr( s, '\n', end-s );
+		bound[i] = eol ? ( eol+1 ) : end;
+	}
+
+	std::vector<ZObjChunk> chunks( numChunks );
+
+	#pragma omp parallel for schedule(dynamic) if( useOpenMP )
+	FOR( i, 0, numChunks )
+	{
+		ParseObjChunk( bound[i], bound[i+1], chunks[i] );
 	}
 
-	fin.close();
+	// prefix sums
+	ZIntArray vOff(numChunks+1), tOff(numChunks+1), nOff(numChunks+1);
+
+	obj.chunkFace  .setLength( numChunks+1 );
+	obj.chunkCorner.setLength( numChunks+1 );
+	obj.chunkTri   .setLength( numChunks+1 );
+
+	FOR( i, 0, numChunks )
+	{
+		const ZObjChunk& c = chunks[i];
+
+		int numTris = 0;
+		FOR( f, 0, c.counts.length() ) { numTris += c.counts[f] - 2; }
+
+		vOff[i+1] = vOff[i] + c.v .length();
+		tOff[i+1] = tOff[i] + c.vt.length();
+		nOff[i+1] = nOff[i] + c.vn.length();
+
+		obj.chunkFace  [i+1] = obj.chunkFace  [i] + c.counts.length();
+		obj.chunkCorner[i+1] = obj.chunkCorner[i] + c.fv.length();
+		obj.chunkTri   [i+1] = obj.chunkTri   [i] + numTris;
+	}
+
+	obj.v     .setLength( vOff[numChunks], false );
+	obj.vt    .setLength( tOff[numChunks], false );
+	obj.vn    .setLength( nOff[numChunks], false );
+	obj.counts.setLength( obj.chunkFace  [numChunks], false );
+	obj.fv    .setLength( obj.chunkCorner[numChunks], false );
+	obj.ft    .setLength( obj.chunkCorner[numChunks], false );
+	obj.fn    .setLength( obj.chunkCorner[numChunks], false );
+
+	const int numV = obj.v .length();
+	const int numT = obj.vt.length();
+	const int numN = obj.vn.length();
+
+	// The invalid v, vt, and vn indices are all rejected in the same way.
+	int numInvalid = 0;
+	ZIntArray firstInvalid( numChunks, -1 ); // the first face-vertex with an invalid index in each chunk
+
+	#pragma omp parallel for schedule(dynamic) reduction(+:numInvalid) if( useOpenMP )
+	FOR( i, 0, numChunks )
+	{
+		ZObjChunk& c = chunks[i];
+
+		// (a relative index before the first element becomes negative)
+		FOR( k, 0, c.relV.length() ) { int& v = c.fv[ c.relV[k] ]; v += vOff[i]; if( v < 0 ) { v = ZObjBadIndex; } }
+		FOR( k, 0, c.relT.length() ) { int& t = c.ft[ c.relT[k] ]; t += tOff[i]; if( t < 0 ) { t = ZObjBadIndex; } }
+		FOR( k, 0, c.relN.length() ) { int& n = c.fn[ c.relN[k] ]; n += nOff[i]; if( n < 0 ) { n = ZObjBadIndex; } }
+
+		FOR( k, 0, c.fv.length() )
+		{
+			const bool invalid = ( c.fv[k] < 0 ) || ( c.fv[k] >= numV )
+			                  || ( c.ft[k] < -1 ) || ( c.ft[k] >= numT )
+			                  || ( c.fn[k] < -1 ) || ( c.fn[k] >= numN );
+
+			if( !invalid ) { continue; }
+
+			if( firstInvalid[i] < 0 ) { firstInvalid[i] = k; }
+			++numInvalid;
+		}
+
+		if( c.v .length() ) { memcpy( (char*)&obj.v [vOff[i]], (char*)&c.v [0], c.v .length()*sizeof(ZPoint)  ); }
+		if( c.vt.length() ) { memcpy( (char*)&obj.vt[tOff[i]], (char*)&c.vt[0], c.vt.length()*sizeof(ZPoint)  ); }
+		if( c.vn.length() ) { memcpy( (char*)&obj.vn[nOff[i]], (char*)&c.vn[0], c.vn.length()*sizeof(ZVector) ); }
+
+		const int f0 = obj.chunkFace  [i];
+		const int c0 = obj.chunkCorner[i];
+
+		if( c.counts.length() ) { memcpy( (char*)&obj.counts[f0], (char*)&c.counts[0], c.counts.length()*sizeof(int) ); }
+
+		if( c.fv.length() )
+		{
+			memcpy( (char*)&obj.fv[c0], (char*)&c.fv[0], c.fv.length()*sizeof(int) );
+			memcpy( (char*)&obj.ft[c0], (char*)&c.ft[0], c.ft.length()*sizeof(int) );
+			memcpy( (char*)&obj.fn[c0], (char*)&c.fn[0], c.fn.length()*sizeof(int) );
+		}
+
+		c.release(); // as early as possible
+	}
+
+	if( numInvalid )
+	{
+		// the line of the first one (only the chunk of it is parsed again)
+		int i = 0;
+		while( firstInvalid[i] < 0 ) { ++i; }
+
+		ZObjChunk chunk;
+		ZIntArray faceLines;
+		ParseObjChunk( bound[i], bound[i+1], chunk, &faceLines );
+
+		int face = 0;
+		for( int corner=chunk.counts[0]; corner<=firstInvalid[i]; corner+=chunk.counts[face] ) { ++face; }
+
+		const int line = (int)std::count( begin, bound[i], '\n' ) + faceLines[face] + 1;
+
+		cout << "Error@ZTriMeshIO::Load_from_obj(): Invalid index at line " << line;
+		cout << " (" << numInvalid << " invalid indices in total): " << filePathName << endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool
+Load_from_obj( ZTriMesh& mesh, const char* filePathName, bool useOpenMP )
+{
+	mesh.reset();
+
+	ZObjData obj;
+	if( !ReadObj( filePathName, obj, useOpenMP ) ) { return false; }
+
+	const int numChunks = obj.chunkFace.length() - 1;
+	const int numTris   = obj.chunkTri[numChunks];
+	const bool hasUV    = ( obj.vt.length() > 0 );
+
+	mesh.p.exchange( obj.v );
+	mesh.v012.setLength( numTris, false );
+	if( hasUV ) { mesh.uv.setLength( numTris*3, false ); }
+
+	// fan triangulation
+	#pragma omp parallel for schedule(dynamic) if( useOpenMP )
+	FOR( i, 0, numChunks )
+	{
+		int corner = obj.chunkCorner[i];
+		int tri    = obj.chunkTri[i];
+
+		FOR( f, obj.chunkFace[i], obj.chunkFace[i+1] )
+		{
+			const int n = obj.counts[f];
+
+			FOR( j, 1, n-1 )
+			{
+				mesh.v012[tri] = ZInt3( obj.fv[corner], obj.fv[corner+j], obj.fv[corner+j+1] );
+
+				if( hasUV )
+				{
+					const int t[3] = { obj.ft[corner], obj.ft[corner+j], obj.ft[corner+j+1] };
+					FOR( k, 0, 3 ) { mesh.uv[3*tri+k] = ( t[k] < 0 ) ? ZPoint(0.f) : obj.vt[ t[k] ]; }
+				}
+
+				++tri;
+			}
+
+			corner += n;
+		}
+	}
+
+	return true;
+}
+
+bool
+Load_from_obj( ZPolyMesh& mesh, const char* filePathName, bool useOpenMP )
+{
+	mesh.reset();
+
+	ZObjData obj;
+	if( !ReadObj( filePathName, obj, useOpenMP ) ) { return false; }
+
+	const int numCorners = obj.fv.length();
+
+	mesh.vertexPositions.exchange( obj.v );
+	mesh.polygonCounts  .exchange( obj.counts );
+	mesh.polygonConnects.exchange( obj.fv );
+
+	if( obj.vt.length() )
+	{
+		const int numUVs = obj.vt.length();
+
+		mesh.u.setLength( numUVs, false );
+		mesh.v.setLength( numUVs, false );
+
+		#pragma omp parallel for if( useOpenMP )
+		FOR( i, 0, numUVs )
+		{
+			mesh.u[i] = obj.vt[i].x;
+			mesh.v[i] = obj.vt[i].y;
+		}
+
+		// the face-vertices without vt refer to the first one.
+		mesh.uvIndices.setLength( numCorners, false );
+
+		#pragma omp parallel for if( useOpenMP )
+		FOR( i, 0, numCorners )
+		{
+			mesh.uvIndices[i] = ZMax( obj.ft[i], 0 );
+		}
+	}
+
+	if( obj.vn.length() )
+	{
+		// per vertex: the normal of the last face-vertex referring to it
+		mesh.vertexNormals.setLength( mesh.numVertices() );
+
+		FOR( i, 0, numCorners )
+		{
+			if( obj.fn[i] >= 0 ) { mesh.vertexNormals[ mesh.polygonConnects[i] ] = obj.vn[ obj.fn[i] ]; }
+		}
+	}
+
+	mesh.computeBoundingBox();
+
+	return true;
+}
+
+bool
+Load_from_obj( ZMesh& mesh, const char* filePathName, bool useOpenMP )
+{
+	mesh.reset();
+
+	ZObjData obj;
+	if( !ReadObj( filePathName, obj, useOpenMP ) ) { return false; }
+
+	if( !mesh.create( obj.v, obj.counts, obj.fv, ZMeshElementType::zFace ) ) { return false; }
+
+	if( obj.vt.length() )
+	{
+		const int numCorners = obj.ft.length();
+
+		// the face-vertices without vt refer to the first one.
+		#pragma omp parallel for if( useOpenMP )
+		FOR( i, 0, numCorners )
+		{
+			obj.ft[i] = ZMax( obj.ft[i], 0 );
+		}
+
+		if( !mesh.assignUVs( obj.vt, obj.ft ) ) { return false; }
+	}
 
 	return true;
 }
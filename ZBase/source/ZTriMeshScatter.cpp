@@ -3,7 +3,7 @@
 //-------------------------------------------------------//
 // author: Wanho Choi @ Dexter Studios                   //
 //         Jaegwang Lim @ Dexter Studios                 //
-// last update: 2018.03.08                               //
+// last update: 2019.03.30                               //
 //-------------------------------------------------------//
 
 #include <ZelosBase.h>
@@ -63,6 +63,8 @@ ZTriMeshScatter::_initParams()
 int
 ZTriMeshScatter::scatter( ZIntArray& triIndices, ZFloat3Array& baryCoords )
 {
+	ZPROFILE_SCOPE( "ZTriMeshScatter::scatter" );
+
 	triIndices.clear();
 	baryCoords.clear();
 
@@ -89,6 +91,8 @@ ZTriMeshScatter::scatter( ZIntArray& triIndices, ZFloat3Array& baryCoords )
 int
 ZTriMeshScatter::scatter( ZPointArray& samples, const int num, bool appending )
 {
+	ZPROFILE_SCOPE( "ZTriMeshScatter::scatter" );
+
 	if( !appending ) { samples.clear(); }
 
 	ZIntArray    triIndices;
@@ -105,7 +109,7 @@ ZTriMeshScatter::scatter( ZPointArray& samples, const int num, bool appending )
     int beginIdn = samples.size();
     samples.resize(beginIdn+count);
 
-    #pragma omp prallel for
+    #pragma omp parallel for if( useOpenMP )
 	for(int i=0; i<count; i++)
 	{
 		const int& tIdx = triIndices[i];
@@ -128,6 +132,8 @@ ZTriMeshScatter::scatter( ZPointArray& samples, const int num, bool appending )
 int
 ZTriMeshScatter::scatter( ZPointArray& positions, ZVectorArray& normals, const int num, bool appending )
 {
+	ZPROFILE_SCOPE( "ZTriMeshScatter::scatter" );
+
 	if( !appending ) 
 	{
 		 positions.clear();
@@ -152,7 +158,7 @@ ZTriMeshScatter::scatter( ZPointArray& positions, ZVectorArray& normals, const i
     positions.resize(beginIdn+count);
 	normals.resize(beginIdn+count);
 
-    #pragma omp prallel for
+    #pragma omp parallel for if( useOpenMP )
 	for(int i=0; i<count; i++)
 	{
 		const int& tIdx = triIndices[i];
@@ -176,6 +182,8 @@ ZTriMeshScatter::scatter( ZPointArray& positions, ZVectorArray& normals, const i
 int 
 ZTriMeshScatter::scatter( ZTriMesh* mesh0, ZTriMesh* mesh1, ZPointArray& positions, ZVectorArray& normals, ZVectorArray& velocities, const float dt, const int num, bool appending )
 {
+	ZPROFILE_SCOPE( "ZTriMeshScatter::scatter" );
+
 	if( !appending ) 
 	{
 		 positions.clear();
@@ -205,7 +213,7 @@ ZTriMeshScatter::scatter( ZTriMesh* mesh0, ZTriMesh* mesh1, ZPointArray& positio
 	normals.resize(beginIdn+count);
 	velocities.resize(beginIdn+count);
 
-    #pragma omp prallel for
+    #pragma omp parallel for if( useOpenMP )
 	for(int i=0; i<count; i++)
 	{
 		const int& tIdx = triIndices[i];
@@ -496,24 +504,36 @@ ZTriMeshScatter::_scatter04()
 
 	_totalArea = intervals.back().first;
 
-	int seed = randomSeed;
+	// Each sample has its own random numbers, so it runs in parallel with the same result as the serial loop.
+	const int seed = randomSeed;
+
+	ZIntArray    tIndices( targetNumber );
+	ZFloat3Array bCoords ( targetNumber );
 
+	#pragma omp parallel for if( useOpenMP )
 	FOR( i, 0, targetNumber )
 	{
-		const float val = _totalArea * ZRand( ++seed );
+		const float val = _totalArea * ZRand( seed + 3*i + 1 );
 
 		std::vector<pair<float,int> >::iterator itr;
 		itr = lower_bound( intervals.begin(), intervals.end(), std::make_pair(val,-1) );
 
-		const int& tIdx = itr->second;
-		if( tIdx < 0 ) { continue; }
+		tIndices[i] = itr->second;
+		if( tIndices[i] < 0 ) { continue; }
 
-		float a = ZRand( ++seed );
-		float b = ZRand( ++seed );
+		float a = ZRand( seed + 3*i + 2 );
+		float b = ZRand( seed + 3*i + 3 );
 		if( a+b >= 1.f ) { a=1.f-a; b=1.f-b; }
 
-		triIndices.push_back( itr->second );
-		baryCoords.push_back( ZFloat3( a, b, 1.f-a-b ) );
+		bCoords[i] = ZFloat3( a, b, 1.f-a-b );
+	}
+
+	FOR( i, 0, targetNumber )
+	{
+		if( tIndices[i] < 0 ) { continue; }
+
+		triIndices.push_back( tIndices[i] );
+		baryCoords.push_back( bCoords[i] );
 	}
 }
 
@@ -561,8 +581,8 @@ ZTriMeshScatter::_scatter05()
 	{
 		sR.setLengthWithValue( nPreSamples, radius );
 
-		ZImageMap dMap;
-		if( dMap.load( densityMap.asChar() ) && uv.length() ) {
+		std::shared_ptr<const ZTiledImage> dMap = ZImageCache::global().get( densityMap.asChar() );
+		if( dMap && uv.length() ) {
 
 			#pragma omp parallel for if( useOpenMP )
 			FOR( i, 0, nPreSamples )
@@ -584,12 +604,12 @@ ZTriMeshScatter::_scatter05()
 
 				if( directRadiusControl ) {
 
-					const float dValue = 1.f - ZClamp( dMap.fastValue(u,v), 0.f, 1.f );
+					const float dValue = 1.f - ZClamp( dMap->fastValue(u,v), 0.f, 1.f );
 					r = ( dValueMax - dValueMin ) * dValue + dValueMin + dValueLift;
 
 				} else {
 
-					const float dValue = ZClamp( dMap.fastValue(u,v), 0.f, 1.f );
+					const float dValue = ZClamp( dMap->fastValue(u,v), 0.f, 1.f );
 					r = radius * ( 2 - dValue ); // 0(black): 2*radius, 1(white): radius
 
 				}
@@ -620,37 +640,20 @@ ZTriMeshScatter::_scatter05()
 		}
 	}
 
-	ZUnboundedHashGrid3D hash;
-	{
-		const float h = ( 2.f * radius ) / sqrtf(3.f); // cell size
-		hash.set( h );
+	// parallel sample elimination (deterministic for any number of threads)
+	ZIntArray selected;
+	SelectPoissonDisk( sP, sN, sR, useOpenMP, selected );
 
-		FOR( i, 0, nPreSamples )
-		{
-			hash.addItem( i, sP[i] );
-		}
-	}
+	const int nSamples = selected.length();
 
-	ZInt3Array cells;
-	hash.getAllocatedCells( cells );
-	cells.shuffle();
+	triIndices.setLength( nSamples, false );
+	baryCoords.setLength( nSamples, false );
 
-	while( !cells.empty() )
+	#pragma omp parallel for if( useOpenMP )
+	FOR( i, 0, nSamples )
 	{
-		FOR( i, 0, cells.size() )
-		{
-			const ZInt3& cell = cells[i];
-			if( hash.empty( cell ) ) { continue; }
-
-			const int idx = hash.firstItem( cell );
-
-			triIndices.push_back( triIndices0[idx] );
-			baryCoords.push_back( baryCoords0[idx] );
-
-			hash.remove( sP[idx], sN[idx], sR[idx], sP, sN );
-		}
-
-		hash.getAllocatedCells( cells );
+		triIndices[i] = triIndices0[ selected[i] ];
+		baryCoords[i] = baryCoords0[ selected[i] ];
 	}
 }
 
@@ -660,8 +663,8 @@ ZTriMeshScatter::_deleteByDensityMap()
 	if( !_mesh || !_triIndices || !_baryCoords ) { return; }
 	if( !_mesh->numUVs() ) { return; }
 
-	ZImageMap dMap;
-	if( !dMap.load( densityMap.asChar() ) ) { return; }
+	std::shared_ptr<const ZTiledImage> dMap = ZImageCache::global().get( densityMap.asChar() );
+	if( !dMap ) { return; }
 
 	const ZPointArray& uv = _mesh->uv;
 
@@ -688,7 +691,7 @@ ZTriMeshScatter::_deleteByDensityMap()
 		const float u = ( a*uv0.x + b*uv1.x + c*uv2.x );
 		const float v = ( a*uv0.y + b*uv1.y + c*uv2.y );
 
-		const float dValue = dMap.fastValue( u, v );
+		const float dValue = dMap->fastValue( u, v );
 
 		if( dValue < ZRand(i) )
 		{
@@ -716,8 +719,8 @@ ZTriMeshScatter::_deleteByRemoveMap()
 	if( !_mesh || !_triIndices || !_baryCoords ) { return; }
 	if( !_mesh->numUVs() ) { return; }
 
-	ZImageMap rMap;
-	if( !rMap.load( removeMap.asChar() ) ) { return; }
+	std::shared_ptr<const ZTiledImage> rMap = ZImageCache::global().get( removeMap.asChar() );
+	if( !rMap ) { return; }
 
 	const ZPointArray& uv = _mesh->uv;
 
@@ -744,7 +747,7 @@ ZTriMeshScatter::_deleteByRemoveMap()
 		const float u = ( a*uv0.x + b*uv1.x + c*uv2.x );
 		const float v = ( a*uv0.y + b*uv1.y + c*uv2.y );
 
-		const float dValue = rMap.fastValue( u, v );
+		const float dValue = rMap->fastValue( u, v );
 
 		if( dValue < removeValue )
 		{
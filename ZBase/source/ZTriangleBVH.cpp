@@ -0,0 +1,1154 @@
+//------------------//
+// ZTriangleBVH.cpp //
+//-------------------------------------------------------//
+// author: Wanho Choi @ Dexter Studios                   //
+// last update: 2019.03.20                               //
+//-------------------------------------------------------//
+
+#include <ZelosBase.h>
+
+#ifdef __SSE2__
+ #include <emmintrin.h>
+ #define Z_BVH_SSE
+#endif
+
+ZELOS_NAMESPACE_BEGIN
+
+// The traversal stack has one pending sibling per level at most.
+#define Z_BVH_MAX_DEPTH  60
+#define Z_BVH_STACK_SIZE 64
+
+// # of bins for the SAH evaluation
+#define Z_BVH_NUM_BINS   16
+
+// The sub-trees with more triangles than this are built as separate OpenMP tasks.
+#define Z_BVH_TASK_SIZE  4096
+
+struct ZTriangleBVHBuildData
+{
+	const ZBoundingBoxArray* boxes;		// triangle bounding boxes
+	ZPointArray              centroids;	// triangle bounding box centers
+	std::atomic<int>         numNodes;	// node counter
+	bool                     useOpenMP;
+};
+
+static inline float
+SurfaceArea( const ZBoundingBox& b )
+{
+	if( !b.initialized() ) { return 0.f; }
+
+	const ZVector d( b.maxPoint() - b.minPoint() );
+	return ( 2.f * ( d.x*d.y + d.y*d.z + d.z*d.x ) );
+}
+
+ZTriangleBVH::ZTriangleBVH( int maxDepth, int maxLeafSize )
+: _numNodes(0)
+{
+	_maxDepth    = ZClamp( maxDepth, 1, Z_BVH_MAX_DEPTH );
+	_maxLeafSize = ZMax( maxLeafSize, 1 );
+}
+
+void
+ZTriangleBVH::reset()
+{
+	_numNodes = 0;
+
+	_minX.clear();   _minY.clear();   _minZ.clear();
+	_maxX.clear();   _maxY.clear();   _maxZ.clear();
+
+	_offset .clear();
+	_count  .clear();
+	_triIds .clear();
+
+	_p0.clear();   _p1.clear();   _p2.clear();
+}
+
+void
+ZTriangleBVH::getTriangleBoxes( const ZPointArray& points, const ZInt3Array& triangles, ZBoundingBoxArray& triBoxes, bool useOpenMP )
+{
+	const int numTriangles = triangles.length();
+
+	triBoxes.setLength( numTriangles );
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( i, 0, numTriangles )
+	{
+		const ZInt3& t = triangles[i];
+
+		ZBoundingBox& bBox = triBoxes[i];
+		bBox.reset();
+
+		bBox.expand( points[ t[0] ] );
+		bBox.expand( points[ t[1] ] );
+		bBox.expand( points[ t[2] ] );
+
+		bBox.expand();
+	}
+}
+
+bool
+ZTriangleBVH::build( const ZPointArray& points, const ZInt3Array& triangles, bool useOpenMP )
+{
+	ZBoundingBoxArray triBoxes;
+	getTriangleBoxes( points, triangles, triBoxes, useOpenMP );
+
+	return build( points, triangles, triBoxes, useOpenMP );
+}
+
+bool
+ZTriangleBVH::build( const ZPointArray& points, const ZInt3Array& triangles, const ZBoundingBoxArray& triBoxes, bool useOpenMP )
+{
+	ZPROFILE_SCOPE( "ZTriangleBVH::build" );
+
+	reset();
+
+	const int numTriangles = triangles.length();
+	if( !numTriangles ) { return true; }
+
+	if( triBoxes.length() != numTriangles )
+	{
+		cout << "Error@ZTriangleBVH::build(): Invalid input data." << endl;
+		return false;
+	}
+
+	_allocate( numTriangles );
+
+	ZTriangleBVHBuildData d;
+	{
+		d.boxes     = &triBoxes;
+		d.useOpenMP = useOpenMP;
+		d.numNodes  = 1; // root
+
+		d.centroids.setLength( numTriangles, false );
+
+		#pragma omp parallel for if( useOpenMP )
+		FOR( i, 0, numTriangles )
+		{
+			d.centroids[i] = triBoxes[i].center();
+			_triIds[i] = i;
+		}
+	}
+
+	if( useOpenMP ) {
+
+		#pragma omp parallel
+		{
+			#pragma omp single nowait
+			{
+				_buildNode( &d, 0, 0, numTriangles, 0 );
+			}
+		}
+
+	} else {
+
+		_buildNode( &d, 0, 0, numTriangles, 0 );
+
+	}
+
+	_numNodes = d.numNodes;
+
+	// Release the unused nodes.
+	_minX.resize( _numNodes );   _minY.resize( _numNodes );   _minZ.resize( _numNodes );
+	_maxX.resize( _numNodes );   _maxY.resize( _numNodes );   _maxZ.resize( _numNodes );
+	_offset.resize( _numNodes );
+	_count.resize( _numNodes );
+
+	// vertices in the leaf order
+	#pragma omp parallel for if( useOpenMP )
+	FOR( i, 0, numTriangles )
+	{
+		const ZInt3& t = triangles[ _triIds[i] ];
+
+		_p0[i] = points[ t[0] ];
+		_p1[i] = points[ t[1] ];
+		_p2[i] = points[ t[2] ];
+	}
+
+	return true;
+}
+
+void
+ZTriangleBVH::_allocate( int numTriangles )
+{
+	// A binary tree with N leaves has 2N-1 nodes at most.
+	const int maxNodes = 2*numTriangles;
+
+	_minX.setLength( maxNodes, false );   _minY.setLength( maxNodes, false );   _minZ.setLength( maxNodes, false );
+	_maxX.setLength( maxNodes, false );   _maxY.setLength( maxNodes, false );   _maxZ.setLength( maxNodes, false );
+
+	_offset.setLength( maxNodes, false );
+	_count.setLength( maxNodes, false );
+
+	_triIds.setLength( numTriangles, false );
+
+	_p0.setLength( numTriangles, false );
+	_p1.setLength( numTriangles, false );
+	_p2.setLength( numTriangles, false );
+}
+
+void
+ZTriangleBVH::_buildNode( ZTriangleBVHBuildData* d, int node, int begin, int end, int depth )
+{
+	const ZBoundingBoxArray& boxes     = *d->boxes;
+	const ZPointArray&       centroids = d->centroids;
+
+	int* ids = &_triIds[0];
+
+	ZBoundingBox box, cBox;
+
+	for( int i=begin; i<end; ++i )
+	{
+		box.expand( boxes[ ids[i] ] );
+		cBox.expand( centroids[ ids[i] ] );
+	}
+
+	_setBox( node, box );
+
+	const int n = end - begin;
+
+	if( n <= _maxLeafSize || depth >= _maxDepth )
+	{
+		_offset[node] = begin;
+		_count[node]  = n;
+		return;
+	}
+
+	// binned SAH split
+	int   bestAxis = -1;
+	int   bestBin  = -1;
+	float bestCost = Z_LARGE;
+
+	const ZPoint& cMin = cBox.minPoint();
+	const ZPoint& cMax = cBox.maxPoint();
+
+	FOR( axis, 0, 3 )
+	{
+		const float extent = cMax[axis] - cMin[axis];
+		if( extent <= 0.f ) { continue; }
+
+		const float scale = Z_BVH_NUM_BINS / extent;
+
+		int          binCount[Z_BVH_NUM_BINS];
+		ZBoundingBox binBox[Z_BVH_NUM_BINS];
+
+		FOR( b, 0, Z_BVH_NUM_BINS ) { binCount[b] = 0; }
+
+		for( int i=begin; i<end; ++i )
+		{
+			const int b = ZMin( int( ( centroids[ ids[i] ][axis] - cMin[axis] ) * scale ), Z_BVH_NUM_BINS-1 );
+
+			++binCount[b];
+			binBox[b].expand( boxes[ ids[i] ] );
+		}
+
+		// right-to-left sweep
+		float        rightArea[Z_BVH_NUM_BINS];
+		ZBoundingBox accBox;
+		int          accCount = 0;
+
+		for( int b=Z_BVH_NUM_BINS-1; b>0; --b )
+		{
+			accBox.expand( binBox[b] );
+			accCount += binCount[b];
+			rightArea[b] = SurfaceArea( accBox ) * accCount;
+		}
+
+		// left-to-right sweep
+		accBox.reset();
+		accCount = 0;
+
+		FOR( b, 0, Z_BVH_NUM_BINS-1 )
+		{
+			accBox.expand( binBox[b] );
+			accCount += binCount[b];
+
+			if( !accCount || accCount == n ) { continue; }
+
+			const float cost = SurfaceArea( accBox ) * accCount + rightArea[b+1];
+
+			if( cost < bestCost )
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin  = b;
+			}
+		}
+	}
+
+	int mid = begin;
+
+	if( bestAxis >= 0 )
+	{
+		const int   axis  = bestAxis;
+		const float scale = Z_BVH_NUM_BINS / ( cMax[axis] - cMin[axis] );
+		const float cMinA = cMin[axis];
+		const int   split = bestBin;
+
+		mid = int( std::partition( ids+begin, ids+end, [&]( int t )
+		{
+			return ( ZMin( int( ( centroids[t][axis] - cMinA ) * scale ), Z_BVH_NUM_BINS-1 ) <= split );
+		} ) - ids );
+	}
+
+	// all the centroids are coincident: split by the count
+	if( mid == begin || mid == end )
+	{
+		mid = begin + n/2;
+	}
+
+	const int left = d->numNodes.fetch_add( 2 );
+
+	_offset[node] = left;
+	_count[node]  = 0;
+
+	if( d->useOpenMP && n > Z_BVH_TASK_SIZE ) {
+
+		#pragma omp task firstprivate( d, left, begin, mid, depth )
+		_buildNode( d, left, begin, mid, depth+1 );
+
+		_buildNode( d, left+1, mid, end, depth+1 );
+
+		#pragma omp taskwait
+
+	} else {
+
+		_buildNode( d, left,   begin, mid, depth+1 );
+		_buildNode( d, left+1, mid,   end, depth+1 );
+
+	}
+}
+
+int
+ZTriangleBVH::numLeafNodes() const
+{
+	int sum = 0;
+
+	FOR( i, 0, _numNodes )
+	{
+		if( _count[i] ) { ++sum; }
+	}
+
+	return sum;
+}
+
+float
+ZTriangleBVH::averageNumTriangles() const
+{
+	const int numLeaves = numLeafNodes();
+	if( !numLeaves ) { return 0.f; } // avoid division by zero
+
+	return ( _triIds.length() / (float)numLeaves );
+}
+
+ZBoundingBox
+ZTriangleBVH::boundingBox( int node ) const
+{
+	if( node < 0 || node >= _numNodes ) { return ZBoundingBox(); }
+
+	return ZBoundingBox( ZPoint( _minX[node], _minY[node], _minZ[node] ), ZPoint( _maxX[node], _maxY[node], _maxZ[node] ) );
+}
+
+float
+ZTriangleBVH::closestPoint( const ZPoint& p, ZPoint& closestPt, int& closestTri, ZFloat3& baryCoords, float maxDist ) const
+{
+	closestTri = -1;
+
+	if( !_numNodes ) { return Z_LARGE; }
+
+	float bestDist2 = ( maxDist < Z_LARGE ) ? ( maxDist*maxDist ) : Z_LARGE;
+
+	int stack[Z_BVH_STACK_SIZE];
+	int top = 0;
+
+	stack[top++] = 0;
+
+	ZFloat3 coeff;
+
+	while( top )
+	{
+		const int node = stack[--top];
+
+		// Equal distances are not culled to break ties by the triangle index.
+		if( _squaredDistance( node, p ) > bestDist2 ) { continue; }
+
+		const int count = _count[node];
+
+		if( count ) { // leaf
+
+			const int start = _offset[node];
+
+			FOR( i, start, start+count )
+			{
+				const ZPoint q( ClosestPointOnTriangle( p, _p0[i], _p1[i], _p2[i], coeff ) );
+				const float dist2 = p.squaredDistanceTo( q );
+
+				if( dist2 > bestDist2 ) { continue; }
+
+				const int tId = _triIds[i];
+
+				if( dist2 == bestDist2 && closestTri >= 0 && tId > closestTri ) { continue; }
+
+				bestDist2  = dist2;
+				closestTri = tId;
+				closestPt  = q;
+				baryCoords = coeff;
+			}
+
+		} else { // for interior node, visit the closer child first
+
+			const int left  = _offset[node];
+			const int right = left+1;
+
+			const float lDist2 = _squaredDistance( left,  p );
+			const float rDist2 = _squaredDistance( right, p );
+
+			if( lDist2 < rDist2 ) {
+				if( rDist2 <= bestDist2 ) { stack[top++] = right; }
+				if( lDist2 <= bestDist2 ) { stack[top++] = left;  }
+			} else {
+				if( lDist2 <= bestDist2 ) { stack[top++] = left;  }
+				if( rDist2 <= bestDist2 ) { stack[top++] = right; }
+			}
+
+		}
+	}
+
+	if( closestTri < 0 ) { return Z_LARGE; }
+
+	return sqrtf( bestDist2 );
+}
+
+float
+ZTriangleBVH::intersectRay( const ZRay& ray, int& hitTri, ZFloat3& baryCoords ) const
+{
+	return _intersectRay( ray.origin(), ray.direction().direction(), ray.min(), ray.max(), hitTri, baryCoords );
+}
+
+// the smallest magnitude of a direction component in the slab test
+#define Z_BVH_MIN_DIR 1e-30f
+
+// 1/d which is finite even for d=0 (keeping the sign),
+// so that a ray on a box plane gives 0*(1/d)=0 instead of NaN, and the grazing hits are not culled.
+static inline float
+SafeInverse( float d )
+{
+	return ( 1.f / ( ( fabsf(d) >= Z_BVH_MIN_DIR ) ? d : ( ( d < 0.f ) ? -Z_BVH_MIN_DIR : Z_BVH_MIN_DIR ) ) );
+}
+
+float
+ZTriangleBVH::_intersectRay( const ZPoint& o, const ZVector& dir, float tMin, float tMax, int& hitTri, ZFloat3& baryCoords ) const
+{
+	hitTri = -1;
+	baryCoords.zeroize();
+
+	if( !_numNodes ) { return Z_LARGE; }
+
+	const float ix = SafeInverse( dir.x );
+	const float iy = SafeInverse( dir.y );
+	const float iz = SafeInverse( dir.z );
+
+	float bestT = tMax;
+
+	int stack[Z_BVH_STACK_SIZE];
+	int top = 0;
+
+	stack[top++] = 0;
+
+	while( top )
+	{
+		const int node = stack[--top];
+
+		// slab test
+		const float tx0 = ( _minX[node] - o.x ) * ix,  tx1 = ( _maxX[node] - o.x ) * ix;
+		const float ty0 = ( _minY[node] - o.y ) * iy,  ty1 = ( _maxY[node] - o.y ) * iy;
+		const float tz0 = ( _minZ[node] - o.z ) * iz,  tz1 = ( _maxZ[node] - o.z ) * iz;
+
+		const float tNear = ZMax( ZMax( ZMin(tx0,tx1), ZMin(ty0,ty1) ), ZMax( ZMin(tz0,tz1), tMin ) );
+		const float tFar  = ZMin( ZMin( ZMax(tx0,tx1), ZMax(ty0,ty1) ), ZMax(tz0,tz1) );
+
+		if( !( tNear <= tFar && tNear <= bestT ) ) { continue; }
+
+		const int count = _count[node];
+
+		if( count ) { // leaf
+
+			const int start = _offset[node];
+
+			FOR( i, start, start+count )
+			{
+				// Moller-Trumbore
+				const ZPoint& A = _p0[i];
+				const ZVector e1( _p1[i] - A );
+				const ZVector e2( _p2[i] - A );
+
+				const ZVector pv( dir ^ e2 );
+				const float det = e1 * pv;
+				if( det == 0.f ) { continue; }
+
+				const float invDet = 1.f / det;
+
+				const ZVector tv( o - A );
+				const float u = ( tv * pv ) * invDet;
+				if( !( u >= 0.f ) ) { continue; }
+
+				const ZVector qv( tv ^ e1 );
+				const float v = ( dir * qv ) * invDet;
+				if( !( v >= 0.f && u+v <= 1.f ) ) { continue; }
+
+				const float t = ( e2 * qv ) * invDet;
+				if( !( t >= tMin && t <= bestT ) ) { continue; }
+
+				const int tId = _triIds[i];
+
+				if( t == bestT && hitTri >= 0 && tId > hitTri ) { continue; }
+
+				bestT  = t;
+				hitTri = tId;
+				baryCoords.set( 1.f-u-v, u, v );
+			}
+
+		} else {
+
+			stack[top++] = _offset[node]+1;
+			stack[top++] = _offset[node];
+
+		}
+	}
+
+	if( hitTri < 0 ) { return Z_LARGE; }
+
+	return bestT;
+}
+
+// 10 bits -> 30 bits (two zeros between the bits)
+static inline unsigned int
+SpreadBits( unsigned int x )
+{
+	x = ( x | ( x << 16 ) ) & 0x030000FF;
+	x = ( x | ( x <<  8 ) ) & 0x0300F00F;
+	x = ( x | ( x <<  4 ) ) & 0x030C30C3;
+	x = ( x | ( x <<  2 ) ) & 0x09249249;
+	return x;
+}
+
+// the query indices sorted by the Morton codes of the points (the ties by the index)
+static void
+QueryOrder( const ZPointArray& points, std::vector<int>& order, bool useOpenMP )
+{
+	const int n = points.length();
+
+	ZBoundingBox box;
+	FOR( i, 0, n ) { box.expand( points[i] ); }
+
+	const ZPoint  minPt = box.minPoint();
+	const ZVector size  = box.maxPoint() - minPt;
+
+	const float sx = 1023.f / ZMax( size.x, Z_EPS );
+	const float sy = 1023.f / ZMax( size.y, Z_EPS );
+	const float sz = 1023.f / ZMax( size.z, Z_EPS );
+
+	std::vector<uint64_t> keys( n );
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( i, 0, n )
+	{
+		const ZPoint& p = points[i];
+
+		const unsigned int x = (unsigned int)ZClamp( ( p.x - minPt.x ) * sx, 0.f, 1023.f );
+		const unsigned int y = (unsigned int)ZClamp( ( p.y - minPt.y ) * sy, 0.f, 1023.f );
+		const unsigned int z = (unsigned int)ZClamp( ( p.z - minPt.z ) * sz, 0.f, 1023.f );
+
+		const uint64_t code = ( SpreadBits(x) << 2 ) | ( SpreadBits(y) << 1 ) | SpreadBits(z);
+
+		keys[i] = ( code << 32 ) | (uint64_t)i;
+	}
+
+	std::sort( keys.begin(), keys.end() );
+
+	order.resize( n );
+	FOR( i, 0, n ) { order[i] = (int)( keys[i] & 0xffffffff ); }
+}
+
+void
+ZTriangleBVH::closestPoints( const ZPointArray& points, ZFloatArray& dists, ZPointArray& closestPts, ZIntArray& closestTris, ZFloat3Array& baryCoords, float maxDist, bool useOpenMP ) const
+{
+	ZPROFILE_SCOPE( "ZTriangleBVH::closestPoints" );
+
+	const int n = points.length();
+
+	dists       .setLength( n, false );
+	closestPts  .setLength( n, false );
+	closestTris .setLength( n, false );
+	baryCoords  .setLength( n, false );
+
+	if( n == 0 ) { return; }
+
+	// The packets are made in the Morton order of the queries.
+	// (The packet of the scattered queries traverses the union of their paths, which is slower than the single queries.)
+	std::vector<int> order;
+	QueryOrder( points, order, useOpenMP );
+
+	const int numPackets = ( n + Z_BVH_PACKET_SIZE-1 ) / Z_BVH_PACKET_SIZE;
+
+	#pragma omp parallel for schedule(dynamic,64) if( useOpenMP )
+	FOR( k, 0, numPackets )
+	{
+		const int start = k * Z_BVH_PACKET_SIZE;
+		const int count = ZMin( Z_BVH_PACKET_SIZE, n-start );
+
+		ZPoint  p[Z_BVH_PACKET_SIZE], q[Z_BVH_PACKET_SIZE];
+		ZFloat3 bary[Z_BVH_PACKET_SIZE];
+		float   dist[Z_BVH_PACKET_SIZE];
+		int     tri[Z_BVH_PACKET_SIZE];
+
+		// The last packet is padded by repeating its last query.
+		FOR( l, 0, Z_BVH_PACKET_SIZE ) { p[l] = points[ order[ start + ZMin(l,count-1) ] ]; }
+
+		_closestPointPacket( p, maxDist, dist, tri, q, bary );
+
+		FOR( l, 0, count )
+		{
+			const int i = order[ start + l ];
+
+			dists[i]       = dist[l];
+			closestTris[i] = tri[l];
+			closestPts[i]  = q[l];
+			baryCoords[i]  = bary[l];
+		}
+	}
+}
+
+void
+ZTriangleBVH::intersectRays( const ZPointArray& origins, const ZVectorArray& directions, ZFloatArray& hitDists, ZIntArray& hitTris, ZFloat3Array& baryCoords, float maxDist, bool useOpenMP ) const
+{
+	const int n = origins.length();
+
+	if( directions.length() != n )
+	{
+		cout << "Error@ZTriangleBVH::intersectRays(): Invalid input data." << endl;
+		hitDists.clear();   hitTris.clear();   baryCoords.clear();
+		return;
+	}
+
+	hitDists   .setLength( n, false );
+	hitTris    .setLength( n, false );
+	baryCoords .setLength( n, false );
+
+	const int numPackets = ( n + Z_BVH_PACKET_SIZE-1 ) / Z_BVH_PACKET_SIZE;
+
+	#pragma omp parallel for schedule(dynamic,64) if( useOpenMP )
+	FOR( k, 0, numPackets )
+	{
+		const int start = k * Z_BVH_PACKET_SIZE;
+		const int count = ZMin( Z_BVH_PACKET_SIZE, n-start );
+
+		ZPoint  o[Z_BVH_PACKET_SIZE];
+		ZVector d[Z_BVH_PACKET_SIZE];
+		ZFloat3 bary[Z_BVH_PACKET_SIZE];
+		float   dist[Z_BVH_PACKET_SIZE];
+		int     tri[Z_BVH_PACKET_SIZE];
+
+		FOR( l, 0, Z_BVH_PACKET_SIZE )
+		{
+			const int i = start + ZMin(l,count-1);
+
+			o[l] = origins[i];
+			d[l] = directions[i].direction();
+		}
+
+		_intersectRayPacket( o, d, maxDist, dist, tri, bary );
+
+		FOR( l, 0, count )
+		{
+			const int i = start + l;
+
+			hitDists[i]   = dist[l];
+			hitTris[i]    = tri[l];
+			baryCoords[i] = bary[l];
+		}
+	}
+}
+
+#ifdef Z_BVH_SSE
+
+// lane-wise mask ? a : b
+static inline __m128
+Select( __m128 mask, __m128 a, __m128 b )
+{
+	return _mm_or_ps( _mm_and_ps( mask, a ), _mm_andnot_ps( mask, b ) );
+}
+
+static inline __m128i
+Select( __m128 mask, __m128i a, __m128i b )
+{
+	const __m128i m = _mm_castps_si128( mask );
+	return _mm_or_si128( _mm_and_si128( m, a ), _mm_andnot_si128( m, b ) );
+}
+
+// the same as SafeInverse() for four lanes
+static inline __m128
+SafeInverse( __m128 d )
+{
+	const __m128 sign  = _mm_and_ps( d, _mm_castsi128_ps( _mm_set1_epi32( (int)0x80000000 ) ) );
+	const __m128 small = _mm_cmplt_ps( _mm_andnot_ps( _mm_castsi128_ps( _mm_set1_epi32( (int)0x80000000 ) ), d ), _mm_set1_ps( Z_BVH_MIN_DIR ) );
+
+	return _mm_div_ps( _mm_set1_ps(1.f), Select( small, _mm_or_ps( _mm_set1_ps( Z_BVH_MIN_DIR ), sign ), d ) );
+}
+
+// the same as ZClamp(x,0,1) including signed zeros and NaNs
+static inline __m128
+Clamp01( __m128 x )
+{
+	return _mm_min_ps( _mm_set1_ps(1.f), _mm_max_ps( _mm_setzero_ps(), x ) );
+}
+
+// the number of lanes where a < b
+static inline int
+NumLess( __m128 a, __m128 b )
+{
+	const int m = _mm_movemask_ps( _mm_cmplt_ps( a, b ) );
+	return ( (m&1) + ((m>>1)&1) + ((m>>2)&1) + ((m>>3)&1) );
+}
+
+#endif
+
+void
+ZTriangleBVH::_closestPointPacket( const ZPoint* p, float maxDist, float* dist, int* tri, ZPoint* q, ZFloat3* bary ) const
+{
+	#ifdef Z_BVH_SSE
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one  = _mm_set1_ps( 1.f );
+	const __m128 sign = _mm_set1_ps( -0.f );
+
+	const __m128 px = _mm_setr_ps( p[0].x, p[1].x, p[2].x, p[3].x );
+	const __m128 py = _mm_setr_ps( p[0].y, p[1].y, p[2].y, p[3].y );
+	const __m128 pz = _mm_setr_ps( p[0].z, p[1].z, p[2].z, p[3].z );
+
+	__m128  bestDist2 = _mm_set1_ps( ( maxDist < Z_LARGE ) ? ( maxDist*maxDist ) : Z_LARGE );
+	__m128i bestTri   = _mm_set1_epi32( -1 );
+	__m128  bestS     = zero;
+	__m128  bestT     = zero;
+	__m128  bestX     = zero;
+	__m128  bestY     = zero;
+	__m128  bestZ     = zero;
+
+	// the squared distances from the node box
+	#define Z_BVH_BOX_DIST2( node, result )                                                                                   \
+	{                                                                                                                        \
+		const __m128 dx = _mm_max_ps( _mm_max_ps( _mm_sub_ps( _mm_set1_ps(_minX[node]), px ), _mm_sub_ps( px, _mm_set1_ps(_maxX[node]) ) ), zero ); \
+		const __m128 dy = _mm_max_ps( _mm_max_ps( _mm_sub_ps( _mm_set1_ps(_minY[node]), py ), _mm_sub_ps( py, _mm_set1_ps(_maxY[node]) ) ), zero ); \
+		const __m128 dz = _mm_max_ps( _mm_max_ps( _mm_sub_ps( _mm_set1_ps(_minZ[node]), pz ), _mm_sub_ps( pz, _mm_set1_ps(_maxZ[node]) ) ), zero ); \
+		result = _mm_add_ps( _mm_add_ps( _mm_mul_ps(dx,dx), _mm_mul_ps(dy,dy) ), _mm_mul_ps(dz,dz) );                       \
+	}
+
+	int stack[Z_BVH_STACK_SIZE];
+	int top = 0;
+
+	if( _numNodes ) { stack[top++] = 0; }
+
+	while( top )
+	{
+		const int node = stack[--top];
+
+		__m128 nodeDist2;
+		Z_BVH_BOX_DIST2( node, nodeDist2 );
+
+		if( !_mm_movemask_ps( _mm_cmple_ps( nodeDist2, bestDist2 ) ) ) { continue; }
+
+		const int count = _count[node];
+
+		if( count ) { // leaf
+
+			const int start = _offset[node];
+
+			FOR( i, start, start+count )
+			{
+				// ClosestPointOnTriangle() for four points
+				const ZPoint& A = _p0[i];
+				const ZVector AB( _p1[i]-A ), AC( _p2[i]-A );
+
+				const float a = AB*AB, b = AB*AC, c = AC*AC;
+				const float det = a*c-b*b;
+				const float invDet = 1.f/det;
+				const float denom = a-2*b+c;
+
+				const __m128 va = _mm_set1_ps(a), vb = _mm_set1_ps(b), vc = _mm_set1_ps(c);
+
+				const __m128 PAx = _mm_sub_ps( _mm_set1_ps(A.x), px );
+				const __m128 PAy = _mm_sub_ps( _mm_set1_ps(A.y), py );
+				const __m128 PAz = _mm_sub_ps( _mm_set1_ps(A.z), pz );
+
+				const __m128 d = _mm_add_ps( _mm_add_ps( _mm_mul_ps( _mm_set1_ps(AB.x), PAx ), _mm_mul_ps( _mm_set1_ps(AB.y), PAy ) ), _mm_mul_ps( _mm_set1_ps(AB.z), PAz ) );
+				const __m128 e = _mm_add_ps( _mm_add_ps( _mm_mul_ps( _mm_set1_ps(AC.x), PAx ), _mm_mul_ps( _mm_set1_ps(AC.y), PAy ) ), _mm_mul_ps( _mm_set1_ps(AC.z), PAz ) );
+
+				const __m128 s = _mm_sub_ps( _mm_mul_ps(vb,e), _mm_mul_ps(vc,d) );
+				const __m128 t = _mm_sub_ps( _mm_mul_ps(vb,d), _mm_mul_ps(va,e) );
+
+				const __m128 sNeg = _mm_cmplt_ps( s, zero );
+				const __m128 tNeg = _mm_cmplt_ps( t, zero );
+
+				const __m128 sd = Clamp01( _mm_div_ps( _mm_xor_ps(d,sign), va ) ); // ZClamp(-d/a,0,1)
+				const __m128 te = Clamp01( _mm_div_ps( _mm_xor_ps(e,sign), vc ) ); // ZClamp(-e/c,0,1)
+
+				// s+t < det
+				__m128 s0 = _mm_mul_ps( s, _mm_set1_ps(invDet) );
+				__m128 t0 = _mm_mul_ps( t, _mm_set1_ps(invDet) );
+				{
+					const __m128 bothNeg = _mm_and_ps( sNeg, tNeg );
+					const __m128 dNeg    = _mm_cmplt_ps( d, zero );
+					const __m128 useSd   = _mm_or_ps( _mm_andnot_ps( sNeg, tNeg ), _mm_and_ps( bothNeg, dNeg ) );
+					const __m128 useTe   = _mm_or_ps( _mm_andnot_ps( tNeg, sNeg ), _mm_andnot_ps( dNeg, bothNeg ) );
+
+					s0 = Select( useSd, sd, Select( useTe, zero, s0 ) );
+					t0 = Select( useSd, zero, Select( useTe, te, t0 ) );
+				}
+
+				// s+t >= det
+				__m128 s1, t1;
+				{
+					const __m128 vDenom = _mm_set1_ps(denom);
+					const __m128 tmp0   = _mm_add_ps( vb, d );
+					const __m128 tmp1   = _mm_add_ps( vc, e );
+
+					const __m128 sEdge0 = Clamp01( _mm_div_ps( _mm_sub_ps( tmp1, tmp0 ), vDenom ) );
+					const __m128 sEdge1 = Clamp01( _mm_div_ps( _mm_sub_ps( _mm_sub_ps( tmp1, vb ), d ), vDenom ) );
+
+					const __m128 sCase = _mm_cmpgt_ps( tmp1, tmp0 );
+					const __m128 tCase = _mm_cmpgt_ps( _mm_add_ps( va, d ), _mm_add_ps( vb, e ) );
+
+					const __m128 sEdge0Sel = _mm_and_ps( sNeg, sCase );
+					const __m128 sTe       = _mm_andnot_ps( sCase, sNeg );
+					const __m128 tSd       = _mm_andnot_ps( sNeg, _mm_andnot_ps( tCase, tNeg ) );
+
+					s1 = Select( sEdge0Sel, sEdge0, sEdge1 );
+					t1 = _mm_sub_ps( one, s1 );
+
+					s1 = Select( sTe, zero, Select( tSd, sd, s1 ) );
+					t1 = Select( sTe, te, Select( tSd, zero, t1 ) );
+				}
+
+				const __m128 inside = _mm_cmplt_ps( _mm_add_ps(s,t), _mm_set1_ps(det) );
+
+				const __m128 S = Select( inside, s0, s1 );
+				const __m128 T = Select( inside, t0, t1 );
+
+				const __m128 qx = _mm_add_ps( _mm_add_ps( _mm_set1_ps(A.x), _mm_mul_ps( S, _mm_set1_ps(AB.x) ) ), _mm_mul_ps( T, _mm_set1_ps(AC.x) ) );
+				const __m128 qy = _mm_add_ps( _mm_add_ps( _mm_set1_ps(A.y), _mm_mul_ps( S, _mm_set1_ps(AB.y) ) ), _mm_mul_ps( T, _mm_set1_ps(AC.y) ) );
+				const __m128 qz = _mm_add_ps( _mm_add_ps( _mm_set1_ps(A.z), _mm_mul_ps( S, _mm_set1_ps(AB.z) ) ), _mm_mul_ps( T, _mm_set1_ps(AC.z) ) );
+
+				const __m128 dx = _mm_sub_ps( qx, px );
+				const __m128 dy = _mm_sub_ps( qy, py );
+				const __m128 dz = _mm_sub_ps( qz, pz );
+
+				const __m128 dist2 = _mm_add_ps( _mm_add_ps( _mm_mul_ps(dx,dx), _mm_mul_ps(dy,dy) ), _mm_mul_ps(dz,dz) );
+
+				// the same tie-break as closestPoint()
+				const __m128i tId  = _mm_set1_epi32( _triIds[i] );
+				const __m128i tieI = _mm_or_si128( _mm_cmplt_epi32( bestTri, _mm_setzero_si128() ), _mm_cmplt_epi32( tId, bestTri ) );
+				const __m128  tie  = _mm_and_ps( _mm_cmpeq_ps( dist2, bestDist2 ), _mm_castsi128_ps( tieI ) );
+				const __m128  upd  = _mm_or_ps( _mm_cmplt_ps( dist2, bestDist2 ), tie );
+
+				if( !_mm_movemask_ps( upd ) ) { continue; }
+
+				bestDist2 = Select( upd, dist2, bestDist2 );
+				bestTri   = Select( upd, tId,   bestTri   );
+				bestS     = Select( upd, S,     bestS     );
+				bestT     = Select( upd, T,     bestT     );
+				bestX     = Select( upd, qx,    bestX     );
+				bestY     = Select( upd, qy,    bestY     );
+				bestZ     = Select( upd, qz,    bestZ     );
+			}
+
+		} else { // for interior node, visit the closer child first (by the majority of the lanes)
+
+			const int left  = _offset[node];
+			const int right = left+1;
+
+			__m128 lDist2, rDist2;
+			Z_BVH_BOX_DIST2( left,  lDist2 );
+			Z_BVH_BOX_DIST2( right, rDist2 );
+
+			const bool lActive = _mm_movemask_ps( _mm_cmple_ps( lDist2, bestDist2 ) );
+			const bool rActive = _mm_movemask_ps( _mm_cmple_ps( rDist2, bestDist2 ) );
+
+			if( NumLess( lDist2, rDist2 ) >= 2 ) {
+				if( rActive ) { stack[top++] = right; }
+				if( lActive ) { stack[top++] = left;  }
+			} else {
+				if( lActive ) { stack[top++] = left;  }
+				if( rActive ) { stack[top++] = right; }
+			}
+
+		}
+	}
+
+	#undef Z_BVH_BOX_DIST2
+
+	float d2[4], s[4], t[4], x[4], y[4], z[4];
+
+	_mm_storeu_ps( d2, bestDist2 );
+	_mm_storeu_ps( s,  bestS );
+	_mm_storeu_ps( t,  bestT );
+	_mm_storeu_ps( x,  bestX );
+	_mm_storeu_ps( y,  bestY );
+	_mm_storeu_ps( z,  bestZ );
+	_mm_storeu_si128( (__m128i*)tri, bestTri );
+
+	FOR( l, 0, Z_BVH_PACKET_SIZE )
+	{
+		if( tri[l] < 0 ) {
+
+			dist[l] = Z_LARGE;
+			q[l].set( Z_LARGE, Z_LARGE, Z_LARGE );
+			bary[l].zeroize();
+
+		} else {
+
+			dist[l] = sqrtf( d2[l] );
+			q[l].set( x[l], y[l], z[l] );
+			bary[l].set( (1-s[l]-t[l]), s[l], t[l] );
+
+		}
+	}
+
+	#else
+
+	FOR( l, 0, Z_BVH_PACKET_SIZE )
+	{
+		dist[l] = closestPoint( p[l], q[l], tri[l], bary[l], maxDist );
+
+		if( tri[l] < 0 )
+		{
+			q[l].set( Z_LARGE, Z_LARGE, Z_LARGE );
+			bary[l].zeroize();
+		}
+	}
+
+	#endif
+}
+
+void
+ZTriangleBVH::_intersectRayPacket( const ZPoint* o, const ZVector* dir, float tMax, float* dist, int* tri, ZFloat3* bary ) const
+{
+	#ifdef Z_BVH_SSE
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one  = _mm_set1_ps( 1.f );
+
+	const __m128 ox = _mm_setr_ps( o[0].x, o[1].x, o[2].x, o[3].x );
+	const __m128 oy = _mm_setr_ps( o[0].y, o[1].y, o[2].y, o[3].y );
+	const __m128 oz = _mm_setr_ps( o[0].z, o[1].z, o[2].z, o[3].z );
+
+	const __m128 dx = _mm_setr_ps( dir[0].x, dir[1].x, dir[2].x, dir[3].x );
+	const __m128 dy = _mm_setr_ps( dir[0].y, dir[1].y, dir[2].y, dir[3].y );
+	const __m128 dz = _mm_setr_ps( dir[0].z, dir[1].z, dir[2].z, dir[3].z );
+
+	const __m128 ix = SafeInverse( dx );
+	const __m128 iy = SafeInverse( dy );
+	const __m128 iz = SafeInverse( dz );
+
+	__m128  bestT   = _mm_set1_ps( tMax );
+	__m128i bestTri = _mm_set1_epi32( -1 );
+	__m128  bestU   = zero;
+	__m128  bestV   = zero;
+
+	int stack[Z_BVH_STACK_SIZE];
+	int top = 0;
+
+	if( _numNodes ) { stack[top++] = 0; }
+
+	while( top )
+	{
+		const int node = stack[--top];
+
+		// slab test (the same as _intersectRay())
+		{
+			const __m128 tx0 = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps(_minX[node]), ox ), ix );
+			const __m128 tx1 = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps(_maxX[node]), ox ), ix );
+			const __m128 ty0 = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps(_minY[node]), oy ), iy );
+			const __m128 ty1 = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps(_maxY[node]), oy ), iy );
+			const __m128 tz0 = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps(_minZ[node]), oz ), iz );
+			const __m128 tz1 = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps(_maxZ[node]), oz ), iz );
+
+			const __m128 tNear = _mm_max_ps( _mm_max_ps( _mm_min_ps(tx0,tx1), _mm_min_ps(ty0,ty1) ), _mm_max_ps( _mm_min_ps(tz0,tz1), zero ) );
+			const __m128 tFar  = _mm_min_ps( _mm_min_ps( _mm_max_ps(tx0,tx1), _mm_max_ps(ty0,ty1) ), _mm_max_ps(tz0,tz1) );
+
+			if( !_mm_movemask_ps( _mm_and_ps( _mm_cmple_ps( tNear, tFar ), _mm_cmple_ps( tNear, bestT ) ) ) ) { continue; }
+		}
+
+		const int count = _count[node];
+
+		if( count ) { // leaf
+
+			const int start = _offset[node];
+
+			FOR( i, start, start+count )
+			{
+				// Moller-Trumbore for four rays
+				const ZPoint& A = _p0[i];
+				const ZVector e1( _p1[i] - A );
+				const ZVector e2( _p2[i] - A );
+
+				const __m128 e1x = _mm_set1_ps(e1.x), e1y = _mm_set1_ps(e1.y), e1z = _mm_set1_ps(e1.z);
+				const __m128 e2x = _mm_set1_ps(e2.x), e2y = _mm_set1_ps(e2.y), e2z = _mm_set1_ps(e2.z);
+
+				const __m128 pvx = _mm_sub_ps( _mm_mul_ps(dy,e2z), _mm_mul_ps(dz,e2y) );
+				const __m128 pvy = _mm_sub_ps( _mm_mul_ps(dz,e2x), _mm_mul_ps(dx,e2z) );
+				const __m128 pvz = _mm_sub_ps( _mm_mul_ps(dx,e2y), _mm_mul_ps(dy,e2x) );
+
+				const __m128 det    = _mm_add_ps( _mm_add_ps( _mm_mul_ps(e1x,pvx), _mm_mul_ps(e1y,pvy) ), _mm_mul_ps(e1z,pvz) );
+				const __m128 invDet = _mm_div_ps( one, det );
+
+				const __m128 tvx = _mm_sub_ps( ox, _mm_set1_ps(A.x) );
+				const __m128 tvy = _mm_sub_ps( oy, _mm_set1_ps(A.y) );
+				const __m128 tvz = _mm_sub_ps( oz, _mm_set1_ps(A.z) );
+
+				const __m128 u = _mm_mul_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps(tvx,pvx), _mm_mul_ps(tvy,pvy) ), _mm_mul_ps(tvz,pvz) ), invDet );
+
+				const __m128 qvx = _mm_sub_ps( _mm_mul_ps(tvy,e1z), _mm_mul_ps(tvz,e1y) );
+				const __m128 qvy = _mm_sub_ps( _mm_mul_ps(tvz,e1x), _mm_mul_ps(tvx,e1z) );
+				const __m128 qvz = _mm_sub_ps( _mm_mul_ps(tvx,e1y), _mm_mul_ps(tvy,e1x) );
+
+				const __m128 v = _mm_mul_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps(dx,qvx), _mm_mul_ps(dy,qvy) ), _mm_mul_ps(dz,qvz) ), invDet );
+				const __m128 t = _mm_mul_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps(e2x,qvx), _mm_mul_ps(e2y,qvy) ), _mm_mul_ps(e2z,qvz) ), invDet );
+
+				__m128 hit = _mm_cmpneq_ps( det, zero );
+				hit = _mm_and_ps( hit, _mm_cmpge_ps( u, zero ) );
+				hit = _mm_and_ps( hit, _mm_cmpge_ps( v, zero ) );
+				hit = _mm_and_ps( hit, _mm_cmple_ps( _mm_add_ps(u,v), one ) );
+				hit = _mm_and_ps( hit, _mm_cmpge_ps( t, zero ) );
+
+				// the same tie-break as _intersectRay()
+				const __m128i tId  = _mm_set1_epi32( _triIds[i] );
+				const __m128i tieI = _mm_or_si128( _mm_cmplt_epi32( bestTri, _mm_setzero_si128() ), _mm_cmplt_epi32( tId, bestTri ) );
+				const __m128  tie  = _mm_and_ps( _mm_cmpeq_ps( t, bestT ), _mm_castsi128_ps( tieI ) );
+				const __m128  upd  = _mm_and_ps( hit, _mm_or_ps( _mm_cmplt_ps( t, bestT ), tie ) );
+
+				if( !_mm_movemask_ps( upd ) ) { continue; }
+
+				bestT   = Select( upd, t,   bestT   );
+				bestTri = Select( upd, tId, bestTri );
+				bestU   = Select( upd, u,   bestU   );
+				bestV   = Select( upd, v,   bestV   );
+			}
+
+		} else {
+
+			stack[top++] = _offset[node]+1;
+			stack[top++] = _offset[node];
+
+		}
+	}
+
+	float t[4], u[4], v[4];
+
+	_mm_storeu_ps( t, bestT );
+	_mm_storeu_ps( u, bestU );
+	_mm_storeu_ps( v, bestV );
+	_mm_storeu_si128( (__m128i*)tri, bestTri );
+
+	FOR( l, 0, Z_BVH_PACKET_SIZE )
+	{
+		if( tri[l] < 0 ) {
+
+			dist[l] = Z_LARGE;
+			bary[l].zeroize();
+
+		} else {
+
+			dist[l] = t[l];
+			bary[l].set( 1.f-u[l]-v[l], u[l], v[l] );
+
+		}
+	}
+
+	#else
+
+	FOR( l, 0, Z_BVH_PACKET_SIZE )
+	{
+		dist[l] = _intersectRay( o[l], dir[l], 0.f, tMax, tri[l], bary[l] );
+	}
+
+	#endif
+}
+
+void
+ZTriangleBVH::getTriangles( const ZBoundingBox& bBox, ZIntArray& triangles, bool accurate ) const
+{
+	triangles.clear();
+
+	if( !_numNodes ) { return; }
+
+	const ZPoint& m = bBox.minPoint();
+	const ZPoint& M = bBox.maxPoint();
+
+	int stack[Z_BVH_STACK_SIZE];
+	int top = 0;
+
+	stack[top++] = 0;
+
+	while( top )
+	{
+		const int node = stack[--top];
+
+		if( !_intersects( node, bBox ) ) { continue; }
+
+		const int count = _count[node];
+
+		if( count ) { // leaf
+
+			const int start = _offset[node];
+
+			FOR( i, start, start+count )
+			{
+				const ZPoint& p0 = _p0[i];
+				const ZPoint& p1 = _p1[i];
+				const ZPoint& p2 = _p2[i];
+
+				if( ZMax( p0.x, p1.x, p2.x ) < m.x || ZMin( p0.x, p1.x, p2.x ) > M.x ) { continue; }
+				if( ZMax( p0.y, p1.y, p2.y ) < m.y || ZMin( p0.y, p1.y, p2.y ) > M.y ) { continue; }
+				if( ZMax( p0.z, p1.z, p2.z ) < m.z || ZMin( p0.z, p1.z, p2.z ) > M.z ) { continue; }
+
+				if( accurate && !bBox.intersectsWithTriangle( p0, p1, p2 ) ) { continue; }
+
+				triangles.push_back( _triIds[i] );
+			}
+
+		} else {
+
+			stack[top++] = _offset[node]+1;
+			stack[top++] = _offset[node];
+
+		}
+	}
+
+	std::sort( triangles.begin(), triangles.end() );
+}
+
+double
+ZTriangleBVH::usedMemorySize( ZDataUnit::DataUnit dataUnit ) const
+{
+	double size = 0;
+
+	size += _minX.usedMemorySize(dataUnit) + _minY.usedMemorySize(dataUnit) + _minZ.usedMemorySize(dataUnit);
+	size += _maxX.usedMemorySize(dataUnit) + _maxY.usedMemorySize(dataUnit) + _maxZ.usedMemorySize(dataUnit);
+	size += _offset.usedMemorySize(dataUnit) + _count.usedMemorySize(dataUnit) + _triIds.usedMemorySize(dataUnit);
+	size += _p0.usedMemorySize(dataUnit) + _p1.usedMemorySize(dataUnit) + _p2.usedMemorySize(dataUnit);
+
+	return size;
+}
+
+ostream&
+operator<<( ostream& os, const ZTriangleBVH& object )
+{
+	os << "<ZTriangleBVH>" << endl;
+	os << " # of triangles             : " << object.numTriangles() << endl;
+	os << " # of nodes                 : " << object.numNodes() << endl;
+	os << " # of leaf nodes            : " << object.numLeafNodes() << endl;
+	os << " avg. # of triangles / leaf : " << object.averageNumTriangles() << endl;
+	return os;
+}
+
+ZELOS_NAMESPACE_END
+
@@ -2,7 +2,7 @@
 // ZVectorField3D.cpp //
 //-------------------------------------------------------//
 // author: Wanho Choi @ Dexter Studios                   //
-// last update: 2015.10.07                               //
+// last update: 2019.03.30                               //
 //-------------------------------------------------------//
 
 #include <ZelosBase.h>
@@ -86,6 +86,98 @@ ZVectorField3D::exchange( const ZVectorField3D& f )
 	return true;
 }
 
+void
+ZVectorField3D::setNoise( const ZSimplexNoise& noise, float time, bool useOpenMP )
+{
+	ZVector* _data = (ZVector*)ZVectorArray::pointer();
+
+	const int numRows = (_jMax+1)*(_kMax+1);
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( r, 0, numRows )
+	{
+		const int j = r % (_jMax+1);
+		const int k = r / (_jMax+1);
+
+		float x[4], y[4], z[4];
+		float a[4], b[4], c[4];
+		float vx[4], vy[4], vz[4];
+
+		for( int i=0; i<=_iMax; i+=4 )
+		{
+			const int m = ZMin( 4, _iMax+1-i );
+
+			FOR( l, 0, 4 )
+			{
+				const ZPoint p( this->position( i+ZMin(l,m-1), j, k ) );
+				x[l]=p.x; y[l]=p.y; z[l]=p.z;
+			}
+
+			// the three components with the same offsets as ZSimplexNoise::vector()
+			noise.fBm4( x, y, z, time, 1, 1.f, 1.f, 1.f, vx );
+
+			FOR( l, 0, 4 ) { a[l]=y[l]-19.1f; b[l]=z[l]+33.4f; c[l]=x[l]+47.2f; }
+			noise.fBm4( a, b, c, time, 1, 1.f, 1.f, 1.f, vy );
+
+			FOR( l, 0, 4 ) { a[l]=z[l]+74.2f; b[l]=x[l]-124.5f; c[l]=y[l]+99.4f; }
+			noise.fBm4( a, b, c, time, 1, 1.f, 1.f, 1.f, vz );
+
+			const int idx = ZField3DBase::index(i,j,k);
+			FOR( l, 0, m ) { _data[idx+l].set( vx[l], vy[l], vz[l] ); }
+		}
+	}
+}
+
+void
+ZVectorField3D::setCurlNoise( const ZCurlNoise& noise, float time, bool useOpenMP )
+{
+	ZVector* _data = (ZVector*)ZVectorArray::pointer();
+
+	const int numRows = (_jMax+1)*(_kMax+1);
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( r, 0, numRows )
+	{
+		const int j = r % (_jMax+1);
+		const int k = r / (_jMax+1);
+
+		float x[4], y[4], z[4];
+		float vx[4], vy[4], vz[4];
+
+		for( int i=0; i<=_iMax; i+=4 )
+		{
+			const int m = ZMin( 4, _iMax+1-i );
+
+			FOR( l, 0, 4 )
+			{
+				const ZPoint p( this->position( i+ZMin(l,m-1), j, k ) );
+				x[l]=p.x; y[l]=p.y; z[l]=p.z;
+			}
+
+			noise.velocity4( x, y, z, time, vx, vy, vz );
+
+			const int idx = ZField3DBase::index(i,j,k);
+			FOR( l, 0, m ) { _data[idx+l].set( vx[l], vy[l], vz[l] ); }
+		}
+	}
+}
+
+bool
+ZVectorField3D::sample( const ZPointArray& points, ZVectorArray& values, ZInterpolationType::InterpolationType type, bool useOpenMP ) const
+{
+	ZPROFILE_SCOPE( "ZVectorField3D::sample" );
+
+	values.setLength( points.length(), false );
+
+	if( (int)ZVectorArray::size() != _numElements )
+	{
+		cout << "Error@ZVectorField3D::sample(): Invalid field data." << endl;
+		return false;
+	}
+
+	return ZField3DBase::_sample( (const float*)ZVectorArray::pointer(), 3, points, (float*)values.pointer(), type, useOpenMP );
+}
+
 const ZString
 ZVectorField3D::dataType() const
 {
@@ -2,7 +2,7 @@
 // ZVoxelizer.cpp //
 //-------------------------------------------------------//
 // author: Wanho Choi @ Dexter Studios                   //
-// last update: 2018.03.08                               //
+// last update: 2019.03.26                               //
 //-------------------------------------------------------//
 
 #include <ZelosBase.h>
@@ -377,6 +377,8 @@ ZVoxelizer::_tagInterfacialElements()
 void
 ZVoxelizer::finalize()
 {
+	ZPROFILE_SCOPE( "ZVoxelizer::finalize" );
+
 	if( !_lvs || !_stt ) { return; }
 
 	ZScalarField3D& lvs = *_lvs;
@@ -607,6 +609,529 @@ ZVoxelizer::_update( const ZInt3& ijk, int sign )
 	}
 }
 
+bool
+ZVoxelizer::voxelize( ZScalarField3D& lvs, const ZTriMesh& mesh, float negRange, float posRange, bool useOpenMP )
+{
+	return _voxelize( lvs, (ZVectorField3D*)NULL, mesh, (const ZVectorArray*)NULL, negRange, posRange, useOpenMP );
+}
+
+bool
+ZVoxelizer::voxelize( ZScalarField3D& lvs, ZVectorField3D& vel, const ZTriMesh& mesh, const ZVectorArray& vVel, float negRange, float posRange, bool useOpenMP )
+{
+	if( !lvs.directComputable(vel) )
+	{
+		cout << "Error@ZVoxelizer::voxelize(): Not computable fields." << endl;
+		return false;
+	}
+
+	if( mesh.numVertices() != vVel.length() )
+	{
+		cout << "Error@ZVoxelizer::voxelize(): Invalid vertex velocities." << endl;
+		return false;
+	}
+
+	return _voxelize( lvs, &vel, mesh, &vVel, negRange, posRange, useOpenMP );
+}
+
+bool
+ZVoxelizer::_voxelize( ZScalarField3D& lvs, ZVectorField3D* velPtr, const ZTriMesh& mesh, const ZVectorArray* vVelPtr, float negRange, float posRange, bool useOpenMP )
+{
+	ZPROFILE_SCOPE( "ZVoxelizer::voxelize" );
+
+	if( lvs.location()!=ZFieldLocation::zNode && lvs.location()!=ZFieldLocation::zCell )
+	{
+		cout << "Error@ZVoxelizer::voxelize(): Invalid field location." << endl;
+		return false;
+	}
+
+	ZVoxelizer::reset();
+
+	_onCell = (lvs.location()==ZFieldLocation::zCell) ? true : false;
+
+	_iMax = lvs.iMax();
+	_jMax = lvs.jMax();
+	_kMax = lvs.kMax();
+
+	_h = lvs.avgCellSize();
+	_negRange = ZAbs( negRange );
+	_posRange = ZAbs( posRange );
+
+	_lvs = &lvs;
+	_vel = velPtr;
+
+	const ZPointArray& vPos = mesh.p;
+	const ZInt3Array&  v012 = mesh.v012;
+
+	const int numElements  = lvs.numElements();
+	const int numTriangles = v012.length();
+
+	if( velPtr ) { velPtr->zeroize(); }
+
+	if( mesh.numVertices() < 3 || !numTriangles )
+	{
+		lvs.fill( _posRange*_h );
+		lvs.setMinMax( useOpenMP );
+		reset();
+		return true;
+	}
+
+	const int   maxIdx[3] = { _iMax, _jMax, _kMax };
+	const float d[3]      = { lvs.dx(), lvs.dy(), lvs.dz() };
+	const float dd[3]     = { 1/d[0], 1/d[1], 1/d[2] };
+	const float offset[3] = { lvs.minPoint().x + (_onCell ? 0.5f*d[0] : 0.f),
+	                          lvs.minPoint().y + (_onCell ? 0.5f*d[1] : 0.f),
+	                          lvs.minPoint().z + (_onCell ? 0.5f*d[2] : 0.f) };
+
+	// The elements within one cell from the crossings get the exact distances.
+	// Their closest triangles are within this reach (per axis in elements).
+	const float maxD = ZMax( d[0], d[1], d[2] );
+	const float reach[3] = { maxD*dd[0], maxD*dd[1], maxD*dd[2] };
+
+	// per triangle element ranges
+	// lo~hi: the grid lines crossing the box of the triangle (can be empty)
+	// blo~bhi: the elements which can be tagged or reached by the triangle (blo[a]>bhi[a]: out of the grid)
+	ZInt3Array lo( numTriangles ), hi( numTriangles ), blo( numTriangles ), bhi( numTriangles );
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( t, 0, numTriangles )
+	{
+		const ZInt3& v = v012[t];
+		const ZPoint &p0=vPos[v[0]], &p1=vPos[v[1]], &p2=vPos[v[2]];
+
+		FOR( a, 0, 3 )
+		{
+			float minX, maxX;
+			ZMinMax( p0[a], p1[a], p2[a], minX, maxX );
+
+			minX = (minX-offset[a])*dd[a];
+			maxX = (maxX-offset[a])*dd[a];
+
+			lo [t][a] = ZMax( (int)ceilf ( minX ), 0 );
+			hi [t][a] = ZMin( (int)floorf( maxX ), maxIdx[a] );
+			blo[t][a] = ZMax( ZMin( (int)floorf(minX)-1, (int)floorf(minX-reach[a]) ), 0 );
+			bhi[t][a] = ZMin( ZMax( (int)floorf(maxX)+2, (int)ceilf (maxX+reach[a]) ), maxIdx[a] );
+		}
+	}
+
+	// binning the triangles into the 8x8x8 element tiles (in the triangle order)
+	const int tnx = (_iMax+8)>>3, tny = (_jMax+8)>>3, tnz = (_kMax+8)>>3;
+	const int numTiles = tnx*tny*tnz;
+
+	ZIntArray tileStart( numTiles+1 );
+	ZIntArray tileTris;
+	{
+		FOR( iter, 0, 2 )
+		{
+			if( iter == 1 )
+			{
+				FOR( n, 0, numTiles ) { tileStart[n+1] += tileStart[n]; }
+				tileTris.setLength( tileStart[numTiles] );
+				for( int n=numTiles; n>0; --n ) { tileStart[n] = tileStart[n-1]; }
+				tileStart[0] = 0;
+			}
+
+			FOR( t, 0, numTriangles )
+			{
+				const ZInt3 &l=blo[t], &u=bhi[t];
+				if( l[0]>u[0] || l[1]>u[1] || l[2]>u[2] ) { continue; }
+
+				for( int tk=(l[2]>>3); tk<=(u[2]>>3); ++tk )
+				for( int tj=(l[1]>>3); tj<=(u[1]>>3); ++tj )
+				for( int ti=(l[0]>>3); ti<=(u[0]>>3); ++ti )
+				{
+					const int tile = ti + tnx*(tj+tny*tk);
+
+					if( iter == 0 ) { ++tileStart[tile+1];              }
+					else            { tileTris[ tileStart[tile+1]++ ] = t; }
+				}
+			}
+		}
+	}
+
+	float* phi = (float*)lvs.pointer();
+	ZVector* vel = velPtr ? (ZVector*)velPtr->pointer() : (ZVector*)NULL;
+	const ZVector* vVel = vVelPtr ? (const ZVector*)vVelPtr->pointer() : (const ZVector*)NULL;
+
+	std::vector<float> dst( numElements, Z_LARGE );	// unsigned distance in voxels
+	std::vector<char>  sgn( numElements, 0 );			// sign (0: unknown)
+	std::vector<char>  fixed( numElements, 0 );		// interfacial elements
+	std::vector<char>  band( numTiles, 0 );			// tiles to be swept
+
+	// Each tile is owned by one thread, and its triangles are processed in the triangle order.
+	#pragma omp parallel for schedule(dynamic,4) if( useOpenMP )
+	FOR( tile, 0, numTiles )
+	{
+		const int tBegin = tileStart[tile];
+		const int tEnd   = tileStart[tile+1];
+		if( tBegin == tEnd ) { continue; }
+
+		const int tc[3] = { tile%tnx, (tile/tnx)%tny, tile/(tnx*tny) };
+
+		int e0[3], e1[3];	// the element range of the tile
+		FOR( a, 0, 3 ) { e0[a] = tc[a]<<3; e1[a] = ZMin( e0[a]+7, maxIdx[a] ); }
+
+		// the signed distance along the grid lines of each axis crossing the triangles (per element of the tile)
+		float axisDist[3][512];
+
+		FOR( l, 0, 512 ) { axisDist[0][l] = axisDist[1][l] = axisDist[2][l] = Z_LARGE; }
+
+		ZFloat3 baryCoords;
+
+		FOR( n, tBegin, tEnd )
+		{
+			const int t = tileTris[n];
+
+			const ZInt3& v = v012[t];
+			const ZPoint &p0=vPos[v[0]], &p1=vPos[v[1]], &p2=vPos[v[2]];
+
+			const ZVector triNrm( Normal( p0,p1,p2 ) );
+
+			FOR( a, 0, 3 )
+			{
+				if( ZAbs(triNrm[a]) <= _eps ) { continue; }
+
+				const int b = (a+1)%3;	// the other two axes
+				const int c = (a+2)%3;
+
+				const int sign = (triNrm[a]>0) ? (+1) : (-1);
+
+				const int b0 = ZMax( lo[t][b], e0[b] ), b1 = ZMin( hi[t][b], e1[b] );
+				const int c0 = ZMax( lo[t][c], e0[c] ), c1 = ZMin( hi[t][c], e1[c] );
+
+				for( int ec=c0; ec<=c1; ++ec )
+				for( int eb=b0; eb<=b1; ++eb )
+				{{
+					int e[3];
+					e[a]=0; e[b]=eb; e[c]=ec;
+
+					const ZPoint p( offset[0]+e[0]*d[0], offset[1]+e[1]*d[1], offset[2]+e[2]*d[2] );
+
+					// the same crossing test as _tagInterfacialElements()
+					if( BaryCoords( p, p0,p1,p2, b, baryCoords ) != 1 ) { continue; }
+
+					const float x = ( baryCoords[0]*p0[a] + baryCoords[1]*p1[a] + baryCoords[2]*p2[a] ) - offset[a];
+
+					const int I = int(x*dd[a]);
+					if( I < 0 || I > maxIdx[a] ) { continue; }
+
+					const int candidates[4] = { I, I+1, I+2, I-1 };
+
+					FOR( m, 0, 4 )
+					{
+						e[a] = candidates[m];
+						if( e[a] < e0[a] || e[a] > e1[a] ) { continue; }
+
+						const float est = sign * ( e[a]*d[a] - x );
+						const int   l   = ZSparseField3DBase::localIndex( e[0], e[1], e[2] );
+
+						float& f = axisDist[a][l];
+						if( ZAbs(f) > ZAbs(est) ) { f = est; }
+					}
+				}}
+			}
+		}
+
+		// the elements within one cell from the crossings: the sign of the nearest crossing
+		// (dist2: the squared exact distance, -1: not an interfacial element)
+		float dist2[512];
+		char  nearestSign[512];
+
+		FOR( l, 0, 512 )
+		{
+			dist2[l] = -1.f;
+
+			float minAbs = Z_LARGE;
+			FOR( a, 0, 3 ) { minAbs = ZMin( minAbs, ZAbs( axisDist[a][l] ) ); }
+
+			if( minAbs > maxD ) { continue; }
+
+			dist2[l] = Z_LARGE;
+
+			int a = 0;
+			if( ZAbs(axisDist[1][l]) < ZAbs(axisDist[a][l]) ) { a = 1; }
+			if( ZAbs(axisDist[2][l]) < ZAbs(axisDist[a][l]) ) { a = 2; }
+
+			nearestSign[l] = (axisDist[a][l]<0) ? (-1) : (+1);
+		}
+
+		// their exact distances (all the triangles within the reach are in the bin)
+		FOR( n, tBegin, tEnd )
+		{
+			const int t = tileTris[n];
+
+			const ZInt3& v = v012[t];
+			const ZPoint &p0=vPos[v[0]], &p1=vPos[v[1]], &p2=vPos[v[2]];
+
+			ZPoint minP, maxP;
+			ZMinMax( p0.x,p1.x,p2.x, minP.x,maxP.x );
+			ZMinMax( p0.y,p1.y,p2.y, minP.y,maxP.y );
+			ZMinMax( p0.z,p1.z,p2.z, minP.z,maxP.z );
+
+			int r0[3], r1[3];
+			FOR( a, 0, 3 )
+			{
+				r0[a] = ZMax( (int)ceilf ( (minP[a]-offset[a])*dd[a] - reach[a] ), e0[a] );
+				r1[a] = ZMin( (int)floorf( (maxP[a]-offset[a])*dd[a] + reach[a] ), e1[a] );
+			}
+
+			for( int k=r0[2]; k<=r1[2]; ++k )
+			for( int j=r0[1]; j<=r1[1]; ++j )
+			for( int i=r0[0]; i<=r1[0]; ++i )
+			{{
+				const int l = ZSparseField3DBase::localIndex(i,j,k);
+				if( dist2[l] < 0 ) { continue; }
+
+				const ZPoint p( offset[0]+i*d[0], offset[1]+j*d[1], offset[2]+k*d[2] );
+
+				// the lower bound: the distance to the bounding box of the triangle
+				const float bx = ZMax( minP.x-p.x, 0.f, p.x-maxP.x );
+				const float by = ZMax( minP.y-p.y, 0.f, p.y-maxP.y );
+				const float bz = ZMax( minP.z-p.z, 0.f, p.z-maxP.z );
+				if( bx*bx + by*by + bz*bz >= dist2[l] ) { continue; }
+
+				const float dd2 = p.squaredDistanceTo( ClosestPointOnTriangle( p, p0,p1,p2, baryCoords ) );
+				if( dd2 >= dist2[l] ) { continue; }
+
+				dist2[l] = dd2;
+				if( vel ) { vel[ lvs.index(i,j,k) ] = WeightedSum( vVel[v[0]], vVel[v[1]], vVel[v[2]], baryCoords ); }
+			}}
+		}
+
+		for( int k=e0[2]; k<=e1[2]; ++k )
+		for( int j=e0[1]; j<=e1[1]; ++j )
+		for( int i=e0[0]; i<=e1[0]; ++i )
+		{{
+			const int l = ZSparseField3DBase::localIndex(i,j,k);
+			if( dist2[l] < 0 ) { continue; }
+
+			const int idx = lvs.index(i,j,k);
+
+			dst[idx]   = sqrtf( dist2[l] ) / _h;
+			sgn[idx]   = nearestSign[l];
+			fixed[idx] = 1;
+
+			band[tile] = 1;
+		}}
+	}
+
+	// the tiles which can have the elements within the narrow band
+	{
+		const int R = ( 7 + (int)ceilf( ZMax( _negRange, _posRange ) ) + 1 ) >> 3;
+
+		std::vector<char> seed( band );
+
+		#pragma omp parallel for if( useOpenMP )
+		FOR( tile, 0, numTiles )
+		{
+			if( seed[tile] ) { continue; }
+
+			const int ti=tile%tnx, tj=(tile/tnx)%tny, tk=tile/(tnx*tny);
+
+			for( int k=ZMax(tk-R,0); k<=ZMin(tk+R,tnz-1) && !band[tile]; ++k )
+			for( int j=ZMax(tj-R,0); j<=ZMin(tj+R,tny-1) && !band[tile]; ++j )
+			for( int i=ZMax(ti-R,0); i<=ZMin(ti+R,tnx-1); ++i )
+			{
+				if( seed[ i+tnx*(j+tny*k) ] ) { band[tile] = 1; break; }
+			}
+		}
+	}
+
+	_sweep( dst, sgn, fixed, band, tnx, tny, tnz, useOpenMP );
+
+	// the sign of each tile out of the band: flood fill over the tile grid
+	// (The tiles out of the band have no interface, so the sign of a tile is the sign of the facing element of its neighbor.)
+	std::vector<char> tileSgn( numTiles, 0 );
+	{
+		std::vector<int> queue;
+		queue.reserve( numTiles );
+
+		FOR( tile, 0, numTiles ) { if( band[tile] ) { queue.push_back( tile ); } }
+
+		for( size_t q=0; q<queue.size(); ++q )
+		{
+			const int tile = queue[q];
+			const int tc[3] = { tile%tnx, (tile/tnx)%tny, tile/(tnx*tny) };
+			const int tn[3] = { tnx, tny, tnz };
+
+			FOR( a, 0, 3 )
+			FOR( side, 0, 2 )
+			{
+				int nc[3] = { tc[0], tc[1], tc[2] };
+				nc[a] += side ? (+1) : (-1);
+				if( nc[a] < 0 || nc[a] >= tn[a] ) { continue; }
+
+				const int nbr = nc[0] + tnx*(nc[1]+tny*nc[2]);
+				if( band[nbr] || tileSgn[nbr] ) { continue; }
+
+				char sign = tileSgn[tile];
+
+				if( band[tile] )
+				{
+					// the element of this tile facing the center of the neighbor tile
+					int e[3];
+					FOR( b, 0, 3 ) { e[b] = ZMin( (tc[b]<<3)+4, maxIdx[b] ); }
+					e[a] = side ? ZMin( (tc[a]<<3)+7, maxIdx[a] ) : (tc[a]<<3);
+
+					sign = sgn[ lvs.index( e[0], e[1], e[2] ) ];
+				}
+
+				if( !sign ) { continue; }
+
+				tileSgn[nbr] = sign;
+				queue.push_back( nbr );
+			}
+		}
+	}
+
+	#pragma omp parallel for if( useOpenMP )
+	PER_EACH_ELEMENT_3D( lvs )
+
+		const int idx  = lvs.index(i,j,k);
+		const int tile = (i>>3) + tnx*( (j>>3) + tny*(k>>3) );
+
+		const char sign = band[tile] ? sgn[idx] : tileSgn[tile];
+
+		if( sign < 0 )      { phi[idx] = -ZMin( dst[idx], _negRange ) * _h; }
+		else if( sign > 0 ) { phi[idx] =  ZMin( dst[idx], _posRange ) * _h; }
+		else                { phi[idx] = _posRange * _h;                    }
+
+	END_PER_EACH_3D
+
+	lvs.setMinMax( useOpenMP );
+
+	reset();
+
+	return true;
+}
+
+// parallel fast sweeping in voxel units over the band tiles
+// For each sweeping order, the tiles on a plane ti+tj+tk=const. don't share any face,
+// so they are swept in parallel, and every element sees its upwind neighbors already updated.
+void
+ZVoxelizer::_sweep( std::vector<float>& dst, std::vector<char>& sgn, const std::vector<char>& fixed, const std::vector<char>& band, int tnx, int tny, int tnz, bool useOpenMP )
+{
+	ZPROFILE_SCOPE( "ZVoxelizer::sweep" );
+
+	ZScalarField3D& lvs = *_lvs;
+	ZVector* vel = _vel ? (ZVector*)_vel->pointer() : (ZVector*)NULL;
+
+	const int iMax=_iMax, jMax=_jMax, kMax=_kMax;
+	const int numPlanes = tnx + tny + tnz - 2;
+
+	const int maxIterations = 16;
+
+	FOR( iter, 0, maxIterations )
+	{
+		int numChanged = 0;
+
+		FOR( order, 0, 8 )
+		{
+			const int di = (order&1) ? (-1) : (+1);
+			const int dj = (order&2) ? (-1) : (+1);
+			const int dk = (order&4) ? (-1) : (+1);
+
+			FOR( plane, 0, numPlanes )
+			{
+				const int tkk0 = ZMax( 0, plane-(tnx-1)-(tny-1) ), tkk1 = ZMin( tnz-1, plane );
+
+				#pragma omp parallel for schedule(dynamic) reduction(+:numChanged) if( useOpenMP )
+				for( int tkk=tkk0; tkk<=tkk1; ++tkk )
+				{
+					const int tjj0 = ZMax( 0, plane-tkk-(tnx-1) ), tjj1 = ZMin( tny-1, plane-tkk );
+
+					for( int tjj=tjj0; tjj<=tjj1; ++tjj )
+					{
+						const int tii = plane - tkk - tjj;
+
+						const int ti = (di>0) ? tii : (tnx-1-tii);
+						const int tj = (dj>0) ? tjj : (tny-1-tjj);
+						const int tk = (dk>0) ? tkk : (tnz-1-tkk);
+
+						if( !band[ ti+tnx*(tj+tny*tk) ] ) { continue; }
+
+						const int i0=ti<<3, i1=ZMin(i0+7,iMax);
+						const int j0=tj<<3, j1=ZMin(j0+7,jMax);
+						const int k0=tk<<3, k1=ZMin(k0+7,kMax);
+
+						for( int k=((dk>0)?k0:k1); k>=k0 && k<=k1; k+=dk )
+						for( int j=((dj>0)?j0:j1); j>=j0 && j<=j1; j+=dj )
+						for( int i=((di>0)?i0:i1); i>=i0 && i<=i1; i+=di )
+						{{
+							const int idx = lvs.index(i,j,k);
+							if( fixed[idx] ) { continue; }
+
+							// the smaller neighbor of each axis
+							float nv[3] = { Z_LARGE, Z_LARGE, Z_LARGE };
+							int   ni[3] = { -1, -1, -1 };
+
+							if( i!=0    ) { const int n=lvs.i0(idx); if( dst[n]<nv[0] ) { nv[0]=dst[n]; ni[0]=n; } }
+							if( i!=iMax ) { const int n=lvs.i1(idx); if( dst[n]<nv[0] ) { nv[0]=dst[n]; ni[0]=n; } }
+							if( j!=0    ) { const int n=lvs.j0(idx); if( dst[n]<nv[1] ) { nv[1]=dst[n]; ni[1]=n; } }
+							if( j!=jMax ) { const int n=lvs.j1(idx); if( dst[n]<nv[1] ) { nv[1]=dst[n]; ni[1]=n; } }
+							if( k!=0    ) { const int n=lvs.k0(idx); if( dst[n]<nv[2] ) { nv[2]=dst[n]; ni[2]=n; } }
+							if( k!=kMax ) { const int n=lvs.k1(idx); if( dst[n]<nv[2] ) { nv[2]=dst[n]; ni[2]=n; } }
+
+							// sorting (ascending)
+							if( nv[0] > nv[1] ) { ZSwap( nv[0], nv[1] ); ZSwap( ni[0], ni[1] ); }
+							if( nv[1] > nv[2] ) { ZSwap( nv[1], nv[2] ); ZSwap( ni[1], ni[2] ); }
+							if( nv[0] > nv[1] ) { ZSwap( nv[0], nv[1] ); ZSwap( ni[0], ni[1] ); }
+
+							if( ni[0] < 0 ) { continue; }
+
+							// the upwind solution of |grad(u)|=1
+							int   m = 1;
+							float u = nv[0] + 1;
+
+							if( u > nv[1] )
+							{
+								m = 2;
+								u = 0.5f * ( nv[0] + nv[1] + sqrtf( 2 - ZPow2(nv[0]-nv[1]) ) );
+
+								if( u > nv[2] )
+								{
+									m = 3;
+									const float s = nv[0] + nv[1] + nv[2];
+									const float q = ZPow2(s) - 3*( ZPow2(nv[0]) + ZPow2(nv[1]) + ZPow2(nv[2]) - 1 );
+									u = ( s + sqrtf( ZMax( q, 0.f ) ) ) / 3;
+								}
+							}
+
+							const char sign = sgn[ ni[0] ];
+							u = ZMin( u, (sign<0) ? _negRange : _posRange );
+
+							float& cur = dst[idx];
+							if( !( u < cur ) ) { continue; }
+
+							if( cur-u > 1e-5f ) { ++numChanged; }
+
+							cur = u;
+							sgn[idx] = sign;
+
+							// velocity extension: weighted by the upwind differences
+							if( vel )
+							{
+								ZVector sum;
+								float wSum = 0.f;
+
+								FOR( l, 0, m )
+								{
+									const float w = u - nv[l];
+									sum += w * vel[ ni[l] ];
+									wSum += w;
+								}
+
+								vel[idx] = ( wSum > 0 ) ? ( sum * (1/wSum) ) : vel[ ni[0] ];
+							}
+						}}
+					}
+				}
+			}
+		}
+
+		if( !numChanged ) { break; }
+	}
+}
+
 ostream&
 operator<<( ostream& os, const ZVoxelizer& object )
 {
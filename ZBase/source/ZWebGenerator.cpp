@@ -0,0 +1,308 @@
+//-------------------//
+// ZWebGenerator.cpp //
+//-------------------------------------------------------//
+// author: Jaegwang Lim @ Dexter Studios                 //
+// last update: 2019.03.18                               //
+//-------------------------------------------------------//
+
+#include <ZelosBase.h>
+
+ZELOS_NAMESPACE_BEGIN
+
+ZWebGenerator::ZWebGenerator()
+{
+	numStrands     = 1;
+	seed           = 0;
+	segScale       = 1.f;
+	radius         = 1.f;
+	swirl          = 0.f;
+	noiseFrequency = 0.f;
+	noiseOffset    = 0.f;
+	noiseScale     = 1.f;
+	noiseOctaves   = 1;
+	noiseFunction  = NULL;
+}
+
+void
+ZWebGenerator::reset()
+{
+	_guides           .reset();
+	_startIdx         .clear();
+	_numSamples       .clear();
+	_guideLength      .clear();
+	_position         .clear();
+	_normal           .clear();
+	_biNormal         .clear();
+	_swirlRampValue   .clear();
+	_noiseRampValue   .clear();
+	_normalizedLength .clear();
+}
+
+int
+ZWebGenerator::numSamples( const ZCurves& guides, int i ) const
+{
+	const int nCVs = ( guideCVCounts.length() == guides.numCurves() ) ? guideCVCounts[i] : guides.numCVs(i);
+	return ZMax( int( nCVs * segScale ), 2 );
+}
+
+bool
+ZWebGenerator::compute( const ZCurves& guides, ZCurves& strands, bool useOpenMP )
+{
+	ZPROFILE_SCOPE( "ZWebGenerator::compute" );
+
+	const int nGuides = guides.numCurves();
+
+	if( !nGuides || numStrands < 1 )
+	{
+		strands.reset();
+		return false;
+	}
+
+	FOR( i, 0, nGuides )
+	{
+		if( guides.numCVs(i) < 2 )
+		{
+			cout << "Error@ZWebGenerator::compute(): Invalid guide curve." << endl;
+			strands.reset();
+			return false;
+		}
+	}
+
+	_allocate( guides );
+
+	// The guides without the arc length table are copied to build it.
+	// The copy is kept for the next call, since the Maya adapter gives the same guides without the table every time.
+	const ZCurves* guidesPtr = &guides;
+
+	if( !guides.hasArcLengthTable() )
+	{
+		if( !_guides.hasArcLengthTable() || !_isSame( guides, _guides ) )
+		{
+			_guides = guides;
+			_guides.buildArcLengthTable( 8, useOpenMP );
+		}
+
+		guidesPtr = &_guides;
+	}
+
+	// The frames are propagated along each guide, so the guides are the unit of parallelism here.
+	#pragma omp parallel for if( useOpenMP && nGuides>1 )
+	FOR( i, 0, nGuides )
+	{
+		_computeFrames( *guidesPtr, i );
+	}
+
+	const int nTotalStrands = nGuides * numStrands;
+
+	bool toReAlloc = ( strands.numCurves() != nTotalStrands );
+
+	if( !toReAlloc )
+	{
+		FOR( k, 0, nTotalStrands )
+		{
+			if( strands.numCVs(k) != _numSamples[k/numStrands] ) { toReAlloc = true; break; }
+		}
+	}
+
+	if( toReAlloc )
+	{
+		ZIntArray nCVs( nTotalStrands );
+
+		FOR( k, 0, nTotalStrands )
+		{
+			nCVs[k] = _numSamples[k/numStrands];
+		}
+
+		strands.set( nCVs );
+	}
+
+	#pragma omp parallel for if( useOpenMP )
+	FOR( k, 0, nTotalStrands )
+	{
+		const int g     = k / numStrands;
+		const int start = _startIdx[g];
+		const int nCVs  = _numSamples[g];
+
+		const float sx = ( ZRand( k+25612*seed ) - 0.5f ) * 2.f;
+		const float sy = ( ZRand( k+63188*seed ) - 0.5f ) * 2.f;
+		const float sr = ( ZRand( k+13188*seed ) - 0.5f ) * 2.f;
+		const float of = ( ZRand( k+53188*seed ) - 0.5f ) * 2.f;
+
+		double rot = ZRand( k+44188*seed ) * 360.f;
+
+		ZPoint* cv = &strands.cv( k, 0 );
+
+		FOR( j, 0, nCVs )
+		{
+			const int idx = start + j;
+			const float a = _normalizedLength[idx];
+
+			float noiseRad = _radiusNoise( a, noiseOffset+of );
+			if( noiseRad < -1.f ) { noiseRad = -1.f; }
+			noiseRad *= _noiseRampValue[idx];
+
+			const float r  = radius * ( noiseRad + 1.f );
+			const float rx = sx * r;
+			const float ry = sy * r;
+
+			rot += sr * swirl * _swirlRampValue[idx];
+
+			const float s = (float)sin( rot );
+			const float c = (float)cos( rot );
+
+			const ZPoint&  p = _position[idx];
+			const ZVector& n = _normal[idx];
+			const ZVector& b = _biNormal[idx];
+
+			cv[j].set( p.x + n.x*s*rx + b.x*c*ry, p.y + n.y*s*rx + b.y*c*ry, p.z + n.z*s*rx + b.z*c*ry );
+		}
+	}
+
+	return true;
+}
+
+void
+ZWebGenerator::_allocate( const ZCurves& guides )
+{
+	const int nGuides = guides.numCurves();
+
+	bool toReAlloc = ( _numSamples.length() != nGuides );
+
+	if( !toReAlloc )
+	{
+		FOR( i, 0, nGuides )
+		{
+			if( _numSamples[i] != numSamples( guides, i ) ) { toReAlloc = true; break; }
+		}
+	}
+
+	if( !toReAlloc ) { return; }
+
+	_numSamples.setLength( nGuides );
+	_startIdx.setLength( nGuides );
+	_guideLength.setLength( nGuides );
+
+	int nTotalSamples = 0;
+	FOR( i, 0, nGuides )
+	{
+		_startIdx[i] = nTotalSamples;
+		nTotalSamples += ( _numSamples[i] = numSamples( guides, i ) );
+	}
+
+	// The previous frames are no more valid.
+	_position         .setLength( nTotalSamples );
+	_normal           .setLength( nTotalSamples );
+	_biNormal         .setLength( nTotalSamples );
+	_swirlRampValue   .setLength( nTotalSamples );
+	_noiseRampValue   .setLength( nTotalSamples );
+	_normalizedLength .setLength( nTotalSamples );
+}
+
+void
+ZWebGenerator::_computeFrames( const ZCurves& guides, int i )
+{
+	const int start = _startIdx[i];
+	const int nCVs  = _numSamples[i];
+
+	const float guideLength = _guideLength[i] = guides.arcLength(i);
+	const float step = guideLength / (float)(nCVs-1);
+
+	ZVector tan( guides.tangent( i, 0.f ) );
+	ZVector nor;
+	{
+		ZVector tan0( 0.f, 0.f, 1.f );
+		ZVector nor0( 0.f, 1.f, 0.f );
+
+		// the frame of the previous evaluation
+		if( _normal[start].squaredLength() > 1e-10f )
+		{
+			nor0 = _normal[start];
+			tan0 = ( _biNormal[start] ^ _normal[start] ).normalize();
+		}
+
+		const float angle = Angle( tan0, tan );
+
+		if( angle > 1e-5f ) { nor = Rotate( nor0, (tan0^tan).normalize(), angle ); }
+		else                { nor = nor0; }
+	}
+
+	FOR( j, 0, nCVs )
+	{
+		const int   idx = start + j;
+		const float s   = j * step;
+		const float a   = ( guideLength > 0.f ) ? ZClamp( s/guideLength, 0.f, 1.f ) : 0.f;
+
+		const float t = guides.paramFromLength( i, s );
+
+		ZPoint  pos;
+		ZVector tan1;
+		guides.getPositionAndTangent( i, t, pos, tan1 );
+
+		// parallel transport of the normal
+		const float angle = Angle( tan, tan1 );
+
+		if( angle > 1e-5f )
+		{
+			nor = Rotate( nor, (tan^tan1).normalize(), angle );
+		}
+
+		tan = tan1;
+
+		const ZVector bin( ( nor ^ tan ).normalize() );
+		nor = ( tan ^ bin ).normalize();
+
+		_position[idx] = pos;
+		_normal[idx]   = nor;
+		_biNormal[idx] = bin;
+
+		_normalizedLength[idx] = a;
+		_swirlRampValue[idx]   = ZMax( 0.f, _lookUp( swirlRamp, a ) );
+		_noiseRampValue[idx]   = _lookUp( noiseRamp, a );
+	}
+}
+
+float
+ZWebGenerator::_radiusNoise( float a, float offset ) const
+{
+	float sum  = 0.f;
+	float freq = noiseFrequency;
+	float amp  = noiseScale;
+
+	const int nOctaves = ZMax( noiseOctaves, 1 );
+
+	FOR( o, 0, nOctaves )
+	{
+		const float x = a*freq + offset;
+
+		sum  += ( noiseFunction ? noiseFunction( x ) : _noise.pureValue( x ) ) * amp;
+		freq *= 2.f;
+		amp  *= 0.5f;
+	}
+
+	return sum;
+}
+
+// whether the CVs are the same (bit by bit)
+bool
+ZWebGenerator::_isSame( const ZCurves& a, const ZCurves& b )
+{
+	if( a.numCVs() != b.numCVs() ) { return false; }
+
+	const int n = a.numTotalCVs();
+	if( !n ) { return true; }
+
+	return !memcmp( (const char*)&a.cvs()[0], (const char*)&b.cvs()[0], n*sizeof(ZPoint) );
+}
+
+ostream&
+operator<<( ostream& os, const ZWebGenerator& object )
+{
+	os << "<ZWebGenerator>" << endl;
+	os << " # of strands per guide: " << object.numStrands << endl;
+	os << " radius                : " << object.radius << endl;
+	os << " swirl                 : " << object.swirl << endl;
+	return os;
+}
+
+ZELOS_NAMESPACE_END
+
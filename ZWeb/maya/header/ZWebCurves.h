@@ -22,10 +22,9 @@ class ZWebCurves : public MPxNode
 		bool              isThe1stTime=true;
 
 		/* Buffers */
-		MVectorArray guideCurvePoints;
-		MVectorArray guideCurveBinormals;
-		MVectorArray guideCurveNormals;
-		std::vector< MPointArray > cvPoints;
+		ZCurves       guideCurves;
+		ZCurves       webCurves;
+		ZWebGenerator generator;
 
 	public:
 
@@ -47,9 +46,6 @@ class ZWebCurves : public MPxNode
 		static MObject guideBinormalsObj;
 		static MObject guideNormalsObj;
 
-		// Noises
-		ZSimplexNoise radiusNoise;
-		
 	public:
 
 		ZWebCurves();
@@ -62,6 +58,11 @@ class ZWebCurves : public MPxNode
     	virtual MStatus compute( const MPlug&, MDataBlock& );		
 		virtual MStatus connectionMade( const MPlug& plug, const MPlug& otherPlug, bool asSrc );
 		virtual MStatus connectionBroken( const MPlug& plug, const MPlug& otherPlug, bool asSrc );
+
+	private:
+
+		void getGuideCurve( const MFnNurbsCurve& curveFn );
+		void getRamp( const MObject& rampObj, ZFloatArray& lut, int numSamples=64 );
 };
 
 #endif
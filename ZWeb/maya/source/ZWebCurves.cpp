@@ -10,6 +10,12 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/noise.hpp>
 
+// the radius noise the existing scenes were made with
+static float ClassicPerlin( float x )
+{
+	return glm::perlin( glm::vec4( x, 0.f, 0.f, 0.f ) );
+}
+
 bool ZWebCurves::enable = true;
 std::map<std::string, ZWebCurves*> ZWebCurves::instances;
 
@@ -135,168 +141,50 @@ ZWebCurves::compute( const MPlug& plug, MDataBlock& block )
 
 	if( guideCurveObj.isNull() == true )
 	{
-		guideCurvePoints.clear();
-		guideCurveBinormals.clear();
-		guideCurveNormals.clear();
+		generator.reset();
 	}
 
 	if( guideCurveObj.isNull() == false )
 	{
-		// Get web parameters
-		float segScale(1.f);
-		float radius(1.f);
-		float swirl(0.f);
+		getGuideCurve( MFnNurbsCurve( guideCurveObj ) );
 
-		float xFreq(0.f), xOffset(0.f), xScale(1.f);
-		int   xOctaves(1);
-
-		MFnNurbsCurve guideCurve( guideCurveObj );
-		MRampAttribute rampSwirl( nodeObj, rampSwirlObj );
-		MRampAttribute rampNoise( nodeObj, rampNoiseObj );
-
-		int seed = block.inputValue( seedObj ).asInt();
-
-		double guideLength = guideCurve.length();
+		generator.numStrands    = count;
+		generator.seed          = block.inputValue( seedObj ).asInt();
+		generator.noiseFunction = ClassicPerlin;
 
 		const ZWebCurvesData* params = (ZWebCurvesData*)block.inputValue( inWebDataObj ).asPluginData();
 		if( params )
 		{
-			segScale = params->segScale;
-			swirl = params->swirl;
-			radius = params->radius;
-
-			xFreq = params->noiseFrequency;
-			xOffset = params->noiseOffset;
-			xScale = params->noiseScale;
-			xOctaves = params->noiseOctaves;
-			xOctaves = std::max( xOctaves, 1 );
-		}
-
-		int nCV = guideCurve.numCVs()*segScale;
-		double step = guideLength / float( nCV-1 );
-
-		if( nCV != guideCurvePoints.length() )
-		{
-			guideCurvePoints.setLength( nCV );
-			guideCurveBinormals.setLength( nCV );
-			guideCurveNormals.setLength( nCV );
+			generator.segScale       = params->segScale;
+			generator.swirl          = params->swirl;
+			generator.radius         = params->radius;
+			generator.noiseFrequency = params->noiseFrequency;
+			generator.noiseOffset    = params->noiseOffset;
+			generator.noiseScale     = params->noiseScale;
+			generator.noiseOctaves   = std::max( params->noiseOctaves, 1 );
 		}
 
-		MVector tan = guideCurve.tangent( 0.01f ).normal();
-		MVector nor;
-		
-		{
-			MVector tan0( 0.f, 0.f, 1.f );
-			MVector nor0( 0.f, 1.f, 0.f );
+		getRamp( rampSwirlObj, generator.swirlRamp );
+		getRamp( rampNoiseObj, generator.noiseRamp );
 
-			if( guideCurveNormals[0].length() > 1e-5 )
-			{
-				nor0 = guideCurveNormals[0];
-				tan0 = (guideCurveBinormals[0]^guideCurveNormals[0]).normal();
-			}
+		generator.compute( guideCurves, webCurves );
 
-			float angle = acos( (tan0*tan) / (tan0.length()*tan.length()) );
-
-			if( ZAbs( angle ) > 1e-05 )
-			{
-				MVector axis = (tan0^tan) / (tan0.length()*tan.length());
-				nor = nor0*cos(angle) + (axis*nor0)*axis*(1.0-cos(angle)) + (axis^nor0)*sin(angle);
-				nor.normalize();
-			}
-			else
-			{
-				nor = nor0;
-			}
-		}
-
-		for( int n=0; n<nCV; ++n )
-		{
-			double d = guideCurve.findParamFromLength( (float)n*step );
-
-			MPoint pos;
-			guideCurve.getPointAtParam( d, pos );
-
-			MVector tan0 = tan;
-			tan = guideCurve.tangent( d ).normal();
-	
-			float angle = acos( (tan0*tan) / (tan0.length()*tan.length()) );
-
-			if( ZAbs(angle) > 1e-5 )
-			{
-				MVector axis = (tan0^tan) / (tan0.length()*tan.length());
-				
-				nor = nor*cos(angle) + (axis*nor)*axis*(1.0-cos(angle)) + (axis^nor)*sin(angle);
-
-				MVector bin = (nor^tan).normal();
-				nor = (tan^bin).normal();
-
-				guideCurvePoints[n] = pos;
-				guideCurveNormals[n] = nor;				
-				guideCurveBinormals[n] = bin;
-			}
-			else
-			{
-				guideCurvePoints[n] = pos;
-				guideCurveNormals[n] = nor;				
-				guideCurveBinormals[n] = (nor^tan).normal();
-			}
-		}
+		// Maya data creation is kept out of the threaded part.
+		MArrayDataHandle outCurvesHnd = block.outputArrayValue( outWebCurvesObj );
 
-		cvPoints.resize( count );
+		MPointArray cvs;
 
-		#pragma omp parallel for
 		for( int n=0; n<count; ++n )
-		{		
-			MArrayDataHandle outCurvesHnd = block.outputArrayValue( outWebCurvesObj );
-			outCurvesHnd.jumpToElement( n );			
-
-			MPointArray& cvs = cvPoints[n];
-			if( cvs.length() != nCV ) cvs.setLength( nCV );
-
-			float sx = (ZRand( n+25612*seed )-0.5f)*2.f;
-			float sy = (ZRand( n+63188*seed )-0.5f)*2.f;
-			float sr = (ZRand( n+13188*seed )-0.5f)*2.f;
-			float of = (ZRand( n+53188*seed )-0.5f)*2.f;
+		{
+			outCurvesHnd.jumpToElement( n );
 
-			double rot = ZRand( n+44188*seed )*360.f;
+			const int nCVs = webCurves.numCVs(n);
+			cvs.setLength( nCVs );
 
-			for( int i=0; i<nCV; ++i )
+			for( int i=0; i<nCVs; ++i )
 			{
-				const float s = (float)i*step;
-				const float a = s / guideLength;
-
-				float ex_s(1.f);	
-				rampSwirl.getValueAtPosition( a, ex_s );
-				ex_s = std::max( 0.f, ex_s );
-
-				// noise compute
-				float noise_rad( 0.f );
-				float ofreq  = xFreq;
-				float oScale = xScale; 
-				for( int n=0; n<xOctaves; ++n )
-				{
-					noise_rad += glm::perlin( glm::vec4( a*ofreq + xOffset+of, 0.f,0.f,0.f ) ) * oScale;
-					//noise_rad += radiusNoise.pureValue( a*ofreq + xOffset+of ) * oScale;
-					ofreq  *= 2.f;
-					oScale *= 0.5f;
-				}
-
-				if( noise_rad < -1.f ) noise_rad = -1.f;
-
-				float ex_n(1.f);
-				rampNoise.getValueAtPosition( a, ex_n );
-
-				noise_rad *= ex_n;
-
-				float rx = sx * ( radius*noise_rad + radius );
-				float ry = sy * ( radius*noise_rad + radius );
-
-				const MVector& pos = guideCurvePoints[i];
-				const MVector& nor = guideCurveNormals[i];
-				const MVector& bin = guideCurveBinormals[i];
-
-				rot += sr * swirl * ex_s;
-				cvs[i] = pos + nor*sin(rot)*rx + bin*cos(rot)*ry;
+				const ZPoint& p = webCurves.cv(n,i);
+				cvs.set( i, p.x, p.y, p.z );
 			}
 
 			MFnNurbsCurve newCurveFn;
@@ -305,7 +193,7 @@ ZWebCurves::compute( const MPlug& plug, MDataBlock& block )
 			newCurveFn.createWithEditPoints( cvs, 3, MFnNurbsCurve::kOpen, false, true, true, newCurveData );
 
 			outCurvesHnd.outputValue().set( newCurveData );
-		}		
+		}
 	}
 
 	block.setClean( plug );
@@ -350,3 +238,48 @@ MStatus ZWebCurves::connectionBroken( const MPlug& plug, const MPlug& otherPlug,
 	return MPxNode::connectionBroken( plug, otherPlug, asSrc );
 }
 
+// The NURBS guide is sampled at evenly spaced parameters. (Arc length parameterization is done by ZWebGenerator.)
+// The dense samples only feed the arc length table: the strands get numCVs()*segScale CVs as before.
+void
+ZWebCurves::getGuideCurve( const MFnNurbsCurve& curveFn )
+{
+	const int nSamples = std::max( curveFn.numCVs()*4, 8 );
+
+	generator.guideCVCounts.setLength( 1 );
+	generator.guideCVCounts[0] = curveFn.numCVs();
+
+	if( guideCurves.numCurves() != 1 || guideCurves.numCVs(0) != nSamples )
+	{
+		ZIntArray nCVs( 1, nSamples );
+		guideCurves.set( nCVs );
+	}
+
+	double t0=0.0, t1=1.0;
+	curveFn.getKnotDomain( t0, t1 );
+
+	const double dt = ( t1 - t0 ) / double( nSamples-1 );
+
+	MPoint p;
+
+	for( int i=0; i<nSamples; ++i )
+	{
+		curveFn.getPointAtParam( ( i==nSamples-1 ) ? t1 : ( t0+i*dt ), p );
+		guideCurves.cv(0,i).set( (float)p.x, (float)p.y, (float)p.z );
+	}
+}
+
+void
+ZWebCurves::getRamp( const MObject& rampObj, ZFloatArray& lut, int numSamples )
+{
+	MRampAttribute ramp( nodeObj, rampObj );
+
+	lut.setLength( numSamples );
+
+	for( int i=0; i<numSamples; ++i )
+	{
+		float v = 1.f;
+		ramp.getValueAtPosition( i / float(numSamples-1), v );
+		lut[i] = v;
+	}
+}
+